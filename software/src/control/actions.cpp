@@ -17,14 +17,15 @@
  *
  */
 
-
 // Action dispatch for SC1000 control events
 
 #include "actions.h"
 #include "input_state.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
+#include <memory>
 
 #include "../player/cues.h"
 #include "../player/deck.h"
@@ -32,259 +33,573 @@
 #include "../player/track.h"
 #include "../core/sc1000.h"
 #include "../core/sc_settings.h"
+#include "../input/midi_command.h"
+#include "../input/midi_event.h"
 #include "../platform/alsa.h"
 #include "../util/log.h"
 
 namespace sc {
 namespace control {
 
-void perform_action_for_deck(Deck* deck, const Mapping* map,
-                             const unsigned char midi_buffer[3],
-                             Sc1000* engine, ScSettings* settings,
-                             InputState& input_state)
+namespace {
+
+// When the MIDI event arrived, so the engine can place seeks and pitch
+// changes at a fixed latency. GPIO events apply at the next block.
+double event_time(const MidiEvent* midi_event)
 {
-    switch (map->action_type) {
-    case CUE: {
-        unsigned int cuenum = (map->type == MIDI)
-            ? map->midi_command_bytes[1]
-            : (map->gpio_port * 32) + map->pin + 128;
+    return midi_event ? midi_event->timestamp : 0.0;
+}
 
-        // Track cue button state for auto-cue combo detection
-        // Button index derived from cuenum % 4 (for MIDI notes 0-3, 4-7, etc.)
-        // Or use parameter field if explicitly set (1-4 maps to index 0-3)
-        int button_idx = (map->parameter >= 1 && map->parameter <= 4)
-            ? (map->parameter - 1)
-            : static_cast<int>(cuenum % 4);
-
-        // Handle button press/release for combo detection
-        if (map->edge_type == BUTTON_PRESSED || map->edge_type == BUTTON_PRESSED_SHIFTED) {
-            input_state.cue_button_pressed(button_idx);
-            deck->cue(cuenum, engine);
-        } else if (map->edge_type == BUTTON_RELEASED || map->edge_type == BUTTON_RELEASED_SHIFTED) {
-            // Check for combo - returns 0=none, 1=scratch, 2=beat
-            int combo_deck = input_state.cue_button_released(button_idx);
-            if (combo_deck == 1) {
-                engine->scratch_deck.cycle_auto_cue_mode();
-                // Skip normal cue action when combo detected
-            } else if (combo_deck == 2) {
-                engine->beat_deck.cycle_auto_cue_mode();
-                // Skip normal cue action when combo detected
-            } else {
-                // No combo - normal cue action on release (optional)
-                // deck->cue(cuenum, engine);  // Uncomment if cue should also fire on release
-            }
-        } else {
-            // Other edge types - just fire the cue
-            deck->cue(cuenum, engine);
-        }
-        break;
+// Velocity of a MIDI note as a gain, full for anything else
+float velocity_gain(const MidiEvent* midi_event)
+{
+    if (!midi_event) return 1.0f;
+    MidiCommand cmd = MidiCommand::from_bytes(midi_event->bytes);
+    return cmd.is_note_on() ? static_cast<float>(cmd.data2) / 127.0f : 1.0f;
+}
+
+// Held until a MIDI note off or CC below 64, or the GPIO release
+bool held(const MidiEvent* midi_event)
+{
+    if (!midi_event) return true;
+    MidiCommand cmd = MidiCommand::from_bytes(midi_event->bytes);
+    return cmd.is_note_on() || (cmd.is_cc() && cmd.data2 >= 64);
+}
+
+void nudge_volume(Deck* deck, double amount)
+{
+    deck->player.input.volume_knob += amount;
+    if (deck->player.input.volume_knob > 1.0)
+        deck->player.input.volume_knob = 1.0;
+    if (deck->player.input.volume_knob < 0.0)
+        deck->player.input.volume_knob = 0.0;
+}
+
+//
+// Handlers, one per action (and edge or mode where the old switch branched)
+//
+
+void cue_press(const ActionHandler& h, const MidiEvent* midi_event,
+               Sc1000* engine, ScSettings*, InputState& input_state)
+{
+    // Track cue button state for auto-cue combo detection
+    input_state.cue_button_pressed(h.index);
+    h.deck->player.input.seek_time = event_time(midi_event);
+    h.deck->cue(h.cue, engine);
+}
+
+void cue_release(const ActionHandler& h, const MidiEvent*,
+                 Sc1000* engine, ScSettings*, InputState& input_state)
+{
+    // Check for combo - returns 0=none, 1=scratch, 2=beat
+    // Without a combo a release does nothing (cue fires on press)
+    int combo_deck = input_state.cue_button_released(h.index);
+    if (combo_deck == 1) {
+        engine->scratch_deck.cycle_auto_cue_mode();
+    } else if (combo_deck == 2) {
+        engine->beat_deck.cycle_auto_cue_mode();
     }
-    case DELETECUE: {
-        unsigned int cuenum = (map->type == MIDI)
-            ? map->midi_command_bytes[1]
-            : (map->gpio_port * 32) + map->pin + 128;
-        deck->unset_cue(cuenum);
-        break;
+}
+
+void cue_fire(const ActionHandler& h, const MidiEvent* midi_event,
+              Sc1000* engine, ScSettings*, InputState&)
+{
+    // Other edge types - just fire the cue
+    h.deck->player.input.seek_time = event_time(midi_event);
+    h.deck->cue(h.cue, engine);
+}
+
+void delete_cue(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings*, InputState&)
+{
+    h.deck->unset_cue(h.cue);
+}
+
+void note(const ActionHandler& h, const MidiEvent* midi_event, Sc1000*, ScSettings*, InputState&)
+{
+    const unsigned char* midi_buffer = midi_event->bytes;
+
+    // Check for note-off: status 0x80 or note-on with velocity 0
+    bool is_note_off = (midi_buffer[0] & 0xF0) == 0x80 ||
+                       ((midi_buffer[0] & 0xF0) == 0x90 && midi_buffer[2] == 0);
+    h.deck->player.input.pitch_time = midi_event->timestamp;
+    if (is_note_off) {
+        h.deck->player.input.pitch_note = 1.0;
+        LOG_DEBUG("NOTE action: note-off, pitch reset to 1.0");
+    } else {
+        // Equal temperament: 2^(1/12) per semitone, 0x3C = middle C
+        double new_pitch = pow(pow(2.0, 1.0 / 12.0), midi_buffer[1] - 0x3C);
+        h.deck->player.input.pitch_note = new_pitch;
+        LOG_INFO("NOTE action: note=%d -> pitch=%.3f", midi_buffer[1], new_pitch);
     }
-    case NOTE: {
-        // Check for note-off: status 0x80 or note-on with velocity 0
-        bool is_note_off = (midi_buffer[0] & 0xF0) == 0x80 ||
-                           ((midi_buffer[0] & 0xF0) == 0x90 && midi_buffer[2] == 0);
-        if (is_note_off) {
-            deck->player.input.pitch_note = 1.0;
-            LOG_DEBUG("NOTE action: note-off, pitch reset to 1.0");
-        } else {
-            // Equal temperament: 2^(1/12) per semitone, 0x3C = middle C
-            double new_pitch = pow(pow(2.0, 1.0 / 12.0), midi_buffer[1] - 0x3C);
-            deck->player.input.pitch_note = new_pitch;
-            LOG_INFO("NOTE action: note=%d -> pitch=%.3f", midi_buffer[1], new_pitch);
-        }
-        break;
+}
+
+void one_shot(const ActionHandler& h, const MidiEvent* midi_event, Sc1000* engine, ScSettings*, InputState&)
+{
+    // A slice of the loaded track, between this pad's cue and the next
+    Track* track = h.deck->player.track;
+    if (track == nullptr || track->length == 0) return;
+
+    double start, end;
+    h.deck->cue_slice(h.cue, &start, &end);
+    track_acquire(track);
+    engine->sampler.trigger(track, start * track->rate, end * track->rate, 1.0, velocity_gain(midi_event));
+}
+
+void one_shot_note(const ActionHandler& h, const MidiEvent* midi_event, Sc1000* engine, ScSettings*, InputState&)
+{
+    // What the deck plays, its loop or its track, from the start
+    Track* track = nullptr;
+    if (h.deck->player.input.source == sc::PlaybackSource::Loop && engine->audio) {
+        track = engine->audio->get_loop_track(h.deck_no);
+    } else if (h.deck->player.track != nullptr) {
+        track = h.deck->player.track;
+        track_acquire(track);
     }
-    case STARTSTOP:
-        deck->player.input.stopped = !deck->player.input.stopped;
-        break;
+    if (track == nullptr) return;
 
-    case SHIFTON:
-        LOG_DEBUG("SHIFTON action fired, shifted: %d -> true", input_state.is_shifted());
-        input_state.set_shifted(true);
-        break;
+    // Equal temperament from middle C, like the NOTE action
+    double pitch = pow(pow(2.0, 1.0 / 12.0), midi_event->bytes[1] - 0x3C);
+    engine->sampler.trigger(track, 0.0, track->length, pitch, velocity_gain(midi_event));
+}
 
-    case SHIFTOFF:
-        LOG_DEBUG("SHIFTOFF action fired, shifted: %d -> false", input_state.is_shifted());
-        input_state.set_shifted(false);
-        break;
+void start_stop(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings*, InputState&)
+{
+    h.deck->player.input.stopped = !h.deck->player.input.stopped;
+}
 
-    case NEXTFILE:
-        deck->next_file(engine, settings);
-        break;
+void start(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings*, InputState&)
+{
+    h.deck->player.input.stopped = false;
+}
 
-    case PREVFILE:
-        deck->prev_file(engine, settings);
-        break;
+void stop(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings*, InputState&)
+{
+    h.deck->player.input.stopped = true;
+}
 
-    case RANDOMFILE:
-        deck->random_file(engine, settings);
-        break;
+void shift_on(const ActionHandler&, const MidiEvent*, Sc1000*, ScSettings*, InputState& input_state)
+{
+    LOG_DEBUG("SHIFTON action fired, shifted: %d -> true", input_state.is_shifted());
+    input_state.set_shifted(true);
+}
 
-    case NEXTFOLDER:
-        deck->next_folder(engine, settings);
-        break;
+void shift_off(const ActionHandler&, const MidiEvent*, Sc1000*, ScSettings*, InputState& input_state)
+{
+    LOG_DEBUG("SHIFTOFF action fired, shifted: %d -> false", input_state.is_shifted());
+    input_state.set_shifted(false);
+}
 
-    case PREVFOLDER:
-        deck->prev_folder(engine, settings);
-        break;
+void next_file(const ActionHandler& h, const MidiEvent*, Sc1000* engine, ScSettings* settings, InputState&)
+{
+    h.deck->next_file(engine, settings);
+}
 
-    case VOLUME:
-        deck->player.input.volume_knob = static_cast<double>(midi_buffer[2]) / 128.0;
-        break;
+void prev_file(const ActionHandler& h, const MidiEvent*, Sc1000* engine, ScSettings* settings, InputState&)
+{
+    h.deck->prev_file(engine, settings);
+}
 
-    case PITCH:
-        if (map->type == MIDI) {
-            double pitch = 1.0;
-            int semitone_range = map->parameter;
-
-            // Pitch bend message: use 14-bit accuracy
-            if ((midi_buffer[0] & 0xF0) == 0xE0) {
-                unsigned int pval = (static_cast<unsigned int>(midi_buffer[2]) << 7) |
-                                    static_cast<unsigned int>(midi_buffer[1]);
-                double normalized = (static_cast<double>(pval) - 8192.0) / 8192.0;
-
-                if (semitone_range > 0) {
-                    double semitones = normalized * static_cast<double>(semitone_range);
-                    pitch = std::pow(2.0, semitones / 12.0);
-                    LOG_DEBUG("PITCH action: 14-bit pval=%u norm=%.3f semi=%.1f pitch=%.4f deck=%d",
-                             pval, normalized, semitones, pitch, map->deck_no);
-                } else {
-                    pitch = (normalized * (static_cast<double>(settings->pitch_range) / 100.0)) + 1.0;
-                    LOG_DEBUG("PITCH action: 14-bit pval=%u pitch=%.4f range=%d%% deck=%d",
-                             pval, pitch, settings->pitch_range, map->deck_no);
-                }
-            } else {
-                // 7-bit CC
-                double normalized = (static_cast<double>(midi_buffer[2]) - 64.0) / 64.0;
-
-                if (semitone_range > 0) {
-                    double semitones = normalized * static_cast<double>(semitone_range);
-                    pitch = std::pow(2.0, semitones / 12.0);
-                    LOG_DEBUG("PITCH action: 7-bit val=%d semi=%.1f pitch=%.4f deck=%d",
-                             midi_buffer[2], semitones, pitch, map->deck_no);
-                } else {
-                    pitch = (normalized * (static_cast<double>(settings->pitch_range) / 100.0)) + 1.0;
-                    LOG_DEBUG("PITCH action: 7-bit val=%d pitch=%.4f range=%d%% deck=%d",
-                             midi_buffer[2], pitch, settings->pitch_range, map->deck_no);
-                }
-            }
-            deck->player.input.pitch_fader = pitch;
+void random_file(const ActionHandler& h, const MidiEvent*, Sc1000* engine, ScSettings* settings, InputState&)
+{
+    h.deck->random_file(engine, settings);
+}
+
+void next_folder(const ActionHandler& h, const MidiEvent*, Sc1000* engine, ScSettings* settings, InputState&)
+{
+    h.deck->next_folder(engine, settings);
+}
+
+void prev_folder(const ActionHandler& h, const MidiEvent*, Sc1000* engine, ScSettings* settings, InputState&)
+{
+    h.deck->prev_folder(engine, settings);
+}
+
+void volume(const ActionHandler& h, const MidiEvent* midi_event, Sc1000*, ScSettings*, InputState&)
+{
+    h.deck->player.input.volume_knob = static_cast<double>(midi_event->value) / 16384.0;
+}
+
+// Pitch bend, 14-bit CC and NRPN carry 14 bits, 7-bit CC is scaled up by
+// the parser, so both share one center
+double pitch_normalized(const MidiEvent* midi_event)
+{
+    return (static_cast<double>(midi_event->value) - 8192.0) / 8192.0;
+}
+
+void pitch_semitones(const ActionHandler& h, const MidiEvent* midi_event, Sc1000*, ScSettings*, InputState&)
+{
+    double semitones = pitch_normalized(midi_event) * static_cast<double>(h.index);
+    double pitch = std::pow(2.0, semitones / 12.0);
+    LOG_DEBUG("PITCH action: %s val=%u semi=%.1f pitch=%.4f deck=%d",
+             midi_event->high_res ? "14-bit" : "7-bit",
+             midi_event->value, semitones, pitch, h.deck_no);
+    h.deck->player.input.pitch_time = midi_event->timestamp;
+    h.deck->player.input.pitch_fader = pitch;
+}
+
+void pitch_range(const ActionHandler& h, const MidiEvent* midi_event, Sc1000*, ScSettings* settings, InputState&)
+{
+    double pitch = (pitch_normalized(midi_event) * (static_cast<double>(settings->pitch_range) / 100.0)) + 1.0;
+    LOG_DEBUG("PITCH action: %s val=%u pitch=%.4f range=%d%% deck=%d",
+             midi_event->high_res ? "14-bit" : "7-bit",
+             midi_event->value, pitch, settings->pitch_range, h.deck_no);
+    h.deck->player.input.pitch_time = midi_event->timestamp;
+    h.deck->player.input.pitch_fader = pitch;
+}
+
+void jog(const ActionHandler& h, const MidiEvent* midi_event, Sc1000* engine, ScSettings* settings, InputState&)
+{
+    int ticks = MidiCommand::relative_delta(static_cast<uint8_t>(midi_event->value >> 7), static_cast<uint8_t>(h.index));
+    if (ticks != 0) {
+        h.deck->jog_move(ticks, midi_event->timestamp, engine, settings);
+    }
+}
+
+void jog_touch(const ActionHandler& h, const MidiEvent* midi_event, Sc1000* engine, ScSettings*, InputState&)
+{
+    MidiCommand cmd = MidiCommand::from_bytes(midi_event->bytes);
+    bool touch = cmd.is_note_on() || (cmd.is_cc() && cmd.data2 >= 64);
+    h.deck->jog_touch(touch, midi_event->timestamp, engine);
+}
+
+void jog_pitch(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings*, InputState& input_state)
+{
+    input_state.set_pitch_mode(h.deck_no + 1);
+    LOG_DEBUG("Set Pitch Mode %d", input_state.pitch_mode());
+}
+
+void jog_pitch_stop(const ActionHandler&, const MidiEvent*, Sc1000*, ScSettings*, InputState& input_state)
+{
+    input_state.set_pitch_mode(0);
+}
+
+void sc500(const ActionHandler&, const MidiEvent*, Sc1000*, ScSettings*, InputState&)
+{
+    LOG_DEBUG("SC500 detected");
+}
+
+void volume_up(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings* settings, InputState&)
+{
+    nudge_volume(h.deck, settings->volume_amount);
+}
+
+void volume_down(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings* settings, InputState&)
+{
+    nudge_volume(h.deck, -settings->volume_amount);
+}
+
+void volume_up_held(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings* settings, InputState&)
+{
+    nudge_volume(h.deck, settings->volume_amount_held);
+}
+
+void volume_down_held(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings* settings, InputState&)
+{
+    nudge_volume(h.deck, -settings->volume_amount_held);
+}
+
+void jog_reverse(const ActionHandler&, const MidiEvent*, Sc1000* engine, ScSettings* settings, InputState&)
+{
+    // Published snapshots are never written, publish a changed copy
+    auto next = std::make_unique<ScSettings>(*settings);
+    next->jog_reverse = !settings->jog_reverse;
+    LOG_DEBUG("Reversed Jog Wheel: %d -> %d", settings->jog_reverse, next->jog_reverse);
+    engine->settings.publish(std::move(next));
+}
+
+void bend(const ActionHandler& h, const MidiEvent* midi_event, Sc1000*, ScSettings*, InputState&)
+{
+    // Temporary pitch bend on top of other pitch values
+    h.deck->player.input.pitch_time = event_time(midi_event);
+    h.deck->player.input.pitch_bend = h.value;
+}
+
+void record(const ActionHandler& h, const MidiEvent*, Sc1000* engine, ScSettings*, InputState&)
+{
+    h.deck->record(engine);
+}
+
+void loop_erase(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings*, InputState&)
+{
+    Deck* target = h.deck;
+
+    // Long-hold RECORD erases the loop and navigates to first file
+    LOG_DEBUG("LOOPERASE triggered on deck %d, was source=%d, was current_file_idx=%d",
+              h.deck_no, static_cast<int>(target->player.input.source), target->nav_state.file_idx);
+    target->player.input.loop_erase = true;  // Applied by the audio thread
+    target->player.input.source = sc::PlaybackSource::File;
+
+    // Navigate to first file (position 1, index 0)
+    target->nav_state.file_idx = 0;
+    LOG_DEBUG("LOOPERASE set source=File, current_file_idx=0");
+    if (target->nav_state.files_present) {
+        ScFile* file = target->playlist->get_file(target->nav_state.folder_idx, 0);
+        if (file != nullptr) {
+            target->player.set_track(track_acquire_by_import(target->importer.c_str(), file->full_path));
+            target->player.input.seek_to = 0.0;
+            target->player.input.position_offset = 0.0;
+            target->load_cues();
         }
-        break;
+    }
 
-    case JOGPIT:
-        input_state.set_pitch_mode(map->deck_no + 1);
-        LOG_DEBUG("Set Pitch Mode %d", input_state.pitch_mode());
-        break;
+    target->player.input.beep_request = sc::BeepType::RecordingError;
+    LOG_DEBUG("Loop erased on deck %d, navigated to file 0", h.deck_no);
+}
 
-    case JOGPSTOP:
-        input_state.set_pitch_mode(0);
-        break;
+void loop_recall(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings* settings, InputState&)
+{
+    LOG_DEBUG("Loop recall triggered on deck %d", h.deck_no);
+    if (h.deck->recall_loop(settings)) {
+        h.deck->player.input.beep_request = sc::BeepType::RecordingStart;
+    } else {
+        h.deck->player.input.beep_request = sc::BeepType::RecordingError;
+    }
+}
 
-    case SC500:
-        LOG_DEBUG("SC500 detected");
-        break;
+void grab_loop(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings*, InputState&)
+{
+    // Applied by the audio thread, which owns the capture ring
+    LOG_DEBUG("Grab loop triggered on deck %d (%.0f s)", h.deck_no, h.value);
+    h.deck->player.input.grab_seconds = h.value;
+}
 
-    case VOLUP:
-        deck->player.input.volume_knob += settings->volume_amount;
-        if (deck->player.input.volume_knob > 1.0)
-            deck->player.input.volume_knob = 1.0;
-        break;
+void loop_roll(const ActionHandler& h, const MidiEvent* midi_event, Sc1000*, ScSettings*, InputState&)
+{
+    h.deck->player.input.roll_beats = held(midi_event) ? h.value : 0.0;
+}
 
-    case VOLDOWN:
-        deck->player.input.volume_knob -= settings->volume_amount;
-        if (deck->player.input.volume_knob < 0.0)
-            deck->player.input.volume_knob = 0.0;
-        break;
+void loop_roll_stop(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings*, InputState&)
+{
+    h.deck->player.input.roll_beats = 0.0;
+}
 
-    case VOLUHOLD:
-        deck->player.input.volume_knob += settings->volume_amount_held;
-        if (deck->player.input.volume_knob > 1.0)
-            deck->player.input.volume_knob = 1.0;
-        break;
+void stutter(const ActionHandler& h, const MidiEvent* midi_event, Sc1000*, ScSettings*, InputState&)
+{
+    h.deck->player.input.stutter_beats = held(midi_event) ? h.value : 0.0;
+}
 
-    case VOLDHOLD:
-        deck->player.input.volume_knob -= settings->volume_amount_held;
-        if (deck->player.input.volume_knob < 0.0)
-            deck->player.input.volume_knob = 0.0;
-        break;
+void stutter_stop(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings*, InputState&)
+{
+    h.deck->player.input.stutter_beats = 0.0;
+}
 
-    case JOGREVERSE:
-        LOG_DEBUG("Reversed Jog Wheel: %d", settings->jog_reverse);
-        settings->jog_reverse = !settings->jog_reverse;
-        LOG_DEBUG(" -> %d", settings->jog_reverse);
-        break;
+void search(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings* settings, InputState&)
+{
+    h.deck->search(h.deck->search_query + static_cast<char>(h.index), settings);
+}
 
-    case BEND:
-        // Temporary pitch bend on top of other pitch values
-        deck->player.input.pitch_bend = pow(pow(2.0, 1.0 / 12.0), map->parameter - 0x3C);
-        break;
+void search_back(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings* settings, InputState&)
+{
+    std::string query = h.deck->search_query;
+    if (!query.empty()) query.pop_back();
+    h.deck->search(query, settings);
+}
 
-    default:
-        break;
+void search_clear(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings* settings, InputState&)
+{
+    h.deck->search(std::string(), settings);
+}
+
+void save_loop(const ActionHandler& h, const MidiEvent*, Sc1000* engine, ScSettings*, InputState&)
+{
+    Deck* target = h.deck;
+    sc::DeckInput& input = target->player.input;
+
+    // Saved next to the deck's folders, so the playlist can take it up
+    bool ready = engine->audio && engine->audio->has_loop(h.deck_no) &&
+                 target->playlist && !target->playlist->base_path().empty() &&
+                 input.save_snapshot == nullptr;
+
+    // The reference to the loop is given back in collect_saved_loops()
+    sc::audio::LoopSnapshot* snapshot = nullptr;
+    Track* loop = ready ? engine->audio->get_loop_track(h.deck_no) : nullptr;
+    if (loop) {
+        snapshot = engine->loop_writer.request(h.deck_no, loop,
+                                               target->playlist->base_path() + "/loops");
     }
+
+    if (snapshot == nullptr) {
+        input.beep_request = sc::BeepType::RecordingError;
+        return;
+    }
+
+    // Attached by the audio thread, which owns the loop buffer
+    LOG_DEBUG("Save loop triggered on deck %d", h.deck_no);
+    input.save_snapshot = snapshot;
 }
 
-void dispatch_event(const Mapping* map, const unsigned char midi_buffer[3],
-                    Sc1000* engine, ScSettings* settings,
-                    InputState& input_state)
+void master_record(const ActionHandler& h, const MidiEvent*, Sc1000* engine, ScSettings* settings, InputState&)
 {
-    if (map == nullptr) return;
+    sc::DeckInput& input = h.deck->player.input;
+    sc::audio::MasterRecorder& recorder = engine->master_recorder;
+
+    if (recorder.recording()) {
+        LOG_DEBUG("Master recording stopped");
+        recorder.stop();
+        input.beep_request = sc::BeepType::RecordingStop;
+        return;
+    }
 
-    // Determine target deck from Mapping (0=beat, 1=scratch)
-    Deck* target = (map->deck_no == 0)
-        ? &engine->beat_deck
-        : &engine->scratch_deck;
+    // The file is opened by the writer thread, not here
+    bool started = engine->audio &&
+                   recorder.start(settings->root_path + "/recordings", engine->audio->sample_rate(),
+                                  settings->master_record_input);
+    LOG_DEBUG("Master recording %s", started ? "started" : "unavailable");
+    input.beep_request = started ? sc::BeepType::RecordingStart : sc::BeepType::RecordingError;
+}
 
-    switch (map->action_type) {
-    case RECORD:
-        target->record(engine);
-        break;
+void calibrate_latency(const ActionHandler& h, const MidiEvent*, Sc1000*, ScSettings*, InputState&)
+{
+    // Run by the audio thread, which beeps only once done so the beep is not measured
+    LOG_DEBUG("Latency calibration triggered");
+    h.deck->player.input.calibrate_latency = true;
+}
 
-    case LOOPERASE:
-        // Long-hold RECORD erases the loop and navigates to first file
-        LOG_DEBUG("LOOPERASE triggered on deck %d, was source=%d, was current_file_idx=%d",
-                  map->deck_no, static_cast<int>(target->player.input.source), target->nav_state.file_idx);
-        if (engine->audio) engine->audio->reset_loop(map->deck_no);
-        target->player.input.source = sc::PlaybackSource::File;
-
-        // Navigate to first file (position 1, index 0)
-        target->nav_state.file_idx = 0;
-        LOG_DEBUG("LOOPERASE set source=File, current_file_idx=0");
-        if (target->nav_state.files_present) {
-            ScFile* file = target->playlist->get_file(target->nav_state.folder_idx, 0);
-            if (file != nullptr) {
-                target->player.set_track(track_acquire_by_import(target->importer.c_str(), file->full_path.c_str()));
-                target->player.input.seek_to = 0.0;
-                target->player.input.position_offset = 0.0;
-                target->cues.load_from_file(target->player.track->path);
-            }
-        }
+// Bind one action of a Mapping. Returns false if there is nothing to run.
+bool compile_step(const Mapping& map, ActionType action, ActionHandler* h)
+{
+    const bool midi = (map.type == MIDI);
 
-        target->player.input.beep_request = sc::BeepType::RecordingError;
-        LOG_DEBUG("Loop erased on deck %d, navigated to file 0", map->deck_no);
-        break;
+    switch (action) {
+    case CUE: {
+        h->cue = midi
+            ? map.midi_command_bytes[1]
+            : (map.gpio_port * 32) + map.pin + 128;
 
-    case LOOPRECALL:
-        LOG_DEBUG("Loop recall triggered on deck %d", map->deck_no);
-        if (target->recall_loop(settings)) {
-            target->player.input.beep_request = sc::BeepType::RecordingStart;
+        // Button index derived from cuenum % 4 (for MIDI notes 0-3, 4-7, etc.)
+        // Or use parameter field if explicitly set (1-4 maps to index 0-3)
+        h->index = (map.parameter >= 1 && map.parameter <= 4)
+            ? (map.parameter - 1)
+            : static_cast<int>(h->cue % 4);
+
+        if (map.edge_type == BUTTON_PRESSED || map.edge_type == BUTTON_PRESSED_SHIFTED) {
+            h->fn = cue_press;
+        } else if (map.edge_type == BUTTON_RELEASED || map.edge_type == BUTTON_RELEASED_SHIFTED) {
+            h->fn = cue_release;
         } else {
-            target->player.input.beep_request = sc::BeepType::RecordingError;
+            h->fn = cue_fire;
         }
         break;
-
-    default:
-        perform_action_for_deck(target, map, midi_buffer, engine, settings, input_state);
+    }
+    case ONESHOT:
+        h->cue = midi
+            ? map.midi_command_bytes[1]
+            : (map.gpio_port * 32) + map.pin + 128;
+        h->fn = one_shot;
+        break;
+    case ONESHOTNOTE:
+        h->fn = midi ? one_shot_note : nullptr;
+        break;
+    case DELETECUE:
+        h->cue = midi
+            ? map.midi_command_bytes[1]
+            : (map.gpio_port * 32) + map.pin + 128;
+        h->fn = delete_cue;
+        break;
+    case PITCH:
+        h->index = map.parameter;
+        h->fn = midi ? (map.parameter > 0 ? pitch_semitones : pitch_range) : nullptr;
+        break;
+    case JOG:
+        h->index = map.parameter;
+        h->fn = midi ? jog : nullptr;
+        break;
+    case BEND:
+        h->value = pow(pow(2.0, 1.0 / 12.0), map.parameter - 0x3C);
+        h->fn = bend;
+        break;
+    case NOTE:       h->fn = midi ? note : nullptr; break;
+    case VOLUME:     h->fn = midi ? volume : nullptr; break;
+    case JOGTOUCH:   h->fn = midi ? jog_touch : nullptr; break;
+    case STARTSTOP:  h->fn = start_stop; break;
+    case START:      h->fn = start; break;
+    case STOP:       h->fn = stop; break;
+    case SHIFTON:    h->fn = shift_on; break;
+    case SHIFTOFF:   h->fn = shift_off; break;
+    case NEXTFILE:   h->fn = next_file; break;
+    case PREVFILE:   h->fn = prev_file; break;
+    case RANDOMFILE: h->fn = random_file; break;
+    case NEXTFOLDER: h->fn = next_folder; break;
+    case PREVFOLDER: h->fn = prev_folder; break;
+    case JOGPIT:     h->fn = jog_pitch; break;
+    case JOGPSTOP:   h->fn = jog_pitch_stop; break;
+    case SC500:      h->fn = sc500; break;
+    case VOLUP:      h->fn = volume_up; break;
+    case VOLDOWN:    h->fn = volume_down; break;
+    case VOLUHOLD:   h->fn = volume_up_held; break;
+    case VOLDHOLD:   h->fn = volume_down_held; break;
+    case JOGREVERSE: h->fn = jog_reverse; break;
+    case RECORD:     h->fn = record; break;
+    case LOOPERASE:  h->fn = loop_erase; break;
+    case LOOPRECALL: h->fn = loop_recall; break;
+    case GRABLOOP:
+        h->value = map.parameter;
+        h->fn = grab_loop;
+        break;
+    case SAVELOOP:   h->fn = save_loop; break;
+    case LOOPROLL:
+        h->value = 1.0 / std::max<int>(map.parameter, 1);
+        h->fn = loop_roll;
+        break;
+    case LOOPROLLSTOP: h->fn = loop_roll_stop; break;
+    case STUTTER:
+        h->value = 1.0 / std::max<int>(map.parameter, 1);
+        h->fn = stutter;
         break;
+    case STUTTERSTOP: h->fn = stutter_stop; break;
+    case SEARCH:
+        h->index = map.parameter;
+        h->fn = map.parameter >= 32 ? search : nullptr;
+        break;
+    case SEARCHBACK:  h->fn = search_back; break;
+    case SEARCHCLEAR: h->fn = search_clear; break;
+    case MASTERRECORD: h->fn = master_record; break;
+    case CALIBRATELATENCY: h->fn = calibrate_latency; break;
+    default:         h->fn = nullptr; break;
+    }
+
+    return h->fn != nullptr;
+}
+
+} // namespace
+
+ActionProgram compile_action(const Mapping& map, Deck* beat_deck, Deck* scratch_deck)
+{
+    ActionProgram program;
+
+    auto add = [&](ActionType action) {
+        ActionHandler h;
+        h.deck_no = map.deck_no;
+        h.deck = (map.deck_no == 0) ? beat_deck : scratch_deck;
+        if (compile_step(map, action, &h)) {
+            program.steps[program.count++] = h;
+        }
+    };
+
+    add(map.action_type);
+    for (ActionType action : map.macro) {
+        if (action == NOTHING) break;
+        add(action);
     }
+
+    return program;
+}
+
+void dispatch_event(const Mapping* map, const MidiEvent* midi_event,
+                    Sc1000* engine, ScSettings* settings,
+                    InputState& input_state)
+{
+    if (map == nullptr) return;
+
+    // Mappings held by the registry were compiled when they were added
+    const ActionProgram* program = engine->mappings.program(map);
+    if (program != nullptr) {
+        program->run(midi_event, engine, settings, input_state);
+        return;
+    }
+
+    compile_action(*map, &engine->beat_deck, &engine->scratch_deck)
+        .run(midi_event, engine, settings, input_state);
 }
 
 } // namespace control
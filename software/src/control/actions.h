@@ -17,11 +17,12 @@
  *
  */
 
-
 // Action dispatch for SC1000 control events
 // Maps input events (GPIO, MIDI) to deck operations
 #pragma once
 
+#include <cstddef>
+
 #include "../core/sc_input.h"
 
 struct Deck;
@@ -29,18 +30,64 @@ struct Sc1000;
 struct ScSettings;
 
 namespace sc {
+
+struct MidiEvent;
+
 namespace control {
 
 class InputState;  // Forward declaration
 
-// Execute an action on a specific deck
-void perform_action_for_deck(Deck* d, const Mapping* map,
-                             const unsigned char midi_buffer[3],
-                             Sc1000* engine, ScSettings* settings,
-                             InputState& input_state);
+struct ActionHandler;
+
+using ActionFn = void (*)(const ActionHandler& handler, const MidiEvent* midi_event,
+                          Sc1000* engine, ScSettings* settings, InputState& input_state);
+
+//
+// ActionHandler - one action with everything resolved at load time
+//
+// The function already encodes the action and, where it matters, the edge
+// (cue press vs. release) and parameter mode (semitone vs. percent pitch
+// range). Handlers of MIDI-only actions are only bound to MIDI mappings.
+//
+struct ActionHandler {
+    ActionFn fn = nullptr;
+    Deck* deck = nullptr;
+    unsigned char deck_no = 0;
+
+    // Pre-parsed parameter, meaning depends on fn
+    unsigned int cue = 0;      // CUE, DELETECUE, ONESHOT: cue label
+    int index = 0;             // CUE: button index for combo detection, PITCH: semitone range, JOG: encoding,
+                               // ONESHOTNOTE: note
+    double value = 0.0;        // BEND: pitch ratio, GRABLOOP: seconds, LOOPROLL, STUTTER: beats
+};
+
+//
+// ActionProgram - a Mapping compiled to its handlers
+//
+// action_type first, then the Mapping's macro steps. Running it is a fixed
+// number of indirect calls, no lookup or switch.
+//
+struct ActionProgram {
+    static constexpr size_t MAX_STEPS = 1 + Mapping::MAX_MACRO;
+
+    ActionHandler steps[MAX_STEPS];
+    size_t count = 0;
+
+    void run(const MidiEvent* midi_event, Sc1000* engine, ScSettings* settings,
+             InputState& input_state) const
+    {
+        for (size_t i = 0; i < count; i++) {
+            steps[i].fn(steps[i], midi_event, engine, settings, input_state);
+        }
+    }
+};
+
+// Resolve a Mapping against the decks it can address (0=beat, 1=scratch)
+ActionProgram compile_action(const Mapping& map, Deck* beat_deck, Deck* scratch_deck);
 
 // Dispatch an input event to the appropriate deck
-void dispatch_event(const Mapping* map, const unsigned char midi_buffer[3],
+// midi_event is nullptr for GPIO events
+void dispatch_event(const Mapping* map, const MidiEvent* midi_event,
                     Sc1000* engine, ScSettings* settings,
                     InputState& input_state);
 
@@ -20,19 +20,38 @@
 
 #include "mapping_registry.h"
 
+#include <algorithm>
+
 namespace sc {
 namespace control {
 
+void MappingRegistry::bind(Deck* beat_deck, Deck* scratch_deck) {
+    beat_deck_ = beat_deck;
+    scratch_deck_ = scratch_deck;
+
+    programs_.clear();
+    for (const Mapping& m : mappings_) {
+        programs_.push_back(compile_action(m, beat_deck_, scratch_deck_));
+    }
+}
+
 void MappingRegistry::add(Mapping m) {
     size_t idx = mappings_.size();
     mappings_.push_back(m);
     index_mapping(idx);
+
+    if (beat_deck_ != nullptr) {
+        programs_.push_back(compile_action(m, beat_deck_, scratch_deck_));
+    }
 }
 
 void MappingRegistry::clear() {
     mappings_.clear();
+    programs_.clear();
     gpio_index_.clear();
-    midi_index_.clear();
+    std::fill(midi_table_.begin(), midi_table_.end(), MidiTable::NONE);
+    nrpn_index_.clear();
+    high_res_cc_.fill(0);
 }
 
 Mapping* MappingRegistry::find_gpio(uint8_t port, uint8_t pin, EventType edge) {
@@ -49,12 +68,20 @@ Mapping* MappingRegistry::find_midi(const MidiCommand& cmd, EventType edge) {
     MidiCommand normalized = cmd;
     normalized.normalize();
 
-    MidiKey key{normalized, edge};
-    auto it = midi_index_.find(key);
-    if (it != midi_index_.end()) {
+    if (normalized.is_nrpn()) {
+        uint32_t key = MidiTable::nrpn_key(normalized, edge);
+        auto it = std::lower_bound(nrpn_index_.begin(), nrpn_index_.end(),
+                                   std::make_pair(key, uint16_t{0}));
+        if (it == nrpn_index_.end() || it->first != key) return nullptr;
         return &mappings_[it->second];
     }
-    return nullptr;
+
+    size_t slot = MidiTable::slot(normalized, edge);
+    if (slot >= MidiTable::SIZE) return nullptr;
+
+    uint16_t idx = midi_table_[slot];
+    if (idx == MidiTable::NONE) return nullptr;
+    return &mappings_[idx];
 }
 
 Mapping* MappingRegistry::at(size_t index) {
@@ -65,6 +92,23 @@ const Mapping* MappingRegistry::at(size_t index) const {
     return index < mappings_.size() ? &mappings_[index] : nullptr;
 }
 
+void MappingRegistry::set_action(Mapping* map, ActionType action) {
+    map->action_type = action;
+
+    size_t idx = static_cast<size_t>(map - mappings_.data());
+    if (idx < programs_.size()) {
+        programs_[idx] = compile_action(*map, beat_deck_, scratch_deck_);
+    }
+}
+
+const ActionProgram* MappingRegistry::program(const Mapping* map) const {
+    if (mappings_.empty() || map < mappings_.data() || map >= mappings_.data() + mappings_.size()) {
+        return nullptr;
+    }
+    size_t idx = static_cast<size_t>(map - mappings_.data());
+    return idx < programs_.size() ? &programs_[idx] : nullptr;
+}
+
 void MappingRegistry::index_mapping(size_t idx) {
     const Mapping& m = mappings_[idx];
 
@@ -77,8 +121,32 @@ void MappingRegistry::index_mapping(size_t idx) {
         cmd.data1 = m.midi_command_bytes[1];
         cmd.data2 = m.midi_command_bytes[2];
 
-        MidiKey key{cmd, m.edge_type};
-        midi_index_[key] = idx;
+        if (m.high_res && cmd.is_cc() && cmd.data1 < 32) {
+            high_res_cc_[cmd.channel()] |= 1u << cmd.data1;
+        }
+
+        if (idx >= MidiTable::NONE) {
+            return;
+        }
+
+        // Like a table slot, a later mapping of the same NRPN replaces the earlier one
+        uint32_t key = MidiTable::nrpn_key(cmd, m.edge_type);
+        if (key != MidiTable::NO_KEY) {
+            auto entry = std::make_pair(key, static_cast<uint16_t>(idx));
+            auto it = std::lower_bound(nrpn_index_.begin(), nrpn_index_.end(),
+                                       std::make_pair(key, uint16_t{0}));
+            if (it != nrpn_index_.end() && it->first == key) {
+                *it = entry;
+            } else {
+                nrpn_index_.insert(it, entry);
+            }
+            return;
+        }
+
+        size_t slot = MidiTable::slot(cmd, m.edge_type);
+        if (slot < MidiTable::SIZE) {
+            midi_table_[slot] = static_cast<uint16_t>(idx);
+        }
     }
 }
 
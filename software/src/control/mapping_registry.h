@@ -22,6 +22,9 @@
 
 #include "../core/sc_input.h"
 #include "../input/midi_command.h"
+#include "actions.h"
+#include <array>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 #include <cstdint>
@@ -30,13 +33,13 @@ namespace sc {
 namespace control {
 
 //
-// ButtonState - Runtime state for a mapped button
+// ButtonState - Runtime state for a mapped GPIO pin
 //
 // Separated from Mapping (which is configuration only).
-// Stored in a map keyed by Mapping index.
+// One per scanned pin; debouncing itself is done per port in the GPIO layer.
 //
 struct ButtonState {
-    int debounce = 0;
+    int hold_ticks = 0;          // Scans since the debounced press (0 = released)
     bool shifted_at_press = false;
 };
 
@@ -62,31 +65,68 @@ struct GpioKeyHash {
 };
 
 //
-// MidiKey - Hash key for MIDI Mapping lookup
+// MidiTable - Dense MIDI Mapping lookup
 //
-struct MidiKey {
-    MidiCommand cmd;
-    EventType edge;
+// One slot per (edge, status type, channel, data1), holding a Mapping index.
+// Only unshifted/shifted press edges are looked up for MIDI. Types are the
+// channel voice messages 0x80-0xE0. 2*8*16*128 uint16 slots = 64 KB, of
+// which a controller only ever touches a few cache lines. NRPNs have 14-bit
+// parameter numbers and go to a small sorted side table instead, keyed by
+// nrpn_key().
+//
+struct MidiTable {
+    static constexpr uint16_t NONE = 0xFFFF;
+    static constexpr size_t EDGES = 2;
+    static constexpr size_t TYPES = 8;
+    static constexpr size_t CHANNELS = 16;
+    static constexpr size_t NOTES = 128;
+    static constexpr size_t SIZE = EDGES * TYPES * CHANNELS * NOTES;
+
+    static constexpr uint32_t NO_KEY = 0xFFFFFFFF;
+
+    // Index of a press edge, or EDGES if MIDI doesn't look it up
+    static size_t edge_index(EventType edge) {
+        if (edge == BUTTON_PRESSED) return 0;
+        if (edge == BUTTON_PRESSED_SHIFTED) return 1;
+        return EDGES;
+    }
+
+    // Slot for a normalized command, or SIZE if it can't be mapped
+    static size_t slot(const MidiCommand& cmd, EventType edge) {
+        size_t e = edge_index(edge);
+        if (e == EDGES) return SIZE;
+
+        if (cmd.status < 0x80 || cmd.is_nrpn()) return SIZE;
+        size_t type = static_cast<size_t>((cmd.status >> 4) - 0x8);
+
+        // Pitch bend matches on status only, data bytes are the value
+        size_t data1 = cmd.is_pitch_bend() ? 0 : (cmd.data1 & 0x7F);
 
-    bool operator==(const MidiKey& o) const {
-        return cmd == o.cmd && edge == o.edge;
+        return ((e * TYPES + type) * CHANNELS + cmd.channel()) * NOTES + data1;
     }
-};
 
-struct MidiKeyHash {
-    size_t operator()(const MidiKey& k) const {
-        return MidiCommandHash{}(k.cmd) ^ (static_cast<size_t>(k.edge) << 24);
+    // Side table key of an NRPN: edge, channel and full parameter number
+    static uint32_t nrpn_key(const MidiCommand& cmd, EventType edge) {
+        size_t e = edge_index(edge);
+        if (e == EDGES || !cmd.is_nrpn()) return NO_KEY;
+        return (static_cast<uint32_t>(e) << 18) |
+               (static_cast<uint32_t>(cmd.channel()) << 14) | cmd.nrpn_number();
     }
 };
-
 //
 // MappingRegistry - Indexed storage for input mappings
 //
 // Provides O(1) lookup by GPIO (port, pin, edge) or MIDI (command, edge).
-// Stores mappings in a vector with hash indices for fast lookup.
+// Stores mappings in a vector with a hash index for GPIO and a dense
+// table for MIDI, where a lookup is a single indexed load. Once bound to
+// the decks, every Mapping is also compiled to an ActionProgram, so
+// dispatch is a lookup plus a few indirect calls.
 //
 class MappingRegistry {
 public:
+    // Decks the compiled actions address; compiles existing mappings
+    void bind(Deck* beat_deck, Deck* scratch_deck);
+
     // Add a Mapping (updates indices automatically)
     void add(Mapping m);
 
@@ -101,6 +141,16 @@ public:
     Mapping* at(size_t index);
     const Mapping* at(size_t index) const;
 
+    // Change the action of a Mapping held by this registry, recompiling it
+    void set_action(Mapping* map, ActionType action);
+
+    // CC 0-31 mapped as 14-bit on a MIDI channel, bit n = CC n (see MidiParser)
+    uint32_t high_res_controllers(uint8_t channel) const { return high_res_cc_[channel & 0x0F]; }
+
+    // Compiled actions of a Mapping held by this registry, nullptr if the
+    // registry isn't bound or map is not one of its mappings
+    const ActionProgram* program(const Mapping* map) const;
+
     // Iteration (for init, debug, serialization)
     std::vector<Mapping>& all() { return mappings_; }
     const std::vector<Mapping>& all() const { return mappings_; }
@@ -112,7 +162,14 @@ public:
 private:
     std::vector<Mapping> mappings_;
     std::unordered_map<GpioKey, size_t, GpioKeyHash> gpio_index_;
-    std::unordered_map<MidiKey, size_t, MidiKeyHash> midi_index_;
+    std::vector<uint16_t> midi_table_ = std::vector<uint16_t>(MidiTable::SIZE, MidiTable::NONE);
+    std::vector<std::pair<uint32_t, uint16_t>> nrpn_index_;  // Sorted by key
+    std::array<uint32_t, MidiTable::CHANNELS> high_res_cc_ = {};
+
+    // Parallel to mappings_ while bound
+    std::vector<ActionProgram> programs_;
+    Deck* beat_deck_ = nullptr;
+    Deck* scratch_deck_ = nullptr;
 
     void index_mapping(size_t idx);
 };
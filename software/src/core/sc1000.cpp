@@ -18,6 +18,7 @@
  *
  */
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -39,13 +40,15 @@ void Sc1000::setup(struct Rt* rt, const char* root_path)
 {
     LOG_INFO("SC1000 engine init (root: %s)", root_path);
 
-    settings = std::make_unique<ScSettings>();
+    auto loaded = std::make_unique<ScSettings>();
     mappings.clear();
+    mappings.bind(&beat_deck, &scratch_deck);
 
     // Store root path in settings for use by other components
-    settings->root_path = root_path;
+    loaded->root_path = root_path;
 
-    sc_settings_load_user_configuration(settings.get(), mappings);
+    sc_settings_load_user_configuration(loaded.get(), mappings);
+    settings = std::move(loaded);
 
     // Verify root_path wasn't corrupted by settings loading
     LOG_DEBUG("After settings load, root_path = '%s'", settings->root_path.c_str());
@@ -66,6 +69,16 @@ void Sc1000::setup(struct Rt* rt, const char* root_path)
 
     // Initialize audio hardware (creates AudioHardware instance)
     audio = alsa_create(this, settings.get());
+    loop_writer.start();
+    cue_writer.start();
+    beat_deck.cue_writer = &cue_writer;
+    scratch_deck.cue_writer = &cue_writer;
+    folder_indexer.start(static_cast<unsigned int>(std::max(settings->index_threads, 0)));
+    if (settings->library_watch) {
+        library_watcher.start();
+    }
+    session.init(std::string(root_path) + "/session");
+    master_recorder.init(settings->sample_rate, settings->master_record_buffer_seconds);
     rt->set_engine(this);
 
     alsa_clear_config_cache();
@@ -104,32 +117,257 @@ void Sc1000::load_sample_folders()
     LOG_INFO("Loading beats from: %s", beats_path.c_str());
     LOG_INFO("Loading samples from: %s", samples_path.c_str());
 
-    beat_deck.load_folder(beats_path.c_str());
-    scratch_deck.load_folder(samples_path.c_str());
+    // Open the last session's files rather than the first ones, so the
+    // importer starts on what is about to play
+    bool resume = settings->session_restore && session.load();
+
+    // Listed in the background: the decks open their first files as soon
+    // as those are found, see collect_folders()
+    beat_deck.index_folder(folder_indexer, beats_path.c_str(), resume ? session.deck(0).path : std::string());
+    scratch_deck.index_folder(folder_indexer, samples_path.c_str(), resume ? session.deck(1).path : std::string());
+    library_watcher.watch(0, beats_path);
+    library_watcher.watch(1, samples_path);
+    collect_folders();
+
+    if (resume) {
+        restore_session();
+    }
+}
+
+void Sc1000::collect_folders()
+{
+    beat_deck.take_folders(folder_indexer, settings.get());
 
-    if (!scratch_deck.nav_state.files_present) {
+    if (scratch_deck.take_folders(folder_indexer, settings.get())) {
         // Load the default sentence if no sample files found on usb stick
         scratch_deck.player.set_track(
                          track_acquire_by_import(scratch_deck.importer.c_str(), "/var/scratchsentence.mp3"));
         LOG_DEBUG("Set default track ok");
-        scratch_deck.cues.load_from_file(scratch_deck.player.track->path);
+        scratch_deck.load_cues();
         LOG_DEBUG("Set cues ok");
         // Set the time back a bit so the sample doesn't start too soon
         scratch_deck.player.input.seek_to = -4.0;
         scratch_deck.player.input.target_position = -4.0;
     }
+
+    // Folders changed on the stick since, once a deck's first listing is in
+    Deck* decks[2] = {&beat_deck, &scratch_deck};
+    for (int d = 0; d < 2; d++) {
+        if (decks[d]->indexing) continue;
+        if (std::unique_ptr<Playlist> next = library_watcher.take(d)) {
+            decks[d]->swap_playlist(std::move(next));
+        }
+    }
+}
+
+void Sc1000::restore_session()
+{
+    Deck* decks[2] = {&beat_deck, &scratch_deck};
+
+    for (int d = 0; d < 2; d++) {
+        Deck* deck = decks[d];
+        const sc::DeckSession& saved = session.deck(d);
+
+        // Mapped, not read: the loop plays as soon as the audio thread runs.
+        // The deck gets a reference of its own, the session keeps its mapping
+        Track* loop = audio ? session.map_loop(d, static_cast<int>(audio->sample_rate())) : nullptr;
+        if (loop) track_acquire(loop);
+        bool has_loop = loop && audio->adopt_loop(d, loop);
+        if (loop && !has_loop) track_release(loop);
+        if (has_loop) {
+            session.saved_version[d] = audio->loop_version(d);
+        }
+
+        bool same_file = deck->player.track && deck->player.track->path &&
+                         saved.path == deck->player.track->path;
+        if (saved.at_loop ? !has_loop : !same_file) {
+            continue;
+        }
+
+        if (saved.at_loop) {
+            deck->nav_state.file_idx = -1;
+            deck->player.input.source = sc::PlaybackSource::Loop;
+        }
+
+        for (const auto& [label, position] : saved.cues) {
+            deck->cues.set(label, position);
+        }
+        session.pending_seek[d] = saved.position;
+
+        LOG_INFO("Session: deck %d back at %.1f s of %s", d, saved.position,
+                 saved.at_loop ? "its loop" : saved.path.c_str());
+    }
+}
+
+// What a deck would restore to
+static sc::DeckSession deck_session(Sc1000* engine, const Deck* deck)
+{
+    sc::DeckSession saved;
+    const Track* track = deck->player.track;
+
+    if (track && track->path) {
+        saved.path = track->path;
+    }
+    saved.at_loop = deck->player.input.source == sc::PlaybackSource::Loop;
+    saved.has_loop = engine->audio->has_loop(deck->deck_no);
+    saved.position = std::max(engine->audio->get_position(deck->deck_no), 0.0);
+    saved.cues = deck->cues.all();
+    return saved;
+}
+
+void Sc1000::update_session(double now)
+{
+    if (!audio) return;
+
+    Deck* decks[2] = {&beat_deck, &scratch_deck};
+
+    // A restored position is applied once the file is decoded that far
+    for (int d = 0; d < 2; d++) {
+        double position = session.pending_seek[d];
+        if (position < 0.0) continue;
+
+        const Track* track = decks[d]->player.track;
+        bool ready = decks[d]->player.input.source == sc::PlaybackSource::Loop || !track ||
+                     !track->is_importing() || track->length >= position * track->rate;
+        if (ready) {
+            decks[d]->seek(position, this);
+            session.pending_seek[d] = -1.0;
+        }
+    }
+
+    int interval = settings->session_save_seconds;
+    if (interval <= 0 || session.folder().empty()) return;
+
+    if (session.next_save == 0.0) {
+        session.next_save = now + interval;
+    } else if (now >= session.next_save) {
+        session.next_save = now + interval;
+        save_session(false);
+    }
+}
+
+void Sc1000::save_session(bool final)
+{
+    if (!audio || session.folder().empty()) return;
+
+    Deck* decks[2] = {&beat_deck, &scratch_deck};
+    sc::DeckSession state[2] = {deck_session(this, decks[0]), deck_session(this, decks[1])};
+
+    // Loops changed since they were last written, and not being recorded
+    // into. While running, only with the writer idle: then no earlier save
+    // is still attached and the audio thread won't refuse this one
+    bool writer_idle = loop_writer.pending() == 0;
+    for (int d = 0; d < 2; d++) {
+        unsigned int version = audio->loop_version(d);
+        if (!state[d].has_loop || version == session.saved_version[d] || audio->is_recording(d)) {
+            continue;
+        }
+
+        if (final) {
+            if (session.write_loop(d, audio->peek_loop_track(d))) {
+                session.saved_version[d] = version;
+            }
+        } else if (writer_idle && decks[d]->player.input.session_snapshot == nullptr) {
+            Track* loop = audio->get_loop_track(d);
+            sc::audio::LoopSnapshot* snapshot = loop ? loop_writer.request_raw(d, loop, session.loop_path(d)) : nullptr;
+            if (snapshot) {
+                decks[d]->player.input.session_snapshot = snapshot;
+                session.saved_version[d] = version;
+            }
+        }
+    }
+
+    std::string json = sc::Session::to_json(state);
+    if (!final) {
+        loop_writer.request_file(session.state_path(), std::move(json));
+        return;
+    }
+
+    if (session.write_state(json)) {
+        LOG_INFO("Session saved to %s", session.folder().c_str());
+    }
 }
 
 void Sc1000::clear()
 {
+    // The audio thread has stopped. Loops the writer had not finished with
+    // are written again, then the session goes straight to disk. A snapshot
+    // still attached is left to the engine, which detaches it on reset
+    if (loop_writer.pending() > 0) {
+        session.saved_version[0] = session.saved_version[1] = ~0u;
+    }
+    library_watcher.stop();
+    folder_indexer.stop();
+    loop_writer.stop();
+    cue_writer.stop();
+    collect_saved_loops();
+    save_session(true);
+
     beat_deck.clear();
     scratch_deck.clear();
 
     // Audio hardware cleaned up automatically via unique_ptr
     audio.reset();
 
-    // Settings cleaned up automatically via unique_ptr
-    settings.reset();
+    // Only now the engine holds none of the restored loops
+    session.release_loops();
+    sampler.clear();
+
+    // Finishes the file of a recording still running
+    master_recorder.shutdown();
+}
+
+bool Sc1000::reload_settings()
+{
+    auto next = std::make_unique<ScSettings>();
+
+    sc::control::MappingRegistry next_mappings;
+    next_mappings.bind(&beat_deck, &scratch_deck);
+
+    if (!sc_settings_reload(settings.get(), next.get(), next_mappings)) {
+        return false;
+    }
+
+    // Mappings are only read on the input thread, which is the caller
+    mappings = std::move(next_mappings);
+    settings.publish(std::move(next));
+
+    LOG_INFO("Settings reloaded from %s (%zu mappings)",
+             settings->settings_path.c_str(), mappings.size());
+    return true;
+}
+
+void Sc1000::collect_saved_loops()
+{
+    for (const auto& saved : loop_writer.take_saved()) {
+        Deck& deck = (saved.deck == 0) ? beat_deck : scratch_deck;
+        deck.add_file(saved.folder, saved.path);
+    }
+
+    // Loops the writer took a snapshot of, referenced since the save was queued
+    for (Track* source : loop_writer.take_released()) {
+        track_release(source);
+    }
+}
+
+void Sc1000::check_latency_calibration()
+{
+    if (!audio) return;
+
+    sc::audio::LatencyCalibration cal = audio->latency_calibration();
+    if (cal.runs == latency_runs) return;
+    latency_runs = cal.runs;
+
+    sc::DeckInput& input = beat_deck.player.input;
+    if (cal.state == sc::audio::LatencyCalibration::State::Done) {
+        LOG_INFO("Round-trip latency %d frames (%.1f ms), recordings aligned to it. "
+                 "Set \"latency_frames\": %d for this audio device to keep it",
+                 cal.frames, 1000.0 * cal.frames / audio->sample_rate(), cal.frames);
+        input.beep_request = sc::BeepType::RecordingStop;
+    } else {
+        LOG_WARN("Latency calibration failed: no clear clicks on the input, is the output patched to it?");
+        input.beep_request = sc::BeepType::RecordingError;
+    }
 }
 
 void Sc1000::audio_start()
@@ -156,14 +394,13 @@ ssize_t Sc1000::audio_pollfds(struct pollfd* pe, size_t z)
 
 void Sc1000::audio_handle()
 {
-    if (fault || !audio) {
-        return;
-    }
-
-    if (audio->handle() != 0) {
+    if (!fault && audio && audio->handle() != 0) {
         fault = true;
         LOG_ERROR("Error handling audio device; disabling it");
     }
+
+    // Done with this block's settings snapshot
+    settings.quiescent();
 }
 
 // Helper to handle recording for a single deck
@@ -217,6 +454,55 @@ static void handle_single_deck_recording(Sc1000* engine, Deck* dk, int deck_no)
             LOG_DEBUG("Recording stopped on deck %d, navigated to loop (position 0)", deck_no);
         }
     }
+
+    // Handle save request: snapshot the loop for the writer thread
+    if (pl->input.save_snapshot) {
+        sc::audio::LoopSnapshot* snapshot = pl->input.save_snapshot;
+        pl->input.save_snapshot = nullptr;  // Clear one-shot request
+
+        if (engine->audio->snapshot_loop(deck_no, snapshot)) {
+            pl->input.beep_request = sc::BeepType::RecordingStop;
+            LOG_DEBUG("Saving loop of deck %d", deck_no);
+        } else {
+            pl->input.beep_request = sc::BeepType::RecordingError;
+        }
+    }
+
+    // Handle session save request: as above, but in the background
+    if (pl->input.session_snapshot) {
+        sc::audio::LoopSnapshot* snapshot = pl->input.session_snapshot;
+        pl->input.session_snapshot = nullptr;  // Clear one-shot request
+
+        engine->audio->snapshot_loop(deck_no, snapshot);
+    }
+
+    // Handle latency calibration request, reported by check_latency_calibration()
+    if (pl->input.calibrate_latency) {
+        pl->input.calibrate_latency = false;  // Clear one-shot request
+
+        if (!engine->audio->has_capture() || !engine->audio->calibrate_latency()) {
+            pl->input.beep_request = sc::BeepType::RecordingError;
+        }
+    }
+
+    // Handle grab request: the recent input becomes the loop
+    if (pl->input.grab_seconds >= 0.0) {
+        double seconds = pl->input.grab_seconds;
+        pl->input.grab_seconds = -1.0;  // Clear one-shot request
+
+        if (engine->audio->grab_loop(deck_no, seconds)) {
+            dk->nav_state.file_idx = -1;
+            pl->input.source = sc::PlaybackSource::Loop;
+            pl->input.seek_to = 0.0;
+            pl->input.target_position = 0.0;
+            pl->input.position_offset = 0.0;
+            pl->input.beep_request = sc::BeepType::RecordingStop;
+            LOG_DEBUG("Grabbed %.1f s of input as loop on deck %d", seconds, deck_no);
+        } else {
+            pl->input.beep_request = sc::BeepType::RecordingError;
+            LOG_DEBUG("Failed to grab input on deck %d", deck_no);
+        }
+    }
 }
 
 void Sc1000::handle_deck_recording()
@@ -22,11 +22,20 @@
 #pragma once
 
 #include "../player/deck.h"
+#include "../player/cue_writer.h"
+#include "../player/folder_indexer.h"
+#include "../player/library_watcher.h"
 #include "../platform/crossfader.h"
 #include "../control/mapping_registry.h"
 #include "../control/input_state.h"
 #include "../engine/deck_processing_state.h"
 #include "sc_input.h"
+#include "settings_store.h"
+#include "../engine/loop_writer.h"
+#include "../engine/master_recorder.h"
+#include "../engine/latency_probe.h"
+#include "../engine/sampler.h"
+#include "session.h"
 #include <memory>
 
 struct ScSettings;
@@ -51,7 +60,14 @@ public:
     virtual bool is_recording(int deck) const = 0;
     virtual bool has_loop(int deck) const = 0;
     virtual bool has_capture() const = 0;
-    virtual void reset_loop(int deck) = 0;
+    virtual void reset_loop(int deck) = 0;  // Audio thread, see DeckInput::loop_erase
+    virtual bool grab_loop(int deck, double seconds) = 0;
+    virtual bool adopt_loop(int deck, Track* track) = 0;
+    virtual void collect_loops() = 0;
+    virtual unsigned int loop_version(int deck) const = 0;
+    virtual bool snapshot_loop(int deck, sc::audio::LoopSnapshot* snapshot) = 0;
+    virtual bool calibrate_latency() = 0;
+    virtual sc::audio::LatencyCalibration latency_calibration() const = 0;
     virtual Track* get_loop_track(int deck) = 0;
     virtual Track* peek_loop_track(int deck) = 0;
 
@@ -67,7 +83,8 @@ struct Sc1000
     struct Deck scratch_deck;
     struct Deck beat_deck;
 
-    std::unique_ptr<ScSettings> settings;
+    // Current settings snapshot, swapped as a whole on reload
+    sc::SettingsStore settings;
 
     // Input mappings (GPIO and MIDI) with indexed lookup
     sc::control::MappingRegistry mappings;
@@ -78,6 +95,30 @@ struct Sc1000
     // Crossfader input (handles ADC conversion and calibration)
     Crossfader crossfader;
 
+    // Lists the decks' folders in the background for the input thread to take in
+    FolderIndexer folder_indexer;
+
+    // Builds the decks' playlists again when their folders change on the stick
+    LibraryWatcher library_watcher;
+
+    // Writes the decks' .cue files, off the input thread
+    CueWriter cue_writer;
+
+    // Saves loops to disk in the background. Declared before audio so it
+    // outlives the engine, which may still hold one of its snapshots
+    sc::audio::LoopWriter loop_writer;
+
+    // Records the output mix to disk, fed by the audio thread
+    sc::audio::MasterRecorder master_recorder;
+
+    // One-shot voices over the decks. Declared before audio so it outlives
+    // the engine, which renders its voices
+    sc::audio::Sampler sampler;
+
+    // Last session, saved through loop_writer. Declared before audio so
+    // the loops it restored outlive the engine
+    sc::Session session;
+
     // Audio hardware (ALSA implementation)
     std::unique_ptr<AudioHardware> audio;
     bool fault = false;
@@ -85,6 +126,35 @@ struct Sc1000
     // Setup and lifecycle
     void setup(struct Rt* rt, const char* root_path);
     void load_sample_folders();
+
+    // Re-read the settings file into a new snapshot and new mappings.
+    // Input thread only. Returns false (keeping the current ones) on error.
+    bool reload_settings();
+
+    // Add loops the writer has finished to the decks' playlists and release
+    // the loops it no longer reads (input thread)
+    void collect_saved_loops();
+
+    // Add folders listed in the background to the decks' playlists, opening
+    // a deck's first file once there is one, and swap in playlists built
+    // again after a change on the stick (input thread)
+    void collect_folders();
+
+    // Put the decks back as the last session left them (at boot, before
+    // the audio thread runs)
+    void restore_session();
+
+    // Apply restored positions once their files are decoded, and save the
+    // session every session_save_seconds (input thread)
+    void update_session(double now);
+
+    // Save the session: in the background while running, or with final once
+    // the audio thread has stopped, straight to disk
+    void save_session(bool final);
+
+    // Report a finished latency calibration (input thread)
+    void check_latency_calibration();
+    unsigned int latency_runs = 0;
     void clear();
 
     // Audio hardware control (delegates to AudioHardware interface)
@@ -22,17 +22,26 @@
 // Manages the input thread and coordinates hardware and MIDI input layers
 // This file should be hardware-agnostic - all SC1000-specific code is in sc_hardware.cpp
 
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <unistd.h>
-#include <sys/time.h>
 #include <ctime>
 #include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
 
 #include "../platform/sc_hardware.h"
+#include "../input/midi_event.h"
 #include "../input/midi_input.h"
 
 #include "global.h"
 #include "sc_input.h"
+#include "sc_settings.h"
 #include "../util/log.h"
 
 namespace sc {
@@ -40,6 +49,22 @@ namespace input {
 
 using namespace sc::platform;
 
+/*
+ * Per-second timing statistics of the input loop, replacing the old
+ * FPS counter. Period and jitter are measured between timer wakeups,
+ * overruns count timer expirations that were missed entirely.
+ */
+struct InputLoopStats {
+    unsigned int ticks = 0;
+    unsigned int overruns = 0;
+    unsigned int midi_wakeups = 0;
+    int64_t period_sum_ns = 0;
+    int64_t period_max_ns = 0;
+    int64_t jitter_max_ns = 0;
+
+    void reset() { *this = InputLoopStats(); }
+};
+
 /*
  * InputContext holds all mutable state for the input thread.
  * Combines hardware and MIDI contexts into a single coordinator.
@@ -50,6 +75,11 @@ struct InputContext {
 
     // MIDI input layer (controllers, events)
     MidiContext midi;
+
+    InputLoopStats stats;
+
+    // Modification time of the settings file at the last (re)load
+    struct timespec settings_mtime = {};
 };
 
 // Singleton input context
@@ -59,10 +89,130 @@ static InputContext g_input_ctx;
 static volatile bool g_input_running = true;
 static pthread_t g_input_thread_handle;
 
+// Set by request_sc_settings_reload(), e.g. from a SIGHUP handler
+static std::atomic<bool> g_reload_requested{false};
+
+static int64_t timespec_to_ns(const struct timespec& ts)
+{
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static int64_t monotonic_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return timespec_to_ns(ts);
+}
+
+/*
+ * Run the input thread with SCHED_FIFO one step below the audio thread,
+ * so platter sampling preempts housekeeping but never the DSP.
+ */
+static void raise_input_priority(int rt_priority)
+{
+    if (rt_priority <= 1) {
+        return;  // Audio thread is not realtime, stay below it
+    }
+
+    struct sched_param sp;
+    sp.sched_priority = rt_priority - 1;
+
+    int r = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+    if (r != 0) {
+        LOG_WARN("Input thread: cannot set SCHED_FIFO priority %d: %s",
+                 sp.sched_priority, strerror(r));
+        return;
+    }
+
+    LOG_INFO("Input thread: SCHED_FIFO priority %d", sp.sched_priority);
+}
+
+/*
+ * Arm a periodic timer on absolute CLOCK_MONOTONIC deadlines. The kernel
+ * keeps the phase, so a late wakeup does not push later samples back.
+ */
+static int start_input_timer(int period_us)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd == -1) {
+        LOG_ERROR("timerfd_create: %s", strerror(errno));
+        return -1;
+    }
+
+    int64_t period_ns = static_cast<int64_t>(period_us) * 1000;
+    int64_t first_ns = monotonic_ns() + period_ns;
+
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = period_ns / 1000000000LL;
+    spec.it_interval.tv_nsec = period_ns % 1000000000LL;
+    spec.it_value.tv_sec = first_ns / 1000000000LL;
+    spec.it_value.tv_nsec = first_ns % 1000000000LL;
+
+    if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr) == -1) {
+        LOG_ERROR("timerfd_settime: %s", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void log_loop_stats(InputLoopStats* stats)
+{
+    double avg_us = stats->ticks > 0
+        ? static_cast<double>(stats->period_sum_ns) / stats->ticks / 1000.0
+        : 0.0;
+
+    LOG_STATS("Input: %04u Hz, %.0fus (max %.0fus, jitter %.0fus, overruns %u, midi %u) - ",
+              stats->ticks, avg_us,
+              static_cast<double>(stats->period_max_ns) / 1000.0, static_cast<double>(stats->jitter_max_ns) / 1000.0,
+              stats->overruns, stats->midi_wakeups);
+
+    stats->reset();
+}
+
+/*
+ * Report whether the settings file changed since the last call. Checked once
+ * a second; a half-written file fails to parse and is retried when the
+ * write completes and bumps the time again.
+ */
+static bool settings_file_changed(Sc1000* engine, InputContext* ctx)
+{
+    struct stat st;
+    if (stat(engine->settings->settings_path.c_str(), &st) == -1) {
+        return false;
+    }
+
+    bool changed = st.st_mtim.tv_sec != ctx->settings_mtime.tv_sec ||
+                   st.st_mtim.tv_nsec != ctx->settings_mtime.tv_nsec;
+    ctx->settings_mtime = st.st_mtim;
+    return changed;
+}
+
+/*
+ * Swap in a new settings snapshot and mappings, then rebuild what the
+ * hardware and MIDI layers derived from them. Runs between ticks, so no
+ * pointer into the old mappings is live.
+ */
+static void reload_settings(Sc1000* engine, InputContext* ctx)
+{
+    if (!engine->reload_settings()) {
+        return;
+    }
+
+    ctx->hardware->reload(engine);
+
+    for (const auto& controller : ctx->midi.controllers) {
+        controller->feedback().set_rate(engine->settings->midi_feedback_rate);
+        controller->set_high_res(engine->mappings);
+    }
+}
+
 void* run_sc_input_thread(Sc1000* engine)
 {
     ScSettings* settings = engine->settings.get();
     MidiContext* midi_ctx = &g_input_ctx.midi;
+    InputLoopStats* stats = &g_input_ctx.stats;
 
     // Create and initialize hardware layer
     g_input_ctx.hardware = create_hardware();
@@ -71,59 +221,158 @@ void* run_sc_input_thread(Sc1000* engine)
     // Initialize MIDI layer
     init_midi(midi_ctx);
 
+    // Settings may be replaced while running, keep the boot-time values
+    const unsigned int midi_init_delay = settings->midi_init_delay;
+    settings_file_changed(engine, &g_input_ctx);
+
     // Seed random number generator (used for random file selection)
     srand(static_cast<unsigned int>(time(nullptr)));
 
-    struct timeval tv;
-    time_t last_time = 0;
-    unsigned int frame_count = 0;
     unsigned int second_count = 0;
 
     // Give hardware time to stabilize
     sleep(2);
 
+    raise_input_priority(settings->rt_priority);
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    int timer_fd = start_input_timer(settings->update_rate);
+    int midi_fd = midi_event_queue_fd();
+
+    if (epfd == -1 || timer_fd == -1) {
+        LOG_ERROR("Input thread: cannot set up event loop");
+        exit(EXIT_FAILURE);
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = timer_fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, timer_fd, &ev);
+
+    if (midi_fd != -1) {
+        ev.data.fd = midi_fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, midi_fd, &ev);
+    } else {
+        LOG_WARN("Input thread: no MIDI eventfd, MIDI handled on timer ticks only");
+    }
+
+    const int64_t period_ns = static_cast<int64_t>(settings->update_rate) * 1000;
+    int64_t last_tick_ns = 0;
+    int64_t next_second_ns = monotonic_ns() + 1000000000LL;
+
     while (g_input_running)
     {
-        frame_count++;
+        // Free settings snapshots the audio thread has moved past
+        engine->settings.reclaim();
 
-        // Once per second: log stats, poll for new MIDI devices
-        gettimeofday(&tv, nullptr);
-        if (tv.tv_sec != last_time)
-        {
-            last_time = tv.tv_sec;
-            // Log hardware and DSP stats
-            LOG_STATS("FPS: %06u - ", frame_count);
-            g_input_ctx.hardware->log_stats(engine);
-            frame_count = 0;
-
-            // Debug: list connected MIDI controllers
-            for (const auto& controller : midi_ctx->controllers)
-            {
-                LOG_DEBUG("MIDI : %s", controller->port_name());
+        if (g_reload_requested.exchange(false)) {
+            reload_settings(engine, &g_input_ctx);
+        }
+
+        struct epoll_event events[2];
+        int n = epoll_wait(epfd, events, 2, 100);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
             }
+            LOG_ERROR("epoll_wait: %s", strerror(errno));
+            break;
+        }
+
+        bool tick = false;
 
-            // Poll for new MIDI devices after init delay
-            if (second_count < settings->midi_init_delay)
+        for (int i = 0; i < n; i++)
+        {
+            if (events[i].data.fd == timer_fd)
             {
-                second_count++;
+                uint64_t expirations = 0;
+                if (read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations)
+                    && expirations > 0) {
+                    stats->overruns += static_cast<unsigned int>(expirations - 1);
+                    tick = true;
+                }
             }
-            else if (second_count == settings->midi_init_delay)
+            else if (events[i].data.fd == midi_fd)
             {
-                poll_midi_devices(midi_ctx, engine);
-                second_count = 999;  // Don't poll again
+                midi_event_queue_clear_signal();
+                stats->midi_wakeups++;
             }
         }
 
-        // Poll hardware inputs (PIC, GPIO, encoder)
-        g_input_ctx.hardware->poll(engine);
+        if (tick)
+        {
+            int64_t now_ns = monotonic_ns();
+            if (last_tick_ns != 0) {
+                int64_t period = now_ns - last_tick_ns;
+                int64_t jitter = period > period_ns ? period - period_ns : period_ns - period;
+                stats->period_sum_ns += period;
+                if (period > stats->period_max_ns) stats->period_max_ns = period;
+                if (jitter > stats->jitter_max_ns) stats->jitter_max_ns = jitter;
+            }
+            last_tick_ns = now_ns;
+            stats->ticks++;
+
+            // Poll hardware inputs (PIC, GPIO, encoder)
+            g_input_ctx.hardware->poll(engine);
+            update_jog_wheels(engine);
+
+            // Mirror deck state to MIDI controller LEDs, paced per port
+            update_midi_feedback(midi_ctx, engine);
+
+            // Loops saved and folders listed in the background join the playlists
+            engine->collect_saved_loops();
+            engine->collect_folders();
+            engine->sampler.collect();
+            engine->beat_deck.collect_cues();
+            engine->scratch_deck.collect_cues();
+            if (engine->audio) engine->audio->collect_loops();
+            engine->check_latency_calibration();
+            engine->update_session(static_cast<double>(now_ns) / 1e9);
+
+            // Once per second: log stats, poll for new MIDI devices
+            if (now_ns >= next_second_ns)
+            {
+                next_second_ns += 1000000000LL;
+                if (next_second_ns <= now_ns) {
+                    next_second_ns = now_ns + 1000000000LL;
+                }
+
+                // Log input loop, hardware and DSP stats
+                log_loop_stats(stats);
+                g_input_ctx.hardware->log_stats(engine);
+
+                // Debug: list connected MIDI controllers
+                for (const auto& controller : midi_ctx->controllers)
+                {
+                    LOG_DEBUG("MIDI : %s", controller->port_name());
+                }
+
+                // Edited settings file: reload before the next tick
+                if (settings_file_changed(engine, &g_input_ctx))
+                {
+                    g_reload_requested = true;
+                }
+
+                // Poll for new MIDI devices after init delay
+                if (second_count < midi_init_delay)
+                {
+                    second_count++;
+                }
+                else if (second_count == midi_init_delay)
+                {
+                    poll_midi_devices(midi_ctx, engine);
+                    second_count = 999;  // Don't poll again
+                }
+            }
+        }
 
         // Process MIDI events from the lock-free queue
         process_midi_events(engine);
-
-        // Rate limit input loop
-        usleep(settings->update_rate);
     }
 
+    close(timer_fd);
+    close(epfd);
+
     return nullptr;
 }
 
@@ -160,3 +409,8 @@ void stop_sc_input_thread()
     pthread_join(sc::input::g_input_thread_handle, nullptr);
     LOG_INFO("Input thread stopped");
 }
+
+void request_sc_settings_reload()
+{
+    sc::input::g_reload_requested = true;
+}
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 
 #define CONTROL_NOTE 1
 #define CONTROL_CC 2
@@ -51,6 +52,7 @@ enum MIDIStatusType
    MIDI_NOTE_ON = 9,
    MIDI_CC = 11,
    MIDI_PB = 14,
+   MIDI_NRPN = 15,  // Assembled from CC 99/98/6/38, see MidiCommand::NRPN
 };
 
 enum ActionType
@@ -83,6 +85,21 @@ enum ActionType
    JOGPSTOP,
    JOGREVERSE,
    BEND,
+   JOG,          // Relative jog wheel CC, parameter = encoding (see MidiCommand::relative_delta)
+   JOGTOUCH,     // Jog wheel touch sensor (note on/off or CC >= 64)
+   GRABLOOP,     // Recent input becomes the loop, parameter = seconds (0 = all kept)
+   SAVELOOP,     // Write the loop to a WAV file in the deck's "loops" folder
+   MASTERRECORD, // Start/stop recording the output mix to the "recordings" folder
+   CALIBRATELATENCY, // Measure round-trip latency with the output patched to the input
+   LOOPROLL,     // Loop roll while held, parameter = slices per beat (0 = one beat)
+   LOOPROLLSTOP, // Let go of a loop roll (GPIO release)
+   ONESHOT,      // Sampler voice from cue parameter to the next cue (0 = track start)
+   ONESHOTNOTE,  // Sampler voice of the whole track or loop, pitched by the note
+   STUTTER,      // Beat repeat while held, parameter = repeats per beat (0 = one beat)
+   STUTTERSTOP,  // Let go of a beat repeat (GPIO release)
+   SEARCH,       // Add a character to the deck's search, parameter = its ASCII code (32 = space)
+   SEARCHBACK,   // Take the last character off the search
+   SEARCHCLEAR,  // End the search, back to the folders
    NOTHING,
 };
 
@@ -101,13 +118,19 @@ struct Mapping {
 
    // MIDI event info
    std::array<unsigned char, 3> midi_command_bytes = {0, 0, 0};
+   bool high_res = false;            // CC 0-31 sent with an LSB on CC 32-63
 
    // Action
    unsigned char   deck_no = 0;      // Which deck to apply this action to
    ActionType action_type = ActionType::NOTHING;  // The action to take - cue, shift etc
    unsigned char   parameter = 0;    // for example the output note
 
-   // Runtime state (debounce, shifted_at_press) is stored separately in ButtonState
+   // Macro: further actions fired in order after action_type, on the same
+   // deck with the same parameter. Unused steps are NOTHING.
+   static constexpr size_t MAX_MACRO = 3;
+   std::array<ActionType, MAX_MACRO> macro = {NOTHING, NOTHING, NOTHING};
+
+   // Runtime state (hold timing, shifted_at_press) is stored per pin in ButtonState
    // See sc::control::ButtonState in control/mapping_registry.h
 };
 
@@ -118,6 +141,9 @@ extern "C" {
 void start_sc_input_thread();
 void stop_sc_input_thread();
 
+// Ask the input thread to reload sc_settings.json (async-signal-safe)
+void request_sc_settings_reload();
+
 #ifdef __cplusplus
 }
 #endif
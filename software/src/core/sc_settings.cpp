@@ -52,6 +52,7 @@ NLOHMANN_JSON_SERIALIZE_ENUM( MIDIStatusType, {
     {MIDIStatusType::MIDI_NOTE_OFF, "midi_note_off"},
     {MIDIStatusType::MIDI_CC, "midi_cc"},
     {MIDIStatusType::MIDI_PB, "midi_pb"},
+    {MIDIStatusType::MIDI_NRPN, "midi_nrpn"},
 })
 
 NLOHMANN_JSON_SERIALIZE_ENUM( ActionType, {
@@ -83,6 +84,21 @@ NLOHMANN_JSON_SERIALIZE_ENUM( ActionType, {
    {ActionType::JOGPSTOP, "jog_pstop"},
    {ActionType::JOGREVERSE, "jog_reverse"},
    {ActionType::BEND, "bend"},
+   {ActionType::JOG, "jog"},
+   {ActionType::JOGTOUCH, "jog_touch"},
+   {ActionType::GRABLOOP, "grab_loop"},
+   {ActionType::SAVELOOP, "save_loop"},
+   {ActionType::MASTERRECORD, "master_record"},
+   {ActionType::CALIBRATELATENCY, "calibrate_latency"},
+   {ActionType::LOOPROLL, "loop_roll"},
+   {ActionType::LOOPROLLSTOP, "loop_roll_stop"},
+   {ActionType::ONESHOT, "one_shot"},
+   {ActionType::ONESHOTNOTE, "one_shot_note"},
+   {ActionType::STUTTER, "stutter"},
+   {ActionType::STUTTERSTOP, "stutter_stop"},
+   {ActionType::SEARCH, "search"},
+   {ActionType::SEARCHBACK, "search_back"},
+   {ActionType::SEARCHCLEAR, "search_clear"},
    {ActionType::NOTHING, "nothing"},
 })
 
@@ -111,7 +127,9 @@ namespace config {
 // Default importer path
 constexpr const char* DEFAULT_IMPORTER_PATH = "/root/sc1000-import";
 
-void add_mapping(sc::control::MappingRegistry& registry, IOType type, unsigned char deck_no, unsigned char *buf, unsigned char port, unsigned char pin, bool pullup, EventType edge_type, ActionType action, unsigned char parameter)
+using MacroSteps = std::array<ActionType, Mapping::MAX_MACRO>;
+
+void add_mapping(sc::control::MappingRegistry& registry, IOType type, unsigned char deck_no, unsigned char *buf, unsigned char port, unsigned char pin, bool pullup, EventType edge_type, ActionType action, unsigned char parameter, const MacroSteps& macro = {NOTHING, NOTHING, NOTHING}, bool high_res = false)
 {
    Mapping new_map{};
 
@@ -120,7 +138,7 @@ void add_mapping(sc::control::MappingRegistry& registry, IOType type, unsigned c
    new_map.gpio_port = port;
    new_map.pullup    = pullup;
 
-   // Runtime state (debounce, shifted_at_press) is managed separately in ButtonState
+   // Runtime state (hold timing, shifted_at_press) is managed per pin in ButtonState
 
    if (buf != nullptr)
    {
@@ -128,10 +146,12 @@ void add_mapping(sc::control::MappingRegistry& registry, IOType type, unsigned c
       new_map.midi_command_bytes[1] = buf[1];
       new_map.midi_command_bytes[2] = buf[2];
    }
+   new_map.high_res = high_res;
 
    new_map.edge_type = edge_type;
    new_map.action_type = action;
    new_map.parameter = parameter;
+   new_map.macro = macro;
 
    new_map.deck_no = deck_no;
 
@@ -150,8 +170,13 @@ void settings_from_json(ScSettings* settings, const nlohmann::json& json)
    settings->fader_close_point = json.value("fader_close_point", 2);
    settings->fader_open_point = json.value("fader_open_point", 10);
    settings->update_rate = json.value("update_rate", 2000);
+   settings->rt_priority = json.value("rt_priority", 0);
    settings->platter_enabled = json.value("platter_enabled", true);
    settings->platter_speed = json.value("platter_speed", 2275);
+   settings->platter_estimator = json.value("platter_estimator", true);
+   settings->midi_jog_speed = json.value("midi_jog_speed", 1024);
+   settings->midi_feedback = json.value("midi_feedback", false);
+   settings->midi_feedback_rate = json.value("midi_feedback_rate", 1000);
    settings->debounce_time = json.value("debounce_time", 5);
    settings->hold_time = json.value("hold_time", 100);
    settings->slippiness = json.value("slippiness", 200);
@@ -174,12 +199,66 @@ void settings_from_json(ScSettings* settings, const nlohmann::json& json)
 
    // Loop recording settings
    settings->loop_max_seconds = json.value("loop_max_seconds", 60);
+   settings->loop_pool_seconds = json.value("loop_pool_seconds", 0);
+   settings->capture_ring_seconds = json.value("capture_ring_seconds", 20);
+   settings->loop_overdub = json.value("loop_overdub", false);
+   settings->loop_feedback = json.value("loop_feedback", 0.8);
+   settings->loop_quantize = json.value("loop_quantize", false);
+   settings->loop_bpm = json.value("loop_bpm", 0.0);
+   settings->loop_crossfade_ms = json.value("loop_crossfade_ms", 4.0);
+
+   // Master recording settings
+   settings->master_record_buffer_seconds = json.value("master_record_buffer_seconds", 4);
+   settings->master_record_input = json.value("master_record_input", false);
+
+   // Sampler settings
+   settings->sampler_voices = json.value("sampler_voices", 8);
+   settings->sampler_volume = json.value("sampler_volume", 0.8);
+   settings->sampler_budget_percent = json.value("sampler_budget_percent", 25.0);
+
+   // Session settings
+   settings->index_threads = json.value("index_threads", 2);
+   settings->library_watch = json.value("library_watch", true);
+   settings->session_restore = json.value("session_restore", true);
+   settings->session_save_seconds = json.value("session_save_seconds", 30);
 
    // Crossfader ADC calibration
    settings->crossfader_adc_min = json.value("crossfader_adc_min", 0);
    settings->crossfader_adc_max = json.value("crossfader_adc_max", 1023);
 }
 
+// "action" is one action name, or a list of up to 1 + MAX_MACRO names
+// fired in order (e.g. ["stop", "cue"]). Returns the first, the rest go
+// to macro.
+ActionType actions_from_json(const nlohmann::json& json, MacroSteps* macro)
+{
+   macro->fill(ActionType::NOTHING);
+
+   const nlohmann::json& actions = json["action"];
+   if (!actions.is_array())
+   {
+      return actions.template get<ActionType>();
+   }
+
+   if (actions.empty())
+   {
+      return ActionType::NOTHING;
+   }
+
+   if (actions.size() > 1 + Mapping::MAX_MACRO)
+   {
+      LOG_WARN("Mapping macro has %zu actions, only the first %zu are used",
+               actions.size(), 1 + Mapping::MAX_MACRO);
+   }
+
+   for (size_t i = 1; i < actions.size() && i <= Mapping::MAX_MACRO; i++)
+   {
+      (*macro)[i - 1] = actions[i].template get<ActionType>();
+   }
+
+   return actions[0].template get<ActionType>();
+}
+
 void add_midi_mapping_from_json(sc::control::MappingRegistry& mappings, const nlohmann::json& json)
 {
    const MIDIStatusType midi_status = json["type"].template get<MIDIStatusType>();
@@ -195,11 +274,13 @@ void add_midi_mapping_from_json(sc::control::MappingRegistry& mappings, const nl
    }
 
    const unsigned char channel = json["channel"].template get<unsigned char>();
-   const unsigned char parameter1 = json["parameter1"].template get<unsigned char>();
+   // Up to 16383 for NRPN parameter numbers
+   const unsigned int parameter1 = json["parameter1"].template get<unsigned int>();
    const unsigned char parameter2 = json["parameter2"].template get<unsigned char>();
    const auto deck_string = json["deck"].template get<std::string>();
    const unsigned char deck_no = deck_string == "beats" ? 0 : 1;
-   const ActionType action = json["action"].template get<ActionType>();
+   MacroSteps macro;
+   const ActionType action = actions_from_json(json, &macro);
 
    unsigned char midi_command[3];
 
@@ -214,23 +295,41 @@ void add_midi_mapping_from_json(sc::control::MappingRegistry& mappings, const nl
          midi_command[ 1 ] = note_number;
          midi_command[ 2 ] = 0;
 
-         if (action == ActionType::NOTE)
+         if (action == ActionType::NOTE || action == ActionType::ONESHOTNOTE)
          {
-            add_mapping(mappings, IOType::MIDI, deck_no, midi_command, 0, 0, false, event, action, note_number);
+            add_mapping(mappings, IOType::MIDI, deck_no, midi_command, 0, 0, false, event, action, note_number, macro);
          }
          else
          {
-            add_mapping(mappings, IOType::MIDI, deck_no, midi_command, 0, 0, false, event, action, 0);
+            add_mapping(mappings, IOType::MIDI, deck_no, midi_command, 0, 0, false, event, action, 0, macro);
          }
       }
    }
    else
    {
       midi_command[ 0 ] = static_cast<unsigned char>((control_type_byte << 4) | channel);
-      midi_command[ 1 ] = parameter1;
-      midi_command[ 2 ] = 0;
+      midi_command[ 1 ] = static_cast<unsigned char>(parameter1 & 0x7F);
+      // NRPNs match on the full parameter number, MSB in the third byte
+      midi_command[ 2 ] = midi_status == MIDI_NRPN ? static_cast<unsigned char>((parameter1 >> 7) & 0x7F) : 0;
 
-      add_mapping(mappings, IOType::MIDI, deck_no, midi_command, 0, 0, false, event, action, parameter2);
+      // 14-bit controllers are opt-in, a CC 32-63 may just as well be a knob of its own
+      const bool high_res = json.value("high_res", false);
+      if (high_res && (midi_status != MIDI_CC || parameter1 >= 32))
+      {
+         LOG_WARN("\"high_res\" only applies to control changes 0-31, ignored for %u", parameter1);
+      }
+
+      add_mapping(mappings, IOType::MIDI, deck_no, midi_command, 0, 0, false, event, action, parameter2, macro,
+                  high_res && midi_status == MIDI_CC && parameter1 < 32);
+
+      // A touch sensor or held roll needs its note-off too, which has a table slot of its own.
+      // Only the held action lets go there, the rest of a macro fires on the press alone
+      if ((action == ActionType::JOGTOUCH || action == ActionType::LOOPROLL ||
+           action == ActionType::STUTTER) && midi_status == MIDI_NOTE_ON)
+      {
+         midi_command[ 0 ] = static_cast<unsigned char>((MIDI_NOTE_OFF << 4) | channel);
+         add_mapping(mappings, IOType::MIDI, deck_no, midi_command, 0, 0, false, event, action, parameter2);
+      }
    }
 }
 
@@ -242,50 +341,21 @@ void add_gpio_mapping_from_json(sc::control::MappingRegistry& mappings, const nl
    const bool pull_up = json["pull_up"].template get<bool>();
    const auto deck_string = json["deck"].template get<std::string>();
    const unsigned char deck_no = deck_string == "beats" ? 0 : 1;
-   ActionType action = json["action"].template get<ActionType>();
+   MacroSteps macro;
+   ActionType action = actions_from_json(json, &macro);
 
    // Optional parameter field (used for cue button index in auto-cue combo detection)
    const unsigned char parameter = json.value("parameter", static_cast<unsigned char>(0));
 
-   add_mapping(mappings, IOType::IO, deck_no, nullptr, port, pin, pull_up, event, action, parameter);
+   add_mapping(mappings, IOType::IO, deck_no, nullptr, port, pin, pull_up, event, action, parameter, macro);
 }
 
 // Note: Legacy sc_settings_old_format() function removed - now using JSON config only
 
-void load_json_config(ScSettings* settings, sc::control::MappingRegistry& mappings)
+// Parse a settings file into settings and mappings. Returns false on a
+// JSON error, leaving both partially filled.
+bool parse_json_config(std::istream& f, ScSettings* settings, sc::control::MappingRegistry& mappings)
 {
-   std::ifstream f;
-
-   // Try several locations for settings file:
-   // 1. Current directory (for desktop development)
-   // 2. Root path from settings (if already set)
-   // 3. Default hardware paths
-   const char* paths[] = {
-      "./sc_settings.json",
-      "../sc_settings.json",
-      "/media/sda/sc_settings.json",
-      "/var/sc_settings.json",
-      nullptr
-   };
-
-   for (int i = 0; paths[i] != nullptr; i++)
-   {
-      f.open(paths[i], std::ios::in);
-      if (!f.fail())
-      {
-         std::cerr << "Loaded settings from: " << paths[i] << std::endl;
-         break;
-      }
-      f.clear();  // Clear fail state before trying next path
-   }
-
-   if (f.fail())
-   {
-      std::cerr << "Could not open any settings file, exiting" << std::endl;
-      std::cerr << "Searched: ./sc_settings.json, ../sc_settings.json, /media/sda/sc_settings.json, /var/sc_settings.json" << std::endl;
-      exit(-1);
-   }
-
    try
    {
       auto json_main = nlohmann::json::parse(f);
@@ -358,6 +428,9 @@ void load_json_config(ScSettings* settings, sc::control::MappingRegistry& mappin
                iface.input_channels = dev.value("input_channels", 0);
                iface.input_left = dev.value("input_left", 0);
                iface.input_right = dev.value("input_right", 1);
+               iface.scratch_input_left = dev.value("scratch_input_left", -1);
+               iface.scratch_input_right = dev.value("scratch_input_right", -1);
+               iface.latency_frames = dev.value("latency_frames", 0);
 
                // Initialize output map to none
                for (int i = 0; i < MAX_OUTPUT_CHANNELS; i++) {
@@ -471,18 +544,71 @@ void load_json_config(ScSettings* settings, sc::control::MappingRegistry& mappin
    catch (const nlohmann::json::parse_error& e)
    {
       std::cerr << "JSON parse error: " << e.what() << std::endl;
-      std::cerr << "Using default settings" << std::endl;
-      // Apply defaults via empty JSON object
-      settings_from_json(settings, nlohmann::json::object());
+      return false;
    }
    catch (const nlohmann::json::exception& e)
    {
       std::cerr << "JSON error: " << e.what() << std::endl;
+      return false;
+   }
+
+   return true;
+}
+
+void load_json_config(ScSettings* settings, sc::control::MappingRegistry& mappings)
+{
+   std::ifstream f;
+
+   // Try several locations for settings file:
+   // 1. Current directory (for desktop development)
+   // 2. Root path from settings (if already set)
+   // 3. Default hardware paths
+   const char* paths[] = {
+      "./sc_settings.json",
+      "../sc_settings.json",
+      "/media/sda/sc_settings.json",
+      "/var/sc_settings.json",
+      nullptr
+   };
+
+   for (int i = 0; paths[i] != nullptr; i++)
+   {
+      f.open(paths[i], std::ios::in);
+      if (!f.fail())
+      {
+         std::cerr << "Loaded settings from: " << paths[i] << std::endl;
+         settings->settings_path = paths[i];
+         break;
+      }
+      f.clear();  // Clear fail state before trying next path
+   }
+
+   if (f.fail())
+   {
+      std::cerr << "Could not open any settings file, exiting" << std::endl;
+      std::cerr << "Searched: ./sc_settings.json, ../sc_settings.json, /media/sda/sc_settings.json, /var/sc_settings.json" << std::endl;
+      exit(-1);
+   }
+
+   if (!parse_json_config(f, settings, mappings))
+   {
       std::cerr << "Using default settings" << std::endl;
+      // Apply defaults via empty JSON object
       settings_from_json(settings, nlohmann::json::object());
    }
 }
 
+// Boot-time setting: keep the running value, say so if the file changed it
+template <typename T>
+void keep_boot_setting(T& next, const T& current, const char* name)
+{
+   if (!(next == current))
+   {
+      LOG_WARN("Settings reload: %s takes effect after a restart", name);
+   }
+   next = current;
+}
+
 } // namespace config
 } // namespace sc
 
@@ -492,6 +618,50 @@ void sc_settings_load_user_configuration(ScSettings* settings, sc::control::Mapp
    sc::config::load_json_config(settings, mappings);
 }
 
+bool sc_settings_reload(const ScSettings* current, ScSettings* next, sc::control::MappingRegistry& mappings)
+{
+   std::ifstream f(current->settings_path);
+   if (f.fail())
+   {
+      LOG_WARN("Settings reload: cannot open %s", current->settings_path.c_str());
+      return false;
+   }
+
+   if (!sc::config::parse_json_config(f, next, mappings))
+   {
+      LOG_WARN("Settings reload: %s is invalid, keeping current settings", current->settings_path.c_str());
+      return false;
+   }
+
+   next->settings_path = current->settings_path;
+   next->root_path = current->root_path;
+   next->importer = current->importer;
+
+   // Audio devices, buffers and threads are set up once
+   next->audio_interfaces = current->audio_interfaces;
+   sc::config::keep_boot_setting(next->sample_rate, current->sample_rate, "sample_rate");
+   sc::config::keep_boot_setting(next->period_size, current->period_size, "period_size");
+   sc::config::keep_boot_setting(next->buffer_period_factor, current->buffer_period_factor, "buffer_period_factor");
+   sc::config::keep_boot_setting(next->update_rate, current->update_rate, "update_rate");
+   sc::config::keep_boot_setting(next->rt_priority, current->rt_priority, "rt_priority");
+   sc::config::keep_boot_setting(next->loop_max_seconds, current->loop_max_seconds, "loop_max_seconds");
+   sc::config::keep_boot_setting(next->loop_pool_seconds, current->loop_pool_seconds, "loop_pool_seconds");
+   sc::config::keep_boot_setting(next->capture_ring_seconds, current->capture_ring_seconds, "capture_ring_seconds");
+   sc::config::keep_boot_setting(next->master_record_buffer_seconds, current->master_record_buffer_seconds,
+                                 "master_record_buffer_seconds");
+   sc::config::keep_boot_setting(next->session_restore, current->session_restore, "session_restore");
+   sc::config::keep_boot_setting(next->index_threads, current->index_threads, "index_threads");
+   sc::config::keep_boot_setting(next->library_watch, current->library_watch, "library_watch");
+   next->audio_init_delay = current->audio_init_delay;
+   next->midi_init_delay = current->midi_init_delay;
+
+   // Set by SC500 detection at startup, not only by the file
+   next->disable_volume_adc = next->disable_volume_adc || current->disable_volume_adc;
+   next->disable_pic_buttons = next->disable_pic_buttons || current->disable_pic_buttons;
+
+   return true;
+}
+
 void sc_settings_print_gpio_mappings(const sc::control::MappingRegistry& mappings)
 {
    LOG_INFO("=== GPIO Mappings Loaded ===");
@@ -501,8 +671,12 @@ void sc_settings_print_gpio_mappings(const sc::control::MappingRegistry& mapping
       "PITCH", "NOTE", "GND", "VOLUME", "NEXTFILE", "PREVFILE",
       "RANDOMFILE", "NEXTFOLDER", "PREVFOLDER", "RECORD", "LOOPERASE",
       "LOOPRECALL", "VOLUP", "VOLDOWN", "JOGPIT", "DELETECUE", "SC500",
-      "VOLUHOLD", "VOLDHOLD", "JOGPSTOP", "JOGREVERSE", "BEND", "NOTHING"
+      "VOLUHOLD", "VOLDHOLD", "JOGPSTOP", "JOGREVERSE", "BEND", "JOG",
+      "JOGTOUCH", "GRABLOOP", "SAVELOOP", "MASTERRECORD", "CALIBRATELATENCY",
+      "LOOPROLL", "LOOPROLLSTOP", "ONESHOT", "ONESHOTNOTE", "STUTTER",
+      "STUTTERSTOP", "SEARCH", "SEARCHBACK", "SEARCHCLEAR", "NOTHING"
    };
+   constexpr size_t action_count = sizeof(action_names) / sizeof(action_names[0]);
 
    static const char* edge_names[] = {
       "RELEASED", "PRESSED", "HOLDING", "PRESSED_SHIFTED",
@@ -516,7 +690,7 @@ void sc_settings_print_gpio_mappings(const sc::control::MappingRegistry& mapping
    {
       if (m.type == IOType::IO)
       {
-         const char* action_str = (m.action_type < 29) ? action_names[m.action_type] : "UNKNOWN";
+         const char* action_str = (static_cast<size_t>(m.action_type) < action_count) ? action_names[m.action_type] : "UNKNOWN";
          const char* edge_str = (m.edge_type < 6) ? edge_names[m.edge_type] : "UNKNOWN";
          LOG_DEBUG("  GPIO port=%d pin=%2d deck=%d action=%-12s event=%-16s",
                    m.gpio_port, m.pin, m.deck_no, action_str, edge_str);
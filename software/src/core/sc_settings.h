@@ -71,6 +71,9 @@ struct AudioInterface {
    int input_channels = 0;        // Number of capture channels (0 = no capture)
    int input_left = 0;            // Which capture channel is left
    int input_right = 1;           // Which capture channel is right
+   int scratch_input_left = -1;   // Pair the scratch deck records from (-1 = input_left/right)
+   int scratch_input_right = -1;
+   int latency_frames = 0;        // Round trip output -> input, recordings are aligned by it
 
    // Output channel Mapping: output_map[hw_channel] = logical_type
    // e.g., output_map[4] = OUT_CV1 means hardware channel 4 outputs CV1
@@ -96,9 +99,13 @@ struct ScSettings
    int fader_open_point; // value required to open the fader (when fader is closed)
    int fader_close_point; // value required to close the fader (when fader is open)
 
-   // delay between iterations of the input loop
+   // period of the input loop in microseconds (encoder sampling rate)
    int update_rate;
 
+   // SCHED_FIFO priority of the audio thread (0 = normal scheduling)
+   // The input thread runs one step below it
+   int rt_priority;
+
    // Whether platter input is enabled
    bool platter_enabled;
 
@@ -107,6 +114,19 @@ struct ScSettings
    // Default 3072 = 1.33 seconds for every platter rotation
    int platter_speed;
 
+   // Track the platter with a position/velocity estimator extrapolated to the
+   // next audio block, and let the engine follow it with velocity feed-forward.
+   // Disable to use the raw encoder position and the plain P-controller.
+   bool platter_estimator;
+
+   // Ticks of an external MIDI jog wheel per second of audio (like platter_speed)
+   int midi_jog_speed;
+
+   // Send controller feedback (cue/record/play LEDs, jog position ring)
+   // back to MIDI devices, at most midi_feedback_rate bytes per second
+   bool midi_feedback;
+   int midi_feedback_rate;
+
    // How long to debounce external GPIO switches
    int debounce_time;
 
@@ -163,6 +183,28 @@ struct ScSettings
 
    // Loop recording settings
    int loop_max_seconds;        // Maximum loop recording duration (default 60)
+   int loop_pool_seconds;       // Loop storage shared by both decks, 0 = loop_max_seconds each (default 0)
+   int capture_ring_seconds;    // Input history kept for grab_loop, 0 = off (default 20)
+   bool loop_overdub;           // Punch-in mixes into the loop instead of replacing it (default false)
+   double loop_feedback;        // Overdub: gain on the existing loop per pass, 0-1 (default 0.8)
+   bool loop_quantize;          // Snap recording start/stop and loop rolls to the beat grid (default false)
+   double loop_bpm;             // Beat grid tempo, 0 = taken from the first loop recorded (default 0)
+   double loop_crossfade_ms;    // Crossfade at quantized loop ends and loop roll jumps (default 4)
+
+   // Master recording settings
+   int master_record_buffer_seconds;  // Ring between audio thread and disk, 0 = off (default 4)
+   bool master_record_input;          // Also record the input pair as channels 3-4 (default false)
+
+   // Sampler settings
+   int sampler_voices;          // One-shot voices playing at once, 1-16 (default 8)
+   double sampler_volume;       // Gain of the sampler voices (default 0.8)
+   double sampler_budget_percent;  // Share of each block the voices may take, fewer play past it (default 25)
+
+   // Session settings
+   int index_threads;           // Threads listing the beats and samples folders at boot, 0 = in turn (default 2)
+   bool library_watch;          // Follow files and folders added or removed on the stick while running (default true)
+   bool session_restore;        // Reload the last session's tracks, positions and loops on boot (default true)
+   int session_save_seconds;    // Save the session this often while running, 0 = on shutdown only (default 30)
 
    // Crossfader ADC calibration (for CV gates)
    int crossfader_adc_min;      // ADC value at beat side extreme (default 0)
@@ -171,12 +213,20 @@ struct ScSettings
    // Root directory for samples, settings, etc.
    // Default: /media/sda (hardware), can be overridden via --root CLI arg
    std::string root_path;
+
+   // Settings file this snapshot was loaded from (watched for reload)
+   std::string settings_path;
 };
 
 #include "sc_input.h"
 
 // Settings loading and utility functions
 void sc_settings_load_user_configuration(ScSettings* settings, sc::control::MappingRegistry& mappings);
+
+// Load current's settings file again into next and mappings. Settings that
+// size buffers or pick devices keep their current values. Returns false
+// if the file can't be read or parsed.
+bool sc_settings_reload(const ScSettings* current, ScSettings* next, sc::control::MappingRegistry& mappings);
 void sc_settings_print_gpio_mappings(const sc::control::MappingRegistry& mappings);
 AudioInterface* sc_settings_get_audio_interface(ScSettings* settings, audio_interface_type type);
 void sc_settings_init_default_audio(ScSettings* settings);
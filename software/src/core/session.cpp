@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Session - what the decks had loaded, restored on the next boot
+//
+
+#include "session.h"
+#include "../engine/wav_file.h"
+#include "../player/track.h"
+#include "../util/log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <json.hpp>
+
+namespace sc {
+
+void Session::init(const std::string& folder)
+{
+    folder_ = folder;
+}
+
+std::string Session::loop_path(int deck) const
+{
+    return folder_ + (deck == 0 ? "/loop-beat.pcm" : "/loop-scratch.pcm");
+}
+
+bool Session::load()
+{
+    decks_[0] = DeckSession{};
+    decks_[1] = DeckSession{};
+
+    std::ifstream file(state_path());
+    if (!file) {
+        return false;
+    }
+
+    std::stringstream text;
+    text << file.rdbuf();
+    if (!from_json(text.str(), decks_)) {
+        LOG_WARN("Session: %s is unreadable, starting fresh", state_path().c_str());
+        decks_[0] = DeckSession{};
+        decks_[1] = DeckSession{};
+        return false;
+    }
+
+    LOG_INFO("Session: resuming from %s", state_path().c_str());
+    return true;
+}
+
+Track* Session::map_loop(int deck, int sample_rate)
+{
+    if (!decks_[deck].has_loop) {
+        return nullptr;
+    }
+    return loops_[deck].map(loop_path(deck), sample_rate);
+}
+
+void Session::release_loops()
+{
+    loops_[0].release();
+    loops_[1].release();
+}
+
+bool Session::write_loop(int deck, Track* track) const
+{
+    std::string path = loop_path(deck);
+    std::string tmp;
+    int fd = audio::replace_open(path, &tmp);
+    if (fd == -1) {
+        return false;
+    }
+
+    // A block at a time: pool blocks are not contiguous
+    bool ok = true;
+    for (unsigned int done = 0; ok && done < track->length; done += TRACK_BLOCK_SAMPLES) {
+        unsigned int frames = std::min(track->length - done, static_cast<unsigned int>(TRACK_BLOCK_SAMPLES));
+        ok = audio::write_all(fd, track->get_sample(static_cast<int>(done)),
+                              static_cast<size_t>(frames) * TRACK_CHANNELS * sizeof(signed short));
+    }
+
+    if (!ok) {
+        LOG_ERROR("Session: writing %s failed", path.c_str());
+        audio::replace_abort(fd, tmp);
+        return false;
+    }
+    return audio::replace_commit(fd, tmp, path);
+}
+
+bool Session::write_state(const std::string& json) const
+{
+    std::string path = state_path();
+    std::string tmp;
+    int fd = audio::replace_open(path, &tmp);
+    if (fd == -1) {
+        return false;
+    }
+
+    if (!audio::write_all(fd, json.data(), json.size())) {
+        LOG_ERROR("Session: writing %s failed", path.c_str());
+        audio::replace_abort(fd, tmp);
+        return false;
+    }
+    return audio::replace_commit(fd, tmp, path);
+}
+
+std::string Session::to_json(const DeckSession decks[2])
+{
+    nlohmann::json json;
+    json["version"] = VERSION;
+
+    for (int d = 0; d < 2; d++) {
+        const DeckSession& deck = decks[d];
+        nlohmann::json cues = nlohmann::json::object();
+        for (const auto& [label, position] : deck.cues) {
+            cues[std::to_string(label)] = position;
+        }
+
+        json["decks"].push_back({
+            {"path", deck.path},
+            {"at_loop", deck.at_loop},
+            {"has_loop", deck.has_loop},
+            {"position", deck.position},
+            {"cues", cues},
+        });
+    }
+
+    return json.dump(2);
+}
+
+bool Session::from_json(const std::string& text, DeckSession decks[2])
+{
+    try {
+        auto json = nlohmann::json::parse(text);
+        if (json.value("version", 0) != VERSION || !json["decks"].is_array() || json["decks"].size() != 2) {
+            return false;
+        }
+
+        for (int d = 0; d < 2; d++) {
+            const nlohmann::json& saved = json["decks"][static_cast<size_t>(d)];
+            DeckSession& deck = decks[d];
+            deck.path = saved.value("path", "");
+            deck.at_loop = saved.value("at_loop", false);
+            deck.has_loop = saved.value("has_loop", false);
+            deck.position = std::max(saved.value("position", 0.0), 0.0);
+            deck.cues.clear();
+            nlohmann::json cues = saved.value("cues", nlohmann::json::object());
+            for (const auto& [label, position] : cues.items()) {
+                deck.cues[static_cast<unsigned int>(std::stoul(label))] = position.get<double>();
+            }
+        }
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+} // namespace sc
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Session - what the decks had loaded, restored on the next boot
+//
+// Each deck's file, position, cue points and loop are saved to a session
+// folder on the USB stick on a clean shutdown and every
+// session_save_seconds while running. session.json holds the deck state;
+// each loop is a raw PCM file next to it, mapped straight back in as the
+// deck's loop on boot (see LoopImage). While running, saves go through the
+// loop writer, and a loop is only written again once it has changed.
+//
+// Every file is replaced in one rename, so a power cut leaves the last
+// complete session behind.
+//
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "../engine/loop_image.h"
+
+struct Track;
+
+namespace sc {
+
+struct DeckSession {
+    std::string path;        // File the deck had loaded, empty = none
+    bool at_loop = false;    // Playing its loop rather than the file
+    bool has_loop = false;   // A loop was saved with the session
+    double position = 0.0;   // Seconds into what it was playing
+    std::map<unsigned int, double> cues;
+};
+
+class Session {
+public:
+    static constexpr int VERSION = 1;
+
+    // Keep the session in folder
+    void init(const std::string& folder);
+    const std::string& folder() const { return folder_; }
+
+    // Read the last session. Returns false if there is none or it can't be
+    // parsed, leaving every deck empty
+    bool load();
+    const DeckSession& deck(int deck) const { return decks_[deck]; }
+
+    // Map the deck's saved loop. The session keeps it until release_loops(),
+    // which must wait until the audio engine has let go of it
+    Track* map_loop(int deck, int sample_rate);
+    void release_loops();
+
+    std::string state_path() const { return folder_ + "/session.json"; }
+    std::string loop_path(int deck) const;
+
+    // Write the deck's loop to loop_path() straight from the track, which
+    // nothing may write to meanwhile
+    bool write_loop(int deck, Track* track) const;
+
+    // Write json (see to_json) to state_path()
+    bool write_state(const std::string& json) const;
+
+    static std::string to_json(const DeckSession decks[2]);
+    static bool from_json(const std::string& text, DeckSession decks[2]);
+
+    // === Input thread bookkeeping ===
+
+    double next_save = 0.0;             // When to save next (0 = not scheduled yet)
+    unsigned int saved_version[2] = {}; // Loop version last saved, see AudioHardware::loop_version
+    double pending_seek[2] = {-1.0, -1.0};  // Restored position to seek to (-1 = none)
+
+private:
+    std::string folder_;
+    DeckSession decks_[2];
+    audio::LoopImage loops_[2];
+};
+
+} // namespace sc
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Settings snapshots shared with the realtime thread
+
+#include "settings_store.h"
+#include "sc_settings.h"
+
+namespace sc {
+
+SettingsStore::~SettingsStore()
+{
+    for (const Retired& r : retired_) {
+        delete r.settings;
+    }
+    delete current_.load();
+}
+
+void SettingsStore::publish(std::unique_ptr<ScSettings> next)
+{
+    ScSettings* old = current_.exchange(next.release());
+    if (old == nullptr) {
+        return;
+    }
+
+    // A block that loaded old before the swap ends by bumping the epoch
+    // past this value; blocks after that only see the new snapshot
+    retired_.push_back(Retired{old, epoch_.load()});
+}
+
+SettingsStore& SettingsStore::operator=(std::unique_ptr<ScSettings> next)
+{
+    publish(std::move(next));
+    return *this;
+}
+
+void SettingsStore::reclaim()
+{
+    uint64_t now = epoch_.load();
+
+    size_t kept = 0;
+    for (const Retired& r : retired_) {
+        if (now > r.epoch) {
+            delete r.settings;
+        } else {
+            retired_[kept++] = r;
+        }
+    }
+    retired_.resize(kept);
+}
+
+} // namespace sc
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Settings snapshots shared with the realtime thread
+//
+// The current ScSettings is published through an atomic pointer. A reload
+// builds a complete new snapshot and swaps it in, so a reader sees either
+// the old or the new struct, never a mix. The old snapshot is retired and
+// freed once the audio thread has finished the block that may still hold
+// it; the audio thread reports each finished block through quiescent().
+//
+// Any thread may read. Only one thread writes: startup, then the input
+// thread. Pointers from get() stay valid until that thread calls reclaim().
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct ScSettings;
+
+namespace sc {
+
+class SettingsStore {
+public:
+    SettingsStore() = default;
+    ~SettingsStore();
+
+    SettingsStore(const SettingsStore&) = delete;
+    SettingsStore& operator=(const SettingsStore&) = delete;
+
+    // Current snapshot (nullptr before the first publish)
+    ScSettings* get() const { return current_.load(); }
+    ScSettings* operator->() const { return get(); }
+
+    // Make next the current snapshot and retire the previous one
+    void publish(std::unique_ptr<ScSettings> next);
+    SettingsStore& operator=(std::unique_ptr<ScSettings> next);
+
+    // Audio thread, after each block: snapshots loaded so far are released
+    void quiescent() { epoch_.fetch_add(1); }
+
+    // Writer: free retired snapshots no block can still be reading
+    void reclaim();
+
+    // Snapshots waiting for reclaim()
+    size_t retired() const { return retired_.size(); }
+
+private:
+    struct Retired {
+        ScSettings* settings;
+        uint64_t epoch;  // Audio block count when it was replaced
+    };
+
+    std::atomic<ScSettings*> current_{nullptr};
+    std::atomic<uint64_t> epoch_{0};
+    std::vector<Retired> retired_;
+};
+
+} // namespace sc
@@ -25,6 +25,7 @@
 // - Virtual dispatch once per buffer, compile-time optimization inside
 // - Backward-compatible C API for legacy code
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <climits>
@@ -60,11 +61,108 @@ constexpr double FADER_DECAY_TIME = 0.020;  // Time in seconds fader takes to de
 constexpr double DECAY_SAMPLES = FADER_DECAY_TIME * 48000;
 constexpr double BASE_VOLUME = 7.0 / 8.0;  // Headroom for pitch > 1.0
 constexpr double SAMPLE_RATE = 48000.0;
+constexpr double PLATTER_FEEDBACK_GAIN = 20.0;  // Position error correction (1/s) with velocity feed-forward
+constexpr double ROLL_DEFAULT_BPM = 120.0;  // Loop roll grid until there is a tempo
+constexpr unsigned int STUTTER_DECLICK = 32;  // Frames of crossfade over a beat repeat retrigger
 
 static bool nearly_equal(double val1, double val2, double tolerance) {
     return std::fabs(val1 - val2) < tolerance;
 }
 
+// Wrap a sample position into [0, len)
+static inline double wrap_sample(double sample, int len) {
+    if (len <= 0) return sample;
+    sample = std::fmod(sample, static_cast<double>(len));
+    return sample < 0.0 ? sample + len : sample;
+}
+
+// Wrap a sample position into the loop roll slice [start, end)
+static inline double wrap_roll(double sample, const RollState& roll) {
+    double span = roll.end - roll.start;
+    sample = std::fmod(sample - roll.start, span);
+    return roll.start + (sample < 0.0 ? sample + span : sample);
+}
+
+// Start a loop roll at sample: the slice is span samples from there in the
+// direction of play, moved inside the track if it would run off an end
+static void roll_engage(RollState& roll, double sample, double step, double span,
+                        const Track* track, int len) {
+    if (len <= 0 || span < 1.0 || span >= len) return;
+
+    double start = step >= 0.0 ? sample : sample + 1.0 - span;
+    roll.start = std::min(std::max(start, 0.0), len - span);
+    roll.end = roll.start + span;
+    roll.slip = sample;
+    roll.track = track;
+    roll.period = 0.0;
+    roll.active = true;
+}
+
+// Start a beat repeat at sample: playback jumps back there every period
+// frames, the first time one period from now
+static void stutter_engage(RollState& roll, double sample, double period, const Track* track,
+                           int len) {
+    if (len <= 0 || period < 1.0) return;
+
+    roll.start = sample;
+    roll.slip = sample;
+    roll.track = track;
+    roll.period = period;
+    roll.countdown = period;
+    roll.active = true;
+}
+
+// Crossfade from sample over the next fade frames
+static inline void roll_fade(RollState& roll, double sample, unsigned int fade) {
+    roll.fade_from = sample;
+    roll.fade = fade;
+    roll.fade_step = fade > 0 ? 1.0f / static_cast<float>(fade) : 0.0f;
+}
+
+// Let go of a loop roll: playback jumps on to the slip position, fading over
+// from the slice, unless the track changed underneath the roll
+static void roll_release(RollState& roll, double* sample, const Track* track, int len,
+                         unsigned int fade) {
+    roll.active = false;
+    if (roll.track != track) return;
+
+    roll_fade(roll, *sample, fade);
+    *sample = wrap_sample(roll.slip, len);
+}
+
+// Frame of the block starting at block_time at which an input event stamped
+// event_time is due. Timed events play a fixed latency after they happened:
+// one audio period plus one input period, the longest an event can take from
+// the MIDI read to the block that places it. Returns 0 for untimed or late
+// events and frames for events that belong to a later block.
+static unsigned long event_frame(double event_time, double block_time,
+                                 const ScSettings* settings, unsigned long frames) {
+    if (event_time <= 0.0) return 0;
+
+    double latency = static_cast<double>(settings->period_size) / settings->sample_rate +
+                     static_cast<double>(settings->update_rate) / 1000000.0;
+    double offset = (event_time + latency - block_time) * settings->sample_rate;
+
+    if (offset <= 0.0) return 0;
+    if (offset >= static_cast<double>(frames)) return frames;
+    return static_cast<unsigned long>(offset);
+}
+
+// Capture input is deinterleaved into stereo blocks of this many frames
+constexpr unsigned long CAPTURE_CHUNK = 256;
+
+// Read n frames of one channel pair, starting at frame first, as
+// interleaved stereo float
+static void read_capture_pair(const AudioCapture* capture, unsigned long first, unsigned int n,
+                              int left, int right, float* out) {
+    for (unsigned int i = 0; i < n; i++) {
+        out[2 * i] = read_capture_sample(capture->buffer, capture->format, capture->bytes_per_sample,
+                                         first + i, left, capture->channels);
+        out[2 * i + 1] = read_capture_sample(capture->buffer, capture->format, capture->bytes_per_sample,
+                                             first + i, right, capture->channels);
+    }
+}
+
 //
 // Global state for C API backward compatibility
 // (defined in namespace but accessed via namespace qualifier from C API)
@@ -91,33 +189,49 @@ AudioEngine<InterpPolicy, FormatPolicy>::AudioEngine() {
 
 template<typename InterpPolicy, typename FormatPolicy>
 AudioEngine<InterpPolicy, FormatPolicy>::~AudioEngine() {
+    // Loops may hold tracks of the capture ring and pool blocks, release them first
     if (loop_buffers_initialized_) {
         loop_buffer_clear(&loop_[0]);
         loop_buffer_clear(&loop_[1]);
+        collect_loops();
     }
+    capture_ring_.clear();
+    loop_pool_.clear();
 }
 
 template<typename InterpPolicy, typename FormatPolicy>
-void AudioEngine<InterpPolicy, FormatPolicy>::init_loop_buffers(int sample_rate, int max_seconds) {
+void AudioEngine<InterpPolicy, FormatPolicy>::init_loop_buffers(int sample_rate, int max_seconds,
+                                                                 int pool_seconds) {
     if (loop_buffers_initialized_) {
         loop_buffer_clear(&loop_[0]);
         loop_buffer_clear(&loop_[1]);
+        collect_loops();
     }
-    loop_buffer_init(&loop_[0], sample_rate, max_seconds);
-    loop_buffer_init(&loop_[1], sample_rate, max_seconds);
+
+    // Default: as much as a full-length loop on each deck
+    auto blocks_for = [sample_rate](int seconds) {
+        unsigned long samples = static_cast<unsigned long>(sample_rate) * static_cast<unsigned long>(seconds);
+        return static_cast<unsigned int>((samples + TRACK_BLOCK_SAMPLES - 1) / TRACK_BLOCK_SAMPLES);
+    };
+    unsigned int blocks = pool_seconds > 0 ? blocks_for(pool_seconds) : 2 * blocks_for(max_seconds);
+    blocks = std::min(blocks, static_cast<unsigned int>(TRACK_MAX_BLOCKS));
+    loop_pool_.init(blocks);
+
+    loop_buffer_init(&loop_[0], sample_rate, max_seconds, &loop_pool_, &released_loops_);
+    loop_buffer_init(&loop_[1], sample_rate, max_seconds, &loop_pool_, &released_loops_);
     loop_buffers_initialized_ = true;
 }
 
+template<typename InterpPolicy, typename FormatPolicy>
+void AudioEngine<InterpPolicy, FormatPolicy>::init_capture_ring(int sample_rate, int seconds) {
+    capture_ring_.init(sample_rate, seconds);
+}
+
 template<typename InterpPolicy, typename FormatPolicy>
 bool AudioEngine<InterpPolicy, FormatPolicy>::start_recording(int deck, double playback_position) {
     if (deck < 0 || deck > 1) return false;
     if (!loop_buffers_initialized_) return false;
 
-    // Only one deck can record at a time
-    if (active_recording_deck_ >= 0 && active_recording_deck_ != deck) {
-        return false;
-    }
-
     // For punch-in, sync write position to current playback position
     LoopBuffer* lb = &loop_[deck];
     if (loop_buffer_has_loop(lb)) {
@@ -126,20 +240,50 @@ bool AudioEngine<InterpPolicy, FormatPolicy>::start_recording(int deck, double p
         loop_buffer_set_position(lb, pos_samples);
     }
 
-    if (loop_buffer_start(lb)) {
-        active_recording_deck_ = deck;
-        return true;
+    // Quantized: the first loop starts now and the grid with it, any other
+    // recording on the next beat
+    unsigned int wait = 0;
+    if (quantize_ && !loop_buffer_is_recording(lb)) {
+        bool first = !has_loop(0) && !has_loop(1) && !is_recording(1 - deck);
+        if (first) {
+            grid_.anchor(clock_frames_);
+        } else {
+            wait = grid_.until_next(clock_frames_, 1.0);
+        }
+        record_start_[deck] = clock_frames_ + wait;
     }
-    return false;
+    loop_buffer_set_splice(lb, quantize_ ? crossfade_frames_ : 0);
+
+    return loop_buffer_start_at(lb, wait);
 }
 
 template<typename InterpPolicy, typename FormatPolicy>
 void AudioEngine<InterpPolicy, FormatPolicy>::stop_recording(int deck) {
     if (deck < 0 || deck > 1) return;
-    loop_buffer_stop(&loop_[deck]);
-    if (active_recording_deck_ == deck) {
-        active_recording_deck_ = -1;
+
+    LoopBuffer* lb = &loop_[deck];
+    unsigned int wait = 0;
+    if (quantize_ && loop_buffer_is_recording(lb) && !lb->stopping) {
+        if (!loop_buffer_has_loop(lb)) {
+            // A fresh loop closes a whole number of beats after it started,
+            // at least one. Without a tempo yet it closes now and sets one.
+            uint64_t end = clock_frames_;
+            if (grid_.has_tempo()) {
+                double beat = grid_.beat_frames();
+                double played = clock_frames_ > record_start_[deck]
+                    ? static_cast<double>(clock_frames_ - record_start_[deck]) : 0.0;
+                double beats = std::max(1.0, std::ceil(played / beat - 1e-6));
+                end = std::max(end, record_start_[deck] + static_cast<uint64_t>(std::llround(beats * beat)));
+            }
+            wait = static_cast<unsigned int>(end - clock_frames_);
+            loop_end_[deck] = end;
+            align_[deck] = true;
+        } else {
+            wait = grid_.until_next(clock_frames_, 1.0);
+        }
     }
+
+    loop_buffer_stop_at(lb, wait);
 }
 
 template<typename InterpPolicy, typename FormatPolicy>
@@ -170,6 +314,75 @@ template<typename InterpPolicy, typename FormatPolicy>
 void AudioEngine<InterpPolicy, FormatPolicy>::reset_loop(int deck) {
     if (deck < 0 || deck > 1) return;
     loop_buffer_reset(&loop_[deck]);
+    loop_version_[deck]++;
+}
+
+template<typename InterpPolicy, typename FormatPolicy>
+bool AudioEngine<InterpPolicy, FormatPolicy>::grab_loop(int deck, double seconds) {
+    if (deck < 0 || deck > 1) return false;
+    if (!loop_buffers_initialized_ || !capture_ring_.enabled()) return false;
+    if (loop_buffer_is_recording(&loop_[deck])) return false;
+
+    unsigned int frames = capture_ring_.capacity();
+    if (seconds > 0.0) {
+        frames = static_cast<unsigned int>(std::min(seconds * loop_[deck].sample_rate,
+                                                    static_cast<double>(frames)));
+    }
+
+    Track* t = capture_ring_.grab(frames);
+    if (!t) return false;
+    if (!adopt_loop(deck, t)) {
+        capture_ring_.give_back(t);
+        return false;
+    }
+    return true;
+}
+
+template<typename InterpPolicy, typename FormatPolicy>
+bool AudioEngine<InterpPolicy, FormatPolicy>::adopt_loop(int deck, Track* track) {
+    if (deck < 0 || deck > 1 || !loop_buffers_initialized_) return false;
+    if (!loop_buffer_adopt(&loop_[deck], track)) return false;
+
+    loop_version_[deck]++;
+    return true;
+}
+
+template<typename InterpPolicy, typename FormatPolicy>
+void AudioEngine<InterpPolicy, FormatPolicy>::collect_loops() {
+    Track* track;
+    while (released_loops_.try_dequeue(track)) {
+        if (!capture_ring_.give_back(track)) {
+            track_release(track);
+        }
+    }
+}
+
+template<typename InterpPolicy, typename FormatPolicy>
+bool AudioEngine<InterpPolicy, FormatPolicy>::start_latency_calibration() {
+    int rate = loop_buffers_initialized_ ? loop_[0].sample_rate : static_cast<int>(SAMPLE_RATE);
+    return latency_probe_.start(rate);
+}
+
+template<typename InterpPolicy, typename FormatPolicy>
+void AudioEngine<InterpPolicy, FormatPolicy>::set_record_latency(int frames) {
+    auto latency = static_cast<unsigned int>(std::max(frames, 0));
+    loop_buffer_set_latency(&loop_[0], latency);
+    loop_buffer_set_latency(&loop_[1], latency);
+}
+
+template<typename InterpPolicy, typename FormatPolicy>
+bool AudioEngine<InterpPolicy, FormatPolicy>::snapshot_loop(int deck, LoopSnapshot* snapshot) {
+    // One save at a time per deck, of the loop the input thread took a
+    // reference to. The loop may have been replaced since
+    if (deck < 0 || deck > 1 || !has_loop(deck) || loop_[deck].snapshot ||
+        snapshot->source() != loop_[deck].track) {
+        snapshot->refuse();
+        return false;
+    }
+
+    snapshot->attach(loop_[deck].loop_length);
+    loop_[deck].snapshot = snapshot;
+    return true;
 }
 
 //
@@ -204,8 +417,10 @@ void AudioEngine<InterpPolicy, FormatPolicy>::setup_player(
     unsigned long samples,
     const struct ScSettings* settings,
     double track_length_seconds,
+    double block_time,
     double* target_volume,
-    double* filtered_pitch)
+    double* filtered_pitch,
+    unsigned long* pitch_frame)
 {
     // Read from unified input struct
     const sc::DeckInput& in = pl->input;
@@ -220,6 +435,17 @@ void AudioEngine<InterpPolicy, FormatPolicy>::setup_player(
     // Detect significant external pitch changes for instant response
     // Only triggers on actual MIDI note/bend changes, not on play/pause
     bool external_changed = std::fabs(external_speed - state->last_external_speed) > 0.01;
+
+    // A timed MIDI change snaps in at its frame, or waits for a later block
+    *pitch_frame = 0;
+    if (external_changed) {
+        *pitch_frame = event_frame(in.pitch_time, block_time, settings, samples);
+        if (*pitch_frame >= samples) {
+            external_speed = state->last_external_speed;
+            external_changed = false;
+            *pitch_frame = 0;
+        }
+    }
     state->last_external_speed = external_speed;
 
     // === Motor/platter behavior ===
@@ -235,7 +461,7 @@ void AudioEngine<InterpPolicy, FormatPolicy>::setup_player(
     }
 
     // === Pitch calculation based on mode ===
-    if (in.just_play ||  // Platter is always released on beat deck
+    if ((in.just_play && !in.touched) ||  // Beat deck platter is released unless a jog wheel holds it
         (!in.touched && !state->touched_prev))  // Don't do it on first iteration for backspins
     {
         // Platter released: slipmat simulation toward motor_speed
@@ -265,8 +491,12 @@ void AudioEngine<InterpPolicy, FormatPolicy>::setup_player(
             }
         }
 
-        // Calculate raw target pitch from position error
-        double raw_pitch = (-diff) * 40;
+        // Calculate raw target pitch from position error. With the platter
+        // estimator the measured velocity is fed forward and the position
+        // error only trims drift, so no extra smoothing lag is needed.
+        double raw_pitch = settings->platter_estimator
+            ? in.target_velocity + (-diff) * PLATTER_FEEDBACK_GAIN
+            : (-diff) * 40;
 
         // Clamp to configurable range to prevent wild oscillation
         double max_pitch = settings->max_scratch_pitch;
@@ -282,12 +512,18 @@ void AudioEngine<InterpPolicy, FormatPolicy>::setup_player(
 
     // === Final pitch smoothing ===
     if (external_changed && !in.touched) {
-        // Instant response for MIDI note/bend changes when not scratching
+        // Instant response for MIDI note/bend changes when not scratching.
+        // Snap the current pitch now, or hold it until the event's frame.
         *filtered_pitch = external_speed;
-        state->pitch = external_speed;  // Also snap current pitch for immediate effect
+        if (*pitch_frame == 0) state->pitch = external_speed;
+    } else if (in.touched && settings->platter_estimator) {
+        // Estimator output is already smooth, follow it directly
+        *filtered_pitch = target_pitch;
+        *pitch_frame = 0;
     } else {
         // Normal IIR smoothing for all other cases
         *filtered_pitch = (0.1 * target_pitch) + (0.9 * state->pitch);
+        *pitch_frame = 0;
     }
 
     // Volume fader decay
@@ -339,7 +575,8 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process_players(
     AudioCapture* capture,
     void* playback,
     int channels,
-    unsigned long frames)
+    unsigned long frames,
+    double block_time)
 {
     struct Player* pl1 = &engine->beat_deck.player;
     struct Player* pl2 = &engine->scratch_deck.player;
@@ -351,16 +588,58 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process_players(
     sc::DeckInput& in1 = pl1->input;
     sc::DeckInput& in2 = pl2->input;
 
+    const ScSettings* settings = engine->settings.get();
+
+    // Beat grid: the tempo set, or one read from the first loop while any is left
+    quantize_ = settings->loop_quantize;
+    crossfade_frames_ = static_cast<unsigned int>(std::max(settings->loop_crossfade_ms, 0.0) *
+                                                  settings->sample_rate / 1000.0);
+    if (settings->loop_bpm > 0.0) {
+        grid_.set_bpm(settings->loop_bpm, settings->sample_rate);
+    } else if (!has_loop(0) && !has_loop(1)) {
+        grid_.clear_tempo();
+    } else if (!grid_.has_tempo()) {
+        grid_.set_from_loop(loop_[has_loop(0) ? 0 : 1].loop_length, settings->sample_rate);
+    }
+
+    // Erase requests: the storage goes back to the pool here, where the
+    // other deck takes from it and this one stops reading it
+    if (in1.loop_erase) {
+        in1.loop_erase = false;  // Clear one-shot request
+        reset_loop(0);
+    }
+    if (in2.loop_erase) {
+        in2.loop_erase = false;
+        reset_loop(1);
+    }
+
     // Handle seek requests (from cue jumps, track loads, etc.)
-    if (in1.seek_to >= 0.0) {
-        state1->position = in1.seek_to;
-        state1->position_offset = in1.position_offset;
-        in1.seek_to = -1.0;  // Clear request
+    // Untimed and late ones apply now, timed ones at their frame inside the
+    // block, and ones due in a later block stay pending.
+    unsigned long seek_frame_1 = frames;
+    unsigned long seek_frame_2 = frames;
+    double seek_to_1 = in1.seek_to, seek_offset_1 = in1.position_offset;
+    double seek_to_2 = in2.seek_to, seek_offset_2 = in2.position_offset;
+
+    if (seek_to_1 >= 0.0) {
+        seek_frame_1 = event_frame(in1.seek_time, block_time, settings, frames);
+        if (seek_frame_1 == 0) {
+            state1->position = seek_to_1;
+            state1->position_offset = seek_offset_1;
+            in1.seek_to = -1.0;  // Clear request
+            seek_frame_1 = frames;
+            roll_[0].active = false;
+        }
     }
-    if (in2.seek_to >= 0.0) {
-        state2->position = in2.seek_to;
-        state2->position_offset = in2.position_offset;
-        in2.seek_to = -1.0;  // Clear request
+    if (seek_to_2 >= 0.0) {
+        seek_frame_2 = event_frame(in2.seek_time, block_time, settings, frames);
+        if (seek_frame_2 == 0) {
+            state2->position = seek_to_2;
+            state2->position_offset = seek_offset_2;
+            in2.seek_to = -1.0;  // Clear request
+            seek_frame_2 = frames;
+            roll_[1].active = false;
+        }
     }
 
     // Select track for each player based on source (needed for setup_player)
@@ -380,9 +659,12 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process_players(
 
     double target_volume_1, filtered_pitch_1;
     double target_volume_2, filtered_pitch_2;
+    unsigned long pitch_frame_1, pitch_frame_2;
 
-    setup_player(pl1, state1, frames, engine->settings.get(), track_1_seconds, &target_volume_1, &filtered_pitch_1);
-    setup_player(pl2, state2, frames, engine->settings.get(), track_2_seconds, &target_volume_2, &filtered_pitch_2);
+    setup_player(pl1, state1, frames, settings, track_1_seconds, block_time,
+                 &target_volume_1, &filtered_pitch_1, &pitch_frame_1);
+    setup_player(pl2, state2, frames, settings, track_2_seconds, block_time,
+                 &target_volume_2, &filtered_pitch_2, &pitch_frame_2);
 
     // During fresh recording (recording active but no loop yet), mute track playback
     if (state1->is_recording && !state1->has_loop) target_volume_1 = 0.0;
@@ -404,6 +686,50 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process_players(
         if (sample_2 < 0.0) sample_2 += tr_2_len;
     }
 
+    // Loop roll: while held, a deck repeats a slice roll_beats long from the
+    // next line of that grid on, and slips on underneath. Let go, or touch
+    // the platter, and it is back where it would have been.
+    // A beat repeat (stutter) is held the same way, but jumps back every
+    // stutter_beats at the exact frame, however fast the rate; it wins
+    // over a roll held at the same time.
+    RollState& roll_1 = roll_[0];
+    RollState& roll_2 = roll_[1];
+    const double stutter_1 = in1.touched ? 0.0 : in1.stutter_beats;
+    const double stutter_2 = in2.touched ? 0.0 : in2.stutter_beats;
+    const double roll_beats_1 = stutter_1 > 0.0 ? stutter_1 : in1.touched ? 0.0 : in1.roll_beats;
+    const double roll_beats_2 = stutter_2 > 0.0 ? stutter_2 : in2.touched ? 0.0 : in2.roll_beats;
+    const double beat = grid_.has_tempo() ? grid_.beat_frames()
+                                          : 60.0 * settings->sample_rate / ROLL_DEFAULT_BPM;
+    const unsigned int roll_fade_frames = crossfade_frames_;
+
+    // Let go, or switched between roll and beat repeat
+    if (roll_1.active && (roll_beats_1 <= 0.0 || roll_1.track != tr1 ||
+                          (roll_1.period > 0.0) != (stutter_1 > 0.0))) {
+        roll_release(roll_1, &sample_1, tr1, tr_1_len, roll_fade_frames);
+    }
+    if (roll_2.active && (roll_beats_2 <= 0.0 || roll_2.track != tr2 ||
+                          (roll_2.period > 0.0) != (stutter_2 > 0.0))) {
+        roll_release(roll_2, &sample_2, tr2, tr_2_len, roll_fade_frames);
+    }
+
+    // A rate change of a held beat repeat takes over from the next retrigger
+    if (roll_1.active && stutter_1 > 0.0) roll_1.period = stutter_1 * beat;
+    if (roll_2.active && stutter_2 > 0.0) roll_2.period = stutter_2 * beat;
+
+    // Declick over a retrigger, short enough to fit between two
+    auto stutter_fade = [](const RollState& roll) {
+        return std::min(STUTTER_DECLICK, static_cast<unsigned int>(roll.period / 2.0));
+    };
+
+    // Frame at which a held roll starts, frames if not in this block
+    auto roll_frame = [&](const RollState& roll, double beats) -> unsigned long {
+        if (beats <= 0.0 || roll.active) return frames;
+        unsigned int wait = grid_.has_tempo() ? grid_.until_next(clock_frames_, beats) : 0;
+        return std::min<unsigned long>(wait, frames);
+    };
+    unsigned long roll_frame_1 = roll_frame(roll_1, roll_beats_1);
+    unsigned long roll_frame_2 = roll_frame(roll_2, roll_beats_2);
+
     const float ONE_OVER_SAMPLES = 1.0f / static_cast<float>(frames);
 
     float pitch_1 = static_cast<float>(state1->pitch);
@@ -411,10 +737,19 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process_players(
     float vol_1 = static_cast<float>(state1->volume);
     float vol_2 = static_cast<float>(state2->volume);
 
+    // A pitch change held for a later frame steps there instead of ramping
+    if (pitch_frame_1 == 0) pitch_frame_1 = frames;
+    if (pitch_frame_2 == 0) pitch_frame_2 = frames;
+
     const float volume_gradient_1 = (static_cast<float>(target_volume_1) - vol_1) * ONE_OVER_SAMPLES;
-    const float pitch_gradient_1 = (static_cast<float>(filtered_pitch_1) - pitch_1) * ONE_OVER_SAMPLES;
+    const float pitch_gradient_1 = pitch_frame_1 < frames ? 0.0f :
+        (static_cast<float>(filtered_pitch_1) - pitch_1) * ONE_OVER_SAMPLES;
     const float volume_gradient_2 = (static_cast<float>(target_volume_2) - vol_2) * ONE_OVER_SAMPLES;
-    const float pitch_gradient_2 = (static_cast<float>(filtered_pitch_2) - pitch_2) * ONE_OVER_SAMPLES;
+    const float pitch_gradient_2 = pitch_frame_2 < frames ? 0.0f :
+        (static_cast<float>(filtered_pitch_2) - pitch_2) * ONE_OVER_SAMPLES;
+
+    unsigned long next_event = std::min({seek_frame_1, seek_frame_2, pitch_frame_1, pitch_frame_2,
+                                         roll_frame_1, roll_frame_2});
 
     // Output pointer - advance by bytes_per_sample * channels
     auto* out_ptr = static_cast<uint8_t*>(playback);
@@ -426,6 +761,46 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process_players(
     if (spin_try_lock(&pl1->lock) && spin_try_lock(&pl2->lock)) {
         // Main processing loop - all compile-time optimized
         for (unsigned long s = 0; s < frames; ++s) {
+            // Timed input events due at this frame
+            if (s == next_event) {
+                if (s == seek_frame_1) {
+                    state1->position = seek_to_1;
+                    state1->position_offset = seek_offset_1;
+                    sample_1 = wrap_sample((seek_to_1 - seek_offset_1) * tr_1_rate, tr_1_len);
+                    in1.seek_to = -1.0;
+                    roll_1.active = false;
+                }
+                if (s == seek_frame_2) {
+                    state2->position = seek_to_2;
+                    state2->position_offset = seek_offset_2;
+                    sample_2 = wrap_sample((seek_to_2 - seek_offset_2) * tr_2_rate, tr_2_len);
+                    in2.seek_to = -1.0;
+                    roll_2.active = false;
+                }
+                if (s == pitch_frame_1) pitch_1 = static_cast<float>(filtered_pitch_1);
+                if (s == pitch_frame_2) pitch_2 = static_cast<float>(filtered_pitch_2);
+                if (s == roll_frame_1) {
+                    if (stutter_1 > 0.0) {
+                        stutter_engage(roll_1, sample_1, stutter_1 * beat, tr1, tr_1_len);
+                    } else {
+                        roll_engage(roll_1, sample_1, pitch_1, roll_beats_1 * beat * dt_rate_1, tr1, tr_1_len);
+                    }
+                }
+                if (s == roll_frame_2) {
+                    if (stutter_2 > 0.0) {
+                        stutter_engage(roll_2, sample_2, stutter_2 * beat, tr2, tr_2_len);
+                    } else {
+                        roll_engage(roll_2, sample_2, pitch_2, roll_beats_2 * beat * dt_rate_2, tr2, tr_2_len);
+                    }
+                }
+
+                next_event = frames;
+                for (unsigned long f : {seek_frame_1, seek_frame_2, pitch_frame_1, pitch_frame_2,
+                                        roll_frame_1, roll_frame_2}) {
+                    if (f > s && f < next_event) next_event = f;
+                }
+            }
+
             double step_1 = dt_rate_1 * pitch_1;
             double step_2 = dt_rate_2 * pitch_2;
 
@@ -434,6 +809,26 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process_players(
                 tr1, sample_1, tr_1_len, pitch_1,
                 tr2, sample_2, tr_2_len, pitch_2);
 
+            // Crossfade over a loop roll jump or retrigger, from where playback
+            // would have gone on: the one extra interpolation while either fades
+            if (roll_1.fade > 0 || roll_2.fade > 0) {
+                auto from = InterpPolicy::interpolate(
+                    tr1, roll_1.fade > 0 ? roll_1.fade_from : sample_1, tr_1_len, pitch_1,
+                    tr2, roll_2.fade > 0 ? roll_2.fade_from : sample_2, tr_2_len, pitch_2);
+                if (roll_1.fade > 0) {
+                    float g = static_cast<float>(roll_1.fade--) * roll_1.fade_step;
+                    samples.l1 += (from.l1 - samples.l1) * g;
+                    samples.r1 += (from.r1 - samples.r1) * g;
+                    roll_1.fade_from = wrap_sample(roll_1.fade_from + step_1, tr_1_len);
+                }
+                if (roll_2.fade > 0) {
+                    float g = static_cast<float>(roll_2.fade--) * roll_2.fade_step;
+                    samples.l2 += (from.l2 - samples.l2) * g;
+                    samples.r2 += (from.r2 - samples.r2) * g;
+                    roll_2.fade_from = wrap_sample(roll_2.fade_from + step_2, tr_2_len);
+                }
+            }
+
             // Apply volume and mix
             float sum_l = samples.l1 * vol_1 + samples.l2 * vol_2;
             float sum_r = samples.r1 * vol_1 + samples.r2 * vol_2;
@@ -458,6 +853,35 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process_players(
             sample_1 += step_1;
             sample_2 += step_2;
 
+            // A loop roll wraps within its slice and a beat repeat jumps back
+            // when its period is up, crossfading the jump
+            if (roll_1.active) {
+                roll_1.slip += step_1;
+                if (roll_1.period > 0.0) {
+                    if ((roll_1.countdown -= 1.0) < 0.5) {
+                        roll_fade(roll_1, wrap_sample(sample_1, tr_1_len), stutter_fade(roll_1));
+                        roll_1.countdown += roll_1.period;
+                        sample_1 = roll_1.start;
+                    }
+                } else if (sample_1 >= roll_1.end || sample_1 < roll_1.start) {
+                    roll_fade(roll_1, wrap_sample(sample_1, tr_1_len), roll_fade_frames);
+                    sample_1 = wrap_roll(sample_1, roll_1);
+                }
+            }
+            if (roll_2.active) {
+                roll_2.slip += step_2;
+                if (roll_2.period > 0.0) {
+                    if ((roll_2.countdown -= 1.0) < 0.5) {
+                        roll_fade(roll_2, wrap_sample(sample_2, tr_2_len), stutter_fade(roll_2));
+                        roll_2.countdown += roll_2.period;
+                        sample_2 = roll_2.start;
+                    }
+                } else if (sample_2 >= roll_2.end || sample_2 < roll_2.start) {
+                    roll_fade(roll_2, wrap_sample(sample_2, tr_2_len), roll_fade_frames);
+                    sample_2 = wrap_roll(sample_2, roll_2);
+                }
+            }
+
             // Wrap when crossing track boundary
             // Use fmod for correctness with high pitch values on short loops
             if (tr_1_len > 0 && (sample_1 >= tr_1_len || sample_1 < 0.0)) {
@@ -490,50 +914,198 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process_players(
     state2->position += r2;
     state2->volume = target_volume_2;
 
-    // Handle capture: loop recording and monitoring
-    int deck = active_recording_deck_;
-    bool recording = (deck >= 0 && deck < 2);
+    // Sampler voices on top of the decks, rendered a chunk at a time within
+    // their share of the block
+    Sampler& sampler = engine->sampler;
+    if (sampler.begin_block(settings->sampler_voices, pl1->sample_dt)) {
+        double started = get_time_us();
+        const auto gain = static_cast<float>(settings->sampler_volume / 32768.0);
+        float mix[2 * CAPTURE_CHUNK];
+        out_ptr = static_cast<uint8_t*>(playback);
+
+        for (unsigned long done = 0; done < frames; done += CAPTURE_CHUNK) {
+            auto n = static_cast<unsigned int>(std::min<unsigned long>(CAPTURE_CHUNK, frames - done));
+
+            std::fill(mix, mix + 2 * n, 0.0f);
+            sampler.render<InterpPolicy>(mix, n);
+
+            for (unsigned int i = 0; i < n; i++) {
+                FormatPolicy::write(out_ptr, FormatPolicy::read(out_ptr) + mix[2 * i] * gain);
+                FormatPolicy::write(out_ptr + bytes_per_sample,
+                                    FormatPolicy::read(out_ptr + bytes_per_sample) + mix[2 * i + 1] * gain);
+                out_ptr += frame_size;
+            }
+        }
+
+        double budget = static_cast<double>(frames) * pl1->sample_dt * 1000000.0 *
+                        settings->sampler_budget_percent / 100.0;
+        sampler.end_block(get_time_us() - started, budget);
+    }
+
+    // Saves whose copy is complete no longer need the loop
+    for (LoopBuffer& lb : loop_) {
+        if (lb.snapshot && lb.snapshot->copied()) {
+            loop_buffer_detach_snapshot(&lb);
+            loop_buffer_release_unused(&lb);
+        }
+    }
+
+    // Handle capture: loop recording, input history and monitoring
+    // Each deck records its own channel pair; both can record at once
+    bool recording[2] = {loop_buffer_is_recording(&loop_[0]), loop_buffer_is_recording(&loop_[1])};
     bool has_capture = (capture && capture->buffer);
 
     if (has_capture) {
-        bool monitoring = (deck >= 0 && monitoring_volume_ > 0.0f);
+        for (int d = 0; d < 2; d++) {
+            if (recording[d]) loop_version_[d].fetch_add(1, std::memory_order_relaxed);
+        }
 
-        if (recording || monitoring) {
-            float mon_vol = monitoring_volume_;
+        bool history = capture_ring_.enabled();
+        float mon_vol[2] = {recording[0] ? monitoring_volume_[0] : 0.0f,
+                            recording[1] ? monitoring_volume_[1] : 0.0f};
+        bool monitoring = mon_vol[0] > 0.0f || mon_vol[1] > 0.0f;
+        bool same_pair = capture->scratch_left_channel == capture->left_channel &&
+                         capture->scratch_right_channel == capture->right_channel;
+        bool read_scratch_pair = !same_pair && (recording[1] || mon_vol[1] > 0.0f);
+
+        if (recording[0] || recording[1] || monitoring || history) {
+            for (int d = 0; d < 2; d++) {
+                loop_buffer_set_overdub(&loop_[d], settings->loop_overdub,
+                                        static_cast<float>(settings->loop_feedback));
+            }
+
+            // Deinterleave a chunk at a time, then hand each consumer whole blocks
+            float pair[2][2 * CAPTURE_CHUNK];
             out_ptr = static_cast<uint8_t*>(playback);
 
-            for (unsigned long i = 0; i < frames; ++i) {
-                // Read capture samples using format-aware reader
-                float cap_l = read_capture_sample(capture->buffer, capture->format,
-                                                  capture->bytes_per_sample, i,
-                                                  capture->left_channel, capture->channels);
-                float cap_r = read_capture_sample(capture->buffer, capture->format,
-                                                  capture->bytes_per_sample, i,
-                                                  capture->right_channel, capture->channels);
-
-                // Write to loop buffer if recording (one sample at a time)
-                if (recording) {
-                    loop_buffer_write_float(&loop_[deck], cap_l, cap_r);
+            for (unsigned long done = 0; done < frames; done += CAPTURE_CHUNK) {
+                auto n = static_cast<unsigned int>(std::min<unsigned long>(CAPTURE_CHUNK, frames - done));
+
+                read_capture_pair(capture, done, n, capture->left_channel, capture->right_channel, pair[0]);
+                if (read_scratch_pair) {
+                    read_capture_pair(capture, done, n, capture->scratch_left_channel,
+                                      capture->scratch_right_channel, pair[1]);
+                }
+                const float* deck_input[2] = {pair[0], read_scratch_pair ? pair[1] : pair[0]};
+
+                for (int d = 0; d < 2; d++) {
+                    if (recording[d]) {
+                        loop_buffer_write_block(&loop_[d], deck_input[d], n);
+                    }
+                }
+
+                // Always keep the input history for grab_loop()
+                if (history) {
+                    for (unsigned int i = 0; i < n; i++) {
+                        capture_ring_.write(pair[0][2 * i], pair[0][2 * i + 1]);
+                    }
                 }
 
                 // Add monitoring: mix capture input into output
                 if (monitoring) {
-                    float out_l = FormatPolicy::read(out_ptr) + cap_l * mon_vol;
-                    float out_r = FormatPolicy::read(out_ptr + bytes_per_sample) + cap_r * mon_vol;
+                    for (unsigned int i = 0; i < n; i++) {
+                        float cap_l = deck_input[0][2 * i] * mon_vol[0] + deck_input[1][2 * i] * mon_vol[1];
+                        float cap_r = deck_input[0][2 * i + 1] * mon_vol[0] + deck_input[1][2 * i + 1] * mon_vol[1];
+                        float out_l = FormatPolicy::read(out_ptr) + cap_l;
+                        float out_r = FormatPolicy::read(out_ptr + bytes_per_sample) + cap_r;
 
-                    FormatPolicy::write(out_ptr, out_l);
-                    FormatPolicy::write(out_ptr + bytes_per_sample, out_r);
-                }
+                        FormatPolicy::write(out_ptr, out_l);
+                        FormatPolicy::write(out_ptr + bytes_per_sample, out_r);
 
-                out_ptr += frame_size;
+                        out_ptr += frame_size;
+                    }
+                }
             }
         }
-    } else if (recording) {
+    } else if (recording[0] || recording[1]) {
         // Capture not available but recording is active
         // Don't write anything - this preserves existing audio during punch-in
         // and avoids writing zeros at the start of first recording
         // The diagnostic in alsa.cpp will log when this happens
+        // A latency tail would never arrive, so stop without it
+        for (LoopBuffer& lb : loop_) {
+            if (lb.stopping) loop_buffer_stop_now(&lb);
+        }
+    }
+
+    // A quantized fresh loop plays from its start on the frame it closed on
+    for (int d = 0; d < 2; d++) {
+        if (!align_[d] || loop_buffer_is_recording(&loop_[d])) continue;
+
+        align_[d] = false;
+        if (has_loop(d)) {
+            uint64_t next = clock_frames_ + frames;
+            double into = next > loop_end_[d] ? static_cast<double>(next - loop_end_[d]) : 0.0;
+            deck_state_[d].position = std::fmod(into, static_cast<double>(loop_[d].loop_length)) /
+                                      loop_[d].sample_rate;
+            deck_state_[d].position_offset = 0.0;
+        }
+    }
+
+    // Latency calibration: click on the output, listen for it on the input
+    if (latency_probe_.running()) {
+        if (!has_capture) {
+            latency_probe_.fail();
+        } else {
+            long click = latency_probe_.click_frame(frames);
+            if (click >= 0) {
+                uint8_t* frame = static_cast<uint8_t*>(playback) + click * frame_size;
+                FormatPolicy::write(frame, FormatPolicy::read(frame) + LatencyProbe::CLICK_LEVEL);
+                FormatPolicy::write(frame + bytes_per_sample,
+                                    FormatPolicy::read(frame + bytes_per_sample) + LatencyProbe::CLICK_LEVEL);
+            }
+
+            float input[2 * CAPTURE_CHUNK];
+            for (unsigned long done = 0; done < frames; done += CAPTURE_CHUNK) {
+                auto n = static_cast<unsigned int>(std::min<unsigned long>(CAPTURE_CHUNK, frames - done));
+                read_capture_pair(capture, done, n, capture->left_channel, capture->right_channel, input);
+                latency_probe_.feed(input, n);
+            }
+        }
+
+        int latency = latency_probe_.take_result();
+        if (latency >= 0) {
+            set_record_latency(latency);
+        }
+    }
+
+    // Master recording: the output as heard, plus the input pair if asked for
+    MasterRecorder& recorder = engine->master_recorder;
+    int rec_channels = recorder.begin_block(frames);
+    if (rec_channels > 0) {
+        float block[MasterRecorder::MAX_CHANNELS * CAPTURE_CHUNK];
+        float input[2 * CAPTURE_CHUNK];
+        out_ptr = static_cast<uint8_t*>(playback);
+
+        for (unsigned long done = 0; done < frames; done += CAPTURE_CHUNK) {
+            auto n = static_cast<unsigned int>(std::min<unsigned long>(CAPTURE_CHUNK, frames - done));
+            bool with_input = rec_channels > 2;
+
+            if (with_input) {
+                if (has_capture) {
+                    read_capture_pair(capture, done, n, capture->left_channel, capture->right_channel, input);
+                } else {
+                    std::fill(input, input + 2 * n, 0.0f);
+                }
+            }
+
+            float* dst = block;
+            for (unsigned int i = 0; i < n; i++) {
+                dst[0] = FormatPolicy::read(out_ptr);
+                dst[1] = FormatPolicy::read(out_ptr + bytes_per_sample);
+                if (with_input) {
+                    dst[2] = input[2 * i];
+                    dst[3] = input[2 * i + 1];
+                }
+                dst += rec_channels;
+                out_ptr += frame_size;
+            }
+            recorder.write(block, n, rec_channels);
+        }
+        recorder.end_block();
     }
+
+    clock_frames_ += frames;
 }
 
 template<typename InterpPolicy, typename FormatPolicy>
@@ -545,8 +1117,9 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process(
     unsigned long frames)
 {
     double start_time = get_time_us();
+    double block_time = clock_ ? clock_() : start_time / 1000000.0;
 
-    process_players(engine, capture, playback, playback_channels, frames);
+    process_players(engine, capture, playback, playback_channels, frames, block_time);
 
     double end_time = get_time_us();
     double process_time = end_time - start_time;
@@ -568,6 +1141,9 @@ void AudioEngine<InterpPolicy, FormatPolicy>::process(
         stats_.xruns++;
     }
 
+    stats_.voices = engine->sampler.voices();
+    stats_.voice_limit = engine->sampler.limit();
+
 }
 
 //
@@ -666,6 +1242,8 @@ void audio_engine_get_stats(struct DspStats* stats) {
     stats->process_time_us = sc::audio::g_dsp_stats.process_time_us;
     stats->budget_time_us = sc::audio::g_dsp_stats.budget_time_us;
     stats->xruns = sc::audio::g_dsp_stats.xruns;
+    stats->voices = sc::audio::g_dsp_stats.voices;
+    stats->voice_limit = sc::audio::g_dsp_stats.voice_limit;
 }
 
 void audio_engine_update_global_stats(sc::audio::AudioEngineBase* engine) {
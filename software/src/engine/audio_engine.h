@@ -23,6 +23,8 @@
 #include "../core/sc1000.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <atomic>
+#include <functional>
 #include <memory>
 
 struct LoopBuffer;
@@ -52,6 +54,8 @@ struct DspStats {
     double process_time_us;   /* Last process time in microseconds */
     double budget_time_us;    /* Time budget per period in microseconds */
     unsigned long xruns;      /* Count of times we exceeded budget */
+    int voices;               /* Sampler voices playing */
+    int voice_limit;          /* Sampler voices the CPU budget allows */
 };
 
 /* Capture input info passed to audio engine (I/O data only, no state) */
@@ -62,6 +66,8 @@ struct AudioCapture {
     int channels;               /* Total channels in capture buffer */
     int left_channel;           /* Index of left channel */
     int right_channel;          /* Index of right channel */
+    int scratch_left_channel;   /* Pair recorded by the scratch deck (may equal left/right) */
+    int scratch_right_channel;
 };
 
 #ifdef __cplusplus
@@ -110,6 +116,11 @@ void audio_engine_update_global_stats(sc::audio::AudioEngineBase* engine);
 #include "sample_format.h"
 #include "interpolation_policy.h"
 #include "loop_buffer.h"
+#include "loop_pool.h"
+#include "capture_ring.h"
+#include "loop_snapshot.h"
+#include "latency_probe.h"
+#include "tempo_grid.h"
 #include "deck_processing_state.h"
 #include <alsa/asoundlib.h>
 
@@ -125,6 +136,26 @@ struct DspStats {
     double process_time_us = 0.0;
     double budget_time_us = 0.0;
     unsigned long xruns = 0;
+    int voices = 0;
+    int voice_limit = 0;
+};
+
+//
+// Loop roll or beat repeat of one deck: while active, a roll repeats
+// [start, end) in samples of track and a beat repeat jumps back to start
+// every period frames. Either way slip moves on to where it would be.
+//
+struct RollState {
+    bool active = false;
+    const Track* track = nullptr;
+    double start = 0.0;
+    double end = 0.0;
+    double slip = 0.0;
+    unsigned int fade = 0;        // Frames left of the crossfade over a jump
+    float fade_step = 0.0f;       // Gain step per frame of that crossfade
+    double fade_from = 0.0;       // Sample the crossfade fades out from
+    double period = 0.0;          // Beat repeat: output frames between retriggers (0 = loop roll)
+    double countdown = 0.0;       // Beat repeat: frames until the next retrigger
 };
 
 //
@@ -136,8 +167,12 @@ class AudioEngineBase {
 public:
     virtual ~AudioEngineBase() = default;
 
-    // Initialize loop buffers (call after construction, before processing)
-    virtual void init_loop_buffers(int sample_rate, int max_seconds) = 0;
+    // Initialize loop buffers (call after construction, before processing).
+    // Both decks record into one pool of pool_seconds (0 = max_seconds each)
+    virtual void init_loop_buffers(int sample_rate, int max_seconds, int pool_seconds) = 0;
+
+    // Keep the last seconds of capture input for grab_loop() (0 = off)
+    virtual void init_capture_ring(int sample_rate, int seconds) = 0;
 
     // Main processing function
     // capture: input audio (nullptr if not available)
@@ -154,22 +189,56 @@ public:
     virtual bool start_recording(int deck, double playback_position = 0.0) = 0;
     virtual void stop_recording(int deck) = 0;
     virtual bool is_recording(int deck) const = 0;
-    virtual int recording_deck() const = 0;
 
     // Loop track access
     virtual Track* get_loop_track(int deck) = 0;      // Acquires reference
     virtual Track* peek_loop_track(int deck) = 0;     // No ref change (RT-safe)
     virtual bool has_loop(int deck) const = 0;
-    virtual void reset_loop(int deck) = 0;
+    virtual void reset_loop(int deck) = 0;            // Audio thread, see DeckInput::loop_erase
+
+    // Make the last seconds of capture input the deck's loop, without copying
+    // (0 = all of the history). Call from the audio thread.
+    virtual bool grab_loop(int deck, double seconds) = 0;
+
+    // Make track the deck's loop, e.g. one restored from disk. Takes over
+    // a reference the caller holds, unless it returns false, see
+    // loop_buffer_adopt. Call from the audio thread, or before it runs.
+    virtual bool adopt_loop(int deck, Track* track) = 0;
+
+    // Release the loops the decks have dropped since the last call (input
+    // thread). The audio thread hands them back rather than releasing them.
+    virtual void collect_loops() = 0;
+
+    // Changes whenever the deck's loop does: recorded into, grabbed, adopted
+    // or erased. Any thread.
+    virtual unsigned int loop_version(int deck) const = 0;
 
-    // Monitoring volume for active recording deck
-    virtual void set_monitoring_volume(float volume) = 0;
-    virtual float monitoring_volume() const = 0;
+    // Start a copy-on-write snapshot of the deck's loop for saving. Later
+    // punch-ins do not change it. On failure the snapshot is refused.
+    // Call from the audio thread.
+    virtual bool snapshot_loop(int deck, LoopSnapshot* snapshot) = 0;
+
+    // Round-trip latency calibration: clicks on the output are timed on the
+    // capture input, which must be patched to it. A result is applied to
+    // recording at once. Start from the audio thread.
+    virtual bool start_latency_calibration() = 0;
+    virtual LatencyCalibration latency_calibration() const = 0;
+
+    // Frames by which the input lags what was heard; recordings are aligned by it
+    virtual void set_record_latency(int frames) = 0;
+
+    // Monitoring volume for a recording deck's input
+    virtual void set_monitoring_volume(int deck, float volume) = 0;
+    virtual float monitoring_volume(int deck) const = 0;
 
     // Stats
     virtual const DspStats& get_stats() const = 0;
     virtual void reset_peak() = 0;
 
+    // Clock (seconds) that input event timestamps are compared against when
+    // scheduling them into a block. Defaults to CLOCK_MONOTONIC.
+    virtual void set_clock(std::function<double()> clock) = 0;
+
     // === Query API for external code ===
     // These provide read-only access to deck state.
     // Thread-safe: audio engine writes, external code reads.
@@ -202,7 +271,8 @@ public:
     AudioEngine();
     ~AudioEngine() override;
 
-    void init_loop_buffers(int sample_rate, int max_seconds) override;
+    void init_loop_buffers(int sample_rate, int max_seconds, int pool_seconds) override;
+    void init_capture_ring(int sample_rate, int seconds) override;
 
     void process(
         Sc1000* engine,
@@ -215,17 +285,32 @@ public:
     bool start_recording(int deck, double playback_position = 0.0) override;
     void stop_recording(int deck) override;
     bool is_recording(int deck) const override;
-    int recording_deck() const override { return active_recording_deck_; }
 
     // Loop track access
     Track* get_loop_track(int deck) override;
     Track* peek_loop_track(int deck) override;
     bool has_loop(int deck) const override;
     void reset_loop(int deck) override;
+    bool grab_loop(int deck, double seconds) override;
+    bool adopt_loop(int deck, Track* track) override;
+    void collect_loops() override;
+    unsigned int loop_version(int deck) const override {
+        return (deck >= 0 && deck < 2) ? loop_version_[deck].load(std::memory_order_relaxed) : 0;
+    }
+    bool snapshot_loop(int deck, LoopSnapshot* snapshot) override;
+
+    // Latency calibration
+    bool start_latency_calibration() override;
+    LatencyCalibration latency_calibration() const override { return latency_probe_.status(); }
+    void set_record_latency(int frames) override;
 
     // Monitoring
-    void set_monitoring_volume(float volume) override { monitoring_volume_ = volume; }
-    float monitoring_volume() const override { return monitoring_volume_; }
+    void set_monitoring_volume(int deck, float volume) override {
+        if (deck >= 0 && deck < 2) monitoring_volume_[deck] = volume;
+    }
+    float monitoring_volume(int deck) const override {
+        return (deck >= 0 && deck < 2) ? monitoring_volume_[deck] : 0.0f;
+    }
 
     // Stats
     const DspStats& get_stats() const override { return stats_; }
@@ -234,6 +319,8 @@ public:
         stats_.xruns = 0;
     }
 
+    void set_clock(std::function<double()> clock) override { clock_ = std::move(clock); }
+
     // Query API
     DeckProcessingState get_deck_state(int deck) const override {
         if (deck < 0 || deck > 1) return DeckProcessingState{};
@@ -269,14 +356,31 @@ private:
     DspStats stats_{};
     DeckProcessingState deck_state_[2]{};  // Per-deck audio engine internal state
     LoopBuffer loop_[2]{};              // Loop buffers for both decks
-    int active_recording_deck_ = -1;     // Which deck is recording (-1 = none)
-    float monitoring_volume_ = 0.0f;     // Monitoring volume for recording
+    LoopPool loop_pool_;                 // Storage both loop buffers record into
+    CaptureRing capture_ring_;           // Always-on input history
+    SPSCQueue<Track*> released_loops_{16};  // Dropped loops, audio thread to input thread
+    LatencyProbe latency_probe_;         // Round-trip measurement in progress
+    float monitoring_volume_[2]{};       // Monitoring volume per recording deck
+    std::atomic<unsigned int> loop_version_[2]{};  // See loop_version()
     bool loop_buffers_initialized_ = false;
+    std::function<double()> clock_;      // Empty = CLOCK_MONOTONIC
+
+    // Quantizing: recording and loop roll snap to a beat grid on the output
+    TempoGrid grid_;
+    uint64_t clock_frames_ = 0;          // Output frames played, the grid's timeline
+    bool quantize_ = false;              // loop_quantize, as of the last block
+    unsigned int crossfade_frames_ = 0;  // loop_crossfade_ms, as of the last block
+    uint64_t record_start_[2]{};         // Frame a quantized recording starts on
+    uint64_t loop_end_[2]{};             // Frame a quantized fresh loop closes on
+    bool align_[2]{};                    // Loop closing: play it from its start at loop_end_
+    RollState roll_[2]{};
 
     // Setup player parameters for the block
+    // pitch_frame: frame at which a timed MIDI pitch change snaps in (0 = block start)
     void setup_player(Player* pl, DeckProcessingState* state, unsigned long samples,
                       const ScSettings* settings, double track_length_seconds,
-                      double* target_volume, double* filtered_pitch);
+                      double block_time, double* target_volume, double* filtered_pitch,
+                      unsigned long* pitch_frame);
 
     // Process and mix both players
     void process_players(
@@ -284,7 +388,8 @@ private:
         AudioCapture* capture,
         void* playback,
         int channels,
-        unsigned long frames);
+        unsigned long frames,
+        double block_time);
 };
 
 //
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Capture Ring - always-on history of the capture input
+//
+
+#include "capture_ring.h"
+#include "../player/track.h"
+#include "../util/log.h"
+
+#include <algorithm>
+#include <new>
+
+namespace sc {
+namespace audio {
+
+CaptureRing::~CaptureRing()
+{
+    clear();
+}
+
+bool CaptureRing::init(int sample_rate, int seconds)
+{
+    clear();
+
+    if (sample_rate <= 0 || seconds <= 0) {
+        return true;
+    }
+
+    auto capacity = static_cast<unsigned int>(sample_rate * seconds);
+
+    for (int i = 0; i < BUFFERS; i++) {
+        // Zeroed, so the pages are resident before the audio thread writes
+        data_[i].reset(new (std::nothrow) int16_t[4 * static_cast<size_t>(capacity)]());
+        track_[i] = track_acquire_for_recording(sample_rate);
+        if (!data_[i] || !track_[i]) {
+            LOG_ERROR("CaptureRing: failed to allocate %d seconds", seconds);
+            clear();
+            return false;
+        }
+    }
+
+    active_ = 0;
+    live_ = data_[0].get();
+    capacity_ = capacity;
+    pos_ = 0;
+    filled_ = 0;
+
+    LOG_INFO("CaptureRing: keeping the last %d seconds of input", seconds);
+    return true;
+}
+
+void CaptureRing::clear()
+{
+    for (int i = 0; i < BUFFERS; i++) {
+        if (track_[i]) {
+            track_release(track_[i]);
+            track_[i] = nullptr;
+        }
+        in_use_[i].store(false, std::memory_order_relaxed);
+        data_[i].reset();
+    }
+
+    live_ = nullptr;
+    capacity_ = 0;
+    pos_ = 0;
+    filled_ = 0;
+}
+
+Track* CaptureRing::grab(unsigned int frames)
+{
+    frames = std::min(frames, filled_);
+    if (frames == 0) {
+        return nullptr;
+    }
+
+    // Somewhere to keep writing: a buffer no deck holds
+    int next = -1;
+    for (int i = 1; i < BUFFERS && next < 0; i++) {
+        int candidate = (active_ + i) % BUFFERS;
+        if (!in_use_[candidate].load(std::memory_order_acquire)) {
+            next = candidate;
+        }
+    }
+    if (next < 0) {
+        return nullptr;
+    }
+
+    // The span ends at pos_ in the mirrored half, so it never wraps. The
+    // track's block count stays 0: it does not own this memory
+    Track* t = track_[active_];
+    int16_t* start = live_ + 2 * (pos_ + capacity_ - frames);
+    unsigned int blocks = (frames + TRACK_BLOCK_SAMPLES - 1) / TRACK_BLOCK_SAMPLES;
+    for (unsigned int b = 0; b < blocks; b++) {
+        t->block[b] = reinterpret_cast<TrackBlock*>(
+            start + static_cast<size_t>(b) * TRACK_BLOCK_SAMPLES * TRACK_CHANNELS);
+    }
+    t->set_length(frames);
+    in_use_[active_].store(true, std::memory_order_relaxed);
+
+    active_ = next;
+    live_ = data_[next].get();
+    pos_ = 0;
+    filled_ = 0;
+
+    return t;
+}
+
+bool CaptureRing::give_back(const Track* track)
+{
+    for (int i = 0; i < BUFFERS; i++) {
+        if (track_[i] && track_[i] == track) {
+            in_use_[i].store(false, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace audio
+} // namespace sc
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Capture Ring - always-on history of the capture input
+//
+// The audio thread writes every captured frame into a circular buffer, so
+// the last N seconds can be turned into a loop after the fact. Each frame is
+// stored twice, at pos and pos + capacity, which keeps any span of up to
+// capacity frames contiguous in memory. A grabbed span becomes a Track whose
+// blocks point straight into the buffer: no copy, no allocation.
+//
+// A grabbed buffer is frozen while a deck plays it and writing moves on to a
+// free one, so there is one buffer per deck plus the one being written.
+// Writing and grabbing run on the audio thread. A grabbed buffer is marked
+// in use by the ring itself, never through the track's refcount, and is
+// given back from the input thread once the deck has dropped it.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "loop_buffer.h"
+
+namespace sc {
+namespace audio {
+
+class CaptureRing {
+public:
+    static constexpr int BUFFERS = 3;
+
+    CaptureRing() = default;
+    ~CaptureRing();
+
+    CaptureRing(const CaptureRing&) = delete;
+    CaptureRing& operator=(const CaptureRing&) = delete;
+
+    // Allocate the buffers (not RT-safe). seconds <= 0 disables the ring.
+    // Returns false if allocation failed, leaving the ring disabled
+    bool init(int sample_rate, int seconds);
+
+    // Free the buffers. Grabbed tracks must have been released
+    void clear();
+
+    bool enabled() const { return capacity_ > 0; }
+
+    // Frames held per buffer, and how many are filled since the last grab
+    unsigned int capacity() const { return capacity_; }
+    unsigned int filled() const { return filled_; }
+
+    // Append one frame (float [-1, 1]) to the buffer being written
+    void write(float left, float right)
+    {
+        int16_t* frame = live_ + 2 * pos_;
+        int16_t* mirror = frame + 2 * capacity_;
+        frame[0] = mirror[0] = float_to_s16(left);
+        frame[1] = mirror[1] = float_to_s16(right);
+
+        if (++pos_ == capacity_) pos_ = 0;
+        if (filled_ < capacity_) filled_++;
+    }
+
+    // Turn the last frames (clamped to what is filled) into a track and
+    // continue writing into a free buffer. The ring keeps the only reference;
+    // the buffer stays frozen until give_back(). Returns nullptr if nothing
+    // is filled or every other buffer is still in use
+    Track* grab(unsigned int frames);
+
+    // Let the buffer of a grabbed track be written again. Returns false if
+    // track is not one of the ring's. Any thread.
+    bool give_back(const Track* track);
+
+private:
+    std::unique_ptr<int16_t[]> data_[BUFFERS];
+    Track* track_[BUFFERS] = {};
+    std::atomic<bool> in_use_[BUFFERS] = {};  // Grabbed and not given back yet
+    int active_ = 0;
+
+    int16_t* live_ = nullptr;     // data_[active_]
+    unsigned int capacity_ = 0;   // Frames per buffer (each stored twice)
+    unsigned int pos_ = 0;        // Next frame to write
+    unsigned int filled_ = 0;
+};
+
+} // namespace audio
+} // namespace sc
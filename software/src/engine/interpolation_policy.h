@@ -26,6 +26,7 @@
 // Usage:
 //   auto result = CubicInterpolation::interpolate(tr1, pos1, len1, pitch1,
 //                                                  tr2, pos2, len2, pitch2);
+//   auto voice = CubicInterpolation::interpolate_one(tr, pos, len, pitch);
 
 #pragma once
 
@@ -43,6 +44,13 @@ struct DualDeckSamples {
     float l2, r2;  // Scratch deck (left, right)
 };
 
+//
+// Result type for a single track (sampler voices)
+//
+struct StereoSample {
+    float left, right;
+};
+
 //
 // Cubic interpolation policy (4-tap Catmull-Rom)
 // Fast, no anti-aliasing
@@ -61,6 +69,12 @@ struct CubicInterpolation {
 
         return {result.l1, result.r1, result.l2, result.r2};
     }
+
+    static inline StereoSample interpolate_one(Track* tr, double sample_pos, int tr_len, float /* pitch */)
+    {
+        auto result = dsp::cubic_interpolate_track_opt(tr, sample_pos, tr_len);
+        return {result.left, result.right};
+    }
 };
 
 //
@@ -81,6 +95,12 @@ struct SincInterpolation {
 
         return {result.l1, result.r1, result.l2, result.r2};
     }
+
+    static inline StereoSample interpolate_one(Track* tr, double sample_pos, int tr_len, float pitch)
+    {
+        auto result = dsp::sinc_interpolate_track_opt(tr, sample_pos, tr_len, std::fabs(pitch));
+        return {result.left, result.right};
+    }
 };
 
 //
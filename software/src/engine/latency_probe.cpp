@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Latency Probe - measures the round trip from output to capture
+//
+
+#include "latency_probe.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sc {
+namespace audio {
+
+// A click must stand out this far above the noise floor, and this far
+// from silence, to count
+static constexpr float NOISE_MARGIN = 4.0f;
+static constexpr float MIN_LEVEL = 0.02f;
+
+bool LatencyProbe::start(int sample_rate)
+{
+    if (running_) return false;
+
+    // Half a second per click, far more than any interface's round trip
+    interval_ = static_cast<unsigned long>(sample_rate / 2);
+    pos_ = 0;
+    noise_ = 0.0f;
+    std::fill(peak_, peak_ + PINGS, 0.0f);
+    std::fill(peak_at_, peak_at_ + PINGS, 0UL);
+    result_ = -2;
+    running_ = true;
+    state_.store(static_cast<int>(LatencyCalibration::State::Running), std::memory_order_release);
+    return true;
+}
+
+long LatencyProbe::click_frame(unsigned long frames) const
+{
+    if (!running_) return -1;
+
+    // Clicks at interval, 2 * interval, ... PINGS * interval
+    unsigned long next = std::max(interval_, (pos_ + interval_ - 1) / interval_ * interval_);
+    if (next > PINGS * interval_ || next >= pos_ + frames) {
+        return -1;
+    }
+    return static_cast<long>(next - pos_);
+}
+
+void LatencyProbe::feed(const float* input, unsigned int n)
+{
+    if (!running_) return;
+
+    for (unsigned int i = 0; i < n; i++, pos_++) {
+        float level = std::max(std::fabs(input[2 * i]), std::fabs(input[2 * i + 1]));
+        if (pos_ < interval_) {
+            noise_ = std::max(noise_, level);
+            continue;
+        }
+
+        unsigned long ping = pos_ / interval_ - 1;
+        if (ping >= PINGS) {
+            finish();
+            return;
+        }
+        if (level > peak_[ping]) {
+            peak_[ping] = level;
+            peak_at_[ping] = pos_ - (ping + 1) * interval_;
+        }
+    }
+}
+
+void LatencyProbe::fail()
+{
+    if (!running_) return;
+
+    running_ = false;
+    result_ = -1;
+    state_.store(static_cast<int>(LatencyCalibration::State::Failed), std::memory_order_release);
+    runs_.fetch_add(1, std::memory_order_release);
+}
+
+void LatencyProbe::finish()
+{
+    // Clicks lost in the noise don't count, the median of the rest does
+    float threshold = std::max(MIN_LEVEL, noise_ * NOISE_MARGIN);
+    unsigned long found[PINGS];
+    int count = 0;
+    for (int p = 0; p < PINGS; p++) {
+        if (peak_[p] > threshold) {
+            found[count++] = peak_at_[p];
+        }
+    }
+
+    if (count <= PINGS / 2) {
+        fail();
+        return;
+    }
+
+    // At most PINGS entries: a plain insertion sort
+    for (int i = 1; i < count; i++) {
+        unsigned long v = found[i];
+        int j = i;
+        for (; j > 0 && found[j - 1] > v; j--) {
+            found[j] = found[j - 1];
+        }
+        found[j] = v;
+    }
+    running_ = false;
+    result_ = static_cast<int>(found[count / 2]);
+    frames_.store(result_, std::memory_order_relaxed);
+    state_.store(static_cast<int>(LatencyCalibration::State::Done), std::memory_order_release);
+    runs_.fetch_add(1, std::memory_order_release);
+}
+
+int LatencyProbe::take_result()
+{
+    int result = result_;
+    if (result != -2) {
+        result_ = -2;
+    }
+    return result;
+}
+
+LatencyCalibration LatencyProbe::status() const
+{
+    LatencyCalibration s;
+    s.runs = runs_.load(std::memory_order_acquire);
+    s.state = static_cast<LatencyCalibration::State>(state_.load(std::memory_order_acquire));
+    s.frames = frames_.load(std::memory_order_relaxed);
+    return s;
+}
+
+} // namespace audio
+} // namespace sc
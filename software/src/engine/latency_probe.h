@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Latency Probe - measures the round trip from output to capture
+//
+// With the output patched back into the input, the probe listens to the
+// input for a moment to learn the noise floor, then plays a few single
+// sample clicks and finds each one in the capture stream. The median
+// distance in frames is the round-trip latency, by which recordings are
+// late relative to what was heard.
+//
+// Runs on the audio thread; the result is published through atomics so
+// other threads can poll it.
+//
+
+#pragma once
+
+#include <atomic>
+
+namespace sc {
+namespace audio {
+
+struct LatencyCalibration {
+    enum class State { Idle, Running, Done, Failed };
+
+    State state = State::Idle;
+    int frames = 0;           // Measured round trip (when Done)
+    unsigned int runs = 0;    // Calibrations finished so far
+};
+
+class LatencyProbe {
+public:
+    static constexpr int PINGS = 5;
+    static constexpr float CLICK_LEVEL = 0.5f;
+
+    // === Audio thread ===
+
+    // Begin a calibration. Returns false if one is running
+    bool start(int sample_rate);
+
+    bool running() const { return running_; }
+
+    // Frame of the coming block of frames to click at, or -1 if none
+    long click_frame(unsigned long frames) const;
+
+    // Analyse the next n frames of the input pair (interleaved stereo)
+    void feed(const float* input, unsigned int n);
+
+    // Give up, e.g. when the capture goes away
+    void fail();
+
+    // Round trip in frames once finished, -1 on failure. Reading it
+    // clears it, so it is applied once.
+    int take_result();
+
+    // === Any thread ===
+    LatencyCalibration status() const;
+
+private:
+    void finish();
+
+    bool running_ = false;
+    unsigned long interval_ = 0;      // Frames between clicks (and listened before)
+    unsigned long pos_ = 0;           // Frames fed since start
+    float noise_ = 0.0f;              // Loudest input before the first click
+    float peak_[PINGS] = {};          // Loudest input after each click
+    unsigned long peak_at_[PINGS] = {};
+    int result_ = -2;                 // -2 = nothing to take
+
+    std::atomic<int> state_{static_cast<int>(LatencyCalibration::State::Idle)};
+    std::atomic<int> frames_{0};
+    std::atomic<unsigned int> runs_{0};
+};
+
+} // namespace audio
+} // namespace sc
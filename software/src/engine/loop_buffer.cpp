@@ -24,15 +24,20 @@
 // Workflow:
 // 1. First RECORD: captures audio, defines loop length when stopped
 // 2. Subsequent RECORDs: punch-in mode, overwrites circularly from current position
+//    (or, in overdub mode, mixes into the loop with the old layers decaying)
 // 3. Long-hold RECORD: resets/erases, next RECORD starts fresh
 //
 
 #include "loop_buffer.h"
+#include "loop_pool.h"
+#include "loop_snapshot.h"
 #include "../player/track.h"
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
 
-void loop_buffer_init(struct LoopBuffer* lb, int sample_rate, int max_seconds)
+void loop_buffer_init(struct LoopBuffer* lb, int sample_rate, int max_seconds,
+                      sc::audio::LoopPool* pool, sc::SPSCQueue<Track*>* released)
 {
     lb->write_pos = 0;
     lb->max_samples = static_cast<unsigned int>(sample_rate * max_seconds);
@@ -41,45 +46,129 @@ void loop_buffer_init(struct LoopBuffer* lb, int sample_rate, int max_seconds)
     lb->recording = false;
     lb->length_locked = false;
     lb->max_reached = false;
-
-    // Pre-allocate track with full capacity to avoid RT allocation
+    lb->overdub = false;
+    lb->feedback = 1.0f;
+    lb->latency = 0;
+    lb->skip = 0;
+    lb->tail = 0;
+    lb->stopping = false;
+    lb->splice = 0;
+    lb->snapshot = nullptr;
+    lb->released = released;
+    lb->retired = nullptr;
+    lb->pool = pool;
+    lb->blocks = 0;
+
+    // Storage comes from the shared pool while recording, avoiding RT allocation
     lb->track = track_acquire_for_recording(sample_rate);
-    if (lb->track)
+    lb->storage = lb->track;
+    if (!lb->track)
     {
-        // Pre-allocate all the space we'll need
-        if (lb->track->ensure_space(lb->max_samples) < 0)
-        {
-            fprintf(stderr, "LoopBuffer: failed to pre-allocate %u samples\n", lb->max_samples);
-            track_release(lb->track);
-            lb->track = nullptr;
-        }
-        else
+        fprintf(stderr, "LoopBuffer: failed to create track\n");
+    }
+}
+
+// Give storage blocks beyond the first keep back to the pool
+static void release_blocks(struct LoopBuffer* lb, unsigned int keep)
+{
+    while (lb->blocks > keep)
+    {
+        lb->blocks--;
+        lb->pool->give_back(lb->storage->block[lb->blocks]);
+        lb->storage->block[lb->blocks] = nullptr;
+    }
+}
+
+// Make sure storage holds the block for sample pos, taking one from the pool
+static bool take_block(struct LoopBuffer* lb, unsigned int pos)
+{
+    unsigned int needed = pos / TRACK_BLOCK_SAMPLES + 1;
+    while (lb->blocks < needed)
+    {
+        TrackBlock* block = lb->pool ? lb->pool->take() : nullptr;
+        if (!block)
         {
-            printf("LoopBuffer: pre-allocated %u samples (%.1f sec)\n",
-                   lb->max_samples, static_cast<float>(lb->max_samples) / sample_rate);
+            return false;
         }
+        lb->storage->block[lb->blocks++] = block;
     }
-    else
+    return true;
+}
+
+// Queue a dropped adopted track for release. One a save still reads waits
+// for the save to detach: a capture ring buffer must not be written over
+// before then. The queue can't fill up, every track in it was adopted first
+// and there is at most one of those per ring buffer and restored loop
+static void hand_back(struct LoopBuffer* lb, Track* track)
+{
+    if (lb->snapshot && lb->snapshot->source() == track)
     {
-        fprintf(stderr, "LoopBuffer: failed to create track\n");
+        lb->retired = track;
+    }
+    else if (!lb->released->try_enqueue(track))
+    {
+        fprintf(stderr, "LoopBuffer: release queue full, track leaked\n");
+    }
+}
+
+// Go back to the recording track, dropping an adopted one
+static void drop_adopted(struct LoopBuffer* lb)
+{
+    if (lb->track != lb->storage)
+    {
+        hand_back(lb, lb->track);
+        lb->track = lb->storage;
+    }
+}
+
+void loop_buffer_detach_snapshot(struct LoopBuffer* lb)
+{
+    if (!lb->snapshot)
+    {
+        return;
+    }
+
+    lb->snapshot->detach();
+    lb->snapshot = nullptr;
+    if (lb->retired)
+    {
+        hand_back(lb, lb->retired);
+        lb->retired = nullptr;
     }
 }
 
 void loop_buffer_clear(struct LoopBuffer* lb)
 {
+    // Finish a save in progress before the track can go away
+    if (lb->snapshot)
+    {
+        lb->snapshot->preserve_all();
+        loop_buffer_detach_snapshot(lb);
+    }
+
+    drop_adopted(lb);
     if (lb->track)
     {
+        lb->track->set_length(0);
+        release_blocks(lb, 0);
         track_release(lb->track);
         lb->track = nullptr;
+        lb->storage = nullptr;
     }
     lb->write_pos = 0;
     lb->loop_length = 0;
     lb->recording = false;
+    lb->stopping = false;
     lb->length_locked = false;
     lb->max_reached = false;
 }
 
 bool loop_buffer_start(struct LoopBuffer* lb)
+{
+    return loop_buffer_start_at(lb, 0);
+}
+
+bool loop_buffer_start_at(struct LoopBuffer* lb, unsigned int wait)
 {
     if (lb->recording)
     {
@@ -96,6 +185,8 @@ bool loop_buffer_start(struct LoopBuffer* lb)
     {
         // Punch-in mode: keep existing data, start overwriting from current write_pos
         lb->recording = true;
+        lb->stopping = false;
+        lb->skip = wait;
         lb->max_reached = false;
         printf("LoopBuffer: punch-in recording started at pos %u (loop length %u samples, %.2f sec)\n",
                lb->write_pos, lb->loop_length,
@@ -103,18 +194,63 @@ bool loop_buffer_start(struct LoopBuffer* lb)
         return true;
     }
 
-    // Fresh recording: reset state but reuse pre-allocated track
+    // Fresh recording: reset state, blocks still held are written first
+    drop_adopted(lb);
     lb->write_pos = 0;
     lb->loop_length = 0;
     lb->length_locked = false;
     lb->max_reached = false;
     lb->recording = true;
+    lb->stopping = false;
+
+    // What was heard when recording started reaches the input latency frames later
+    lb->skip = lb->latency + wait;
 
     printf("LoopBuffer: fresh recording started (max %u samples)\n", lb->max_samples);
     return true;
 }
 
 void loop_buffer_stop(struct LoopBuffer* lb)
+{
+    loop_buffer_stop_at(lb, 0);
+}
+
+void loop_buffer_stop_at(struct LoopBuffer* lb, unsigned int wait)
+{
+    if (!lb->recording || lb->stopping)
+    {
+        return;
+    }
+
+    // Keep recording until the input has caught up with the stop, counted
+    // from the end of the skip; a fresh loop also records its splice
+    unsigned int end = lb->latency + wait + (lb->length_locked ? 0 : lb->splice);
+    if (end > lb->skip)
+    {
+        lb->stopping = true;
+        lb->tail = end - lb->skip;
+        return;
+    }
+
+    loop_buffer_stop_now(lb);
+}
+
+// Fold the frames recorded past the loop end into its start, fading from
+// them into the loop, so the end runs into the start without a click
+static void splice_loop(struct LoopBuffer* lb)
+{
+    const unsigned int n = lb->splice;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        const float g = (static_cast<float>(i) + 0.5f) / static_cast<float>(n);
+        signed short* head = lb->track->get_sample(static_cast<int>(i));
+        const signed short* over = lb->track->get_sample(static_cast<int>(lb->loop_length + i));
+        head[0] = static_cast<signed short>(head[0] * g + over[0] * (1.0f - g));
+        head[1] = static_cast<signed short>(head[1] * g + over[1] * (1.0f - g));
+    }
+}
+
+void loop_buffer_stop_now(struct LoopBuffer* lb)
 {
     if (!lb->recording)
     {
@@ -122,6 +258,7 @@ void loop_buffer_stop(struct LoopBuffer* lb)
     }
 
     lb->recording = false;
+    lb->stopping = false;
 
     if (!lb->length_locked)
     {
@@ -129,6 +266,11 @@ void loop_buffer_stop(struct LoopBuffer* lb)
         if (lb->track && lb->write_pos > 0)
         {
             lb->loop_length = lb->write_pos;
+            if (lb->splice > 0 && lb->write_pos > 2 * lb->splice)
+            {
+                lb->loop_length -= lb->splice;
+                splice_loop(lb);
+            }
             lb->length_locked = true;
             lb->track->set_length(lb->loop_length);
             printf("LoopBuffer: loop defined, %u samples (%.2f sec)\n",
@@ -138,6 +280,7 @@ void loop_buffer_stop(struct LoopBuffer* lb)
         {
             printf("LoopBuffer: recording stopped (empty)\n");
         }
+        loop_buffer_release_unused(lb);
     }
     else
     {
@@ -146,25 +289,68 @@ void loop_buffer_stop(struct LoopBuffer* lb)
     }
 }
 
-// Helper to convert float [-1, 1] to S16
-static inline int16_t float_to_s16(float sample)
+// Write n frames to one contiguous run of samples. Overdub keeps what is
+// there, scaled by feedback, and adds the input on top.
+static void write_span(signed short* dest, const float* frames, unsigned int n,
+                       bool overdub, float feedback)
+{
+    const unsigned int samples = n * 2;
+
+    if (overdub)
+    {
+        const float gain = feedback / 32767.0f;
+        for (unsigned int i = 0; i < samples; i++)
+        {
+            dest[i] = float_to_s16(static_cast<float>(dest[i]) * gain + frames[i]);
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < samples; i++)
+        {
+            dest[i] = float_to_s16(frames[i]);
+        }
+    }
+}
+
+// Frames from pos to the end of its track block
+static unsigned int block_remaining(unsigned int pos)
 {
-    // Clamp and scale
-    float clamped = sample;
-    if (clamped > 1.0f) clamped = 1.0f;
-    if (clamped < -1.0f) clamped = -1.0f;
-    return static_cast<int16_t>(clamped * 32767.0f);
+    return TRACK_BLOCK_SAMPLES - pos % TRACK_BLOCK_SAMPLES;
 }
 
-unsigned int loop_buffer_write_float(struct LoopBuffer* lb,
-                                     float left,
-                                     float right)
+unsigned int loop_buffer_write_block(struct LoopBuffer* lb,
+                                     const float* frames,
+                                     unsigned int count)
 {
     if (!lb->recording || !lb->track)
     {
         return 0;
     }
 
+    // Input from before the start, as it was heard
+    if (lb->skip > 0)
+    {
+        unsigned int n = std::min(lb->skip, count);
+        lb->skip -= n;
+        frames += 2 * n;
+        count -= n;
+
+        // A punch-in waiting for its start keeps pace with the loop
+        if (lb->length_locked && lb->loop_length > 0)
+        {
+            lb->write_pos = (lb->write_pos + n) % lb->loop_length;
+        }
+    }
+
+    // After a stop only the tail is left
+    if (lb->stopping)
+    {
+        count = std::min(count, lb->tail);
+    }
+
+    unsigned int written = 0;
+
     if (lb->length_locked)
     {
         // Punch-in mode: write circularly within loop_length
@@ -173,43 +359,72 @@ unsigned int loop_buffer_write_float(struct LoopBuffer* lb,
             return 0;  // Shouldn't happen, but safety check
         }
 
-        unsigned int pos = lb->write_pos % lb->loop_length;
-        signed short* dest = lb->track->get_sample(static_cast<int>(pos));
+        while (written < count)
+        {
+            unsigned int pos = lb->write_pos % lb->loop_length;
+            unsigned int span = std::min({count - written, lb->loop_length - pos, block_remaining(pos)});
 
-        dest[0] = float_to_s16(left);
-        dest[1] = float_to_s16(right);
+            if (lb->snapshot)
+            {
+                lb->snapshot->preserve(lb->track, pos, span);
+            }
+            write_span(lb->track->get_sample(static_cast<int>(pos)), frames + 2 * written, span,
+                       lb->overdub, lb->feedback);
 
-        lb->write_pos++;
-        // Wrap write_pos to avoid overflow over time
-        lb->write_pos = lb->write_pos % lb->loop_length;
+            written += span;
+            lb->write_pos = (pos + span) % lb->loop_length;
+        }
     }
     else
     {
-        // Fresh recording: linear write until max (space is pre-allocated)
-        unsigned int remaining = lb->max_samples - lb->write_pos;
-        if (remaining == 0)
+        // Fresh recording: linear write until max, taking pool blocks as needed
+        while (written < count)
         {
-            if (!lb->max_reached)
+            unsigned int remaining = lb->max_samples - lb->write_pos;
+            bool pool_empty = remaining > 0 && !take_block(lb, lb->write_pos);
+            if (remaining == 0 || pool_empty)
             {
-                lb->max_reached = true;
-                printf("LoopBuffer: max length reached\n");
+                if (!lb->max_reached)
+                {
+                    lb->max_reached = true;
+                    printf("LoopBuffer: %s\n", pool_empty ? "loop pool used up" : "max length reached");
+                }
+                break;
             }
-            return 0;
-        }
 
-        // Write sample to track (space is pre-allocated, no RT allocation)
-        signed short* dest = lb->track->get_sample(static_cast<int>(lb->write_pos));
+            unsigned int span = std::min({count - written, remaining, block_remaining(lb->write_pos)});
 
-        dest[0] = float_to_s16(left);
-        dest[1] = float_to_s16(right);
+            if (lb->snapshot)
+            {
+                lb->snapshot->preserve(lb->track, lb->write_pos, span);
+            }
+            write_span(lb->track->get_sample(static_cast<int>(lb->write_pos)), frames + 2 * written, span,
+                       false, 0.0f);
 
-        lb->write_pos++;
+            written += span;
+            lb->write_pos += span;
+        }
 
         // Update track length as we go (allows scratching while recording)
         lb->track->set_length(lb->write_pos);
     }
 
-    return 1;
+    if (lb->stopping)
+    {
+        lb->tail -= count;
+        if (lb->tail == 0)
+        {
+            loop_buffer_stop_now(lb);
+        }
+    }
+
+    return written;
+}
+
+void loop_buffer_set_overdub(struct LoopBuffer* lb, bool overdub, float feedback)
+{
+    lb->overdub = overdub;
+    lb->feedback = feedback < 0.0f ? 0.0f : (feedback > 1.0f ? 1.0f : feedback);
 }
 
 Track* loop_buffer_get_track(struct LoopBuffer* lb)
@@ -251,17 +466,61 @@ void loop_buffer_reset(struct LoopBuffer* lb)
     if (lb->recording)
     {
         lb->recording = false;
+        lb->stopping = false;
     }
 
-    // Reset state but keep pre-allocated track
+    // Reset state, the other deck may use the blocks now
+    drop_adopted(lb);
     lb->write_pos = 0;
     lb->loop_length = 0;
     lb->length_locked = false;
     lb->max_reached = false;
+    loop_buffer_release_unused(lb);
 
     printf("LoopBuffer: reset/erased\n");
 }
 
+bool loop_buffer_adopt(struct LoopBuffer* lb, Track* track)
+{
+    if (lb->recording || !track || track->length == 0)
+    {
+        return false;
+    }
+
+    drop_adopted(lb);
+    lb->track = track;
+
+    lb->write_pos = 0;
+    lb->loop_length = track->length;
+    lb->length_locked = true;
+    lb->max_reached = false;
+    loop_buffer_release_unused(lb);
+
+    printf("LoopBuffer: adopted %u samples (%.2f sec)\n",
+           lb->loop_length, static_cast<float>(lb->loop_length) / static_cast<float>(lb->sample_rate));
+    return true;
+}
+
+void loop_buffer_release_unused(struct LoopBuffer* lb)
+{
+    if (lb->recording || lb->snapshot || !lb->storage)
+    {
+        return;
+    }
+
+    // All of storage goes while another track is the loop
+    unsigned int keep = 0;
+    if (lb->track == lb->storage && lb->length_locked)
+    {
+        keep = (lb->loop_length + TRACK_BLOCK_SAMPLES - 1) / TRACK_BLOCK_SAMPLES;
+    }
+    else
+    {
+        lb->storage->set_length(0);
+    }
+    release_blocks(lb, keep);
+}
+
 void loop_buffer_set_position(struct LoopBuffer* lb, unsigned int position_samples)
 {
     if (!lb->length_locked || lb->loop_length == 0)
@@ -270,6 +529,17 @@ void loop_buffer_set_position(struct LoopBuffer* lb, unsigned int position_sampl
         return;
     }
 
-    // Clamp to valid range
-    lb->write_pos = position_samples % lb->loop_length;
+    // Clamp to valid range, moved back by the latency
+    unsigned int latency = lb->latency % lb->loop_length;
+    lb->write_pos = (position_samples % lb->loop_length + lb->loop_length - latency) % lb->loop_length;
+}
+
+void loop_buffer_set_latency(struct LoopBuffer* lb, unsigned int frames)
+{
+    lb->latency = frames;
+}
+
+void loop_buffer_set_splice(struct LoopBuffer* lb, unsigned int frames)
+{
+    lb->splice = frames;
 }
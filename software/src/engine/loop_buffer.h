@@ -27,13 +27,20 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "../util/spsc_queue.h"
+
 struct Track;
 
+namespace sc { namespace audio { class LoopSnapshot; class LoopPool; } }
+
 //
 // Loop Buffer State
 //
 struct LoopBuffer {
     Track* track;          // Underlying track with block storage
+    Track* storage;        // Recording track, track points here unless one was adopted
+    sc::audio::LoopPool* pool;    // Where storage gets its blocks from
+    unsigned int blocks;          // Pool blocks storage holds (its blocks field stays 0)
     unsigned int write_pos;       // Current write position (samples)
     unsigned int max_samples;     // Maximum recording length (samples)
     unsigned int loop_length;     // Defined loop length (set after first recording)
@@ -41,27 +48,76 @@ struct LoopBuffer {
     bool recording;               // Currently recording?
     bool length_locked;           // Loop length defined (first recording complete)?
     bool max_reached;             // Hit max length during recording?
+    bool overdub;                 // Punch-in mixes into the loop instead of replacing it
+    float feedback;               // Overdub: gain applied to the existing loop per pass
+    unsigned int latency;         // Round trip (frames) by which input lags what was heard
+    unsigned int skip;            // Input frames still to drop at the start of a recording
+    unsigned int tail;            // Input frames still to record after a stop
+    bool stopping;                // Stop requested, recording the tail
+    unsigned int splice;          // Frames a fresh loop records past its end to crossfade into its start
+    sc::audio::LoopSnapshot* snapshot;  // Save in progress, old audio is kept before writes
+    sc::SPSCQueue<Track*>* released;    // Dropped adopted tracks, released off the audio thread
+    Track* retired;               // Dropped adopted track the save still reads, queued on detach
 };
 
-// Initialize loop buffer with sample rate and max recording time
-void loop_buffer_init(struct LoopBuffer* lb, int sample_rate, int max_seconds);
-
-// Clear loop buffer (release track, reset state)
+// Convert float [-1, 1] to the S16 samples tracks are stored in
+static inline int16_t float_to_s16(float sample)
+{
+    // Clamp and scale
+    float clamped = sample;
+    if (clamped > 1.0f) clamped = 1.0f;
+    if (clamped < -1.0f) clamped = -1.0f;
+    return static_cast<int16_t>(clamped * 32767.0f);
+}
+
+// Initialize loop buffer with sample rate and max recording time. Storage
+// is taken from pool as the recording grows, up to max_seconds. Adopted
+// tracks are handed back through released once dropped; the audio thread
+// never changes a track's refcount
+void loop_buffer_init(struct LoopBuffer* lb, int sample_rate, int max_seconds,
+                      sc::audio::LoopPool* pool, sc::SPSCQueue<Track*>* released);
+
+// Clear loop buffer (release track and pool blocks, reset state)
 void loop_buffer_clear(struct LoopBuffer* lb);
 
 // Start recording - creates new track, resets position
 // Returns true on success, false if already recording or allocation failed
 bool loop_buffer_start(struct LoopBuffer* lb);
 
-// Stop recording - finalizes track length
+// Start recording wait output frames from now, e.g. on a beat. Punch-ins
+// keep their write position moving with the loop in the meantime
+bool loop_buffer_start_at(struct LoopBuffer* lb, unsigned int wait);
+
+// Stop recording - finalizes track length. With a latency set, recording
+// goes on for that many more input frames first (still reported as recording)
 void loop_buffer_stop(struct LoopBuffer* lb);
 
-// Write audio frames to buffer (call from capture callback)
-// Input is float [-1, 1], will be converted to S16 for storage
+// Stop recording wait output frames from now, sample-accurately
+void loop_buffer_stop_at(struct LoopBuffer* lb, unsigned int wait);
+
+// Stop recording right away, without the latency tail
+void loop_buffer_stop_now(struct LoopBuffer* lb);
+
+// Compensate for input lagging the output by frames: recordings start and
+// stop that much later in the input, punch-ins land that much earlier in
+// the loop, so what is recorded lines up with what was heard
+void loop_buffer_set_latency(struct LoopBuffer* lb, unsigned int frames);
+
+// Record frames past the end of a fresh loop and crossfade them into its
+// start, so the splice is seamless. 0 keeps the loop end as a hard cut
+void loop_buffer_set_splice(struct LoopBuffer* lb, unsigned int frames);
+
+// Write a block of interleaved stereo frames (float [-1, 1]) to the buffer
+// (call from capture callback). Runs contiguous within a track block are
+// written in one pass; punch-in replaces or overdubs, see loop_buffer_set_overdub.
 // Returns number of frames written (may be less than requested if max reached)
-unsigned int loop_buffer_write_float(struct LoopBuffer* lb,
-                                     float left,
-                                     float right);
+unsigned int loop_buffer_write_block(struct LoopBuffer* lb,
+                                     const float* frames,
+                                     unsigned int count);
+
+// Punch-in mode: replace the loop, or mix the input into it (sound-on-sound)
+// with the existing audio scaled by feedback [0, 1] on each pass
+void loop_buffer_set_overdub(struct LoopBuffer* lb, bool overdub, float feedback);
 
 // Get the recorded track (acquires reference - caller must release)
 // Returns NULL if no recording exists
@@ -79,6 +135,21 @@ unsigned int loop_buffer_get_length(struct LoopBuffer* lb);
 // Reset/erase the loop (clears track and unlocks length for fresh recording)
 void loop_buffer_reset(struct LoopBuffer* lb);
 
-// Set write position for punch-in (syncs to playback position)
-// position_samples should be within [0, loop_length)
+// Use an existing track as the loop, e.g. one grabbed from the capture ring.
+// Takes over the caller's reference (or capture ring hold), which goes to
+// the released queue when the track is dropped again; its length becomes
+// the loop length. The pre-allocated track is used again after a reset.
+// RT-safe, no copy or allocation. Returns false, leaving the reference with
+// the caller, while recording or if the track is empty
+bool loop_buffer_adopt(struct LoopBuffer* lb, Track* track);
+
+// The save in progress has copied everything: let go of it
+void loop_buffer_detach_snapshot(struct LoopBuffer* lb);
+
+// Give pool blocks the loop no longer needs back, e.g. after an erase.
+// Blocks are kept while recording or while a save still reads them.
+void loop_buffer_release_unused(struct LoopBuffer* lb);
+
+// Set write position for punch-in (syncs to playback position, less the
+// latency) position_samples should be within [0, loop_length)
 void loop_buffer_set_position(struct LoopBuffer* lb, unsigned int position_samples);
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Loop Image - a loop saved as raw PCM, mapped back in as a track
+//
+
+#include "loop_image.h"
+#include "../player/track.h"
+#include "../util/log.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sc {
+namespace audio {
+
+LoopImage::~LoopImage()
+{
+    release();
+}
+
+Track* LoopImage::map(const std::string& path, int sample_rate)
+{
+    release();
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return nullptr;
+    }
+
+    const size_t frame_bytes = TRACK_CHANNELS * sizeof(signed short);
+    const size_t frames = static_cast<size_t>(st.st_size) / frame_bytes;
+    if (frames == 0 || frames > static_cast<size_t>(TRACK_MAX_BLOCKS) * TRACK_BLOCK_SAMPLES) {
+        LOG_WARN("LoopImage: %s is empty or too long, not restored", path.c_str());
+        close(fd);
+        return nullptr;
+    }
+
+    // Populating a private writable mapping copies every page now
+    size_t size = frames * frame_bytes;
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR("LoopImage: mapping %s failed: %s", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+
+    Track* t = track_acquire_for_recording(sample_rate);
+    if (t == nullptr) {
+        munmap(data, size);
+        return nullptr;
+    }
+
+    auto* pcm = static_cast<signed short*>(data);
+    unsigned int blocks = static_cast<unsigned int>((frames + TRACK_BLOCK_SAMPLES - 1) / TRACK_BLOCK_SAMPLES);
+    for (unsigned int b = 0; b < blocks; b++) {
+        t->block[b] = reinterpret_cast<TrackBlock*>(
+            pcm + static_cast<size_t>(b) * TRACK_BLOCK_SAMPLES * TRACK_CHANNELS);
+    }
+    t->set_length(static_cast<unsigned int>(frames));
+
+    data_ = data;
+    size_ = size;
+    track_ = t;
+
+    LOG_INFO("LoopImage: mapped %s (%.1f sec)", path.c_str(),
+             static_cast<double>(frames) / sample_rate);
+    return t;
+}
+
+void LoopImage::release()
+{
+    if (track_) {
+        track_release(track_);
+        track_ = nullptr;
+    }
+    if (data_) {
+        munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+} // namespace audio
+} // namespace sc
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Loop Image - a loop saved as raw PCM, mapped back in as a track
+//
+// The file (interleaved stereo S16, native byte order, no header) is mapped
+// privately and faulted in up front. Writable private pages are copied on
+// that first touch, so punch-ins into the restored loop neither fault on the
+// audio thread nor reach the file, and the file may be replaced meanwhile.
+// Like a grabbed span of the capture ring, the track's blocks point straight
+// into the mapping and its block count stays 0.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+struct Track;
+
+namespace sc {
+namespace audio {
+
+class LoopImage {
+public:
+    LoopImage() = default;
+    ~LoopImage();
+
+    LoopImage(const LoopImage&) = delete;
+    LoopImage& operator=(const LoopImage&) = delete;
+
+    // Map the file as a track at sample_rate (not RT-safe). The image keeps
+    // a reference; the track stays valid until release(). Returns nullptr if
+    // the file is missing, empty or longer than a track holds
+    Track* map(const std::string& path, int sample_rate);
+
+    // Drop the track and unmap. No one else may hold the track any more
+    void release();
+
+    Track* track() const { return track_; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    Track* track_ = nullptr;
+};
+
+} // namespace audio
+} // namespace sc
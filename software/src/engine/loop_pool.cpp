@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Loop Pool - track blocks shared by the loop buffers of both decks
+//
+
+#include "loop_pool.h"
+#include "../player/track.h"
+#include "../util/log.h"
+
+#include <cstring>
+
+namespace sc {
+namespace audio {
+
+LoopPool::~LoopPool()
+{
+    clear();
+}
+
+bool LoopPool::init(unsigned int blocks)
+{
+    clear();
+    free_.reset(new TrackBlock*[blocks]);
+
+    for (unsigned int i = 0; i < blocks; i++) {
+        TrackBlock* block = track_block_alloc();
+        if (block == nullptr) {
+            LOG_ERROR("LoopPool: only %u of %u blocks allocated", i, blocks);
+            return false;
+        }
+
+        // Fault every page in now rather than on the audio thread
+        memset(block, 0, sizeof(TrackBlock));
+        free_[size_++] = block;
+        available_ = size_;
+    }
+
+    LOG_INFO("LoopPool: %u blocks (%zu MB) shared by both decks",
+             size_, size_ * sizeof(TrackBlock) / (1024 * 1024));
+    return true;
+}
+
+void LoopPool::clear()
+{
+    if (available_ != size_) {
+        LOG_ERROR("LoopPool: %u blocks still in use, leaking the pool", size_ - available_);
+        free_.release();
+    } else {
+        for (unsigned int i = 0; i < available_; i++) {
+            track_block_free(free_[i]);
+        }
+        free_.reset();
+    }
+    size_ = 0;
+    available_ = 0;
+}
+
+} // namespace audio
+} // namespace sc
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Loop Pool - track blocks shared by the loop buffers of both decks
+//
+// All loop storage is allocated, touched and (optionally) locked into RAM
+// up front. A deck takes blocks as its recording grows and gives them back
+// when its loop is erased, so one deck can record a long loop while the
+// other has none, without reserving the maximum for each.
+//
+// Blocks are taken and given back on the audio thread only: a pop or push
+// is a plain stack operation, no locks and no allocation.
+//
+
+#pragma once
+
+#include <memory>
+
+struct TrackBlock;
+
+namespace sc {
+namespace audio {
+
+class LoopPool {
+public:
+    LoopPool() = default;
+    ~LoopPool();
+
+    LoopPool(const LoopPool&) = delete;
+    LoopPool& operator=(const LoopPool&) = delete;
+
+    // Allocate blocks (not RT-safe). Returns false if not all of them
+    // could be allocated, keeping the ones that could
+    bool init(unsigned int blocks);
+
+    // Free the blocks (not RT-safe). All of them must have been given back
+    void clear();
+
+    // A free block, or nullptr if the pool is used up
+    TrackBlock* take()
+    {
+        return available_ > 0 ? free_[--available_] : nullptr;
+    }
+
+    void give_back(TrackBlock* block) { free_[available_++] = block; }
+
+    unsigned int size() const { return size_; }
+    unsigned int available() const { return available_; }
+
+private:
+    std::unique_ptr<TrackBlock*[]> free_;
+    unsigned int size_ = 0;
+    unsigned int available_ = 0;
+};
+
+} // namespace audio
+} // namespace sc
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Loop Snapshot - copy-on-write copy of a loop for saving to disk
+//
+
+#include "loop_snapshot.h"
+#include "../player/track.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace sc {
+namespace audio {
+
+LoopSnapshot::LoopSnapshot(Track* source, unsigned int capacity)
+    : data_(new (std::nothrow) int16_t[2 * static_cast<size_t>(capacity)])
+    , pages_(new (std::nothrow) std::atomic<uint8_t>[capacity / PAGE_FRAMES + 1])
+    , scratch_(new (std::nothrow) int16_t[2 * PAGE_FRAMES])
+    , capacity_((data_ && pages_ && scratch_) ? capacity : 0)
+    , source_(source)
+{
+}
+
+LoopSnapshot::~LoopSnapshot() = default;
+
+void LoopSnapshot::attach(unsigned int frames)
+{
+    rate_ = source_->rate;
+    frames_ = std::min(frames, capacity_);
+    page_count_ = (frames_ + PAGE_FRAMES - 1) / PAGE_FRAMES;
+
+    for (unsigned int p = 0; p < page_count_; p++) {
+        pages_[p].store(NOT_COPIED, std::memory_order_relaxed);
+    }
+    copied_pages_.store(0, std::memory_order_relaxed);
+    state_.store(State::Attached, std::memory_order_release);
+}
+
+void LoopSnapshot::detach()
+{
+    state_.store(State::Detached, std::memory_order_release);
+}
+
+void LoopSnapshot::preserve(const Track* track, unsigned int first, unsigned int count)
+{
+    if (track != source_ || count == 0 || first >= frames_) {
+        return;
+    }
+
+    unsigned int last = std::min(first + count, frames_) - 1;
+    for (unsigned int p = first / PAGE_FRAMES; p <= last / PAGE_FRAMES; p++) {
+        claim_page(p);
+    }
+}
+
+void LoopSnapshot::preserve_all()
+{
+    for (unsigned int p = 0; p < page_count_; p++) {
+        claim_page(p);
+    }
+}
+
+void LoopSnapshot::copy_all()
+{
+    for (unsigned int p = 0; p < page_count_; p++) {
+        take_page(p);
+    }
+}
+
+void LoopSnapshot::copy_page(unsigned int page, int16_t* to) const
+{
+    // Pages never straddle a track block: PAGE_FRAMES divides TRACK_BLOCK_SAMPLES
+    unsigned int first = page * PAGE_FRAMES;
+    unsigned int count = std::min(PAGE_FRAMES, frames_ - first);
+    memcpy(to, source_->get_sample(static_cast<int>(first)), count * 2 * sizeof(int16_t));
+}
+
+void LoopSnapshot::claim_page(unsigned int page)
+{
+    // Not copied, or the writer's copy is still in flight: copy it here
+    // rather than wait on a lower priority thread
+    uint8_t state = pages_[page].load(std::memory_order_acquire);
+    while (state == NOT_COPIED || state == WRITER_COPYING) {
+        if (pages_[page].compare_exchange_weak(state, AUDIO_COPYING, std::memory_order_acquire)) {
+            copy_page(page, data_.get() + 2 * static_cast<size_t>(page) * PAGE_FRAMES);
+            pages_[page].store(COPIED, std::memory_order_release);
+            copied_pages_.fetch_add(1, std::memory_order_acq_rel);
+            return;
+        }
+    }
+}
+
+void LoopSnapshot::take_page(unsigned int page)
+{
+    uint8_t expected = NOT_COPIED;
+    if (!pages_[page].compare_exchange_strong(expected, WRITER_COPYING, std::memory_order_acquire)) {
+        return;
+    }
+
+    copy_page(page, scratch_.get());
+
+    // Published only if the audio thread did not claim the page meanwhile
+    expected = WRITER_COPYING;
+    if (pages_[page].compare_exchange_strong(expected, COPIED, std::memory_order_acq_rel)) {
+        unsigned int first = page * PAGE_FRAMES;
+        unsigned int count = std::min(PAGE_FRAMES, frames_ - first);
+        memcpy(data_.get() + 2 * static_cast<size_t>(first), scratch_.get(), count * 2 * sizeof(int16_t));
+        copied_pages_.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+static_assert(TRACK_BLOCK_SAMPLES % LoopSnapshot::PAGE_FRAMES == 0,
+              "snapshot pages must not straddle track blocks");
+
+} // namespace audio
+} // namespace sc
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Loop Snapshot - copy-on-write copy of a loop for saving to disk
+//
+// Attaching is instant: nothing is copied on the audio thread up front. The
+// writer thread copies the loop page by page, and a punch-in that is about
+// to overwrite a page not copied yet copies that page first. Either way the
+// snapshot holds the loop as it was when it was attached.
+//
+// The audio thread never touches the source's refcount: the input thread
+// takes a reference when it queues the save and releases it once the writer
+// hands the source back (LoopWriter::take_released).
+//
+// Page states: 0 = not copied, 1 = writer copying, 2 = copied, 3 = audio
+// thread copying. The audio thread never waits on the writer: it claims a
+// page that is not copied or still in flight (0 or 1 to 3) and copies it
+// itself. The writer copies a page it moved from 0 to 1 into a scratch page
+// and publishes it only if it then moves it from 1 to 2, otherwise the
+// audio thread's copy stands.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+struct Track;
+
+namespace sc {
+namespace audio {
+
+class LoopSnapshot {
+public:
+    static constexpr unsigned int PAGE_FRAMES = 1024;
+
+    enum class State { Pending, Attached, Detached, Refused };
+
+    // Room for capacity frames of source (allocates, not RT-safe). The
+    // caller's reference to source is kept until the writer is done
+    LoopSnapshot(Track* source, unsigned int capacity);
+    ~LoopSnapshot();
+
+    LoopSnapshot(const LoopSnapshot&) = delete;
+    LoopSnapshot& operator=(const LoopSnapshot&) = delete;
+
+    // === Audio thread ===
+
+    // Start the snapshot of the first frames of the source (clamped to
+    // capacity). It must be the deck's loop from now until detach()
+    void attach(unsigned int frames);
+
+    // The loop could not be attached; the writer drops the snapshot
+    void refuse() { state_.store(State::Refused, std::memory_order_release); }
+
+    // Call before overwriting frames [first, first + count) of track
+    void preserve(const Track* track, unsigned int first, unsigned int count);
+
+    // Copy every page not copied yet, e.g. before the loop goes away
+    void preserve_all();
+
+    // The track being saved, with the reference taken by the input thread
+    Track* source() const { return source_; }
+
+    // Every page copied, the source is no longer needed
+    bool copied() const { return copied_pages_.load(std::memory_order_acquire) == page_count_; }
+
+    // Let go of the source. The snapshot must not be touched afterwards
+    void detach();
+
+    // === Writer thread ===
+
+    State state() const { return state_.load(std::memory_order_acquire); }
+
+    // Copy every page not copied yet
+    void copy_all();
+
+    // Interleaved S16 stereo, valid once copied()
+    const int16_t* data() const { return data_.get(); }
+    unsigned int frames() const { return frames_; }
+    int rate() const { return rate_; }
+
+private:
+    enum Page : uint8_t { NOT_COPIED, WRITER_COPYING, COPIED, AUDIO_COPYING };
+
+    void claim_page(unsigned int page);  // Audio side
+    void take_page(unsigned int page);   // Writer side
+    void copy_page(unsigned int page, int16_t* to) const;
+
+    std::unique_ptr<int16_t[]> data_;
+    std::unique_ptr<std::atomic<uint8_t>[]> pages_;
+    std::unique_ptr<int16_t[]> scratch_;  // The writer's copy of one page
+    unsigned int capacity_;
+
+    Track* source_ = nullptr;
+    unsigned int frames_ = 0;
+    unsigned int page_count_ = 0;
+    int rate_ = 0;
+
+    std::atomic<State> state_{State::Pending};
+    std::atomic<unsigned int> copied_pages_{0};
+};
+
+} // namespace audio
+} // namespace sc
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Loop Writer - saves loop snapshots to disk on a background thread
+//
+
+#include "loop_writer.h"
+#include "wav_file.h"
+#include "../player/track.h"
+#include "../util/log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace sc {
+namespace audio {
+
+// Bytes per write() call, large so the USB stick sees sequential writes
+static constexpr size_t WRITE_CHUNK = 1024 * 1024;
+
+LoopWriter::~LoopWriter()
+{
+    stop();
+}
+
+void LoopWriter::start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) return;
+
+    running_ = true;
+    thread_ = std::thread(&LoopWriter::run, this);
+}
+
+void LoopWriter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+LoopSnapshot* LoopWriter::request(int deck, Track* source, const std::string& folder)
+{
+    auto snapshot = std::make_unique<LoopSnapshot>(source, source->length);
+    if (snapshot->data() == nullptr) {
+        LOG_ERROR("LoopWriter: no memory for a %u frame snapshot", source->length);
+        track_release(source);
+        return nullptr;
+    }
+
+    return queue(Job{deck, folder, std::move(snapshot), {}, {}});
+}
+
+LoopSnapshot* LoopWriter::request_raw(int deck, Track* source, const std::string& path)
+{
+    auto snapshot = std::make_unique<LoopSnapshot>(source, source->length);
+    if (snapshot->data() == nullptr) {
+        LOG_ERROR("LoopWriter: no memory for a %u frame snapshot", source->length);
+        track_release(source);
+        return nullptr;
+    }
+
+    return queue(Job{deck, {}, std::move(snapshot), path, {}});
+}
+
+bool LoopWriter::request_file(const std::string& path, std::string contents)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return false;
+        queue_.push_back(Job{-1, {}, nullptr, path, std::move(contents)});
+        pending_++;
+    }
+    wake_.notify_one();
+    return true;
+}
+
+LoopSnapshot* LoopWriter::queue(Job job)
+{
+    LoopSnapshot* handle = job.snapshot.get();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            track_release(handle->source());
+            return nullptr;
+        }
+        queue_.push_back(std::move(job));
+        pending_++;
+    }
+    wake_.notify_one();
+    return handle;
+}
+
+std::vector<LoopWriter::Saved> LoopWriter::take_saved()
+{
+    std::vector<Saved> out;
+    if (!has_saved_.load(std::memory_order_acquire)) {
+        return out;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.swap(saved_);
+    has_saved_.store(false, std::memory_order_relaxed);
+    return out;
+}
+
+std::vector<Track*> LoopWriter::take_released()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Track*> out;
+    out.swap(released_);
+    return out;
+}
+
+// The audio thread is done with a snapshot's source, give the reference back
+void LoopWriter::hand_back(Track* source)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    released_.push_back(source);
+}
+
+// Wait until the audio thread moves the snapshot on from a state. Returns
+// false if the writer is stopping meanwhile.
+bool LoopWriter::wait_for(const LoopSnapshot& snapshot, LoopSnapshot::State from)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (snapshot.state() == from) {
+        if (!running_) return false;
+        wake_.wait_for(lock, std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+void LoopWriter::run()
+{
+    std::vector<Unsynced> batch;
+
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (queue_.empty() && !batch.empty()) {
+                // Nothing else to write: sync this batch before sleeping
+                lock.unlock();
+                sync(batch);
+                lock.lock();
+            }
+            wake_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+            if (!running_) break;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        if (!job.snapshot) {
+            replace(job.path, job.contents.data(), job.contents.size());
+            pending_--;
+            continue;
+        }
+
+        LoopSnapshot& snapshot = *job.snapshot;
+        if (!wait_for(snapshot, LoopSnapshot::State::Pending)) {
+            abandon(job);
+            break;
+        }
+
+        // Punch-ins may already have copied all of it and the audio thread
+        // detached. Otherwise copy the rest, then let it detach.
+        if (snapshot.state() != LoopSnapshot::State::Refused) {
+            snapshot.copy_all();
+            if (!wait_for(snapshot, LoopSnapshot::State::Attached)) {
+                abandon(job);
+                break;
+            }
+
+            Unsynced file;
+            if (!job.path.empty()) {
+                replace(job.path, snapshot.data(), static_cast<size_t>(snapshot.frames()) * 4);
+            } else if (write_file(job, &file)) {
+                batch.push_back(std::move(file));
+            }
+        } else {
+            LOG_WARN("LoopWriter: deck %d has no loop to save", job.deck);
+        }
+        hand_back(snapshot.source());
+        pending_--;
+    }
+
+    sync(batch);
+
+    std::deque<Job> rest;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rest.swap(queue_);
+    }
+    for (Job& job : rest) {
+        abandon(job);
+    }
+}
+
+// Drop a save when stopping. A snapshot the audio thread may still attach
+// or hold is leaked rather than freed under it, along with its source.
+void LoopWriter::abandon(Job& job)
+{
+    if (!job.snapshot) {
+        pending_--;
+        return;
+    }
+
+    LoopSnapshot::State state = job.snapshot->state();
+    if (state == LoopSnapshot::State::Pending || state == LoopSnapshot::State::Attached) {
+        LOG_WARN("LoopWriter: stopped with a save of deck %d in progress", job.deck);
+        job.snapshot.release();
+    } else {
+        hand_back(job.snapshot->source());
+    }
+    pending_--;
+}
+
+bool LoopWriter::write_file(const Job& job, Unsynced* out)
+{
+    const LoopSnapshot& snapshot = *job.snapshot;
+    const uint32_t data_bytes = snapshot.frames() * 4;
+
+    std::string path;
+    int fd = wav_create(job.folder, job.deck == 0 ? "loop-beat" : "loop-scratch", &path);
+    if (fd == -1) {
+        return false;
+    }
+
+    uint8_t header[WAV_HEADER_BYTES];
+    wav_header(header, static_cast<uint32_t>(snapshot.rate()), 2, data_bytes);
+
+    // Samples are stored little-endian already, write them straight out
+    bool ok = write_all(fd, header, sizeof(header));
+    const auto* data = reinterpret_cast<const uint8_t*>(snapshot.data());
+    for (size_t done = 0; ok && done < data_bytes; done += WRITE_CHUNK) {
+        ok = write_all(fd, data + done, std::min(WRITE_CHUNK, data_bytes - done));
+    }
+
+    if (!ok) {
+        LOG_ERROR("LoopWriter: writing %s failed: %s", path.c_str(), strerror(errno));
+        close(fd);
+        unlink(path.c_str());
+        return false;
+    }
+
+    LOG_INFO("LoopWriter: wrote %s (%.1f sec)", path.c_str(),
+             static_cast<double>(snapshot.frames()) / snapshot.rate());
+    out->fd = fd;
+    out->saved = Saved{job.deck, job.folder, path};
+    return true;
+}
+
+void LoopWriter::replace(const std::string& path, const void* data, size_t size)
+{
+    std::string tmp;
+    int fd = replace_open(path, &tmp);
+    if (fd == -1) {
+        return;
+    }
+
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    bool ok = true;
+    for (size_t done = 0; ok && done < size; done += WRITE_CHUNK) {
+        ok = write_all(fd, bytes + done, std::min(WRITE_CHUNK, size - done));
+    }
+
+    if (!ok) {
+        LOG_ERROR("LoopWriter: writing %s failed: %s", path.c_str(), strerror(errno));
+        replace_abort(fd, tmp);
+        return;
+    }
+    replace_commit(fd, tmp, path);
+}
+
+// One fsync per file plus one per folder, for everything written since the
+// last sync, then report the files
+void LoopWriter::sync(std::vector<Unsynced>& batch)
+{
+    if (batch.empty()) return;
+
+    std::vector<std::string> folders;
+    for (Unsynced& file : batch) {
+        fdatasync(file.fd);
+        close(file.fd);
+        if (std::find(folders.begin(), folders.end(), file.saved.folder) == folders.end()) {
+            folders.push_back(file.saved.folder);
+        }
+    }
+
+    // Make the new directory entries durable too
+    for (const std::string& folder : folders) {
+        int dir = open(folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir != -1) {
+            fsync(dir);
+            close(dir);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Unsynced& file : batch) {
+        saved_.push_back(std::move(file.saved));
+    }
+    has_saved_.store(true, std::memory_order_release);
+    batch.clear();
+}
+
+} // namespace audio
+} // namespace sc
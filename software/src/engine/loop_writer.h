@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Loop Writer - saves loop snapshots to disk on a background thread
+//
+// The input thread queues a snapshot and hands it to the audio thread to
+// attach. The writer copies it, waits until the audio thread lets go, and
+// streams it to a new WAV file in large sequential writes. Files written in
+// one go are synced together once the queue runs dry, then reported back
+// so the deck's playlist can pick them up.
+//
+// Session state goes through the same queue, so its disk writes never hold
+// up the input thread: loops as raw PCM and small files, each replacing the
+// previous version of the file in one rename.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "loop_snapshot.h"
+
+namespace sc {
+namespace audio {
+
+class LoopWriter {
+public:
+    // A finished file
+    struct Saved {
+        int deck;
+        std::string folder;
+        std::string path;
+    };
+
+    LoopWriter() = default;
+    ~LoopWriter();
+
+    LoopWriter(const LoopWriter&) = delete;
+    LoopWriter& operator=(const LoopWriter&) = delete;
+
+    void start();
+    void stop();
+
+    // Queue a save of the deck's loop, source, into folder (created if
+    // missing). Takes over the caller's reference to source, handed back by
+    // take_released(). Returns the snapshot for the audio thread to attach,
+    // or nullptr (source released) if the writer is not running or out of
+    // memory. Input thread.
+    LoopSnapshot* request(int deck, Track* source, const std::string& folder);
+
+    // Queue a save of the deck's loop as raw PCM replacing path (see
+    // LoopImage). Not reported by take_saved(). Otherwise as request()
+    LoopSnapshot* request_raw(int deck, Track* source, const std::string& path);
+
+    // Queue contents to replace the file at path. Returns false if the
+    // writer is not running
+    bool request_file(const std::string& path, std::string contents);
+
+    // Files finished since the last call (input thread)
+    std::vector<Saved> take_saved();
+
+    // Sources of the saves finished since the last call, for the caller to
+    // release (input thread)
+    std::vector<Track*> take_released();
+
+    // Saves queued or being written
+    size_t pending() const { return pending_.load(std::memory_order_relaxed); }
+
+private:
+    // A WAV file into folder, raw PCM replacing path, or contents (no
+    // snapshot) replacing path
+    struct Job {
+        int deck;
+        std::string folder;
+        std::unique_ptr<LoopSnapshot> snapshot;
+        std::string path;
+        std::string contents;
+    };
+
+    // Written but not yet synced
+    struct Unsynced {
+        int fd;
+        Saved saved;
+    };
+
+    void run();
+    void abandon(Job& job);
+    void hand_back(Track* source);
+    bool wait_for(const LoopSnapshot& snapshot, LoopSnapshot::State from);
+    LoopSnapshot* queue(Job job);
+    bool write_file(const Job& job, Unsynced* out);
+    void replace(const std::string& path, const void* data, size_t size);
+    void sync(std::vector<Unsynced>& batch);
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Job> queue_;
+    std::vector<Saved> saved_;
+    std::vector<Track*> released_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<bool> has_saved_{false};
+    bool running_ = false;
+};
+
+} // namespace audio
+} // namespace sc
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Master Recorder - records the output mix to disk for a whole session
+//
+
+#include "master_recorder.h"
+#include "loop_buffer.h"
+#include "wav_file.h"
+#include "../util/log.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace sc {
+namespace audio {
+
+// Samples converted and written per write() call (1 MB of 16-bit)
+static constexpr size_t WRITE_CHUNK_SAMPLES = 512 * 1024;
+
+// Wait for this much audio before writing, so the stick sees large writes
+static constexpr size_t DRAIN_SAMPLES = 128 * 1024;
+
+// How often the writer looks at the ring
+static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(50);
+
+// WAV sizes are 32-bit: continue in a new file well before that
+static constexpr uint32_t MAX_DATA_BYTES = 0xF0000000u;
+
+// Rewrite the header sizes this often, so a power cut leaves a playable file
+static constexpr uint32_t HEADER_INTERVAL_BYTES = 8 * 1024 * 1024;
+
+// Below normal priority, the writer only has to keep up on average
+static constexpr int WRITER_NICE = 10;
+
+MasterRecorder::~MasterRecorder()
+{
+    shutdown();
+}
+
+void MasterRecorder::init(int rate, int seconds)
+{
+    if (running_ || rate <= 0 || seconds <= 0) return;
+
+    size_t wanted = static_cast<size_t>(rate) * static_cast<size_t>(seconds) * MAX_CHANNELS;
+    size_t capacity = 1;
+    while (capacity < wanted) capacity <<= 1;
+
+    // Value-initialised, so every page is touched now rather than by the audio thread
+    ring_.reset(new (std::nothrow) float[capacity]());
+    chunk_.reset(new (std::nothrow) int16_t[WRITE_CHUNK_SAMPLES]);
+    if (!ring_ || !chunk_) {
+        LOG_ERROR("MasterRecorder: no memory for a %d sec ring", seconds);
+        ring_.reset();
+        chunk_.reset();
+        return;
+    }
+    capacity_ = capacity;
+
+    LOG_INFO("MasterRecorder: %d sec ring (%zu KB)", seconds, capacity * sizeof(float) / 1024);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = true;
+    thread_ = std::thread(&MasterRecorder::run, this);
+}
+
+void MasterRecorder::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+bool MasterRecorder::start(const std::string& folder, unsigned int rate, bool with_input)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return false;
+        want_ = true;
+        session_++;
+        folder_ = folder;
+        want_rate_ = rate;
+        want_channels_ = with_input ? 4 : 2;
+    }
+    wanted_.store(true, std::memory_order_relaxed);
+    wake_.notify_one();
+    return true;
+}
+
+void MasterRecorder::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        want_ = false;
+    }
+    wanted_.store(false, std::memory_order_relaxed);
+    wake_.notify_one();
+}
+
+MasterRecorder::Stats MasterRecorder::stats() const
+{
+    Stats s{};
+    s.recording = armed_.load(std::memory_order_relaxed) != 0;
+    if (capacity_ > 0) {
+        size_t used = head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed);
+        s.fill = static_cast<double>(used) / static_cast<double>(capacity_);
+        s.fill_peak = static_cast<double>(std::max(used, fill_peak_.load(std::memory_order_relaxed))) /
+                      static_cast<double>(capacity_);
+    }
+    s.dropped_blocks = dropped_.load(std::memory_order_relaxed);
+    unsigned int rate = rate_.load(std::memory_order_relaxed);
+    if (rate > 0) {
+        s.seconds = static_cast<double>(frames_written_.load(std::memory_order_relaxed)) / rate;
+    }
+    return s;
+}
+
+void MasterRecorder::run()
+{
+    // On Linux this only lowers the calling thread
+    setpriority(PRIO_PROCESS, 0, WRITER_NICE);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        wake_.wait_for(lock, POLL_INTERVAL);
+
+        bool want = want_ && running_;
+        bool restart = want && session_ != open_session_;
+        unsigned int session = session_;
+        std::string folder = folder_;
+        unsigned int rate = want_rate_;
+        int channels = want_channels_;
+        lock.unlock();
+
+        if (channels_ != 0 && (!want || restart)) {
+            end_session();
+        }
+        if (restart) {
+            open_session_ = session;
+            if (!begin_session(folder, rate, channels)) {
+                stop();
+            }
+        }
+        if (channels_ != 0 && !drain(std::min(DRAIN_SAMPLES, capacity_ / 4))) {
+            LOG_ERROR("MasterRecorder: writing %s failed: %s", path_.c_str(), strerror(errno));
+            end_session();
+            stop();
+        }
+
+        lock.lock();
+    }
+    lock.unlock();
+
+    if (channels_ != 0) {
+        end_session();
+    }
+}
+
+bool MasterRecorder::begin_session(const std::string& folder, unsigned int rate, int channels)
+{
+    // The audio thread is not writing, so anything left over can go
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    dropped_.store(0, std::memory_order_relaxed);
+    fill_peak_.store(0, std::memory_order_relaxed);
+    frames_written_.store(0, std::memory_order_relaxed);
+    rate_.store(rate, std::memory_order_relaxed);
+
+    file_folder_ = folder;
+    channels_ = channels;
+    if (!open_file()) {
+        channels_ = 0;
+        return false;
+    }
+
+    armed_.store(channels);
+    return true;
+}
+
+void MasterRecorder::end_session()
+{
+    // Once disarmed, wait out a period the audio thread may be in the middle of
+    armed_.store(0);
+    while (pushing_.load()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    if (!drain(1)) {
+        LOG_ERROR("MasterRecorder: writing %s failed: %s", path_.c_str(), strerror(errno));
+    }
+    close_file();
+
+    unsigned long dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+        LOG_WARN("MasterRecorder: %lu periods dropped, the disk could not keep up", dropped);
+    }
+    channels_ = 0;
+}
+
+bool MasterRecorder::open_file()
+{
+    fd_ = wav_create(file_folder_, "master", &path_);
+    if (fd_ == -1) {
+        return false;
+    }
+
+    data_bytes_ = 0;
+    uint8_t header[WAV_HEADER_BYTES];
+    wav_header(header, rate_.load(std::memory_order_relaxed), channels_, 0);
+    if (!write_all(fd_, header, sizeof(header))) {
+        LOG_ERROR("MasterRecorder: writing %s failed: %s", path_.c_str(), strerror(errno));
+        close(fd_);
+        fd_ = -1;
+        unlink(path_.c_str());
+        return false;
+    }
+    header_bytes_ = 0;
+
+    LOG_INFO("MasterRecorder: recording %d channels to %s", channels_, path_.c_str());
+    return true;
+}
+
+void MasterRecorder::update_header()
+{
+    uint8_t header[WAV_HEADER_BYTES];
+    wav_header(header, rate_.load(std::memory_order_relaxed), channels_, data_bytes_);
+    if (pwrite(fd_, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))) {
+        header_bytes_ = data_bytes_;
+    }
+}
+
+void MasterRecorder::close_file()
+{
+    if (fd_ == -1) return;
+
+    update_header();
+    fdatasync(fd_);
+    close(fd_);
+    fd_ = -1;
+
+    int dir = open(file_folder_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir != -1) {
+        fsync(dir);
+        close(dir);
+    }
+
+    LOG_INFO("MasterRecorder: wrote %s (%.1f sec)", path_.c_str(),
+             static_cast<double>(data_bytes_) / (2.0 * channels_ * rate_.load(std::memory_order_relaxed)));
+}
+
+// Write out the ring once at least min_samples are waiting. Returns false
+// on a write error.
+bool MasterRecorder::drain(size_t min_samples)
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t used = head_.load(std::memory_order_acquire) - tail;
+
+    // Fill only grows between drains, so the peak is seen here
+    if (used > fill_peak_.load(std::memory_order_relaxed)) {
+        fill_peak_.store(used, std::memory_order_relaxed);
+    }
+    if (used == 0 || used < min_samples) {
+        return true;
+    }
+
+    const size_t mask = capacity_ - 1;
+    while (used > 0) {
+        // Whole frames only: used is, and the chunk size divides by 2 and 4
+        size_t n = std::min(used, WRITE_CHUNK_SAMPLES);
+        auto bytes = static_cast<uint32_t>(n * sizeof(int16_t));
+
+        if (data_bytes_ + bytes > MAX_DATA_BYTES) {
+            close_file();
+            if (!open_file()) return false;
+        }
+        if (fd_ == -1) return false;
+
+        for (size_t i = 0; i < n; i++) {
+            chunk_[i] = float_to_s16(ring_[(tail + i) & mask]);
+        }
+        if (!write_all(fd_, chunk_.get(), bytes)) {
+            return false;
+        }
+
+        tail += n;
+        used -= n;
+        tail_.store(tail, std::memory_order_release);
+
+        data_bytes_ += bytes;
+        frames_written_.fetch_add(n / static_cast<size_t>(channels_), std::memory_order_relaxed);
+        if (data_bytes_ - header_bytes_ >= HEADER_INTERVAL_BYTES) {
+            update_header();
+        }
+    }
+    return true;
+}
+
+} // namespace audio
+} // namespace sc
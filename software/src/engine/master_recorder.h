@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Master Recorder - records the output mix to disk for a whole session
+//
+// The audio thread copies each period it renders (and optionally the input
+// pair) into a preallocated single-producer/single-consumer ring. It never
+// locks, allocates or waits: when the ring has no room for a whole period
+// the period is dropped and counted. A low-priority writer thread drains
+// the ring in large chunks, converts to 16-bit and appends to a WAV file,
+// so a USB stick stalling for a while only fills the ring.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sc {
+namespace audio {
+
+class MasterRecorder {
+public:
+    // Output pair plus input pair
+    static constexpr int MAX_CHANNELS = 4;
+
+    struct Stats {
+        bool recording;
+        double fill;                  // Ring fill level, 0-1
+        double fill_peak;             // Highest fill this session
+        unsigned long dropped_blocks; // Periods lost to a full ring this session
+        double seconds;               // Audio written this session
+    };
+
+    MasterRecorder() = default;
+    ~MasterRecorder();
+
+    MasterRecorder(const MasterRecorder&) = delete;
+    MasterRecorder& operator=(const MasterRecorder&) = delete;
+
+    // Allocate a ring holding seconds of audio at rate and start the
+    // writer thread. 0 seconds leaves the recorder off.
+    void init(int rate, int seconds);
+
+    // Finish any recording and stop the writer thread
+    void shutdown();
+
+    // === Input thread ===
+
+    // Begin a new file in folder (created if missing). with_input adds the
+    // input pair as channels 3-4. Returns false if the recorder is off.
+    bool start(const std::string& folder, unsigned int rate, bool with_input);
+
+    // Finish the file; whatever is still in the ring is written first
+    void stop();
+
+    // Started and not stopped since
+    bool recording() const { return wanted_.load(std::memory_order_relaxed); }
+
+    Stats stats() const;
+
+    // === Audio thread ===
+
+    // Channels per frame to write this period, or 0 if not recording. Also
+    // 0 when the ring lacks room for frames, which counts as a drop.
+    int begin_block(unsigned long frames)
+    {
+        pushing_.store(true);
+        int channels = armed_.load();
+        if (channels == 0) {
+            pushing_.store(false);
+            return 0;
+        }
+
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t used = head - tail_.load(std::memory_order_acquire);
+        if (capacity_ - used < frames * static_cast<size_t>(channels)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            pushing_.store(false);
+            return 0;
+        }
+        cursor_ = head;
+        return channels;
+    }
+
+    // Append interleaved samples, count frames of begin_block()'s width
+    void write(const float* samples, unsigned int count, int channels)
+    {
+        size_t n = count * static_cast<size_t>(channels);
+        size_t at = cursor_ & (capacity_ - 1);
+        size_t first = n < capacity_ - at ? n : capacity_ - at;
+        std::copy(samples, samples + first, ring_.get() + at);
+        std::copy(samples + first, samples + n, ring_.get());
+        cursor_ += n;
+    }
+
+    // Hand the period to the writer
+    void end_block()
+    {
+        head_.store(cursor_, std::memory_order_release);
+        pushing_.store(false);
+    }
+
+private:
+    void run();
+    bool begin_session(const std::string& folder, unsigned int rate, int channels);
+    void end_session();
+    bool open_file();
+    void close_file();
+    bool drain(size_t min_samples);
+    void update_header();
+
+    // Ring: power-of-two samples, positions count up and wrap freely
+    std::unique_ptr<float[]> ring_;
+    size_t capacity_ = 0;
+    std::atomic<size_t> head_{0};      // Written by the audio thread
+    std::atomic<size_t> tail_{0};      // Written by the writer thread
+    size_t cursor_ = 0;                // Audio thread: head while filling a period
+
+    // Channels the audio thread records (0 = not recording) and whether it
+    // is inside begin_block()/end_block(). Sequentially consistent, so once
+    // the writer disarms and sees pushing_ false no more samples arrive.
+    std::atomic<int> armed_{0};
+    std::atomic<bool> pushing_{false};
+
+    std::atomic<unsigned long> dropped_{0};
+    std::atomic<size_t> fill_peak_{0};
+    std::atomic<unsigned long> frames_written_{0};
+    std::atomic<unsigned int> rate_{0};
+    std::atomic<bool> wanted_{false};
+
+    // Requested session, guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread thread_;
+    bool running_ = false;
+    bool want_ = false;
+    unsigned int session_ = 0;         // Bumped by each start()
+    std::string folder_;
+    unsigned int want_rate_ = 0;
+    int want_channels_ = 2;
+
+    // Writer thread only
+    unsigned int open_session_ = 0;
+    int fd_ = -1;
+    std::string path_;
+    std::string file_folder_;
+    int channels_ = 0;                 // 0 = no session
+    uint32_t data_bytes_ = 0;
+    uint32_t header_bytes_ = 0;        // data_bytes_ last put in the header
+    std::unique_ptr<int16_t[]> chunk_;
+};
+
+} // namespace audio
+} // namespace sc
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Sampler - one-shot voices over the decks, for pads and MIDI notes
+//
+
+#include "sampler.h"
+
+namespace sc {
+namespace audio {
+
+Sampler::Sampler()
+    : triggers_(QUEUE_SIZE),
+      finished_(QUEUE_SIZE)
+{
+}
+
+Sampler::~Sampler()
+{
+    clear();
+}
+
+bool Sampler::trigger(Track* track, double start, double end, double pitch, float gain)
+{
+    if (!track) {
+        return false;
+    }
+
+    // One slot stays free so a finished voice can always hand its track back
+    if (in_flight_ >= QUEUE_SIZE - 1 || end <= start || pitch <= 0.0 ||
+        !triggers_.try_enqueue(Trigger{track, start, end, pitch, gain})) {
+        track_release(track);
+        return false;
+    }
+
+    in_flight_++;
+    return true;
+}
+
+void Sampler::collect()
+{
+    Track* track;
+    while (finished_.try_dequeue(track)) {
+        track_release(track);
+        in_flight_--;
+    }
+}
+
+void Sampler::clear()
+{
+    Trigger t;
+    while (triggers_.try_dequeue(t)) {
+        finished_.try_enqueue(t.track);
+    }
+    for (Voice& v : voice_) {
+        if (v.track) finish(v);
+    }
+    playing_.store(0, std::memory_order_relaxed);
+    collect();
+}
+
+bool Sampler::begin_block(int voices, double frame_dt)
+{
+    frame_dt_ = frame_dt;
+    max_voices_ = std::min(std::max(voices, 1), MAX_VOICES);
+    int limit = std::min(limit_.load(std::memory_order_relaxed), max_voices_);
+    limit_.store(limit, std::memory_order_relaxed);
+
+    Trigger t;
+    while (triggers_.try_dequeue(t)) {
+        start(t);
+    }
+    while (sounding() > limit) {
+        steal_oldest();
+    }
+
+    int playing = 0;
+    for (const Voice& v : voice_) {
+        if (v.track) playing++;
+    }
+    playing_.store(playing, std::memory_order_relaxed);
+    return playing > 0;
+}
+
+void Sampler::end_block(double used, double budget)
+{
+    int limit = limit_.load(std::memory_order_relaxed);
+    int count = sounding();
+
+    if (used > budget && count > 1) {
+        limit = count - 1;
+    } else if (used < budget / 2 && limit < max_voices_) {
+        limit++;
+    }
+    limit_.store(limit, std::memory_order_relaxed);
+}
+
+void Sampler::start(const Trigger& t)
+{
+    if (sounding() >= limit_.load(std::memory_order_relaxed)) {
+        steal_oldest();
+    }
+
+    // A free voice, or else the oldest one still fading out, cut short
+    Voice* slot = nullptr;
+    for (Voice& v : voice_) {
+        if (!v.track) {
+            slot = &v;
+            break;
+        }
+        if (!slot || v.serial < slot->serial) slot = &v;
+    }
+    if (slot->track) finish(*slot);
+
+    slot->track = t.track;
+    slot->pos = std::max(t.start, 0.0);
+    slot->end = std::min(t.end, static_cast<double>(t.track->length));
+    slot->step = frame_dt_ * t.track->rate * t.pitch;
+    slot->pitch = static_cast<float>(t.pitch);
+    slot->gain = t.gain;
+    slot->age = 0;
+    slot->serial = ++serial_;
+    slot->releasing = false;
+}
+
+void Sampler::steal_oldest()
+{
+    Voice* oldest = nullptr;
+    for (Voice& v : voice_) {
+        if (v.track && !v.releasing && (!oldest || v.serial < oldest->serial)) {
+            oldest = &v;
+        }
+    }
+    if (!oldest) return;
+
+    oldest->releasing = true;
+    oldest->end = std::min(oldest->end, oldest->pos + DECLICK * oldest->step);
+}
+
+void Sampler::finish(Voice& v)
+{
+    finished_.try_enqueue(v.track);
+    v.track = nullptr;
+}
+
+int Sampler::sounding() const
+{
+    int count = 0;
+    for (const Voice& v : voice_) {
+        if (v.track && !v.releasing) count++;
+    }
+    return count;
+}
+
+} // namespace audio
+} // namespace sc
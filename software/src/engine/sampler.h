@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Sampler - one-shot voices over the decks, for pads and MIDI notes
+//
+// A fixed pool of voices, none allocated while running. The input thread
+// triggers a voice with a reference to a track and a slice of it; the audio
+// thread starts it at the next block, renders the voices one after another
+// for a chunk of frames with the engine's interpolation, and the engine
+// mixes the chunk into the output.
+//
+// At most `voices` play at once. A trigger beyond that steals the oldest
+// voice, which fades out over DECLICK frames. The voices also get a share
+// of the block's time: when rendering took longer than that, the next block
+// plays one voice fewer, again stealing the oldest, and the limit creeps
+// back up once there is room.
+//
+// Track references are not thread-safe, so the audio thread never takes or
+// releases one: a finished voice hands its track back through a queue and
+// collect() releases it on the input thread.
+//
+
+#pragma once
+
+#include "../player/track.h"
+#include "../util/spsc_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace sc {
+namespace audio {
+
+class Sampler {
+public:
+    static constexpr int MAX_VOICES = 16;
+    static constexpr unsigned int DECLICK = 32;  // Frames of fade at a voice's start and end
+
+    Sampler();
+    ~Sampler();
+
+    Sampler(const Sampler&) = delete;
+    Sampler& operator=(const Sampler&) = delete;
+
+    // === Input thread ===
+
+    // Play track from sample start to end (samples of the track) at pitch,
+    // scaled by gain. Takes over the caller's reference, also when the
+    // trigger is refused (too many still in flight)
+    bool trigger(Track* track, double start, double end, double pitch, float gain);
+
+    // Release the tracks of voices that have finished
+    void collect();
+
+    // Drop every voice and release all tracks. Only once the audio thread
+    // has stopped.
+    void clear();
+
+    // Playing now, and how many may play as the budget stands
+    int voices() const { return playing_.load(std::memory_order_relaxed); }
+    int limit() const { return limit_.load(std::memory_order_relaxed); }
+
+    // === Audio thread ===
+
+    // Take triggers and apply the voice count, at most voices (1 to
+    // MAX_VOICES), for output frames frame_dt seconds long. True if any
+    // voice plays this block.
+    bool begin_block(int voices, double frame_dt);
+
+    // Add the next count frames of every voice to mix (interleaved stereo,
+    // in track sample scale)
+    template<typename InterpPolicy>
+    void render(float* mix, unsigned int count);
+
+    // Rendering this block took used of budget (same unit): move the limit
+    void end_block(double used, double budget);
+
+private:
+    struct Voice {
+        Track* track = nullptr;  // nullptr = free
+        double pos = 0.0;        // Samples of the track
+        double end = 0.0;
+        double step = 0.0;       // Samples per output frame
+        float pitch = 1.0f;
+        float gain = 0.0f;
+        unsigned int age = 0;    // Frames played, for the attack
+        uint64_t serial = 0;     // Trigger order, lowest is oldest
+        bool releasing = false;  // Stolen, fading out
+    };
+
+    struct Trigger {
+        Track* track;
+        double start;
+        double end;
+        double pitch;
+        float gain;
+    };
+
+    // Queues hold at most this many, so triggers in flight are kept below it
+    static constexpr int QUEUE_SIZE = 64;
+
+    void start(const Trigger& t);
+    void steal_oldest();
+    void finish(Voice& v);
+    int sounding() const;
+
+    Voice voice_[MAX_VOICES];
+    uint64_t serial_ = 0;
+    double frame_dt_ = 0.0;
+    int max_voices_ = MAX_VOICES;        // Setting, as of the last block
+    std::atomic<int> limit_{MAX_VOICES};
+    std::atomic<int> playing_{0};
+
+    SPSCQueue<Trigger> triggers_;        // Input thread to audio thread
+    SPSCQueue<Track*> finished_;         // Audio thread to input thread
+    int in_flight_ = 0;                  // Input thread: references not back yet
+};
+
+template<typename InterpPolicy>
+void Sampler::render(float* mix, unsigned int count)
+{
+    for (Voice& v : voice_) {
+        if (!v.track) continue;
+
+        Track* tr = v.track;
+        const int len = static_cast<int>(tr->length);
+
+        for (unsigned int i = 0; i < count; i++) {
+            // Fade in over the first frames, out over the last
+            double left = (v.end - v.pos) / v.step;
+            if (left <= 0.0) {
+                finish(v);
+                break;
+            }
+            float fade = 1.0f;
+            if (v.age < DECLICK) fade = static_cast<float>(v.age) / DECLICK;
+            if (left < DECLICK) fade = std::min(fade, static_cast<float>(left) / DECLICK);
+
+            auto s = InterpPolicy::interpolate_one(tr, v.pos, len, v.pitch);
+            mix[2 * i] += s.left * v.gain * fade;
+            mix[2 * i + 1] += s.right * v.gain * fade;
+
+            v.pos += v.step;
+            v.age++;
+        }
+    }
+}
+
+} // namespace audio
+} // namespace sc
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Tempo Grid - beat positions on the output timeline, for quantizing
+//
+
+#include "tempo_grid.h"
+
+#include <cmath>
+
+namespace sc {
+namespace audio {
+
+void TempoGrid::set_bpm(double bpm, int sample_rate)
+{
+    beat_ = bpm > 0.0 ? 60.0 * sample_rate / bpm : 0.0;
+}
+
+void TempoGrid::set_from_loop(unsigned int frames, int sample_rate)
+{
+    if (frames == 0 || sample_rate <= 0) {
+        return;
+    }
+
+    double minutes = frames / (60.0 * sample_rate);
+    double beats = 1.0;
+    while (beats / minutes < MIN_BPM) {
+        beats *= 2.0;
+    }
+    // A loop shorter than a beat at MAX_BPM is a fraction of one
+    while (beats / minutes > MAX_BPM) {
+        beats /= 2.0;
+    }
+    beat_ = frames / beats;
+}
+
+unsigned int TempoGrid::until_next(uint64_t now, double beats) const
+{
+    double span = beat_ * beats;
+    if (span < 1.0 || now < origin_) {
+        return 0;
+    }
+
+    double phase = std::fmod(static_cast<double>(now - origin_), span);
+    auto wait = static_cast<unsigned int>(std::lround(span - phase));
+    return wait >= static_cast<unsigned int>(std::lround(span)) ? 0 : wait;
+}
+
+} // namespace audio
+} // namespace sc
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// Tempo Grid - beat positions on the output timeline, for quantizing
+//
+// The audio engine counts the frames it has played. A grid is a beat length
+// in frames plus a frame a beat falls on; recording and loop roll snap to
+// its lines (whole beats or fractions of one). The tempo is set (loop_bpm)
+// or read from the first loop recorded, as the whole number of beats that
+// puts it between MIN_BPM and MAX_BPM.
+//
+// Audio thread only, plain arithmetic: no locks, no allocation.
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace sc {
+namespace audio {
+
+class TempoGrid {
+public:
+    static constexpr double MIN_BPM = 80.0;
+    static constexpr double MAX_BPM = 160.0;
+
+    void set_bpm(double bpm, int sample_rate);
+
+    // Take the tempo from a loop of frames: 1, 2, 4, 8 ... beats long, the
+    // fewest that make it at least MIN_BPM, or 1/2, 1/4 ... of a beat when
+    // even one beat is faster than MAX_BPM
+    void set_from_loop(unsigned int frames, int sample_rate);
+
+    // Forget the tempo (the grid keeps its anchor)
+    void clear_tempo() { beat_ = 0.0; }
+
+    bool has_tempo() const { return beat_ > 0.0; }
+    double beat_frames() const { return beat_; }
+
+    // A beat falls on frame
+    void anchor(uint64_t frame) { origin_ = frame; }
+
+    // Frames from now to the next line of a grid of beats (0.25 = sixteenths),
+    // 0 if now is on one or there is no tempo
+    unsigned int until_next(uint64_t now, double beats) const;
+
+private:
+    double beat_ = 0.0;      // Frames per beat, 0 = no tempo
+    uint64_t origin_ = 0;
+};
+
+} // namespace audio
+} // namespace sc
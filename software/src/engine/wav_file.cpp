@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// WAV File - helpers shared by the writers that put audio on disk
+//
+
+#include "wav_file.h"
+#include "../util/log.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace sc {
+namespace audio {
+
+static void put_le(uint8_t* p, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void wav_header(uint8_t* header, uint32_t rate, int channels, uint32_t data_bytes)
+{
+    static const uint8_t tmpl[WAV_HEADER_BYTES] = {
+        'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        'd', 'a', 't', 'a', 0, 0, 0, 0};
+    const auto block_align = static_cast<uint32_t>(channels) * 2;
+
+    memcpy(header, tmpl, WAV_HEADER_BYTES);
+    put_le(header + 4, 36 + data_bytes, 4);
+    put_le(header + 16, 16, 4);                   // fmt chunk size
+    put_le(header + 20, 1, 2);                    // PCM
+    put_le(header + 22, static_cast<uint32_t>(channels), 2);
+    put_le(header + 24, rate, 4);
+    put_le(header + 28, rate * block_align, 4);   // Byte rate
+    put_le(header + 32, block_align, 2);
+    put_le(header + 34, 16, 2);                   // Bits per sample
+    put_le(header + 40, data_bytes, 4);
+}
+
+int wav_create(const std::string& folder, const std::string& prefix, std::string* path)
+{
+    if (mkdir(folder.c_str(), 0755) == -1 && errno != EEXIST) {
+        LOG_ERROR("Cannot create %s: %s", folder.c_str(), strerror(errno));
+        return -1;
+    }
+
+    char stamp[32];
+    time_t now = time(nullptr);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+
+    for (int n = 1; n < 100; n++) {
+        *path = folder + "/" + prefix + "-" + stamp +
+                (n > 1 ? "-" + std::to_string(n) : "") + ".wav";
+        int fd = open(path->c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd != -1 || errno != EEXIST) {
+            if (fd == -1) {
+                LOG_ERROR("Cannot create %s: %s", path->c_str(), strerror(errno));
+            }
+            return fd;
+        }
+    }
+    return -1;
+}
+
+bool write_all(int fd, const void* data, size_t size)
+{
+    const auto* p = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+int replace_open(const std::string& path, std::string* tmp)
+{
+    std::string folder = path.substr(0, path.find_last_of('/'));
+    if (!folder.empty() && mkdir(folder.c_str(), 0755) == -1 && errno != EEXIST) {
+        LOG_ERROR("Cannot create %s: %s", folder.c_str(), strerror(errno));
+        return -1;
+    }
+
+    // A name of its own: two writers replacing the same file must not
+    // truncate each other's temporary, the last rename simply wins
+    std::vector<char> name(path.begin(), path.end());
+    const char suffix[] = ".tmp.XXXXXX";
+    name.insert(name.end(), suffix, suffix + sizeof(suffix));
+    int fd = mkostemp(name.data(), O_CLOEXEC);
+    if (fd == -1) {
+        LOG_ERROR("Cannot create %s: %s", name.data(), strerror(errno));
+        return -1;
+    }
+    fchmod(fd, 0644);
+    *tmp = name.data();
+    return fd;
+}
+
+bool replace_commit(int fd, const std::string& tmp, const std::string& path, bool sync_folder)
+{
+    // The data must be on disk before the new name points at it
+    bool ok = fdatasync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) == -1) {
+        LOG_ERROR("Cannot replace %s: %s", path.c_str(), strerror(errno));
+        unlink(tmp.c_str());
+        return false;
+    }
+    if (!sync_folder) {
+        return true;
+    }
+
+    std::string folder = path.substr(0, path.find_last_of('/'));
+    int dir = open(folder.empty() ? "." : folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir != -1) {
+        fsync(dir);
+        close(dir);
+    }
+    return true;
+}
+
+void replace_abort(int fd, const std::string& tmp)
+{
+    close(fd);
+    unlink(tmp.c_str());
+}
+
+} // namespace audio
+} // namespace sc
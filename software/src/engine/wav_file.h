@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+//
+// WAV File - helpers shared by the writers that put audio on disk
+//
+// 16-bit little-endian PCM only, which is what tracks hold in memory.
+// Files rewritten in place (session state) go through a temp file that is
+// renamed over the old one, so a power cut leaves the old or the new file,
+// never half of one.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sc {
+namespace audio {
+
+static constexpr size_t WAV_HEADER_BYTES = 44;
+
+// Fill in a 16-bit PCM header for data_bytes of audio
+void wav_header(uint8_t* header, uint32_t rate, int channels, uint32_t data_bytes);
+
+// Create folder if missing and a new file in it named
+// <prefix>-YYYYMMDD-HHMMSS[-n].wav. Returns the fd, or -1 after logging.
+int wav_create(const std::string& folder, const std::string& prefix, std::string* path);
+
+// write() all of size, retrying short writes and EINTR
+bool write_all(int fd, const void* data, size_t size);
+
+// Start replacing path: creates its folder if missing and opens a new
+// temporary path.tmp.XXXXXX beside it, named in *tmp. Returns the fd, or
+// -1 after logging.
+int replace_open(const std::string& path, std::string* tmp);
+
+// Sync fd, close it and rename tmp over path, then sync its folder unless
+// the caller does that once for several files. Returns false after logging
+// (path is left as it was)
+bool replace_commit(int fd, const std::string& tmp, const std::string& path,
+                    bool sync_folder = true);
+
+// Give up a replacement: close fd and remove tmp
+void replace_abort(int fd, const std::string& tmp);
+
+} // namespace audio
+} // namespace sc
@@ -31,6 +31,16 @@
 //
 
 struct MidiCommand {
+    // Pseudo status for NRPNs assembled by the parser from CC 99/98/6/38.
+    // 0xF0 never carries a channel on the wire, so it can't collide.
+    // data1 = parameter LSB, data2 = parameter MSB.
+    static constexpr uint8_t NRPN = 0xF0;
+
+    // Relative encoder encodings (jog wheels), see relative_delta()
+    static constexpr uint8_t REL_TWOS_COMPLEMENT = 0;  // 1..63 up, 127..64 down
+    static constexpr uint8_t REL_BINARY_OFFSET = 1;    // 65..127 up, 63..0 down
+    static constexpr uint8_t REL_SIGN_MAGNITUDE = 2;   // 1..63 up, 65..127 down
+
     uint8_t status = 0;   // Status byte (type | channel)
     uint8_t data1 = 0;    // Note/CC number or pitch bend LSB
     uint8_t data2 = 0;    // Velocity/value or pitch bend MSB
@@ -46,6 +56,12 @@ struct MidiCommand {
     bool is_note_off() const { return type() == 0x80 || (type() == 0x90 && data2 == 0); }
     bool is_cc() const { return type() == 0xB0; }
     bool is_pitch_bend() const { return type() == 0xE0; }
+    bool is_nrpn() const { return type() == NRPN; }
+
+    // NRPN parameter number (0-16383)
+    uint16_t nrpn_number() const {
+        return (static_cast<uint16_t>(data2) << 7) | data1;
+    }
 
     // 14-bit pitch bend value (0-16383, center at 8192)
     uint16_t pitch_bend_value() const {
@@ -57,6 +73,18 @@ struct MidiCommand {
         return (static_cast<double>(pitch_bend_value()) - 8192.0) / 8192.0;
     }
 
+    // Signed tick count of a relative controller value
+    static int relative_delta(uint8_t value, uint8_t encoding) {
+        switch (encoding) {
+        case REL_BINARY_OFFSET:
+            return static_cast<int>(value) - 64;
+        case REL_SIGN_MAGNITUDE:
+            return (value & 0x40) ? -static_cast<int>(value & 0x3F) : static_cast<int>(value & 0x3F);
+        default:
+            return (value & 0x40) ? static_cast<int>(value) - 128 : static_cast<int>(value);
+        }
+    }
+
     // Equality for use as map key
     // Pitch bend matches on status only (ignores data bytes which are values)
     // Everything else matches on status and data1 (note/CC number)
@@ -62,8 +62,6 @@ int MidiController::init(struct Rt* rt, const char* hw)
         return -1;
     }
 
-    ofill_ = 0;
-
     for (int i = 0; i < NUMDECKS; i++) {
         deck_[i] = nullptr;
     }
@@ -73,8 +71,7 @@ int MidiController::init(struct Rt* rt, const char* hw)
         return -1;
     }
 
-    parsing_ = false;
-    parsed_bytes_ = 0;
+    parser_.reset();
     initialized_ = true;
 
     return 0;
@@ -94,22 +91,13 @@ int MidiController::add_deck(struct Deck* k)
     return 0;
 }
 
-void MidiController::process_midi_message()
+void MidiController::process_midi_message(sc::MidiEvent& event)
 {
-    unsigned char status = midi_buffer_[0] & 0xF0;
-    unsigned char channel = midi_buffer_[0] & 0x0F;
-    const char* type = "???";
-    if (status == 0x90) type = "NoteOn";
-    else if (status == 0x80) type = "NoteOff";
-    else if (status == 0xB0) type = "CC";
-    else if (status == 0xE0) type = "PitchBend";
-
-    LOG_INFO("MIDI: %s ch=%d data=[%d, %d]", type, channel, midi_buffer_[1], midi_buffer_[2]);
-
     // Push MIDI event to lock-free queue for processing by input thread
     // Capture current shifted state from engine's input state
-    bool shifted = rt_ && rt_->engine ? rt_->engine->input_state.is_shifted() : false;
-    if (!midi_event_queue_push(midi_buffer_, shifted)) {
+    event.shifted = rt_ && rt_->engine ? rt_->engine->input_state.is_shifted() : false;
+
+    if (!midi_event_queue_push(event)) {
         LOG_WARN("MIDI event queue full, dropping event");
     }
 }
@@ -122,11 +110,11 @@ ssize_t MidiController::pollfds(struct pollfd* pe, size_t z)
 int MidiController::realtime()
 {
     for (;;) {
-        unsigned char buf;
-        unsigned char command;
+        unsigned char buf[64];
+        double timestamp = 0.0;
         ssize_t z;
 
-        z = midi_read(&midi_, &buf, 1);
+        z = midi_read_stamped(&midi_, buf, sizeof(buf), &timestamp);
         if (z == -1) {
             return -1;
         }
@@ -134,29 +122,13 @@ int MidiController::realtime()
             return 0;
         }
 
-        // Bit 7 set = status byte
-        if (buf & 0x80) {
-            command = buf & 0xF0;
-            // Note Off, Note On, Control Change, Pitch Bend
-            if (command == 0x80 || command == 0x90 || command == 0xB0 || command == 0xE0) {
-                parsing_ = true;
-                parsed_bytes_ = 0;  // Reset counter for new message
-                midi_buffer_[0] = buf;
-            } else {
-                parsing_ = false;
-            }
-        }
-        // Bit 7 unset = data byte
-        else {
-            if (parsing_) {
-                midi_buffer_[++parsed_bytes_] = buf;
-
-                // Complete message (status + 2 data bytes)
-                if (parsed_bytes_ == 2) {
-                    parsing_ = false;
-                    parsed_bytes_ = 0;
-                    process_midi_message();
-                }
+        // Running status, 14-bit CC pairing and NRPN assembly happen in
+        // the parser; only complete events reach the queue
+        for (ssize_t i = 0; i < z; i++) {
+            sc::MidiEvent event;
+            if (parser_.feed(buf[i], &event)) {
+                event.timestamp = timestamp;
+                process_midi_message(event);
             }
         }
 
@@ -166,6 +138,34 @@ int MidiController::realtime()
     return 0;
 }
 
+void MidiController::set_high_res(const sc::control::MappingRegistry& mappings)
+{
+    for (uint8_t channel = 0; channel < 16; channel++) {
+        parser_.set_high_res(channel, mappings.high_res_controllers(channel));
+    }
+}
+
+void MidiController::send_feedback(double now)
+{
+    if (!initialized_) {
+        return;
+    }
+
+    unsigned char buf[64];
+    size_t len = feedback_.flush(now, buf, sizeof(buf));
+    if (len == 0) {
+        return;
+    }
+
+    // A short write may leave the device anywhere; the next flush starts
+    // with a status byte and sends the whole state again
+    ssize_t r = midi_write(&midi_, buf, len);
+    if (r != static_cast<ssize_t>(len)) {
+        LOG_DEBUG("MIDI feedback: %zd of %zu bytes written to %s", r, len, port_name_);
+        feedback_.invalidate();
+    }
+}
+
 void MidiController::clear()
 {
     debug("%p", this);
@@ -30,17 +30,22 @@
 
 #include <memory>
 #include "controller.h"
+#include "midi_feedback.h"
+#include "midi_parser.h"
 #include "../platform/midi.h"
 
 #define NUMDECKS 2
 
 struct Rt;
+namespace sc { namespace control { class MappingRegistry; } }
 
 /*
  * MidiController - handles MIDI input devices
  *
- * Parses raw MIDI bytes into messages and pushes them
- * to a lock-free queue for processing by the input thread.
+ * Parses raw MIDI bytes into timestamped events (including 14-bit
+ * CC and NRPN) and pushes them to a lock-free queue for processing
+ * by the input thread. Controller feedback (LEDs, rings) is written
+ * back to the port from the input thread, see MidiFeedback.
  */
 class MidiController : public Controller {
 public:
@@ -67,19 +72,24 @@ public:
 
     const char* port_name() const { return port_name_; }
 
+    // Pair the 14-bit controllers the mappings ask for (input thread)
+    void set_high_res(const sc::control::MappingRegistry& mappings);
+
+    // Desired feedback state of this port (input thread only)
+    sc::input::MidiFeedback& feedback() { return feedback_; }
+
+    // Write due feedback changes to the port, non-blocking
+    void send_feedback(double now);
+
 private:
-    void process_midi_message();
+    void process_midi_message(sc::MidiEvent& event);
 
     struct Rt* rt_ = nullptr;  // For accessing engine->input_state
     struct Midi midi_;
     struct Deck* deck_[NUMDECKS] = {nullptr, nullptr};
 
-    char obuf_[180] = {};
-    size_t ofill_ = 0;
-
-    bool parsing_ = false;
-    unsigned char parsed_bytes_ = 0;
-    unsigned char midi_buffer_[3] = {};
+    sc::input::MidiParser parser_;
+    sc::input::MidiFeedback feedback_;
 
     char port_name_[32] = {};
     bool initialized_ = false;
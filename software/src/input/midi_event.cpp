@@ -29,30 +29,50 @@
 
 #include "midi_event.h"
 
+#include <cstdint>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
 namespace sc {
 
 // Single global queue instance for MIDI events
 // Pre-allocate space for 64 events to avoid runtime allocation
 static MidiEventQueue g_midi_event_queue(64);
 
+// Wakeup for the input thread, created once at startup so the
+// RT thread only ever does a non-blocking write()
+static int g_midi_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
 } // namespace sc
 
 // C API implementations
 
-int midi_event_queue_push(const unsigned char* midi_bytes, int shifted) {
-    sc::MidiEvent event(midi_bytes, shifted != 0);
+int midi_event_queue_push(const sc::MidiEvent& event) {
     // try_enqueue won't allocate - returns false if queue is full
-    return sc::g_midi_event_queue.try_enqueue(event) ? 1 : 0;
+    if (!sc::g_midi_event_queue.try_enqueue(event)) {
+        return 0;
+    }
+
+    if (sc::g_midi_event_fd != -1) {
+        uint64_t one = 1;
+        ssize_t r = write(sc::g_midi_event_fd, &one, sizeof(one));
+        (void)r;  // EAGAIN only if the counter saturates, reader is awake anyway
+    }
+    return 1;
+}
+
+int midi_event_queue_pop(sc::MidiEvent* event) {
+    return sc::g_midi_event_queue.try_dequeue(*event) ? 1 : 0;
+}
+
+int midi_event_queue_fd() {
+    return sc::g_midi_event_fd;
 }
 
-int midi_event_queue_pop(unsigned char* midi_bytes, int* shifted) {
-    sc::MidiEvent event;
-    if (sc::g_midi_event_queue.try_dequeue(event)) {
-        midi_bytes[0] = event.bytes[0];
-        midi_bytes[1] = event.bytes[1];
-        midi_bytes[2] = event.bytes[2];
-        *shifted = event.shifted ? 1 : 0;
-        return 1;
+void midi_event_queue_clear_signal() {
+    if (sc::g_midi_event_fd != -1) {
+        uint64_t count;
+        ssize_t r = read(sc::g_midi_event_fd, &count, sizeof(count));
+        (void)r;
     }
-    return 0;
 }
@@ -24,26 +24,27 @@
 
 #pragma once
 
-#include "../util/spsc_queue.h"
-
-// API for the realtime thread to push events
-// Returns 1 on success, 0 if queue full
-int midi_event_queue_push(const unsigned char* midi_bytes, int shifted);
+#include <cstdint>
 
-// API for the input thread to pop events
-// Returns 1 if event was available, 0 if queue empty
-int midi_event_queue_pop(unsigned char* midi_bytes, int* shifted);
+#include "../util/spsc_queue.h"
 
 namespace sc {
 
 struct MidiEvent {
-    unsigned char bytes[3];
-    bool shifted;  // Shift state at time of event
+    unsigned char bytes[3];  // Lookup key: status, note/CC/NRPN number, 7-bit value
+    uint16_t value;          // 14-bit value (0-16383), 7-bit values scaled by 128
+    bool high_res;           // value has a real LSB (pitch bend, 14-bit CC, NRPN)
+    bool shifted;            // Shift state at time of event
+    double timestamp;        // CLOCK_MONOTONIC seconds when the message completed
 
-    MidiEvent() : bytes{0, 0, 0}, shifted(false) {}
+    MidiEvent() : bytes{0, 0, 0}, value(0), high_res(false), shifted(false), timestamp(0.0) {}
 
     MidiEvent(const unsigned char* buf, bool shift_state)
-        : bytes{buf[0], buf[1], buf[2]}, shifted(shift_state) {}
+        : bytes{buf[0], buf[1], buf[2]},
+          value(static_cast<uint16_t>(buf[2] << 7)),
+          high_res(false),
+          shifted(shift_state),
+          timestamp(0.0) {}
 };
 
 // Queue size: 64 events should be more than enough
@@ -52,3 +53,18 @@ struct MidiEvent {
 using MidiEventQueue = moodycamel::ReaderWriterQueue<MidiEvent>;
 
 } // namespace sc
+
+// API for the realtime thread to push events
+// Returns 1 on success, 0 if queue full
+int midi_event_queue_push(const sc::MidiEvent& event);
+
+// API for the input thread to pop events
+// Returns 1 if event was available, 0 if queue empty
+int midi_event_queue_pop(sc::MidiEvent* event);
+
+// eventfd signalled on every successful push, so the input thread can
+// sleep in epoll instead of polling the queue. Returns -1 if unavailable.
+int midi_event_queue_fd();
+
+// Drain the eventfd counter (input thread, before popping)
+void midi_event_queue_clear_signal();
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// MIDI controller feedback
+
+#include "midi_feedback.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace sc {
+namespace input {
+
+namespace {
+
+// Slot layout: type (note on, CC), channel, number. Slots of one status
+// are adjacent, so a flush walks them in running status order.
+size_t slot_of(uint8_t status, uint8_t data1)
+{
+    size_t type;
+    switch (status & 0xF0) {
+    case 0x90: type = 0; break;
+    case 0xB0: type = 1; break;
+    default: return MidiFeedback::SLOTS;
+    }
+    return ((type * 16 + (status & 0x0F)) * 128) + (data1 & 0x7F);
+}
+
+uint8_t status_of(size_t slot)
+{
+    uint8_t type = (slot / (16 * 128)) == 0 ? 0x90 : 0xB0;
+    return static_cast<uint8_t>(type | ((slot / 128) & 0x0F));
+}
+
+} // namespace
+
+MidiFeedback::MidiFeedback()
+{
+    memset(desired_, UNKNOWN, sizeof(desired_));
+    memset(sent_, UNKNOWN, sizeof(sent_));
+}
+
+void MidiFeedback::set_rate(double bytes_per_second)
+{
+    rate_ = bytes_per_second > 0.0 ? bytes_per_second : DEFAULT_RATE;
+}
+
+void MidiFeedback::set(uint8_t status, uint8_t data1, uint8_t value)
+{
+    size_t s = slot_of(status, data1);
+    if (s == SLOTS) {
+        return;
+    }
+
+    desired_[s] = value & 0x7F;
+
+    // Back to what the device shows: nothing to send
+    uint64_t bit = 1ULL << (s % 64);
+    if (desired_[s] != sent_[s]) {
+        dirty_[s / 64] |= bit;
+    } else {
+        dirty_[s / 64] &= ~bit;
+    }
+}
+
+void MidiFeedback::invalidate()
+{
+    for (size_t s = 0; s < SLOTS; s++) {
+        sent_[s] = UNKNOWN;
+        if (desired_[s] != UNKNOWN) {
+            dirty_[s / 64] |= 1ULL << (s % 64);
+        }
+    }
+}
+
+size_t MidiFeedback::flush(double now, uint8_t* out, size_t max)
+{
+    // Token bucket: accrue rate_ bytes per second, save up at most a burst
+    double burst = std::max(rate_ * BURST_TIME, 3.0);
+    if (last_flush_ < 0.0) {
+        budget_ = burst;
+    } else if (now > last_flush_) {
+        budget_ = std::min(burst, budget_ + ((now - last_flush_) * rate_));
+    }
+    last_flush_ = now;
+
+    size_t n = 0;
+    uint8_t status = 0;
+
+    // Walk the dirty bits from where the last flush stopped, wrapping
+    // around once, so a busy ring can't starve the slots behind it
+    size_t start = cursor_;
+    for (size_t k = 0; k <= WORDS; k++) {
+        size_t w = ((start / 64) + k) % WORDS;
+        uint64_t bits = dirty_[w];
+        if (k == 0) {
+            bits &= ~0ULL << (start % 64);
+        } else if (k == WORDS) {
+            bits &= ~(~0ULL << (start % 64));
+        }
+
+        while (bits != 0) {
+            size_t s = (w * 64) + static_cast<size_t>(__builtin_ctzll(bits));
+            bits &= bits - 1;
+
+            uint8_t st = status_of(s);
+            size_t cost = (st == status) ? 2 : 3;
+            if (static_cast<double>(cost) > budget_ || n + cost > max) {
+                cursor_ = s;
+                return n;
+            }
+
+            if (st != status) {
+                out[n++] = st;
+                status = st;
+            }
+            out[n++] = static_cast<uint8_t>(s % 128);
+            out[n++] = desired_[s];
+
+            sent_[s] = desired_[s];
+            dirty_[w] &= ~(1ULL << (s % 64));
+            budget_ -= static_cast<double>(cost);
+        }
+    }
+
+    cursor_ = 0;
+    return n;
+}
+
+size_t MidiFeedback::pending() const
+{
+    size_t count = 0;
+    for (uint64_t w : dirty_) {
+        count += static_cast<size_t>(__builtin_popcountll(w));
+    }
+    return count;
+}
+
+} // namespace input
+} // namespace sc
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// MIDI controller feedback
+// Desired LED/ring state per port, diffed against what the device was last
+// sent. Changes between flushes coalesce into one message, output is paced
+// by a byte budget and packed with running status. Runs on the input
+// thread, no allocation.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sc {
+namespace input {
+
+class MidiFeedback {
+public:
+    // Note on (velocity) and control change slots, per channel and number
+    static constexpr size_t TYPES = 2;
+    static constexpr size_t SLOTS = TYPES * 16 * 128;
+
+    // Default pace: a third of a 31250 baud DIN port
+    static constexpr double DEFAULT_RATE = 1000.0;
+
+    // Bytes the budget may save up while idle, in seconds of rate
+    static constexpr double BURST_TIME = 0.05;
+
+    MidiFeedback();
+
+    // Bytes per second this port may carry
+    void set_rate(double bytes_per_second);
+
+    // Desired value of a note (status 0x9n, off = velocity 0) or a
+    // controller (0xBn). Other statuses are ignored.
+    void set(uint8_t status, uint8_t data1, uint8_t value);
+
+    // The device state is unknown (reconnect, failed write): resend
+    // every slot that has a desired value
+    void invalidate();
+
+    // Encode changed slots into out, within max bytes and the budget
+    // accrued up to now. Running status applies within one flush only.
+    // Returns the number of bytes written.
+    size_t flush(double now, uint8_t* out, size_t max);
+
+    // Slots still waiting to be sent
+    size_t pending() const;
+
+private:
+    static constexpr uint8_t UNKNOWN = 0xFF;
+    static constexpr size_t WORDS = SLOTS / 64;
+
+    uint8_t desired_[SLOTS];
+    uint8_t sent_[SLOTS];
+    uint64_t dirty_[WORDS] = {};
+
+    size_t cursor_ = 0;  // Where the last flush ran out of budget
+
+    double rate_ = DEFAULT_RATE;
+    double budget_ = 0.0;
+    double last_flush_ = -1.0;
+};
+
+} // namespace input
+} // namespace sc
@@ -30,13 +30,25 @@
 #include "../control/actions.h"
 #include "../util/log.h"
 
+#include <cmath>
 #include <cstring>
+#include <ctime>
 
 namespace sc {
 namespace input {
 
 using sc::control::dispatch_event;
 
+// Seconds of audio per turn of a jog wheel position ring (33 1/3 rpm)
+static constexpr double RING_REVOLUTION = 1.8;
+
+static double monotonic_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) + (static_cast<double>(ts.tv_nsec) / 1000000000.0);
+}
+
 void init_midi(MidiContext* ctx)
 {
     ctx->controllers.clear();
@@ -73,6 +85,8 @@ void poll_midi_devices(MidiContext* ctx, Sc1000* engine)
                     LOG_INFO("Adding MIDI device %zu - %s", ctx->controllers.size(), ctx->device_names[devc]);
                     controller_add_deck(controller.get(), &engine->beat_deck);
                     controller_add_deck(controller.get(), &engine->scratch_deck);
+                    controller->feedback().set_rate(engine->settings->midi_feedback_rate);
+                    controller->set_high_res(engine->mappings);
                     ctx->controllers.push_back(std::move(controller));
                 }
             }
@@ -87,25 +101,105 @@ void process_midi_events(Sc1000* engine)
     ScSettings* settings = engine->settings.get();
 
     // Process MIDI events from the lock-free queue
-    unsigned char midi_bytes[3];
-    int midi_shifted;
-    while (midi_event_queue_pop(midi_bytes, &midi_shifted)) {
-        EventType edge = midi_shifted ? BUTTON_PRESSED_SHIFTED : BUTTON_PRESSED;
+    MidiEvent event;
+    while (midi_event_queue_pop(&event)) {
+        EventType edge = event.shifted ? BUTTON_PRESSED_SHIFTED : BUTTON_PRESSED;
 
         // Create MidiCommand from bytes and use registry lookup
-        MidiCommand cmd = MidiCommand::from_bytes(midi_bytes);
+        MidiCommand cmd = MidiCommand::from_bytes(event.bytes);
         cmd.normalize();  // Note-on with velocity 0 becomes note-off
 
         Mapping* midi_map = engine->mappings.find_midi(cmd, edge);
         if (midi_map != nullptr) {
-            LOG_DEBUG("MIDI Mapping found: action=%d deck=%d param=%d",
-                     midi_map->action_type, midi_map->deck_no, midi_map->parameter);
-            dispatch_event(midi_map, midi_bytes, engine, settings, engine->input_state);
-        } else {
-            LOG_DEBUG("MIDI no Mapping for [%02X %02X %02X] shifted=%d",
-                     midi_bytes[0], midi_bytes[1], midi_bytes[2], midi_shifted);
+            dispatch_event(midi_map, &event, engine, settings, engine->input_state);
+        }
+    }
+}
+
+void update_jog_wheels(Sc1000* engine)
+{
+    ScSettings* settings = engine->settings.get();
+    double now = monotonic_now();
+
+    engine->beat_deck.jog_update(now, settings);
+    engine->scratch_deck.jog_update(now, settings);
+}
+
+// What a mapped control should show: 0-127, or -1 if its action has no state
+static int feedback_value(const Mapping& map, Sc1000* engine)
+{
+    Deck* deck = (map.deck_no == 0) ? &engine->beat_deck : &engine->scratch_deck;
+    bool on;
+
+    switch (map.action_type) {
+    case CUE:
+    case DELETECUE:
+        on = deck->cues.is_set(map.midi_command_bytes[1]);
+        break;
+    case RECORD:
+        on = engine->audio && engine->audio->is_recording(map.deck_no);
+        break;
+    case LOOPRECALL:
+        on = engine->audio && engine->audio->has_loop(map.deck_no);
+        break;
+    case STARTSTOP:
+    case START:
+        on = !deck->player.input.stopped;
+        break;
+    case STOP:
+        on = deck->player.input.stopped;
+        break;
+    case SHIFTON:
+        on = engine->input_state.is_shifted();
+        break;
+    case JOGPIT:
+        on = engine->input_state.pitch_mode() == map.deck_no + 1;
+        break;
+    case JOG: {
+        double position = engine->audio ? engine->audio->get_position(map.deck_no) : 0.0;
+        double turn = position / RING_REVOLUTION;
+        return static_cast<int>((turn - std::floor(turn)) * 128.0) & 0x7F;
+    }
+    default:
+        return -1;
+    }
+
+    return on ? 127 : 0;
+}
+
+void update_midi_feedback(MidiContext* ctx, Sc1000* engine)
+{
+    if (!engine->settings->midi_feedback || ctx->controllers.empty()) {
+        return;
+    }
+
+    // A button can carry an action per shift state: the one that would
+    // fire now is applied last and decides what its LED shows
+    EventType current = engine->input_state.is_shifted() ? BUTTON_PRESSED_SHIFTED : BUTTON_PRESSED;
+    EventType other = (current == BUTTON_PRESSED) ? BUTTON_PRESSED_SHIFTED : BUTTON_PRESSED;
+
+    for (EventType edge : {other, current}) {
+        for (const Mapping& map : engine->mappings.all()) {
+            if (map.type != MIDI || map.edge_type != edge) {
+                continue;
+            }
+
+            int value = feedback_value(map, engine);
+            if (value < 0) {
+                continue;
+            }
+
+            for (const auto& controller : ctx->controllers) {
+                controller->feedback().set(map.midi_command_bytes[0], map.midi_command_bytes[1],
+                                           static_cast<uint8_t>(value));
+            }
         }
     }
+
+    double now = monotonic_now();
+    for (const auto& controller : ctx->controllers) {
+        controller->send_feedback(now);
+    }
 }
 
 } // namespace input
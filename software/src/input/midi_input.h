@@ -56,5 +56,14 @@ void poll_midi_devices(MidiContext* ctx, Sc1000* engine);
 // Dispatches events to the appropriate action handlers
 void process_midi_events(Sc1000* engine);
 
+// Sample external jog wheels into their decks' target position
+// Call once per input tick, like the built-in encoder is polled
+void update_jog_wheels(Sc1000* engine);
+
+// Refresh every controller's feedback (LEDs of mapped cue, record, play,
+// shift and pitch mode buttons, position ring on jog wheel CCs) from deck
+// state and send what changed. Call once per input tick.
+void update_midi_feedback(MidiContext* ctx, Sc1000* engine);
+
 } // namespace input
 } // namespace sc
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// MIDI byte stream parser
+
+#include "midi_parser.h"
+#include "midi_command.h"
+
+namespace sc {
+namespace input {
+
+namespace {
+
+// Controllers with a meaning of their own
+constexpr uint8_t CC_DATA_ENTRY = 6;   // LSB on CC 38, paired while a parameter is selected
+constexpr uint8_t CC_NRPN_LSB = 98;
+constexpr uint8_t CC_NRPN_MSB = 99;
+constexpr uint8_t CC_RPN_LSB = 100;
+constexpr uint8_t CC_RPN_MSB = 101;
+
+// Number of data bytes after a channel voice status
+int message_length(uint8_t status)
+{
+    uint8_t type = status & 0xF0;
+    return (type == 0xC0 || type == 0xD0) ? 1 : 2;
+}
+
+void set_event(MidiEvent* out, uint8_t status, uint8_t data1, uint8_t data2,
+               uint16_t value, bool high_res)
+{
+    out->bytes[0] = status;
+    out->bytes[1] = data1;
+    out->bytes[2] = data2;
+    out->value = value;
+    out->high_res = high_res;
+}
+
+} // namespace
+
+void MidiParser::reset()
+{
+    running_status_ = 0;
+    data_count_ = 0;
+    for (auto& ch : channels_) {
+        ch = ChannelState{};
+    }
+}
+
+void MidiParser::set_high_res(uint8_t channel, uint32_t controllers)
+{
+    high_res_[channel & 0x0F].store(controllers, std::memory_order_relaxed);
+}
+
+bool MidiParser::feed(uint8_t byte, MidiEvent* out)
+{
+    // System realtime (clock, start/stop, active sensing) may appear
+    // anywhere, even between data bytes, and leaves running status alone
+    if (byte >= 0xF8) {
+        return false;
+    }
+
+    // Status byte: system common and SysEx cancel running status
+    if (byte & 0x80) {
+        running_status_ = byte < 0xF0 ? byte : 0;
+        data_count_ = 0;
+        return false;
+    }
+
+    // Data byte: under running status a new message starts without a status
+    if (running_status_ == 0) {
+        return false;
+    }
+
+    data_[data_count_++] = byte;
+    if (data_count_ < message_length(running_status_)) {
+        return false;
+    }
+
+    data_count_ = 0;
+    return complete(out);
+}
+
+bool MidiParser::complete(MidiEvent* out)
+{
+    uint8_t channel = running_status_ & 0x0F;
+
+    switch (running_status_ & 0xF0) {
+    case 0x80:
+    case 0x90:
+        set_event(out, running_status_, data_[0], data_[1],
+                  static_cast<uint16_t>(data_[1] << 7), false);
+        return true;
+
+    case 0xB0:
+        return control_change(channel, data_[0], data_[1], out);
+
+    case 0xE0:
+        set_event(out, running_status_, data_[0], data_[1],
+                  static_cast<uint16_t>((data_[1] << 7) | data_[0]), true);
+        return true;
+
+    default:
+        // Aftertouch and program change have nothing to map to
+        return false;
+    }
+}
+
+bool MidiParser::control_change(uint8_t channel, uint8_t cc, uint8_t value, MidiEvent* out)
+{
+    ChannelState& ch = channels_[channel];
+
+    // Parameter selection only changes state. 127/127 is the null parameter.
+    switch (cc) {
+    case CC_NRPN_MSB:
+    case CC_NRPN_LSB:
+    case CC_RPN_MSB:
+    case CC_RPN_LSB:
+        if (cc == CC_NRPN_MSB || cc == CC_RPN_MSB) {
+            ch.param_msb = value;
+        } else {
+            ch.param_lsb = value;
+        }
+        if (ch.param_msb == 0x7F && ch.param_lsb == 0x7F) {
+            ch.data_entry = DataEntry::None;
+        } else {
+            ch.data_entry = (cc >= CC_RPN_LSB) ? DataEntry::Rpn : DataEntry::Nrpn;
+        }
+        return false;
+
+    default:
+        break;
+    }
+
+    // Pair 14-bit controllers: CC n (MSB) followed by CC n+32 (LSB), for
+    // the controllers mapped as high_res and for data entry while a
+    // parameter is selected. Such a controller only counts as 14-bit once
+    // its LSB has been seen; until then the MSB goes out alone as a 7-bit
+    // value. Every other CC 0-63 is an independent 7-bit controller.
+    uint32_t paired = high_res_[channel].load(std::memory_order_relaxed);
+    if (ch.data_entry != DataEntry::None) {
+        paired |= 1u << CC_DATA_ENTRY;
+    }
+
+    uint16_t value14 = static_cast<uint16_t>(value << 7);
+    bool high_res = false;
+
+    if (cc < 32 && (paired & (1u << cc))) {
+        uint32_t bit = 1u << cc;
+        ch.msb[cc] = value;
+        ch.msb_seen |= bit;
+        if (ch.lsb_seen & bit) {
+            return false;  // Emitted together with the LSB
+        }
+    } else if (cc >= 32 && cc < 64 && (paired & ch.msb_seen & (1u << (cc - 32)))) {
+        cc = static_cast<uint8_t>(cc - 32);
+        ch.lsb_seen |= 1u << cc;
+        value14 = static_cast<uint16_t>((ch.msb[cc] << 7) | value);
+        high_res = true;
+    }
+
+    if (cc == CC_DATA_ENTRY && ch.data_entry != DataEntry::None) {
+        // RPNs (bend range, tuning) configure synths, nothing maps to them
+        if (ch.data_entry == DataEntry::Rpn) {
+            return false;
+        }
+        set_event(out, static_cast<uint8_t>(MidiCommand::NRPN | channel),
+                  ch.param_lsb, ch.param_msb, value14, high_res);
+        return true;
+    }
+
+    set_event(out, static_cast<uint8_t>(0xB0 | channel), cc,
+              static_cast<uint8_t>(value14 >> 7), value14, high_res);
+    return true;
+}
+
+} // namespace input
+} // namespace sc
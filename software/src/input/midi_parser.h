@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// MIDI byte stream parser
+// Turns raw rawmidi bytes into MidiEvents: running status, 14-bit control
+// changes (CC 0-31 MSB paired with CC 32-63 LSB, for the controllers a
+// mapping marks high_res) and NRPNs (CC 99/98 select, CC 6/38 data entry).
+// Runs on the realtime thread, no allocation.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "midi_event.h"
+
+namespace sc {
+namespace input {
+
+class MidiParser {
+public:
+    // Feed one byte from the port. Returns true when *out holds a complete
+    // event; shifted and timestamp are left for the caller to fill in.
+    bool feed(uint8_t byte, MidiEvent* out);
+
+    // Forget running status and all controller state (device reopened)
+    void reset();
+
+    // CC 0-31 of a channel to pair with their LSB on CC 32-63, bit n = CC n.
+    // Every other CC is 7-bit. Set from the input thread, kept over reset().
+    void set_high_res(uint8_t channel, uint32_t controllers);
+
+private:
+    // Which parameter the data entry controllers (CC 6/38) address
+    enum class DataEntry : uint8_t { None, Nrpn, Rpn };
+
+    struct ChannelState {
+        uint8_t msb[32] = {};      // Last MSB of CC 0-31
+        uint32_t msb_seen = 0;     // Bit n: CC n has been received
+        uint32_t lsb_seen = 0;     // Bit n: CC n is a 14-bit controller, wait for its LSB
+        uint8_t param_msb = 0x7F;  // NRPN/RPN parameter being selected
+        uint8_t param_lsb = 0x7F;
+        DataEntry data_entry = DataEntry::None;
+    };
+
+    bool complete(MidiEvent* out);
+    bool control_change(uint8_t channel, uint8_t cc, uint8_t value, MidiEvent* out);
+
+    uint8_t running_status_ = 0;  // 0 = none, data bytes are dropped
+    uint8_t data_[2] = {};
+    int data_count_ = 0;
+
+    ChannelState channels_[16];
+    std::atomic<uint32_t> high_res_[16] = {};
+};
+
+} // namespace input
+} // namespace sc
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+// Platter motion estimator
+
+#include "platter_estimator.h"
+
+#include <cmath>
+
+namespace sc {
+namespace input {
+
+void PlatterEstimator::reset(double position, double time)
+{
+    position_ = position;
+    velocity_ = 0.0;
+    time_ = time;
+    initialized_ = true;
+}
+
+void PlatterEstimator::update(double measured_position, double time)
+{
+    if (!initialized_) {
+        reset(measured_position, time);
+        return;
+    }
+
+    double dt = time - time_;
+    if (dt <= 0.0) {
+        return;
+    }
+
+    double predicted = position_ + velocity_ * dt;
+    double residual = measured_position - predicted;
+
+    if (std::fabs(residual) > JUMP_THRESHOLD) {
+        reset(measured_position, time);
+        return;
+    }
+
+    position_ = predicted + ALPHA * residual;
+    velocity_ += (BETA / dt) * residual;
+    time_ = time;
+}
+
+double PlatterEstimator::predict(double time) const
+{
+    double dt = time - time_;
+    if (dt < 0.0) dt = 0.0;
+    if (dt > MAX_EXTRAPOLATION) dt = MAX_EXTRAPOLATION;
+
+    return position_ + velocity_ * dt;
+}
+
+} // namespace input
+} // namespace sc
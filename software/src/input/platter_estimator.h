@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+// Platter motion estimator
+// Alpha-beta tracker turning quantized encoder positions into a smooth
+// position/velocity estimate that can be extrapolated ahead in time.
+// Hardware-agnostic: positions are in seconds of audio, times in seconds.
+
+#pragma once
+
+namespace sc {
+namespace input {
+
+class PlatterEstimator {
+public:
+    // Gains of the alpha-beta filter. beta = alpha^2 / (2 - alpha) gives a
+    // critically damped response; 0.25 settles in ~10 input periods while
+    // keeping 12-bit quantization and coarse input steps out of the velocity.
+    static constexpr double ALPHA = 0.25;
+    static constexpr double BETA = ALPHA * ALPHA / (2.0 - ALPHA);
+
+    // A residual larger than this (seconds of audio in one sample) is not
+    // hand movement but a rebase of the encoder offset (touch, cue, load)
+    static constexpr double JUMP_THRESHOLD = 0.25;
+
+    // Never extrapolate further than this (seconds), in case input stalls
+    static constexpr double MAX_EXTRAPOLATION = 0.02;
+
+    // Restart tracking at a position with zero velocity
+    void reset(double position, double time);
+
+    // Feed one measured position taken at time
+    void update(double measured_position, double time);
+
+    // Position extrapolated to time (clamped to MAX_EXTRAPOLATION)
+    double predict(double time) const;
+
+    double position() const { return position_; }
+
+    // Platter velocity in seconds of audio per second, i.e. playback pitch
+    double velocity() const { return velocity_; }
+
+    bool is_initialized() const { return initialized_; }
+
+private:
+    double position_ = 0.0;
+    double velocity_ = 0.0;
+    double time_ = 0.0;
+    bool initialized_ = false;
+};
+
+} // namespace input
+} // namespace sc
@@ -136,6 +136,8 @@ static void sig_handler(int signo)
     if (signo == SIGINT) {
         printf("received SIGINT\n");
         g_rig.quit();  // Signal main loop to exit cleanly
+    } else if (signo == SIGHUP) {
+        request_sc_settings_reload();
     }
 }
 
@@ -160,6 +162,12 @@ int main(int argc, char* argv[])
         exit(1);
     }
 
+    // SIGHUP reloads sc_settings.json without restarting
+    if (signal(SIGHUP, sig_handler) == SIG_ERR) {
+        SC_LOG_ERROR("Can't catch SIGHUP");
+        exit(1);
+    }
+
     if (setlocale(LC_ALL, "") == nullptr) {
         SC_LOG_ERROR("Could not honour the local encoding");
         return -1;
@@ -183,7 +191,7 @@ int main(int argc, char* argv[])
     start_sc_input_thread();
 
     // Start realtime stuff
-    priority = 0;
+    priority = g_sc1000_engine.settings->rt_priority;
 
     if (g_rt.start(priority) == -1) {
         return -1;
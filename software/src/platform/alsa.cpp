@@ -99,6 +99,13 @@ public:
     bool has_loop(int deck) const override;
     bool has_capture() const override { return capture_enabled_; }
     void reset_loop(int deck) override;
+    bool grab_loop(int deck, double seconds) override;
+    bool adopt_loop(int deck, Track* track) override;
+    void collect_loops() override;
+    unsigned int loop_version(int deck) const override;
+    bool snapshot_loop(int deck, sc::audio::LoopSnapshot* snapshot) override;
+    bool calibrate_latency() override;
+    sc::audio::LatencyCalibration latency_calibration() const override;
     Track* get_loop_track(int deck) override;
     Track* peek_loop_track(int deck) override;
 
@@ -121,7 +128,9 @@ private:
     int capture_channels_ = 0;
     int capture_left_ = 0;
     int capture_right_ = 1;
-    AudioInterface* config_ = nullptr;
+    int capture_scratch_left_ = 0;
+    int capture_scratch_right_ = 1;
+    bool cv_enabled_ = false;  // Config is not kept: settings snapshots get replaced
     CvState cv_{};
     snd_pcm_format_t playback_format_ = SND_PCM_FORMAT_S16_LE;
     snd_pcm_format_t capture_format_ = SND_PCM_FORMAT_S16_LE;
@@ -590,15 +599,16 @@ int AlsaAudio::process_audio() {
         capture_info.channels = capture_channels_;
         capture_info.left_channel = capture_left_;
         capture_info.right_channel = capture_right_;
+        capture_info.scratch_left_channel = capture_scratch_left_;
+        capture_info.scratch_right_channel = capture_scratch_right_;
 
+        // Each recording deck monitors its input through its own volume
         constexpr float BASE_VOLUME = 7.0f / 8.0f;
-        int rec_deck = audio_engine_->recording_deck();
-        if (rec_deck == 0) {
-            audio_engine_->set_monitoring_volume(BASE_VOLUME * static_cast<float>(audio_engine_->get_volume(0)));
-        } else if (rec_deck == 1) {
-            audio_engine_->set_monitoring_volume(BASE_VOLUME * static_cast<float>(audio_engine_->get_volume(1)));
-        } else {
-            audio_engine_->set_monitoring_volume(0.0f);
+        for (int deck = 0; deck < 2; deck++) {
+            float volume = audio_engine_->is_recording(deck)
+                ? BASE_VOLUME * static_cast<float>(audio_engine_->get_volume(deck))
+                : 0.0f;
+            audio_engine_->set_monitoring_volume(deck, volume);
         }
     }
 
@@ -624,7 +634,7 @@ int AlsaAudio::process_audio() {
             in += stereo_bytes;
         }
 
-        if (config_ && config_->supports_cv) {
+        if (cv_enabled_) {
             // Use query API for audio engine output state
             auto deck_state = audio_engine_->get_deck_state(1);  // Scratch deck = 1
             CvControllerInput cv_input = {
@@ -690,6 +700,34 @@ void AlsaAudio::reset_loop(int deck) {
     audio_engine_->reset_loop(deck);
 }
 
+bool AlsaAudio::grab_loop(int deck, double seconds) {
+    return audio_engine_->grab_loop(deck, seconds);
+}
+
+bool AlsaAudio::adopt_loop(int deck, Track* track) {
+    return audio_engine_->adopt_loop(deck, track);
+}
+
+void AlsaAudio::collect_loops() {
+    audio_engine_->collect_loops();
+}
+
+unsigned int AlsaAudio::loop_version(int deck) const {
+    return audio_engine_->loop_version(deck);
+}
+
+bool AlsaAudio::snapshot_loop(int deck, sc::audio::LoopSnapshot* snapshot) {
+    return audio_engine_->snapshot_loop(deck, snapshot);
+}
+
+bool AlsaAudio::calibrate_latency() {
+    return audio_engine_->start_latency_calibration();
+}
+
+sc::audio::LatencyCalibration AlsaAudio::latency_calibration() const {
+    return audio_engine_->latency_calibration();
+}
+
 Track* AlsaAudio::get_loop_track(int deck) {
     return audio_engine_->get_loop_track(deck);
 }
@@ -740,9 +778,11 @@ bool AlsaAudio::setup(AlsaDeviceInfo* device_info, AudioInterface* config, int n
              snd_pcm_format_name(playback_format_));
 
     num_channels_ = num_channels;
-    config_ = config;
+    cv_enabled_ = config && config->supports_cv;
     capture_left_ = config ? config->input_left : 0;
     capture_right_ = config ? config->input_right : 1;
+    capture_scratch_left_ = (config && config->scratch_input_left >= 0) ? config->scratch_input_left : capture_left_;
+    capture_scratch_right_ = (config && config->scratch_input_right >= 0) ? config->scratch_input_right : capture_right_;
 
     int hw_input_channels = static_cast<int>(device_info->input_channels);
     if (hw_input_channels >= 2) {
@@ -762,7 +802,12 @@ bool AlsaAudio::setup(AlsaDeviceInfo* device_info, AudioInterface* config, int n
     }
 
     int loop_max = settings ? settings->loop_max_seconds : 60;
-    audio_engine_->init_loop_buffers(TARGET_SAMPLE_RATE, loop_max);
+    int loop_pool = settings ? settings->loop_pool_seconds : 0;
+    audio_engine_->init_loop_buffers(TARGET_SAMPLE_RATE, loop_max, loop_pool);
+    audio_engine_->set_record_latency(config ? config->latency_frames : 0);
+    if (capture_enabled_ && settings) {
+        audio_engine_->init_capture_ring(TARGET_SAMPLE_RATE, settings->capture_ring_seconds);
+    }
 
     if (config && config->supports_cv) {
         cv_engine_init(&cv_, TARGET_SAMPLE_RATE);
@@ -54,12 +54,18 @@ uint16_t encoder_read_angle(EncoderState* state)
 {
     if (!state->present) return 0;
 
-    unsigned char high, low;
-    i2c_read_reg(state->i2c_fd, AS5600_ANGLE_H, &high);
-    i2c_read_reg(state->i2c_fd, AS5600_ANGLE_L, &low);
+    // ANGLE_H/ANGLE_L are adjacent and the AS5600 auto-increments,
+    // so both bytes come from one combined transaction
+    static_assert(AS5600_ANGLE_L == AS5600_ANGLE_H + 1, "angle registers must be contiguous");
+
+    unsigned char buf[2];
+    if (!i2c_read_block(state->i2c_fd, AS5600_ADDR, AS5600_ANGLE_H, buf, 2)) {
+        return state->last_angle;
+    }
 
     // 12-bit angle: high byte has bits 11:8, low byte has bits 7:0
-    return (static_cast<uint16_t>(high & 0x0F) << 8) | low;
+    state->last_angle = static_cast<uint16_t>((buf[0] & 0x0F) << 8) | buf[1];
+    return state->last_angle;
 }
 
 } // namespace platform
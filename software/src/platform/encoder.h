@@ -30,6 +30,7 @@ namespace platform {
 struct EncoderState {
     int i2c_fd = -1;
     bool present = false;
+    uint16_t last_angle = 0;  // Returned again if a bus transaction fails
 };
 
 // Initialize rotary encoder on I2C bus
@@ -34,7 +34,10 @@
 namespace sc {
 namespace platform {
 
-// MCP23017 register addresses
+// MCP23017 I2C address
+constexpr uint8_t MCP23017_ADDR = 0x20;
+
+// MCP23017 register addresses (IOCON.BANK = 0, sequential mode)
 constexpr uint8_t MCP_IODIRA   = 0x00;  // I/O direction register A
 constexpr uint8_t MCP_IODIRB   = 0x01;  // I/O direction register B
 constexpr uint8_t MCP_GPPUA    = 0x0C;  // Pullup register A
@@ -47,7 +50,7 @@ constexpr uint32_t A13_GPIO_BASE = 0x01C20800;
 
 bool gpio_init_mcp23017(GpioState* state)
 {
-    state->mcp23017_fd = i2c_open("/dev/i2c-1", 0x20);
+    state->mcp23017_fd = i2c_open("/dev/i2c-1", MCP23017_ADDR);
     if (state->mcp23017_fd < 0) {
         LOG_WARN("Couldn't init external GPIO (MCP23017)");
         state->mcp23017_present = false;
@@ -159,11 +162,13 @@ uint16_t gpio_mcp23017_read_all(GpioState* state)
 {
     if (!state->mcp23017_present) return 0;
 
-    unsigned char bank_a, bank_b;
-    i2c_read_reg(state->mcp23017_fd, MCP_GPIOA, &bank_a);
-    i2c_read_reg(state->mcp23017_fd, MCP_GPIOB, &bank_b);
+    // GPIOA and GPIOB in one combined transaction
+    unsigned char banks[2];
+    if (!i2c_read_block(state->mcp23017_fd, MCP23017_ADDR, MCP_GPIOA, banks, 2)) {
+        return 0;
+    }
 
-    uint16_t result = (static_cast<uint16_t>(bank_b) << 8) | bank_a;
+    uint16_t result = (static_cast<uint16_t>(banks[1]) << 8) | banks[0];
 
     // Invert: hardware is active-low, return active-high
     return result ^ 0xFFFF;
@@ -219,5 +224,42 @@ uint32_t gpio_a13_read_port(GpioState* state, uint8_t port)
     return *data_reg ^ 0xFFFFFFFF;  // Invert: active-low to active-high
 }
 
+uint32_t gpio_debounce_update(GpioPortDebounce* db, uint32_t sample, uint32_t mask,
+                              unsigned int lockout_ticks)
+{
+    if (lockout_ticks > (1u << GPIO_DEBOUNCE_PLANES) - 1) {
+        lockout_ticks = (1u << GPIO_DEBOUNCE_PLANES) - 1;
+    }
+
+    // Advance the counters of locked pins (ripple-carry across planes)
+    uint32_t carry = db->lockout;
+    for (int i = 0; i < GPIO_DEBOUNCE_PLANES && carry; i++) {
+        uint32_t plane = db->count[i];
+        db->count[i] = plane ^ carry;
+        carry &= plane;
+    }
+
+    // Release pins whose counter reached lockout_ticks
+    uint32_t expired = db->lockout;
+    for (int i = 0; i < GPIO_DEBOUNCE_PLANES; i++) {
+        expired &= (lockout_ticks >> i) & 1u ? db->count[i] : ~db->count[i];
+    }
+    if (expired) {
+        db->lockout &= ~expired;
+        for (int i = 0; i < GPIO_DEBOUNCE_PLANES; i++) {
+            db->count[i] &= ~expired;
+        }
+    }
+
+    // Accept edges on free pins and lock them
+    uint32_t changed = (sample ^ db->state) & mask & ~db->lockout;
+    db->state ^= changed;
+    if (lockout_ticks > 0) {
+        db->lockout |= changed;
+    }
+
+    return changed;
+}
+
 } // namespace platform
 } // namespace sc
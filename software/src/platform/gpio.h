@@ -73,5 +73,26 @@ bool gpio_a13_read_pin(GpioState* state, uint8_t port, uint8_t pin);
 // Read all pins from an A13 GPIO port
 uint32_t gpio_a13_read_port(GpioState* state, uint8_t port);
 
+//
+// Bitsliced debouncing for a whole 32-bit port
+//
+// An edge is accepted as soon as it is seen, then the pin ignores further
+// changes for lockout_ticks scans (contact bounce). The lockout counters are
+// vertical: plane i holds bit i of every pin's counter, so a scan is a few
+// word-wide operations no matter how many pins are mapped.
+//
+constexpr int GPIO_DEBOUNCE_PLANES = 8;  // Lockout up to 255 scans
+
+struct GpioPortDebounce {
+    uint32_t state = 0;    // Debounced pin state (active-high)
+    uint32_t lockout = 0;  // Pins currently ignoring changes
+    uint32_t count[GPIO_DEBOUNCE_PLANES] = {};
+};
+
+// Feed one raw port sample, considering only pins in mask
+// Returns the pins whose debounced state changed on this scan
+uint32_t gpio_debounce_update(GpioPortDebounce* db, uint32_t sample, uint32_t mask,
+                              unsigned int lockout_ticks);
+
 } // namespace platform
 } // namespace sc
@@ -27,6 +27,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <linux/i2c.h>
 #include <linux/i2c-dev.h>
 
 #include "../util/log.h"
@@ -63,6 +64,65 @@ void i2c_read_reg(int fd, unsigned char reg, unsigned char* result)
     }
 }
 
+int i2c_read_block(int fd, unsigned char address, unsigned char reg,
+                   unsigned char* buf, size_t len)
+{
+    struct i2c_msg msgs[2];
+    msgs[0].addr = address;
+    msgs[0].flags = 0;
+    msgs[0].len = 1;
+    msgs[0].buf = &reg;
+    msgs[1].addr = address;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].len = static_cast<__u16>(len);
+    msgs[1].buf = buf;
+
+    struct i2c_rdwr_ioctl_data xfer;
+    xfer.msgs = msgs;
+    xfer.nmsgs = 2;
+
+    if (ioctl(fd, I2C_RDWR, &xfer) != 2) {
+        LOG_WARN("I2C block read error (0x%02x, reg 0x%02x)", address, reg);
+        return 0;
+    }
+    return 1;
+}
+
+int i2c_read_regs(int fd, unsigned char address, const unsigned char* regs,
+                  unsigned char* buf, size_t count)
+{
+    if (count == 0 || count > I2C_MAX_COMBINED_REGS) {
+        return 0;
+    }
+
+    unsigned char reg_bytes[I2C_MAX_COMBINED_REGS];
+    struct i2c_msg msgs[I2C_MAX_COMBINED_REGS * 2];
+
+    for (size_t i = 0; i < count; i++) {
+        reg_bytes[i] = regs[i];
+
+        msgs[i * 2].addr = address;
+        msgs[i * 2].flags = 0;
+        msgs[i * 2].len = 1;
+        msgs[i * 2].buf = &reg_bytes[i];
+
+        msgs[i * 2 + 1].addr = address;
+        msgs[i * 2 + 1].flags = I2C_M_RD;
+        msgs[i * 2 + 1].len = 1;
+        msgs[i * 2 + 1].buf = &buf[i];
+    }
+
+    struct i2c_rdwr_ioctl_data xfer;
+    xfer.msgs = msgs;
+    xfer.nmsgs = static_cast<__u32>(count * 2);
+
+    if (ioctl(fd, I2C_RDWR, &xfer) != static_cast<int>(count * 2)) {
+        LOG_WARN("I2C combined read error (0x%02x)", address);
+        return 0;
+    }
+    return 1;
+}
+
 int i2c_write_reg(int fd, unsigned char reg, unsigned char value)
 {
     char buf[2];
@@ -22,6 +22,8 @@
 // I2C communication primitives for SC1000 hardware
 #pragma once
 
+#include <cstddef>
+
 namespace sc {
 namespace platform {
 
@@ -32,6 +34,24 @@ int i2c_open(const char* path, unsigned char address);
 // Read a single byte from an I2C register
 void i2c_read_reg(int fd, unsigned char reg, unsigned char* result);
 
+// Read len consecutive registers starting at reg in one I2C_RDWR
+// transaction (register write, repeated start, read). The device must
+// auto-increment its register pointer.
+// Returns 1 on success, 0 on failure
+int i2c_read_block(int fd, unsigned char address, unsigned char reg,
+                   unsigned char* buf, size_t len);
+
+// Read count arbitrary registers in one I2C_RDWR transaction, as one
+// write/read message pair per register joined by repeated starts.
+// For devices that don't auto-increment. count is limited to
+// I2C_MAX_COMBINED_REGS.
+// Returns 1 on success, 0 on failure
+int i2c_read_regs(int fd, unsigned char address, const unsigned char* regs,
+                  unsigned char* buf, size_t count);
+
+// Kernel limit is 42 messages per I2C_RDWR (I2C_RDWR_IOCTL_MAX_MSGS)
+constexpr size_t I2C_MAX_COMBINED_REGS = 21;
+
 // Write a single byte to an I2C register
 // Returns 1 on success, 0 on failure
 int i2c_write_reg(int fd, unsigned char reg, unsigned char value);
@@ -23,6 +23,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 
 #include "midi.h"
 #include "../util/log.h"
@@ -79,6 +80,23 @@ int midi_open(struct Midi* m, const char* name)
         return -1;
     }
 
+    m->kernel_tstamp = false;
+
+#if defined(SND_LIB_VERSION) && SND_LIB_VERSION >= 0x010206
+    /* Ask the kernel to stamp input as it arrives (Linux 5.14+); older
+     * kernels reject the params and we stamp at read time instead */
+    snd_rawmidi_params_t* params;
+    snd_rawmidi_params_alloca(&params);
+    if (snd_rawmidi_params_current(m->in, params) == 0 &&
+        snd_rawmidi_params_set_read_mode(m->in, params, SND_RAWMIDI_READ_TSTAMP) == 0 &&
+        snd_rawmidi_params_set_clock_type(m->in, params, SND_RAWMIDI_CLOCK_MONOTONIC) == 0 &&
+        snd_rawmidi_params(m->in, params) == 0) {
+        m->kernel_tstamp = true;
+    }
+#endif
+
+    LOG_DEBUG("MIDI %s: %s timestamps", name, m->kernel_tstamp ? "kernel" : "read time");
+
     return 0;
 }
 
@@ -136,6 +154,35 @@ ssize_t midi_read(struct Midi* m, void* buf, size_t len)
     return r;
 }
 
+ssize_t midi_read_stamped(struct Midi* m, void* buf, size_t len, double* timestamp)
+{
+    struct timespec ts;
+    ssize_t r;
+
+#if defined(SND_LIB_VERSION) && SND_LIB_VERSION >= 0x010206
+    if (m->kernel_tstamp) {
+        /* Returns only bytes sharing one stamp, i.e. one or more frames */
+        r = snd_rawmidi_tread(m->in, &ts, buf, len);
+        if (r < 0) {
+            if (r == -EAGAIN) {
+                return 0;
+            }
+            alsa_error("rawmidi_tread", static_cast<int>(r));
+            return -1;
+        }
+        *timestamp = static_cast<double>(ts.tv_sec) + (static_cast<double>(ts.tv_nsec) / 1000000000.0);
+        return r;
+    }
+#endif
+
+    r = midi_read(m, buf, len);
+    if (r > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        *timestamp = static_cast<double>(ts.tv_sec) + (static_cast<double>(ts.tv_nsec) / 1000000000.0);
+    }
+    return r;
+}
+
 ssize_t midi_write(struct Midi* m, const void* buf, size_t len)
 {
     ssize_t r;
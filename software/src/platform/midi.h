@@ -29,6 +29,7 @@
 
 struct Midi {
     snd_rawmidi_t *in, *out;
+    bool kernel_tstamp;  /* Input is read in framing mode with CLOCK_MONOTONIC stamps */
 };
 
 int midi_open(struct Midi *m, const char *name);
@@ -36,5 +37,12 @@ void midi_close(struct Midi *m);
 
 ssize_t midi_pollfds(struct Midi *m, struct pollfd *pe, size_t len);
 ssize_t midi_read(struct Midi *m, void *buf, size_t len);
+
+/*
+ * Read raw bytes of input together with the CLOCK_MONOTONIC time (seconds)
+ * they arrived: the kernel's stamp if the device supports framing mode,
+ * otherwise the time of the read
+ */
+ssize_t midi_read_stamped(struct Midi *m, void *buf, size_t len, double *timestamp);
 ssize_t midi_write(struct Midi *m, const void *buf, size_t len);
 int listdev(const char *devname, char names[64][64]);
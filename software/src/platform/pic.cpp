@@ -33,6 +33,24 @@ namespace platform {
 // PIC I2C address
 constexpr uint8_t PIC_ADDR = 0x69;
 
+// PIC register map (STATUSDATA[] in firmware/main.c)
+enum PicRegister : uint8_t {
+    PIC_REG_ADC0_LOW = 0x00,   // ADC low bytes 0x00-0x03
+    PIC_REG_ADC1_LOW,
+    PIC_REG_ADC2_LOW,
+    PIC_REG_ADC3_LOW,
+    PIC_REG_ADC_HIGH,          // 2 high bits per ADC, packed ADC0 in bits 1:0
+    PIC_REG_BUTTONS,           // Buttons in bits 3:0 (active-low), capsense bit 4
+    PIC_REG_COUNT
+};
+
+// The firmware does not auto-increment its register index on reads, so the
+// whole map is fetched as write/read pairs inside a single combined transaction
+constexpr uint8_t PIC_REGISTERS[PIC_REG_COUNT] = {
+    PIC_REG_ADC0_LOW, PIC_REG_ADC1_LOW, PIC_REG_ADC2_LOW, PIC_REG_ADC3_LOW,
+    PIC_REG_ADC_HIGH, PIC_REG_BUTTONS
+};
+
 bool pic_init(PicState* state)
 {
     state->i2c_fd = i2c_open("/dev/i2c-2", PIC_ADDR);
@@ -52,33 +70,26 @@ PicReadings pic_read_all(PicState* state)
 
     if (!state->present) return readings;
 
-    unsigned char result;
-
-    // Read ADC low bytes (registers 0x00-0x03)
-    i2c_read_reg(state->i2c_fd, 0x00, &result);
-    readings.adc[0] = result;
-    i2c_read_reg(state->i2c_fd, 0x01, &result);
-    readings.adc[1] = result;
-    i2c_read_reg(state->i2c_fd, 0x02, &result);
-    readings.adc[2] = result;
-    i2c_read_reg(state->i2c_fd, 0x03, &result);
-    readings.adc[3] = result;
-
-    // Read ADC high bits (register 0x04, packed)
-    i2c_read_reg(state->i2c_fd, 0x04, &result);
-    readings.adc[0] |= static_cast<uint16_t>((result & 0x03) << 8);
-    readings.adc[1] |= static_cast<uint16_t>((result & 0x0C) << 6);
-    readings.adc[2] |= static_cast<uint16_t>((result & 0x30) << 4);
-    readings.adc[3] |= static_cast<uint16_t>((result & 0xC0) << 2);
-
-    // Read buttons and capsense (register 0x05)
-    i2c_read_reg(state->i2c_fd, 0x05, &result);
-    readings.buttons[0] = !(result & 0x01);
-    readings.buttons[1] = !((result >> 1) & 0x01);
-    readings.buttons[2] = !((result >> 2) & 0x01);
-    readings.buttons[3] = !((result >> 3) & 0x01);
-    readings.cap_touched = (result >> 4) & 0x01;
+    unsigned char regs[PIC_REG_COUNT];
+    if (!i2c_read_regs(state->i2c_fd, PIC_ADDR, PIC_REGISTERS, regs, PIC_REG_COUNT)) {
+        return state->last;
+    }
+
+    // 10-bit ADCs: low byte plus two packed high bits
+    unsigned char high = regs[PIC_REG_ADC_HIGH];
+    for (int i = 0; i < 4; i++) {
+        readings.adc[i] = static_cast<uint16_t>(regs[PIC_REG_ADC0_LOW + i] |
+                                                (((high >> (i * 2)) & 0x03) << 8));
+    }
+
+    // Buttons (active-low) and capsense
+    unsigned char buttons = regs[PIC_REG_BUTTONS];
+    for (int i = 0; i < 4; i++) {
+        readings.buttons[i] = !((buttons >> i) & 0x01);
+    }
+    readings.cap_touched = (buttons >> 4) & 0x01;
 
+    state->last = readings;
     return readings;
 }
 
@@ -27,11 +27,6 @@
 namespace sc {
 namespace platform {
 
-struct PicState {
-    int i2c_fd = -1;
-    bool present = false;
-};
-
 // Raw readings from PIC
 struct PicReadings {
     uint16_t adc[4];       // 10-bit ADC values (faders, pots)
@@ -39,6 +34,12 @@ struct PicReadings {
     bool cap_touched;      // Capacitive touch sensor
 };
 
+struct PicState {
+    int i2c_fd = -1;
+    bool present = false;
+    PicReadings last = {};  // Returned again if a bus transaction fails
+};
+
 // Initialize PIC input processor on I2C bus
 bool pic_init(PicState* state);
 
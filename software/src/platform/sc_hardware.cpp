@@ -28,12 +28,13 @@
 #include "../control/actions.h"
 #include "../control/mapping_registry.h"
 #include "../engine/audio_engine.h"
+#include "../input/platter_estimator.h"
 #include "../player/track.h"
 #include "../util/log.h"
 
 #include <cmath>
 #include <ctime>
-#include <unordered_map>
+#include <vector>
 
 namespace sc {
 namespace platform {
@@ -58,13 +59,20 @@ public:
     bool init(Sc1000* engine) override;
     void poll(Sc1000* engine) override;
     void log_stats(Sc1000* engine) override;
+    void reload(Sc1000* engine) override;
 
 private:
     // Platform hardware (GPIO, encoder, PIC)
     HardwareState hw_;
 
-    // Button runtime state (separate from Mapping config)
-    std::unordered_map<size_t, ButtonState> button_states_;
+    // GPIO scanning: port 0 = MCP23017, ports 1-6 = A13 PB-PG
+    static constexpr int GPIO_PORTS = 7;
+    uint32_t gpio_mask_[GPIO_PORTS] = {};                    // Pins with IO mappings
+    GpioPortDebounce gpio_debounce_[GPIO_PORTS];
+    std::vector<size_t> pin_mappings_[GPIO_PORTS][32];       // Mapping indices per pin
+
+    // Button runtime state per pin (separate from Mapping config)
+    ButtonState button_states_[GPIO_PORTS][32];
 
     // Shift key state
     bool shift_latched_ = false;
@@ -88,13 +96,21 @@ private:
     // Rotary sensor filtering
     unsigned int num_blips_ = 0;
 
+    // Platter position/velocity tracking
+    sc::input::PlatterEstimator platter_estimator_;
+
     // Polling rate control
     unsigned char pic_skip_counter_ = 0;
 
     // Internal methods
     void init_gpio(Sc1000* engine);
-    void detect_sc500(ScSettings* settings);
+    void configure_gpio_pins(Sc1000* engine);
+    void detect_sc500(Sc1000* engine);
+    void index_gpio_mappings(Sc1000* engine);
     void process_gpio_buttons(Sc1000* engine);
+    void handle_gpio_press(Sc1000* engine, int port, int pin, bool shifted);
+    void handle_gpio_release(Sc1000* engine, int port, int pin);
+    void handle_gpio_held(Sc1000* engine, int port, int pin);
     void process_pic_inputs(Sc1000* engine);
     void process_encoder(Sc1000* engine);
 };
@@ -148,12 +164,24 @@ bool SC1000Hardware::init(Sc1000* engine)
         settings->crossfader_adc_max);
 
     // Detect SC500 variant
-    detect_sc500(settings);
+    detect_sc500(engine);
 
     // Return true if we have at least some hardware
     return hw_.pic.present || hw_.encoder.present || hw_.gpio.mmap_present;
 }
 
+void SC1000Hardware::reload(Sc1000* engine)
+{
+    ScSettings* settings = engine->settings.get();
+
+    // Pin directions and pullups follow the new mappings
+    configure_gpio_pins(engine);
+
+    engine->crossfader.set_calibration(
+        settings->crossfader_adc_min,
+        settings->crossfader_adc_max);
+}
+
 void SC1000Hardware::poll(Sc1000* engine)
 {
     if (hw_.pic.present)
@@ -188,6 +216,7 @@ void SC1000Hardware::poll(Sc1000* engine)
         {
             engine->scratch_deck.player.input.target_position += (input_time - last_input_time);
         }
+        engine->scratch_deck.player.input.target_velocity = 1.0;
         last_input_time = input_time;
 
         // Still process GPIO buttons even without PIC
@@ -201,13 +230,19 @@ void SC1000Hardware::log_stats(Sc1000* engine)
     struct DspStats dsp;
     audio_engine_get_stats(&dsp);
 
+    // Master recorder ring: how close the disk is to falling behind
+    sc::audio::MasterRecorder::Stats rec = engine->master_recorder.stats();
+
     LOG_STATS(
         "ADCS: %04u, %04u, %04u, %04u | XF: %.2f | "
-        "DSP: %.1f%% (peak: %.1f%%, %.0fus/%.0fus, xruns: %lu) | "
+        "DSP: %.1f%% (peak: %.1f%%, %.0fus/%.0fus, xruns: %lu, voices: %d/%d) | "
+        "Rec: %s %.0f%% (peak: %.0f%%, dropped: %lu) | "
         "Enc: %04d Cap: %d Buttons: %01u,%01u,%01u,%01u\n",
         pic_readings_.adc[0], pic_readings_.adc[1], pic_readings_.adc[2], pic_readings_.adc[3],
         engine->crossfader.position(),
         dsp.load_percent, dsp.load_peak, dsp.process_time_us, dsp.budget_time_us, dsp.xruns,
+        dsp.voices, dsp.voice_limit,
+        rec.recording ? "on" : "off", rec.fill * 100.0, rec.fill_peak * 100.0, rec.dropped_blocks,
         engine->scratch_deck.encoder_state.angle,
         engine->scratch_deck.player.input.touched,
         pic_readings_.buttons[0], pic_readings_.buttons[1],
@@ -216,11 +251,19 @@ void SC1000Hardware::log_stats(Sc1000* engine)
 
 void SC1000Hardware::init_gpio(Sc1000* engine)
 {
-    struct Mapping* map;
-
     // Initialize MCP23017 GPIO expander
     gpio_init_mcp23017(&hw_.gpio);
 
+    // Initialize A13 memory-mapped GPIO
+    gpio_init_a13_mmap(&hw_.gpio);
+
+    configure_gpio_pins(engine);
+}
+
+void SC1000Hardware::configure_gpio_pins(Sc1000* engine)
+{
+    struct Mapping* map;
+
     // Configure MCP23017 pins based on mappings
     if (hw_.gpio.mcp23017_present)
     {
@@ -245,9 +288,6 @@ void SC1000Hardware::init_gpio(Sc1000* engine)
         }
     }
 
-    // Initialize A13 memory-mapped GPIO
-    gpio_init_a13_mmap(&hw_.gpio);
-
     // Configure A13 GPIO pins based on mappings
     if (hw_.gpio.mmap_present)
     {
@@ -262,7 +302,7 @@ void SC1000Hardware::init_gpio(Sc1000* engine)
                     // dirty hack, don't map J7 SCL/SDA pins if MCP is present
                     if (hw_.gpio.mcp23017_present && j == 1 && (i == 15 || i == 16))
                     {
-                        map->action_type = NOTHING;
+                        engine->mappings.set_action(map, NOTHING);
                     }
                     else
                     {
@@ -273,9 +313,40 @@ void SC1000Hardware::init_gpio(Sc1000* engine)
             }
         }
     }
+
+    index_gpio_mappings(engine);
 }
 
-void SC1000Hardware::detect_sc500(ScSettings* settings)
+void SC1000Hardware::index_gpio_mappings(Sc1000* engine)
+{
+    for (int port = 0; port < GPIO_PORTS; port++)
+    {
+        gpio_mask_[port] = 0;
+        gpio_debounce_[port] = GpioPortDebounce();
+        for (int pin = 0; pin < 32; pin++)
+        {
+            pin_mappings_[port][pin].clear();
+            button_states_[port][pin] = ButtonState();
+        }
+    }
+
+    auto& mappings = engine->mappings.all();
+    for (size_t idx = 0; idx < mappings.size(); ++idx)
+    {
+        const Mapping& m = mappings[idx];
+        if (m.type != IO || m.gpio_port >= GPIO_PORTS || m.pin > 31)
+            continue;
+
+        bool available = (m.gpio_port == 0) ? hw_.gpio.mcp23017_present : hw_.gpio.mmap_present;
+        if (!available)
+            continue;
+
+        gpio_mask_[m.gpio_port] |= 1u << m.pin;
+        pin_mappings_[m.gpio_port][m.pin].push_back(idx);
+    }
+}
+
+void SC1000Hardware::detect_sc500(Sc1000* engine)
 {
     // Detect SC500 by seeing if G11 is pulled low
     if (hw_.gpio.mmap_present)
@@ -283,8 +354,12 @@ void SC1000Hardware::detect_sc500(ScSettings* settings)
         if (gpio_a13_read_pin(&hw_.gpio, 6, 11))
         {
             LOG_INFO("SC500 detected");
-            settings->disable_volume_adc = true;
-            settings->disable_pic_buttons = true;
+
+            // Published snapshots are never written, publish a changed copy
+            auto next = std::make_unique<ScSettings>(*engine->settings.get());
+            next->disable_volume_adc = true;
+            next->disable_pic_buttons = true;
+            engine->settings.publish(std::move(next));
         }
     }
 }
@@ -292,140 +367,140 @@ void SC1000Hardware::detect_sc500(ScSettings* settings)
 void SC1000Hardware::process_gpio_buttons(Sc1000* engine)
 {
     ScSettings* settings = engine->settings.get();
-
-    // Read all MCP23017 pins at once (already inverted by platform layer)
-    uint16_t mcp_pins = 0;
-    if (hw_.gpio.mcp23017_present)
-    {
-        mcp_pins = gpio_mcp23017_read_all(&hw_.gpio);
-    }
+    unsigned int lockout = static_cast<unsigned int>(settings->debounce_time > 0 ? settings->debounce_time : 0);
 
     // Capture shifted state ONCE before processing any mappings
     bool shifted_at_start = engine->input_state.is_shifted();
 
-    // Use index-based iteration to associate ButtonState with each Mapping
+    for (int port = 0; port < GPIO_PORTS; port++)
+    {
+        uint32_t mask = gpio_mask_[port];
+        if (!mask)
+            continue;
+
+        // One register read per port (already inverted to active-high)
+        uint32_t sample = (port == 0)
+            ? gpio_mcp23017_read_all(&hw_.gpio)
+            : gpio_a13_read_port(&hw_.gpio, static_cast<uint8_t>(port));
+
+        GpioPortDebounce* db = &gpio_debounce_[port];
+        uint32_t changed = gpio_debounce_update(db, sample, mask, lockout);
+
+        // Edges: only pins that changed on this scan
+        for (uint32_t bits = changed; bits; bits &= bits - 1)
+        {
+            int pin = __builtin_ctz(bits);
+            if (db->state & (1u << pin))
+                handle_gpio_press(engine, port, pin, shifted_at_start);
+            else
+                handle_gpio_release(engine, port, pin);
+        }
+
+        // Hold timing: only pins that are down and weren't just pressed
+        for (uint32_t bits = db->state & ~changed; bits; bits &= bits - 1)
+        {
+            handle_gpio_held(engine, port, __builtin_ctz(bits));
+        }
+    }
+}
+
+void SC1000Hardware::handle_gpio_press(Sc1000* engine, int port, int pin, bool shifted)
+{
+    ScSettings* settings = engine->settings.get();
+    ButtonState& bs = button_states_[port][pin];
     auto& mappings = engine->mappings.all();
-    for (size_t idx = 0; idx < mappings.size(); ++idx)
+
+    LOG_DEBUG("Button port=%d pin=%d pressed, shifted=%d", port, pin, shifted);
+
+    bs.shifted_at_press = shifted;
+    bs.hold_ticks = 1;
+
+    for (size_t idx : pin_mappings_[port][pin])
     {
         const Mapping& m = mappings[idx];
-        ButtonState& bs = button_states_[idx];
 
-        // Only digital pins
-        if (m.type == IO && (!(m.gpio_port == 0 && !hw_.gpio.mcp23017_present)))
+        if (first_time_ && m.deck_no == 1 && (m.action_type == VOLUP || m.action_type == VOLDOWN))
         {
-            bool pin_value = false;
-            if (m.gpio_port == 0 && hw_.gpio.mcp23017_present)
-            {
-                pin_value = (mcp_pins >> m.pin) & 0x01;
-            }
-            else if (hw_.gpio.mmap_present)
-            {
-                pin_value = gpio_a13_read_pin(&hw_.gpio, m.gpio_port, m.pin);
-            }
+            engine->beat_deck.player.set_track(
+                track_acquire_by_import(engine->beat_deck.importer.c_str(), "/var/os-version.mp3"));
+            engine->beat_deck.load_cues();
+            engine->scratch_deck.player.input.volume_knob = 0.0;
+            continue;
+        }
 
-            // Button not pressed, check for button
-            if (bs.debounce == 0)
-            {
-                if (pin_value)
-                {
-                    if (m.action_type == RECORD || m.action_type == LOOPERASE)
-                    {
-                        LOG_DEBUG("Button port=%d pin=%d pressed, shifted=%d, edge_type=%d, action=%d",
-                                  m.gpio_port, m.pin, shifted_at_start, m.edge_type, m.action_type);
-                    }
-                    LOG_DEBUG("Button %d pressed", m.pin);
+        if ((!shifted && m.edge_type == BUTTON_PRESSED) ||
+            (shifted && m.edge_type == BUTTON_PRESSED_SHIFTED))
+        {
+            LOG_DEBUG("FIRING action=%d for port=%d pin=%d deck=%d",
+                      m.action_type, m.gpio_port, m.pin, m.deck_no);
+            dispatch_event(&m, nullptr, engine, settings, engine->input_state);
+        }
+    }
+}
 
-                    if (first_time_ && m.deck_no == 1 && (m.action_type == VOLUP || m.action_type == VOLDOWN))
-                    {
-                        engine->beat_deck.player.set_track(
-                            track_acquire_by_import(engine->beat_deck.importer.c_str(), "/var/os-version.mp3"));
-                        engine->beat_deck.cues.load_from_file(engine->beat_deck.player.track->path);
-                        engine->scratch_deck.player.input.volume_knob = 0.0;
-                    }
-                    else
-                    {
-                        bs.shifted_at_press = shifted_at_start;
-
-                        if (m.action_type == NEXTFILE || m.action_type == PREVFILE ||
-                            m.action_type == RANDOMFILE || m.action_type == JOGPIT)
-                        {
-                            LOG_DEBUG("Checking Mapping port=%d pin=%d action=%d edge=%d shifted=%d",
-                                      m.gpio_port, m.pin, m.action_type, m.edge_type, shifted_at_start);
-                        }
-
-                        if ((!shifted_at_start && m.edge_type == BUTTON_PRESSED) ||
-                            (shifted_at_start && m.edge_type == BUTTON_PRESSED_SHIFTED))
-                        {
-                            if (m.action_type == NEXTFILE || m.action_type == PREVFILE ||
-                                m.action_type == RANDOMFILE || m.action_type == JOGPIT)
-                            {
-                                LOG_DEBUG("FIRING action=%d for port=%d pin=%d deck=%d",
-                                          m.action_type, m.gpio_port, m.pin, m.deck_no);
-                            }
-                            dispatch_event(&m, nullptr, engine, settings, engine->input_state);
-                        }
-
-                        bs.debounce++;
-                    }
-                }
-            }
-            else if (bs.debounce > 0 && bs.debounce < settings->debounce_time)
-            {
-                bs.debounce++;
-            }
-            else if (bs.debounce >= settings->debounce_time && bs.debounce < settings->hold_time)
-            {
-                if (!pin_value)
-                {
-                    LOG_DEBUG("Button %d released", m.pin);
-                    if ((!bs.shifted_at_press && m.edge_type == BUTTON_RELEASED) ||
-                        (bs.shifted_at_press && m.edge_type == BUTTON_RELEASED_SHIFTED))
-                        dispatch_event(&m, nullptr, engine, settings, engine->input_state);
-                    bs.debounce = -settings->debounce_time;
-                }
-                else
-                {
-                    bs.debounce++;
-                }
-            }
-            else if (bs.debounce == settings->hold_time)
-            {
-                LOG_DEBUG("Button port=%d pin=%d HELD, shifted_at_press=%d, edge_type=%d, action=%d",
-                          m.gpio_port, m.pin, bs.shifted_at_press, m.edge_type, m.action_type);
-                if ((!bs.shifted_at_press && m.edge_type == BUTTON_HOLDING) ||
-                    (bs.shifted_at_press && m.edge_type == BUTTON_HOLDING_SHIFTED))
-                {
-                    LOG_DEBUG("Triggering held action for port=%d pin=%d action=%d",
-                              m.gpio_port, m.pin, m.action_type);
-                    dispatch_event(&m, nullptr, engine, settings, engine->input_state);
-                }
-                bs.debounce++;
-            }
-            else if (bs.debounce > settings->hold_time)
-            {
-                if (pin_value)
-                {
-                    if (m.action_type == VOLUHOLD || m.action_type == VOLDHOLD)
-                    {
-                        if ((!bs.shifted_at_press && m.edge_type == BUTTON_HOLDING) ||
-                            (bs.shifted_at_press && m.edge_type == BUTTON_HOLDING_SHIFTED))
-                            dispatch_event(&m, nullptr, engine, settings, engine->input_state);
-                    }
-                }
-                else
-                {
-                    LOG_DEBUG("Button %d released", m.pin);
-                    if (m.edge_type == BUTTON_RELEASED && !bs.shifted_at_press)
-                        dispatch_event(&m, nullptr, engine, settings, engine->input_state);
-                    bs.debounce = -settings->debounce_time;
-                }
-            }
-            else if (bs.debounce < 0)
-            {
-                bs.debounce++;
-            }
+void SC1000Hardware::handle_gpio_release(Sc1000* engine, int port, int pin)
+{
+    ScSettings* settings = engine->settings.get();
+    ButtonState& bs = button_states_[port][pin];
+    auto& mappings = engine->mappings.all();
+    bool after_hold = bs.hold_ticks > settings->hold_time;
+
+    LOG_DEBUG("Button port=%d pin=%d released", port, pin);
+
+    for (size_t idx : pin_mappings_[port][pin])
+    {
+        const Mapping& m = mappings[idx];
+
+        // After a hold only the unshifted release fires
+        if (after_hold)
+        {
+            if (m.edge_type == BUTTON_RELEASED && !bs.shifted_at_press)
+                dispatch_event(&m, nullptr, engine, settings, engine->input_state);
+        }
+        else if ((!bs.shifted_at_press && m.edge_type == BUTTON_RELEASED) ||
+                 (bs.shifted_at_press && m.edge_type == BUTTON_RELEASED_SHIFTED))
+        {
+            dispatch_event(&m, nullptr, engine, settings, engine->input_state);
         }
     }
+
+    bs.hold_ticks = 0;
+}
+
+void SC1000Hardware::handle_gpio_held(Sc1000* engine, int port, int pin)
+{
+    ScSettings* settings = engine->settings.get();
+    ButtonState& bs = button_states_[port][pin];
+
+    if (bs.hold_ticks < settings->hold_time)
+    {
+        bs.hold_ticks++;
+        return;
+    }
+
+    auto& mappings = engine->mappings.all();
+    bool first_hold = (bs.hold_ticks == settings->hold_time);
+
+    if (first_hold)
+    {
+        LOG_DEBUG("Button port=%d pin=%d HELD, shifted_at_press=%d", port, pin, bs.shifted_at_press);
+    }
+
+    for (size_t idx : pin_mappings_[port][pin])
+    {
+        const Mapping& m = mappings[idx];
+
+        if (!((!bs.shifted_at_press && m.edge_type == BUTTON_HOLDING) ||
+              (bs.shifted_at_press && m.edge_type == BUTTON_HOLDING_SHIFTED)))
+            continue;
+
+        // Hold fires once, volume hold actions repeat every scan
+        if (first_hold || m.action_type == VOLUHOLD || m.action_type == VOLDHOLD)
+            dispatch_event(&m, nullptr, engine, settings, engine->input_state);
+    }
+
+    if (first_hold)
+        bs.hold_ticks++;
 }
 
 void SC1000Hardware::process_pic_inputs(Sc1000* engine)
@@ -500,7 +575,7 @@ void SC1000Hardware::process_pic_inputs(Sc1000* engine)
                 {
                     engine->beat_deck.player.set_track(
                         track_acquire_by_import(engine->beat_deck.importer.c_str(), "/var/os-version.mp3"));
-                    engine->beat_deck.cues.load_from_file(engine->beat_deck.player.track->path);
+                    engine->beat_deck.load_cues();
                     button_machine_state_ = ButtonMachineState::Waiting;
                 }
             }
@@ -692,8 +767,15 @@ void SC1000Hardware::process_encoder(Sc1000* engine)
                 engine->scratch_deck.player.input.pitch_note = pitch_offset;
             }
         }
+        else if (engine->scratch_deck.jog_state.touched)
+        {
+            // An external jog wheel holds the deck and drives target_position.
+            // The encoder offset is rebased on the next platter touch.
+        }
         else
         {
+            bool touched_now = false;
+
             if (settings->platter_enabled)
             {
                 double scratch_pos = engine->audio ? engine->audio->get_position(1) : 0.0;
@@ -711,6 +793,7 @@ void SC1000Hardware::process_encoder(Sc1000* engine)
                         LOG_DEBUG("touch!");
                         engine->scratch_deck.player.input.target_position = scratch_pos;
                         engine->scratch_deck.player.input.touched = true;
+                        touched_now = true;
                     }
                 }
                 else
@@ -732,9 +815,33 @@ void SC1000Hardware::process_encoder(Sc1000* engine)
                 engine->scratch_deck.encoder_state.offset -= 4096;
             }
 
-            engine->scratch_deck.player.input.target_position =
+            double measured_position =
                 static_cast<double>(engine->scratch_deck.encoder_state.angle +
                     engine->scratch_deck.encoder_state.offset) / settings->platter_speed;
+
+            if (settings->platter_estimator)
+            {
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                double now = static_cast<double>(ts.tv_sec) + (static_cast<double>(ts.tv_nsec) / 1000000000.0);
+
+                // Hand grabs the record: restart from rest at the new anchor
+                if (touched_now)
+                    platter_estimator_.reset(measured_position, now);
+                else
+                    platter_estimator_.update(measured_position, now);
+
+                // Aim at where the platter will be when the next audio block
+                // has been rendered, not where it was a sample period ago
+                double block_time = static_cast<double>(settings->period_size) / settings->sample_rate;
+
+                engine->scratch_deck.player.input.target_position = platter_estimator_.predict(now + block_time);
+                engine->scratch_deck.player.input.target_velocity = platter_estimator_.velocity();
+            }
+            else
+            {
+                engine->scratch_deck.player.input.target_position = measured_position;
+            }
         }
         old_pitch_mode_ = engine->input_state.pitch_mode();
     }
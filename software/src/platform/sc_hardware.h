@@ -48,6 +48,9 @@ public:
     // Stats/debugging (called once per second)
     virtual void log_stats(Sc1000* engine) = 0;
 
+    // Settings and mappings were reloaded: rebuild what was derived from them
+    virtual void reload(Sc1000* engine) { (void)engine; }
+
     // Capability queries (override to advertise features)
     virtual bool has_motor_control() const { return false; }
     virtual bool has_force_feedback() const { return false; }
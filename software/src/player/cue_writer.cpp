@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+//
+// Cue Writer - saves .cue files on a background thread
+//
+
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "cue_writer.h"
+#include "cues.h"
+#include "../engine/wav_file.h"
+#include "../util/log.h"
+
+CueWriter::~CueWriter()
+{
+	stop();
+}
+
+void CueWriter::start()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (running_) return;
+
+	running_ = true;
+	for (Read& read : reads_) {
+		read.state = ReadState::None;
+	}
+	requested_ = 0;
+	written_ = 0;
+	thread_ = std::thread(&CueWriter::run, this);
+}
+
+void CueWriter::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!running_) return;
+		running_ = false;
+	}
+	wake_.notify_all();
+	thread_.join();
+	LOG_DEBUG("CueWriter: %zu saves, %zu files written", requested(), written());
+}
+
+bool CueWriter::request(const std::string& path, std::string contents)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!running_) return false;
+		queue_[path] = std::move(contents);
+	}
+	requested_++;
+	wake_.notify_one();
+	return true;
+}
+
+bool CueWriter::pending(const std::string& path, std::string* contents)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (const auto* saves : {&queue_, &writing_}) {
+		auto it = saves->find(path);
+		if (it != saves->end()) {
+			*contents = it->second;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CueWriter::merge(const std::string& path, std::string contents)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!running_) return false;
+		merges_.emplace_back(path, std::move(contents));
+	}
+	wake_.notify_one();
+	return true;
+}
+
+bool CueWriter::read(int deck, const std::string& path)
+{
+	if (deck < 0 || deck >= DECKS) return false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!running_) return false;
+
+		Read& read = reads_[deck];
+		read.path = path;
+		read.contents.clear();
+		read.state = ReadState::Queued;
+		read.serial++;
+	}
+	wake_.notify_one();
+	return true;
+}
+
+bool CueWriter::take(int deck, const std::string& path, std::string* contents)
+{
+	if (deck < 0 || deck >= DECKS) return false;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	Read& read = reads_[deck];
+	if (read.state != ReadState::Done || read.path != path) return false;
+	read.state = ReadState::None;
+
+	for (const auto* saves : {&queue_, &writing_}) {
+		auto it = saves->find(path);
+		if (it != saves->end()) {
+			*contents = it->second;
+			return true;
+		}
+	}
+	*contents = std::move(read.contents);
+	return true;
+}
+
+bool CueWriter::reading() const
+{
+	for (const Read& read : reads_) {
+		if (read.state == ReadState::Queued) return true;
+	}
+	return false;
+}
+
+// Each merge becomes a save of the whole file, queued like any other
+void CueWriter::merge_files()
+{
+	std::vector<std::pair<std::string, std::string>> merges;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		merges.swap(merges_);
+	}
+
+	for (const auto& [path, contents] : merges) {
+		std::string base;
+		bool queued;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto it = queue_.find(path);
+			queued = it != queue_.end();
+			if (queued) base = it->second;
+		}
+		if (!queued) {
+			std::ifstream file(path);
+			if (file) {
+				std::ostringstream in;
+				in << file.rdbuf();
+				base = in.str();
+			}
+		}
+
+		Cues cues, over;
+		cues.load(base);
+		over.load(contents);
+		for (const auto& [label, position] : over.all()) {
+			cues.set(label, position);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		queue_[path] = cues.contents();
+		requested_++;
+	}
+}
+
+// Outside the lock; a deck asking again meanwhile has its read redone
+void CueWriter::read_files()
+{
+	for (int deck = 0; deck < DECKS; deck++) {
+		std::string path;
+		unsigned serial;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (reads_[deck].state != ReadState::Queued) continue;
+			path = reads_[deck].path;
+			serial = reads_[deck].serial;
+		}
+
+		std::string contents;
+		std::ifstream file(path);
+		if (file) {
+			std::ostringstream in;
+			in << file.rdbuf();
+			contents = in.str();
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		Read& read = reads_[deck];
+		if (read.serial == serial) {
+			read.contents = std::move(contents);
+			read.state = ReadState::Done;
+		}
+	}
+}
+
+void CueWriter::run()
+{
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait(lock, [this] {
+				return !running_ || !queue_.empty() || !merges_.empty() || reading();
+			});
+			if (!reading() && merges_.empty()) {
+				if (queue_.empty()) return;  // Stopping, all written
+
+				// Saves of the same files coming in meanwhile replace these,
+				// unless stopping; a track loading cuts the wait short
+				wake_.wait_for(lock, std::chrono::milliseconds(GATHER_MS),
+				               [this] { return !running_ || !merges_.empty() || reading(); });
+				if (!reading() && merges_.empty()) writing_.swap(queue_);
+			}
+		}
+
+		merge_files();
+		read_files();
+		if (writing_.empty()) continue;
+
+		// Only this thread changes writing_, pending() reads it under the lock
+		write(writing_);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		writing_.clear();
+	}
+}
+
+// Every file to its temporary first, then each renamed over the old one,
+// then one sync per folder for the new names
+void CueWriter::write(const std::map<std::string, std::string>& batch)
+{
+	struct Pending {
+		int fd;
+		std::string tmp;
+		const std::string* path;
+	};
+	std::vector<Pending> files;
+	for (const auto& [path, contents] : batch) {
+		std::string tmp;
+		int fd = sc::audio::replace_open(path, &tmp);
+		if (fd == -1) continue;
+		if (!sc::audio::write_all(fd, contents.data(), contents.size())) {
+			LOG_ERROR("CueWriter: cannot write %s", path.c_str());
+			sc::audio::replace_abort(fd, tmp);
+			continue;
+		}
+		files.push_back(Pending{fd, std::move(tmp), &path});
+	}
+
+	std::vector<std::string> folders;
+	size_t committed = 0;
+	for (const auto& [fd, tmp, path] : files) {
+		if (!sc::audio::replace_commit(fd, tmp, *path, false)) continue;
+		committed++;
+
+		std::string folder = path->substr(0, path->find_last_of('/'));
+		if (std::find(folders.begin(), folders.end(), folder) == folders.end()) {
+			folders.push_back(std::move(folder));
+		}
+	}
+
+	for (const std::string& folder : folders) {
+		int dir = open(folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (dir != -1) {
+			fsync(dir);
+			close(dir);
+		}
+	}
+	written_ += committed;
+	LOG_DEBUG("CueWriter: %zu of %zu files written", committed, batch.size());
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+//
+// Cue Writer - saves .cue files on a background thread
+//
+// The input thread changes tracks and sets cues while it samples the
+// platter, so it only hands the contents over. Saves are kept by path,
+// newest only: a file saved again before it is written is written once.
+// The writer gathers saves for GATHER_MS, then writes the batch, each file
+// replacing the old one in one rename, and syncs each folder once.
+//
+// It reads them too: a deck that loads a track asks for its .cue file and
+// takes the contents on a later pass of the input loop. Cues set before
+// that are merged over the file here. Merges and reads go before the
+// gathered writes.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class CueWriter {
+public:
+	static constexpr int GATHER_MS = 250;
+	static constexpr int DECKS = 2;
+
+	CueWriter() = default;
+	~CueWriter();
+
+	CueWriter(const CueWriter&) = delete;
+	CueWriter& operator=(const CueWriter&) = delete;
+
+	void start();
+
+	// Write what is still queued, then join
+	void stop();
+
+	/*
+	 * Queue contents to replace the file at path, in place of a save of
+	 * path still queued
+	 * Return: false if the writer is not running
+	 */
+	bool request(const std::string& path, std::string contents);
+
+	/*
+	 * The newest contents queued or being written for path, so a load
+	 * sees them before they are on disk
+	 * Return: false if there are none
+	 */
+	bool pending(const std::string& path, std::string* contents);
+
+	/*
+	 * Queue contents to go over the cue points in the file at path (or in
+	 * a save of it still queued), keeping the ones they leave unset
+	 * Return: false if the writer is not running
+	 */
+	bool merge(const std::string& path, std::string contents);
+
+	/*
+	 * Read the file at path for deck, in place of a read still pending
+	 * for it
+	 * Return: false if the writer is not running
+	 */
+	bool read(int deck, const std::string& path);
+
+	/*
+	 * The contents read for deck, if they are of path: empty when there is
+	 * no file, and the newest save if one came after the read was asked for
+	 * Return: false until the read is done
+	 */
+	bool take(int deck, const std::string& path, std::string* contents);
+
+	// Saves requested and files written since start
+	size_t requested() const { return requested_.load(std::memory_order_relaxed); }
+	size_t written() const { return written_.load(std::memory_order_relaxed); }
+
+private:
+	void run();
+	void write(const std::map<std::string, std::string>& batch);
+	bool reading() const;
+	void merge_files();
+	void read_files();
+
+	enum class ReadState { None, Queued, Done };
+	struct Read {
+		std::string path;
+		std::string contents;
+		ReadState state = ReadState::None;
+		unsigned serial = 0;  // A read asked for again while on its way is redone
+	};
+
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	bool running_ = false;
+	std::map<std::string, std::string> queue_;    // By path
+	std::map<std::string, std::string> writing_;  // The batch on its way to disk
+	std::vector<std::pair<std::string, std::string>> merges_;  // Path, contents
+	Read reads_[DECKS];
+
+	std::atomic<size_t> requested_{0};
+	std::atomic<size_t> written_{0};
+};
@@ -19,17 +19,14 @@
 
 #include <fstream>
 #include <sstream>
-#include <cstdlib>
 
 #include "cues.h"
+#include "../engine/wav_file.h"
 #include "../util/log.h"
 
-namespace {
-
-// Replace file extension with ".cue"
-// Returns empty string if no extension found
-std::string get_cue_path(const char* pathname)
+std::string Cues::path_for(const char* pathname)
 {
+    // Replace file extension with ".cue"
     if (pathname == nullptr) {
         return {};
     }
@@ -44,8 +41,6 @@ std::string get_cue_path(const char* pathname)
     return path;
 }
 
-} // anonymous namespace
-
 void Cues::set(unsigned int label, double position)
 {
     positions_[label] = position;
@@ -77,7 +72,7 @@ bool Cues::is_set(unsigned int label) const
 
 void Cues::load_from_file(const char* pathname)
 {
-    std::string cuepath = get_cue_path(pathname);
+    std::string cuepath = path_for(pathname);
     if (cuepath.empty()) {
         return;
     }
@@ -87,11 +82,19 @@ void Cues::load_from_file(const char* pathname)
         return;
     }
 
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    load(contents.str());
+}
+
+void Cues::load(const std::string& contents)
+{
     positions_.clear();
 
+    std::istringstream lines(contents);
     std::string line;
     unsigned int index = 0;
-    while (std::getline(file, line)) {
+    while (std::getline(lines, line)) {
         if (line.empty()) {
             index++;
             continue;
@@ -109,29 +112,17 @@ void Cues::load_from_file(const char* pathname)
     }
 }
 
-void Cues::save_to_file(const char* pathname) const
+std::string Cues::contents() const
 {
     // Don't save if cue 0 is at position 0.0 (likely uninitialized)
     auto cue0 = positions_.find(0);
     if (cue0 != positions_.end() && cue0->second == 0.0) {
-        return;
+        return {};
     }
 
     // Don't save if no cues are set
     if (positions_.empty()) {
-        return;
-    }
-
-    std::string cuepath = get_cue_path(pathname);
-    if (cuepath.empty()) {
-        return;
-    }
-
-    LOG_DEBUG("Saving cue: %s", cuepath.c_str());
-
-    std::ofstream file(cuepath);
-    if (!file) {
-        return;
+        return {};
     }
 
     // Find the highest label to know how many lines to write
@@ -143,6 +134,7 @@ void Cues::save_to_file(const char* pathname) const
     }
 
     // Write positions, using CUE_FILE_UNSET for gaps
+    std::ostringstream file;
     for (unsigned int i = 0; i <= max_label; ++i) {
         auto it = positions_.find(i);
         if (it != positions_.end()) {
@@ -151,10 +143,30 @@ void Cues::save_to_file(const char* pathname) const
             file << CUE_FILE_UNSET << '\n';
         }
     }
+    return file.str();
+}
 
-    file.close();
+// Without the cue writer (see cue_writer.h): written in place of the old
+// file in one rename, so a crash leaves one or the other
+void Cues::save_to_file(const char* pathname) const
+{
+    std::string contents = this->contents();
+    std::string cuepath = path_for(pathname);
+    if (contents.empty() || cuepath.empty()) {
+        return;
+    }
+
+    LOG_DEBUG("Saving cue: %s", cuepath.c_str());
 
-    // Sync the file to disk
-    std::string sync_cmd = "/bin/sync \"" + cuepath + "\"";
-    std::system(sync_cmd.c_str());
+    std::string tmp;
+    int fd = sc::audio::replace_open(cuepath, &tmp);
+    if (fd == -1) {
+        return;
+    }
+    if (!sc::audio::write_all(fd, contents.data(), contents.size())) {
+        LOG_ERROR("Cannot write %s", cuepath.c_str());
+        sc::audio::replace_abort(fd, tmp);
+        return;
+    }
+    sc::audio::replace_commit(fd, tmp, cuepath);
 }
@@ -61,10 +61,22 @@ public:
     // Check if a cue point is set
     bool is_set(unsigned int label) const;
 
+    // All cue points set, by label
+    const std::map<unsigned int, double>& all() const { return positions_; }
+
     // File I/O
     void load_from_file(const char* pathname);
     void save_to_file(const char* pathname) const;
 
+    // The .cue file of a track, empty if its path has no extension
+    static std::string path_for(const char* pathname);
+
+    // What save_to_file() writes, empty if there is nothing worth saving
+    std::string contents() const;
+
+    // Take the cue points from the contents of a .cue file
+    void load(const std::string& contents);
+
 private:
     std::map<unsigned int, double> positions_;
 };
@@ -19,8 +19,11 @@
  *
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <unistd.h>
 
 #include "../core/global.h"
 #include "../core/sc1000.h"
@@ -30,8 +33,10 @@
 #include "../util/status.h"
 #include "../thread/rig.h"
 
+#include "cue_writer.h"
 #include "cues.h"
 #include "deck.h"
+#include "folder_indexer.h"
 #include "playlist.h"
 #include "track.h"
 
@@ -51,7 +56,7 @@ bool LoopState::has_loop() const
 static void load_track_internal(struct Deck* d, Track* track, struct ScSettings* settings)
 {
 	struct Player* pl = &d->player;
-	d->cues.save_to_file(pl->track->path);
+	d->save_cues();
 	pl->set_track(track);
 
 	// Use new input fields for position and state
@@ -61,7 +66,7 @@ static void load_track_internal(struct Deck* d, Track* track, struct ScSettings*
 	pl->input.source = sc::PlaybackSource::File;  // Switch back to file track (loop is preserved for recall)
 	pl->input.stopped = false;   // Reset stopped state so scratching works immediately
 
-	d->cues.load_from_file(pl->track->path);
+	d->load_cues();
 
 	// Reset pitch to neutral
 	pl->input.pitch_fader = 1.0;
@@ -176,18 +181,7 @@ void Deck::cue(unsigned int label, struct Sc1000* engine)
 			double slot_position_samples = (track_length_samples / divisions) * slot;
 			double slot_position_seconds = slot_position_samples / player.track->rate;
 
-			// Seek to calculated position
-			player.input.seek_to = slot_position_seconds;
-			player.input.position_offset = 0.0;  // Reset offset since we're seeking absolutely
-
-			// For scratch deck: sync encoder and target_position for artifact-free jumps
-			if (!player.input.just_play) {
-				player.input.target_position = slot_position_seconds;
-				// Sync encoder offset: new_pos = (angle + offset) / platter_speed
-				// So offset = new_pos * platter_speed - angle
-				int platter_speed = engine->settings->platter_speed;
-				encoder_state.offset = static_cast<int32_t>(slot_position_seconds * platter_speed) - encoder_state.angle;
-			}
+			seek(slot_position_seconds, engine);
 
 			LOG_DEBUG("Auto-cue: slot=%d/%d pos=%.2fs", slot, divisions, slot_position_seconds);
 			return;
@@ -200,9 +194,7 @@ void Deck::cue(unsigned int label, struct Sc1000* engine)
 		// Set cue at current elapsed time
 		double elapsed = engine && engine->audio ? engine->audio->get_deck_state(deck_no).elapsed() : 0.0;
 		cues.set(label, elapsed);
-		if (player.track != nullptr) {
-			cues.save_to_file(player.track->path);
-		}
+		save_cues();
 	}
 	else {
 		// Seek to cue point: set offset so elapsed = p
@@ -250,7 +242,106 @@ void Deck::punch_out(struct Sc1000* engine)
 	punch = std::nullopt;
 }
 
-void Deck::load_folder(const char* folder_name)
+void Deck::seek(double position, struct Sc1000* engine)
+{
+	player.input.seek_to = position;
+	player.input.position_offset = 0.0;  // Reset offset since we're seeking absolutely
+
+	// For scratch deck: sync encoder and target_position for artifact-free jumps
+	if (!player.input.just_play) {
+		player.input.target_position = position;
+		// Sync encoder offset: new_pos = (angle + offset) / platter_speed
+		// So offset = new_pos * platter_speed - angle
+		int platter_speed = engine->settings->platter_speed;
+		encoder_state.offset = static_cast<int32_t>(position * platter_speed) - encoder_state.angle;
+	}
+}
+
+// Open a file at boot, before anything plays
+static void open_file(Deck* deck, const char* path)
+{
+	deck->player.set_track(track_acquire_by_import(deck->importer.c_str(), path));
+	deck->load_cues();
+}
+
+// The input thread samples the platter, so the cue file is left to the cue
+// writer; only without one running is it written here
+void Deck::save_cues()
+{
+	if (player.track == nullptr) return;
+
+	std::string path = Cues::path_for(player.track->path);
+	std::string contents = cues.contents();
+	if (path.empty() || contents.empty()) return;
+
+	// Left before its file was read: only the cues set since go over it
+	if (cues_loading)
+	{
+		if (cue_writer == nullptr || !cue_writer->merge(path, std::move(contents)))
+		{
+			Cues file;
+			file.load_from_file(player.track->path);
+			for (const auto& [label, position] : cues.all())
+			{
+				file.set(label, position);
+			}
+			file.save_to_file(player.track->path);
+		}
+		return;
+	}
+
+	if (cue_writer == nullptr || !cue_writer->request(path, std::move(contents)))
+	{
+		cues.save_to_file(player.track->path);
+	}
+}
+
+// Cues saved but not yet written are taken from the writer, not the file.
+// The file itself is read by the writer too and arrives in collect_cues().
+void Deck::load_cues()
+{
+	cues_loading = false;
+	if (player.track == nullptr) return;
+
+	std::string path = Cues::path_for(player.track->path);
+	std::string contents;
+	if (cue_writer != nullptr && cue_writer->pending(path, &contents))
+	{
+		cues.load(contents);
+		return;
+	}
+	if (cue_writer != nullptr && !path.empty() && cue_writer->read(deck_no, path))
+	{
+		cues.reset();
+		cues_loading = true;
+		return;
+	}
+	cues.load_from_file(player.track->path);
+}
+
+// Called from the input loop. Cues set before the file arrived stay, the
+// file fills in the rest, and the result is saved.
+void Deck::collect_cues()
+{
+	if (!cues_loading || player.track == nullptr || cue_writer == nullptr) return;
+
+	std::string contents;
+	if (!cue_writer->take(deck_no, Cues::path_for(player.track->path), &contents)) return;
+	cues_loading = false;
+
+	std::map<unsigned int, double> set = cues.all();
+	cues.load(contents);
+	for (const auto& [label, position] : set)
+	{
+		cues.set(label, position);
+	}
+	if (!set.empty())
+	{
+		save_cues();
+	}
+}
+
+void Deck::load_folder(const char* folder_name, const std::string& resume)
 {
 	playlist = std::make_unique<Playlist>();
 
@@ -261,13 +352,27 @@ void Deck::load_folder(const char* folder_name)
 		nav_state.folder_idx = 0;
 		nav_state.file_idx = 0;
 
+		// Open the file to resume with, if it is still there, else the first
+		bool found = resume.empty();
+		for (size_t f = 0; !found && f < playlist->folder_count(); f++)
+		{
+			const ScFolder* folder = playlist->get_folder(f);
+			for (size_t i = 0; !found && i < folder->files.size(); i++)
+			{
+				if (folder->files[i].full_path == resume)
+				{
+					nav_state.folder_idx = f;
+					nav_state.file_idx = static_cast<int>(i);
+					found = true;
+				}
+			}
+		}
+
 		LOG_DEBUG("deck_load_folder");
 
-		ScFile* file = playlist->get_file(0, 0);
-		player.set_track(track_acquire_by_import(importer.c_str(), file->full_path.c_str()));
-		LOG_DEBUG("deck_load_folder set track ok");
-		cues.load_from_file(player.track->path);
-		LOG_DEBUG("deck_load_folder set cues.load_from_file ok");
+		ScFile* file = playlist->get_file(nav_state.folder_idx, static_cast<size_t>(nav_state.file_idx));
+		open_file(this, file->full_path);
+		LOG_DEBUG("deck_load_folder set track and cues ok");
 	}
 	else
 	{
@@ -275,6 +380,197 @@ void Deck::load_folder(const char* folder_name)
 	}
 }
 
+void Deck::index_folder(FolderIndexer& indexer, const char* folder_name, const std::string& resume)
+{
+	playlist = std::make_unique<Playlist>();
+	playlist->reset(folder_name);
+	nav_state.reset();
+	nav_state.files_present = false;
+	pending_resume.clear();
+
+	// The file to resume with opens now if it is still there, rather than
+	// once its folder is listed
+	if (!resume.empty() && access(resume.c_str(), R_OK) == 0)
+	{
+		open_file(this, resume.c_str());
+		pending_resume = resume;
+	}
+
+	indexing = true;
+	indexer.load(deck_no, folder_name);
+}
+
+// Returns true once, when the listing has finished with nothing to open
+bool Deck::take_folders(FolderIndexer& indexer, struct ScSettings* settings)
+{
+	if (!indexing) return false;
+
+	const size_t from = playlist->folder_count();
+	indexing = indexer.take(deck_no, *playlist);
+
+	if (!pending_resume.empty())
+	{
+		// Navigation catches up with the file opened ahead once its folder is in
+		for (size_t f = from; f < playlist->folder_count() && !pending_resume.empty(); f++)
+		{
+			const ScFolder* folder = playlist->get_folder(f);
+			for (size_t i = 0; i < folder->files.size(); i++)
+			{
+				if (folder->files[i].full_path == pending_resume)
+				{
+					nav_state.folder_idx = f;
+					if (nav_state.file_idx >= 0) nav_state.file_idx = static_cast<int>(i);
+					pending_resume.clear();
+					break;
+				}
+			}
+		}
+
+		// Not in the tree after all: navigation starts at the top
+		if (!indexing) pending_resume.clear();
+		if (pending_resume.empty()) nav_state.files_present = playlist->total_files() > 0;
+		return false;
+	}
+
+	// The first file, as soon as the first folder with files is in
+	if (!nav_state.files_present && playlist->total_files() > 0)
+	{
+		nav_state.reset();
+		nav_state.files_present = true;
+		ScFile* file = playlist->get_file(0, 0);
+		load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path), settings);
+		LOG_INFO("Deck %d: opened the first file while listing %s", deck_no, playlist->base_path().c_str());
+	}
+
+	return !indexing && !nav_state.files_present;
+}
+
+void Deck::add_file(const std::string& folder, const std::string& path)
+{
+	if (!playlist)
+	{
+		playlist = std::make_unique<Playlist>();
+	}
+
+	playlist->add_file(folder, path);
+	LOG_INFO("Deck %d: added %s", deck_no, path.c_str());
+
+	if (!nav_state.files_present)
+	{
+		nav_state.files_present = true;
+		nav_state.folder_idx = 0;
+	}
+}
+
+// Put in a playlist built again after the folders changed, keeping
+// navigation on the same folder and file where they are still there
+void Deck::swap_playlist(std::unique_ptr<Playlist> next)
+{
+	std::string folder_path;
+	std::string file_path;
+	if (playlist && nav_state.files_present)
+	{
+		if (ScFolder* folder = playlist->get_folder(nav_state.folder_idx))
+			folder_path = folder->full_path;
+		if (nav_state.file_idx >= 0)
+		{
+			if (ScFile* file = playlist->get_file(nav_state.folder_idx, static_cast<size_t>(nav_state.file_idx)))
+				file_path = file->full_path;
+		}
+	}
+
+	const bool had_files = nav_state.files_present;
+	playlist = std::move(next);
+	nav_state.files_present = playlist->total_files() > 0;
+	if (!nav_state.files_present)
+	{
+		nav_state.reset();
+		LOG_INFO("Deck %d: no files left in %s", deck_no, playlist->base_path().c_str());
+		return;
+	}
+	if (!had_files)
+	{
+		nav_state.reset();
+		LOG_INFO("Deck %d: %zu files found in %s", deck_no, playlist->total_files(), playlist->base_path().c_str());
+		return;
+	}
+
+	// A folder that is gone leaves navigation at the one now in its place;
+	// search results are looked up again in the new files
+	size_t f = 0;
+	if (nav_state.folder_idx == Playlist::RESULTS)
+	{
+		playlist->search(search_query);
+		f = Playlist::RESULTS;
+	}
+	else
+	{
+		while (f < playlist->folder_count() && folder_path != playlist->get_folder(f)->full_path) f++;
+	}
+
+	if (f == playlist->folder_count())
+	{
+		nav_state.folder_idx = std::min(nav_state.folder_idx, playlist->folder_count() - 1);
+		if (nav_state.file_idx >= 0) nav_state.file_idx = 0;
+	}
+	else
+	{
+		nav_state.folder_idx = f;
+		if (nav_state.file_idx >= 0)
+		{
+			// Same for a file: the one now in its place, or the last
+			const ScFolder* folder = playlist->get_folder(f);
+			size_t i = 0;
+			while (i < folder->files.size() && file_path != folder->files[i].full_path) i++;
+			if (i == folder->files.size())
+				i = std::min(static_cast<size_t>(nav_state.file_idx), std::max<size_t>(folder->files.size(), 1) - 1);
+			nav_state.file_idx = static_cast<int>(i);
+		}
+	}
+
+	LOG_INFO("Deck %d: %s changed, %zu files", deck_no, playlist->base_path().c_str(), playlist->total_files());
+}
+
+// Show the files matching query as the folder Playlist::RESULTS, opening
+// the first unless it is on already. An empty query goes back to the
+// folders, on the file last opened from the results.
+void Deck::search(const std::string& query, struct ScSettings* settings)
+{
+	if (!playlist || !nav_state.files_present) return;
+
+	const bool searching = nav_state.folder_idx == Playlist::RESULTS;
+	search_query = query;
+
+	if (query.empty())
+	{
+		if (!searching) return;
+
+		size_t folder_idx = std::min(search_from, playlist->folder_count() - 1);
+		size_t file_idx = 0;
+		ScFile* file = (nav_state.file_idx >= 0)
+			? playlist->get_file(Playlist::RESULTS, static_cast<size_t>(nav_state.file_idx))
+			: nullptr;
+		if (file != nullptr) playlist->locate(file->global_index, &folder_idx, &file_idx);
+
+		nav_state.folder_idx = folder_idx;
+		if (nav_state.file_idx >= 0) nav_state.file_idx = static_cast<int>(file_idx);
+		LOG_INFO("Deck %d: search cleared, back in folder %zu", deck_no, folder_idx);
+		return;
+	}
+
+	if (!searching) search_from = nav_state.folder_idx;
+	const size_t found = playlist->search(query);
+	nav_state.folder_idx = Playlist::RESULTS;
+	nav_state.file_idx = 0;
+	LOG_INFO("Deck %d: search \"%s\", %zu files", deck_no, query.c_str(), found);
+
+	ScFile* first = playlist->get_file(Playlist::RESULTS, 0);
+	if (first == nullptr) return;
+	if (player.input.source == sc::PlaybackSource::File && player.track && player.track->path &&
+	    strcmp(player.track->path, first->full_path) == 0) return;
+	load_track_internal(this, track_acquire_by_import(importer.c_str(), first->full_path), settings);
+}
+
 void Deck::next_file(struct Sc1000* engine, struct ScSettings* settings)
 {
 	LOG_DEBUG("deck %d next_file called, nav_state.files_present=%d, nav_state.file_idx=%d, source=%d",
@@ -290,7 +586,7 @@ void Deck::next_file(struct Sc1000* engine, struct ScSettings* settings)
 		ScFile* file = playlist->get_file(nav_state.folder_idx, 0);
 		if (file != nullptr)
 		{
-			load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path.c_str()), settings);
+			load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path), settings);
 			LOG_DEBUG("deck %d next_file: loaded file 0", deck_no);
 		}
 		else
@@ -304,7 +600,7 @@ void Deck::next_file(struct Sc1000* engine, struct ScSettings* settings)
 		ScFile* file = playlist->get_file(nav_state.folder_idx, static_cast<size_t>(nav_state.file_idx));
 		if (file != nullptr)
 		{
-			load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path.c_str()), settings);
+			load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path), settings);
 			LOG_DEBUG("deck %d next_file: loaded file %d", deck_no, nav_state.file_idx);
 		}
 	}
@@ -343,7 +639,7 @@ void Deck::prev_file(struct Sc1000* engine, struct ScSettings* settings)
 		ScFile* file = playlist->get_file(nav_state.folder_idx, static_cast<size_t>(nav_state.file_idx));
 		if (file != nullptr)
 		{
-			load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path.c_str()), settings);
+			load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path), settings);
 			LOG_DEBUG("deck %d prev_file: loaded file %d", deck_no, nav_state.file_idx);
 		}
 	}
@@ -370,7 +666,7 @@ void Deck::next_folder(struct Sc1000* engine, struct ScSettings* settings)
 		nav_state.folder_idx++;
 		nav_state.file_idx = 0;
 		ScFile* file = playlist->get_file(nav_state.folder_idx, 0);
-		load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path.c_str()), settings);
+		load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path), settings);
 		LOG_DEBUG("Deck %d: next_folder to %zu, file 0", deck_no, nav_state.folder_idx);
 	}
 }
@@ -396,7 +692,7 @@ void Deck::prev_folder(struct Sc1000* engine, struct ScSettings* settings)
 		nav_state.folder_idx--;
 		nav_state.file_idx = 0;
 		ScFile* file = playlist->get_file(nav_state.folder_idx, 0);
-		load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path.c_str()), settings);
+		load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path), settings);
 		LOG_DEBUG("Deck %d: prev_folder to %zu, file 0", deck_no, nav_state.folder_idx);
 	}
 }
@@ -415,7 +711,7 @@ void Deck::random_file(struct Sc1000* engine, struct ScSettings* settings)
 			player.input.source = sc::PlaybackSource::File;
 			// We don't update nav_state.file_idx here since random doesn't fit folder navigation
 			// Just load the track
-			load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path.c_str()), settings);
+			load_track_internal(this, track_acquire_by_import(importer.c_str(), file->full_path), settings);
 		}
 	}
 }
@@ -482,6 +778,39 @@ void Deck::goto_loop(struct Sc1000* engine, struct ScSettings* settings)
 // Auto-cue mode implementation
 //
 
+/*
+ * The part of the loaded track a one-shot of label plays, in seconds:
+ * from its cue (or auto-cue slot) to the next one, or to the end. An
+ * unset cue plays from the start.
+ */
+
+void Deck::cue_slice(unsigned int label, double* start, double* end) const
+{
+	double length = player.track ? player.track->length / static_cast<double>(player.track->rate) : 0.0;
+	*start = 0.0;
+	*end = length;
+
+	int divisions = auto_cue_divisions();
+	if (divisions > 0) {
+		int slot = static_cast<int>(label) % divisions;
+		*start = length * slot / divisions;
+		*end = length * (slot + 1) / divisions;
+		return;
+	}
+
+	auto p = cues.get(label);
+	if (!p.has_value()) {
+		return;
+	}
+
+	*start = p.value();
+	for (const auto& cue : cues.all()) {
+		if (cue.second > *start && cue.second < *end) {
+			*end = cue.second;
+		}
+	}
+}
+
 int Deck::auto_cue_divisions() const
 {
 	switch (auto_cue_mode) {
@@ -507,3 +836,78 @@ void Deck::cycle_auto_cue_mode()
 }
 
 
+
+//
+// External jog wheel
+//
+// Relative ticks accumulate into a wheel position that is sampled once per
+// input tick through the same estimator as the built-in platter, so MIDI
+// bursts and gaps don't reach the engine as velocity spikes.
+//
+
+static void jog_grab(struct Deck* d, double time, struct Sc1000* engine)
+{
+	double position = engine->audio ? engine->audio->get_position(d->deck_no) : 0.0;
+
+	d->jog_state.touched = true;
+	d->jog_state.position = position;
+	d->jog_state.last_move = time;
+	d->jog_state.estimator.reset(position, time);
+
+	d->player.input.target_position = position;
+	d->player.input.target_velocity = 0.0;
+	d->player.input.touched = true;
+}
+
+static void jog_release(struct Deck* d)
+{
+	d->jog_state.touched = false;
+	d->player.input.touched = false;
+}
+
+void Deck::jog_touch(bool touch, double time, struct Sc1000* engine)
+{
+	jog_state.touch_sensor = true;
+
+	if (touch)
+		jog_grab(this, time, engine);
+	else if (jog_state.touched)
+		jog_release(this);
+}
+
+void Deck::jog_move(int ticks, double time, struct Sc1000* engine, struct ScSettings* settings)
+{
+	// Grab on the first tick, and again if a track load let go of the deck
+	if (!jog_state.touched || !player.input.touched)
+		jog_grab(this, time, engine);
+
+	jog_state.position += static_cast<double>(ticks) / settings->midi_jog_speed;
+	jog_state.last_move = time;
+}
+
+void Deck::jog_update(double time, struct ScSettings* settings)
+{
+	if (!jog_state.touched)
+		return;
+
+	if (!jog_state.touch_sensor && time - jog_state.last_move > JogState::RELEASE_TIME)
+	{
+		jog_release(this);
+		return;
+	}
+
+	if (settings->platter_estimator)
+	{
+		jog_state.estimator.update(jog_state.position, time);
+
+		// Same lookahead as the built-in platter: the end of the next block
+		double block_time = static_cast<double>(settings->period_size) / settings->sample_rate;
+
+		player.input.target_position = jog_state.estimator.predict(time + block_time);
+		player.input.target_velocity = jog_state.estimator.velocity();
+	}
+	else
+	{
+		player.input.target_position = jog_state.position;
+	}
+}
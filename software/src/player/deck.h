@@ -48,6 +48,8 @@ typedef struct Playlist Playlist;
 struct ScSettings;
 struct Track;
 struct Sc1000;
+class FolderIndexer;
+class CueWriter;
 
 struct Deck
 {
@@ -65,6 +67,7 @@ struct Deck
    // === Grouped state ===
    NavigationState nav_state;
    EncoderState encoder_state;
+   JogState jog_state;
    LoopState loop_state;
 
    // Auto-cue mode (divides track into equal parts)
@@ -74,6 +77,21 @@ struct Deck
    std::unique_ptr<Playlist> playlist;
    int deck_no;  // 0 = beat, 1 = scratch
 
+   // Folder being listed in the background, and the file opened ahead of
+   // its folder being listed (see index_folder)
+   bool indexing = false;
+   std::string pending_resume;
+
+   // Saves the cues in the background, set by the engine; without it they
+   // are written in place (see save_cues)
+   CueWriter* cue_writer = nullptr;
+   bool cues_loading = false;  // The writer is reading the .cue file, see collect_cues
+
+   // Search typed so far (empty = browsing folders), and the folder to go
+   // back to once it is cleared (see search)
+   std::string search_query;
+   size_t search_from = 0;
+
 #ifdef __cplusplus
    // C++ member functions
    ~Deck();  // Destructor defined in .cpp where Playlist is complete
@@ -86,7 +104,18 @@ struct Deck
    void cue(unsigned int label, struct Sc1000* engine);
    void punch_in(unsigned int label, struct Sc1000* engine);
    void punch_out(struct Sc1000* engine);
-   void load_folder(const char* folder_name);
+   void seek(double position, struct Sc1000* engine);
+   void cue_slice(unsigned int label, double* start, double* end) const;
+   void save_cues();
+   void load_cues();
+   void collect_cues();
+   void load_folder(const char* folder_name, const std::string& resume = std::string());
+   void index_folder(FolderIndexer& indexer, const char* folder_name,
+                     const std::string& resume = std::string());
+   bool take_folders(FolderIndexer& indexer, struct ScSettings* settings);
+   void add_file(const std::string& folder, const std::string& path);
+   void swap_playlist(std::unique_ptr<Playlist> next);
+   void search(const std::string& query, struct ScSettings* settings);
    void next_file(struct Sc1000* engine, struct ScSettings* settings);
    void prev_file(struct Sc1000* engine, struct ScSettings* settings);
    void next_folder(struct Sc1000* engine, struct ScSettings* settings);
@@ -96,6 +125,11 @@ struct Deck
    bool recall_loop(struct ScSettings* settings);
    bool has_loop() const;
 
+   // External jog wheel: touch, relative ticks, per-input-tick update
+   void jog_touch(bool touch, double time, struct Sc1000* engine);
+   void jog_move(int ticks, double time, struct Sc1000* engine, struct ScSettings* settings);
+   void jog_update(double time, struct ScSettings* settings);
+
    // Loop navigation helpers
    bool is_at_loop() const { return nav_state.is_at_loop(); }
    void goto_loop(struct Sc1000* engine, struct ScSettings* settings);
@@ -21,12 +21,18 @@
 
 #include <cstdint>
 
+namespace sc { namespace audio { class LoopSnapshot; } }
+
 //
 // DeckInput - All input state for a single deck
 //
 // This struct contains ALL fields written by the input thread.
 // The audio engine reads these values at buffer boundaries.
 //
+// Event times are CLOCK_MONOTONIC seconds. The audio engine plays a timed
+// request a fixed latency after it happened, at the matching frame of the
+// block, so its timing doesn't depend on the input loop rate.
+//
 // OWNERSHIP: Input thread writes, audio engine reads.
 // Thread safety: Single writer (input thread), single reader (audio engine).
 // No locks needed - worst case is audio engine sees slightly stale value.
@@ -55,17 +61,20 @@ struct DeckInput {
     int32_t encoder_angle = 0;      // Raw encoder angle in ticks
     int32_t encoder_offset = 0;     // Offset for position calculation
     double target_position = 0.0;   // Encoder-derived target position (for scratching)
+    double target_velocity = 0.0;   // Estimated platter velocity (seconds/second), 0 if not estimated
     bool touched = false;           // Capacitive touch state
 
     // === Transport ===
     bool stopped = false;           // Motor stopped (braking)
     double seek_to = -1.0;          // Seek request (-1 = no seek pending)
+    double seek_time = 0.0;         // When the event behind seek_to happened (0 = apply at once)
     double position_offset = 0.0;   // Track start offset (for cue points)
 
     // === Pitch (all multiplicative) ===
     double pitch_fader = 1.0;       // Hardware/MIDI pitch fader
     double pitch_note = 1.0;        // MIDI note (equal temperament)
     double pitch_bend = 1.0;        // MIDI pitch bend
+    double pitch_time = 0.0;        // When the last MIDI pitch change happened (0 = apply at once)
 
     // === Volume ===
     double volume_knob = 0.0;       // Volume pot or MIDI CC (0-1), default muted for safety
@@ -82,6 +91,15 @@ struct DeckInput {
     // === Recording Requests ===
     bool record_start = false;      // Request to start recording
     bool record_stop = false;       // Request to stop recording
+    double grab_seconds = -1.0;     // Request to grab the last seconds of input as loop (0 = all, -1 = none)
+    bool loop_erase = false;        // Request to erase the loop, its storage back to the pool
+    sc::audio::LoopSnapshot* save_snapshot = nullptr;  // Request to attach a save of the loop (owned by the loop writer)
+    sc::audio::LoopSnapshot* session_snapshot = nullptr;  // Same, for the session save (no beep)
+    bool calibrate_latency = false; // Request to measure the round-trip latency (output patched to input)
+
+    // === Loop Roll ===
+    double roll_beats = 0.0;        // Repeat a slice this many beats long while held (0 = off)
+    double stutter_beats = 0.0;     // Retrigger every this many beats while held (0 = off)
 
     // === Feedback Requests ===
     BeepType beep_request = BeepType::None;  // Request a beep sound
@@ -104,9 +122,11 @@ struct DeckInput {
     // Clear one-shot requests (called by audio engine after processing)
     void clear_requests() {
         seek_to = -1.0;
+        seek_time = 0.0;
         load_track = nullptr;
         record_start = false;
         record_stop = false;
+        grab_seconds = -1.0;
         beep_request = BeepType::None;
     }
 };
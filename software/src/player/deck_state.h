@@ -21,6 +21,8 @@
 
 #include <cstdint>
 
+#include "../input/platter_estimator.h"
+
 struct Track;
 
 //
@@ -61,6 +63,18 @@ struct EncoderState {
     }
 };
 
+// External jog wheel state (MIDI JOG/JOGTOUCH actions)
+struct JogState {
+    // Without a touch sensor the wheel lets go after this long without a tick
+    static constexpr double RELEASE_TIME = 0.05;
+
+    bool touched = false;       // Wheel holds the deck
+    bool touch_sensor = false;  // A JOGTOUCH mapping has fired, release on its note-off only
+    double position = 0.0;      // Accumulated wheel position (seconds of audio)
+    double last_move = 0.0;     // Timestamp of the last tick (CLOCK_MONOTONIC seconds)
+    sc::input::PlatterEstimator estimator;
+};
+
 // Loop recording state (deck-level, persists across track changes)
 struct LoopState {
     Track* track = nullptr;  // Recorded loop track (ref-counted)
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+//
+// Folder Indexer - lists the decks' folders on a pool of background threads
+//
+
+#include <algorithm>
+#include <climits>
+
+#include "folder_indexer.h"
+#include "../util/log.h"
+
+FolderIndexer::~FolderIndexer()
+{
+	stop();
+}
+
+void FolderIndexer::start(unsigned int threads)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (running_ || threads == 0) return;
+
+	running_ = true;
+	pooled_ = true;
+	for (unsigned int t = 0; t < threads; t++) {
+		threads_.emplace_back(&FolderIndexer::run, this);
+	}
+}
+
+void FolderIndexer::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!running_) return;
+		running_ = false;
+	}
+	wake_.notify_all();
+	for (auto& thread : threads_) {
+		thread.join();
+	}
+	threads_.clear();
+
+	// Listings still queued are dropped, index writes still go out
+	std::deque<Task> left;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		left.swap(queue_);
+		pooled_ = false;
+	}
+	for (auto& task : left) {
+		if (!task.load) execute(task);
+	}
+}
+
+void FolderIndexer::load(int slot, const std::string& base_path)
+{
+	if (loads_[slot]) {
+		loads_[slot]->dropped.store(true, std::memory_order_relaxed);
+	}
+
+	LOG_DEBUG("indexing %s", base_path.c_str());
+	loads_[slot] = std::make_shared<Load>(base_path);
+	queue(Task{loads_[slot], -1, {}, {}});
+}
+
+bool FolderIndexer::take(int slot, Playlist& playlist)
+{
+	std::shared_ptr<Load>& load = loads_[slot];
+	if (!load) return false;
+
+	int state = load->state.load(std::memory_order_acquire);
+	if (state == LISTING) return true;
+
+	if (state == LISTED) {
+		const size_t count = load->scan.folder_count();
+		while (load->taken < count && load->listed[load->taken].load(std::memory_order_acquire)) {
+			playlist.take(load->scan, load->taken++);
+		}
+		if (load->taken < count) return true;
+
+		std::string contents = load->scan.index_contents();
+		if (!contents.empty()) {
+			queue(Task{nullptr, -1, load->scan.index_path(), std::move(contents)});
+		}
+		LOG_INFO("Added folder %s: %zu files found, %zu folders rescanned", playlist.base_path().c_str(),
+		         playlist.total_files(), playlist.rescanned());
+	}
+
+	load.reset();
+	return false;
+}
+
+void FolderIndexer::queue(Task task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (running_ || (pooled_ && !task.load)) {
+			queue_.push_back(std::move(task));
+			wake_.notify_one();
+			return;
+		}
+		if (pooled_) return;  // Stopping: the listing is dropped
+	}
+
+	// No workers: list in place
+	execute(task);
+}
+
+void FolderIndexer::run()
+{
+	// First folders first across decks, so each deck's first file is found
+	// before either deck's later folders; index writes go last
+	auto rank = [](const Task& task) { return task.load ? task.folder : LONG_MAX; };
+
+	for (;;) {
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+			if (!running_) return;
+
+			auto next = std::min_element(queue_.begin(), queue_.end(),
+			                             [&](const Task& a, const Task& b) { return rank(a) < rank(b); });
+			task = std::move(*next);
+			queue_.erase(next);
+		}
+		execute(task);
+	}
+}
+
+void FolderIndexer::execute(Task& task)
+{
+	if (!task.load) {
+		PlaylistIndex::write(task.path, task.contents);
+		return;
+	}
+	if (task.load->dropped.load(std::memory_order_relaxed)) return;
+
+	if (task.folder < 0) {
+		list_base(task.load);
+	} else {
+		task.load->scan.list_folder(static_cast<size_t>(task.folder));
+		task.load->listed[task.folder].store(true, std::memory_order_release);
+	}
+}
+
+void FolderIndexer::list_base(const std::shared_ptr<Load>& load)
+{
+	if (!load->scan.list()) {
+		load->state.store(FAILED, std::memory_order_release);
+		return;
+	}
+
+	const size_t count = load->scan.folder_count();
+	load->listed.reset(new std::atomic<bool>[count]());
+	load->state.store(LISTED, std::memory_order_release);
+
+	for (size_t i = 0; i < count; i++) {
+		queue(Task{load, static_cast<long>(i), {}, {}});
+	}
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+//
+// Folder Indexer - lists the decks' folders on a pool of background threads
+//
+// Listing a deck's folder tree is one task. It queues a task per
+// subfolder, in order, so the first folders are listed first. The input
+// thread takes listed folders into the deck's playlist in order, so a
+// deck can open its first file as soon as its folder is in, and
+// navigation grows folder by folder while the rest is listed. Once every
+// folder is in, a worker writes the playlist index back.
+//
+// Playlists are only touched on the input thread. Workers only fill in
+// their own folder of a scan and publish it with a flag.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "playlist.h"
+
+class FolderIndexer {
+public:
+	static constexpr int SLOTS = 2;  // One per deck
+
+	FolderIndexer() = default;
+	~FolderIndexer();
+
+	FolderIndexer(const FolderIndexer&) = delete;
+	FolderIndexer& operator=(const FolderIndexer&) = delete;
+
+	void start(unsigned int threads);
+	// Join the workers, finishing index writes still queued
+	void stop();
+
+	/*
+	 * Start listing base_path for slot, dropping a listing of slot still
+	 * under way. Without worker threads it is listed right here.
+	 */
+	void load(int slot, const std::string& base_path);
+
+	/*
+	 * Take the folders of slot listed since the last call into playlist, in
+	 * order (input thread)
+	 * Return: true while the listing is still under way
+	 */
+	bool take(int slot, Playlist& playlist);
+
+private:
+	// One listing of a folder tree
+	struct Load {
+		explicit Load(const std::string& base_path) : scan(base_path) {}
+
+		PlaylistScan scan;
+		std::atomic<int> state{LISTING};
+		std::unique_ptr<std::atomic<bool>[]> listed;  // By folder, set once ready to take
+		std::atomic<bool> dropped{false};
+		size_t taken = 0;                             // Input thread only
+	};
+	enum { LISTING, LISTED, FAILED };
+
+	// The base folder of load (folder < 0), one of its folders, or writing
+	// index contents to path
+	struct Task {
+		std::shared_ptr<Load> load;
+		long folder = -1;
+		std::string path;
+		std::string contents;
+	};
+
+	void run();
+	void execute(Task& task);
+	void list_base(const std::shared_ptr<Load>& load);
+	void queue(Task task);
+
+	std::vector<std::thread> threads_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::deque<Task> queue_;
+	bool running_ = false;
+	bool pooled_ = false;   // Workers started and not yet joined
+
+	std::shared_ptr<Load> loads_[SLOTS];  // Input thread only
+};
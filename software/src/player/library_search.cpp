@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+//
+// Library Search - finds files by the words in their names
+//
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+#include "library_search.h"
+#include "playlist.h"
+#include "../util/log.h"
+
+namespace {
+
+// Add the words of [p, end) to words, in lower case. Bytes past ASCII
+// (UTF-8) count as letters, so names in other scripts are found as typed.
+void split(const char* p, const char* end, std::vector<std::string>* words)
+{
+	std::string word;
+	for (; p < end; p++) {
+		unsigned char c = static_cast<unsigned char>(*p);
+		if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80) {
+			word += static_cast<char>(c);
+		} else if (c >= 'A' && c <= 'Z') {
+			word += static_cast<char>(c - 'A' + 'a');
+		} else if (!word.empty()) {
+			words->push_back(word);
+			word.clear();
+		}
+	}
+	if (!word.empty()) {
+		words->push_back(word);
+	}
+}
+
+const char* base_name(const char* path)
+{
+	const char* slash = strrchr(path, '/');
+	return slash ? slash + 1 : path;
+}
+
+} // namespace
+
+void LibrarySearch::build(const std::vector<ScFolder>& folders, size_t file_count)
+{
+	clear();
+
+	// Words numbered as first seen, then laid out sorted
+	std::unordered_map<std::string, uint32_t> ids;
+	std::vector<const std::string*> unique;
+	std::vector<std::string> folder_words;
+	std::vector<std::string> words;
+
+	for (const ScFolder& folder : folders) {
+		const char* folder_name = base_name(folder.full_path);
+		folder_words.clear();
+		split(folder_name, folder_name + strlen(folder_name), &folder_words);
+
+		for (const ScFile& file : folder.files) {
+			const char* name = base_name(file.full_path);
+			const char* dot = strrchr(name, '.');
+			words = folder_words;
+			split(name, (dot && dot != name) ? dot : name + strlen(name), &words);
+
+			std::sort(words.begin(), words.end());
+			words.erase(std::unique(words.begin(), words.end()), words.end());
+			for (const std::string& word : words) {
+				auto id = ids.emplace(word, static_cast<uint32_t>(unique.size()));
+				if (id.second) {
+					unique.push_back(&id.first->first);
+				}
+				entries_.push_back(Entry{id.first->second, file.global_index});
+			}
+		}
+	}
+
+	std::vector<uint32_t> order(unique.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return *unique[a] < *unique[b]; });
+
+	std::vector<uint32_t> offsets(unique.size());
+	for (uint32_t id : order) {
+		offsets[id] = static_cast<uint32_t>(pool_.size());
+		pool_ += *unique[id];
+		pool_ += '\0';
+	}
+	for (Entry& entry : entries_) {
+		entry.word = offsets[entry.word];
+	}
+	std::sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+		return a.word != b.word ? a.word < b.word : a.file < b.file;
+	});
+
+	marks_.assign(file_count, 0);
+	built_ = true;
+	LOG_DEBUG("search index: %zu words, %zu entries", unique.size(), entries_.size());
+}
+
+void LibrarySearch::clear()
+{
+	built_ = false;
+	pool_.clear();
+	entries_.clear();
+	marks_.clear();
+	mark_ = 0;
+	words_.clear();
+	ranges_.clear();
+}
+
+// The entries within whose word starts with prefix
+LibrarySearch::Range LibrarySearch::narrow(Range within, const std::string& prefix) const
+{
+	const char* pool = pool_.data();
+	auto compare = [&](const Entry& entry) { return strncmp(pool + entry.word, prefix.c_str(), prefix.size()); };
+
+	auto begin = entries_.begin();
+	auto lo = std::partition_point(begin + within.begin, begin + within.end,
+	                               [&](const Entry& entry) { return compare(entry) < 0; });
+	auto hi = std::partition_point(lo, begin + within.end, [&](const Entry& entry) { return compare(entry) == 0; });
+	return Range{static_cast<size_t>(lo - begin), static_cast<size_t>(hi - begin)};
+}
+
+void LibrarySearch::find(const std::string& query, std::vector<unsigned int>* out)
+{
+	out->clear();
+
+	std::vector<std::string> words;
+	split(query.data(), query.data() + query.size(), &words);
+
+	std::vector<Range> ranges;
+	for (size_t i = 0; i < words.size() && built_; i++) {
+		Range within{0, entries_.size()};
+		if (i < words_.size() && words[i].compare(0, words_[i].size(), words_[i]) == 0) {
+			within = ranges_[i];
+		}
+		ranges.push_back(narrow(within, words[i]));
+	}
+	words_ = std::move(words);
+	ranges_ = std::move(ranges);
+	if (ranges_.empty()) {
+		return;
+	}
+
+	// A file matching words 0..k carries mark_ + k + 1
+	const uint32_t count = static_cast<uint32_t>(ranges_.size());
+	if (mark_ > UINT32_MAX - count) {
+		std::fill(marks_.begin(), marks_.end(), 0);
+		mark_ = 0;
+	}
+	for (uint32_t k = 0; k < count; k++) {
+		for (size_t e = ranges_[k].begin; e < ranges_[k].end; e++) {
+			uint32_t& mark = marks_[entries_[e].file];
+			if (k == 0 || mark == mark_ + k) {
+				mark = mark_ + k + 1;
+			}
+		}
+	}
+
+	mark_ += count;
+	for (size_t file = 0; file < marks_.size(); file++) {
+		if (marks_[file] == mark_) {
+			out->push_back(static_cast<unsigned int>(file));
+		}
+	}
+}
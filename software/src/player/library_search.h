@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+//
+// Library Search - finds files by the words in their names
+//
+// Every word of a file's name, and of its folder's name, is a key: the
+// words are kept once each, sorted, in one string pool, and a table of
+// (word, file) pairs sorted the same way stands in for a prefix trie, a
+// prefix being one contiguous run of it. A query matches the files that
+// have a word starting with each of its words ("kick 909" finds
+// "909 Kick 02.wav" and "kicks/909-hard.wav"). Typing on extends the
+// last query, so each word is only looked up within the run it matched
+// before.
+//
+// Input thread only. Building takes one pass and a sort over the
+// library; a query then costs two binary searches per word, a pass over
+// the entries each word matched and one over a mark per file.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ScFolder;
+
+class LibrarySearch {
+public:
+	// Index the files of folders, numbered by their global_index
+	void build(const std::vector<ScFolder>& folders, size_t file_count);
+
+	// Forget the index, the library has changed
+	void clear();
+
+	bool built() const { return built_; }
+
+	/*
+	 * Global indices of the files matching every word of query, in
+	 * library order. Case and punctuation do not count.
+	 */
+	void find(const std::string& query, std::vector<unsigned int>* out);
+
+private:
+	struct Entry {
+		uint32_t word;  // Offset in pool_, in sorted order
+		uint32_t file;
+	};
+	struct Range {
+		size_t begin;
+		size_t end;
+	};
+
+	Range narrow(Range within, const std::string& prefix) const;
+
+	bool built_ = false;
+	std::string pool_;              // Words, sorted, each NUL-terminated
+	std::vector<Entry> entries_;    // Sorted by word, then file
+	std::vector<uint32_t> marks_;   // By file: words of the query matched so far
+	uint32_t mark_ = 0;
+
+	// The last query, word by word, and the run each matched
+	std::vector<std::string> words_;
+	std::vector<Range> ranges_;
+};
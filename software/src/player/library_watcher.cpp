@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+//
+// Library Watcher - follows the decks' folders on the stick with inotify
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "library_watcher.h"
+#include "../util/log.h"
+
+namespace {
+
+// Subfolders show up, go and get renamed in the base; files in the subfolders
+constexpr uint32_t BASE_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+constexpr uint32_t FOLDER_MASK = IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+// Names the playlist leaves out anyway (see scan() in playlist.cpp)
+bool ignored(const char* name, bool folder)
+{
+	return name[0] == '.' || (!folder && strstr(name, ".cue") != nullptr);
+}
+
+} // namespace
+
+LibraryWatcher::~LibraryWatcher()
+{
+	stop();
+}
+
+bool LibraryWatcher::start()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (running_) return true;
+
+	inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotify_ == -1) {
+		LOG_WARN("Cannot watch the library: %s", strerror(errno));
+		return false;
+	}
+	if (pipe2(wake_, O_NONBLOCK | O_CLOEXEC) == -1) {
+		LOG_WARN("Cannot watch the library: %s", strerror(errno));
+		close(inotify_);
+		inotify_ = -1;
+		return false;
+	}
+
+	running_ = true;
+	thread_ = std::thread(&LibraryWatcher::run, this);
+	return true;
+}
+
+void LibraryWatcher::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!running_) return;
+		running_ = false;
+	}
+	char e = 0;
+	if (write(wake_[1], &e, 1) == -1) {
+		LOG_WARN("Cannot wake the library watcher: %s", strerror(errno));
+	}
+	thread_.join();
+
+	close(inotify_);
+	close(wake_[0]);
+	close(wake_[1]);
+	inotify_ = wake_[0] = wake_[1] = -1;
+	watched_.clear();
+	for (int slot = 0; slot < SLOTS; slot++) {
+		bases_[slot].clear();
+		ready_[slot].reset();
+		pending_[slot] = Pending();
+	}
+}
+
+void LibraryWatcher::watch(int slot, const std::string& base_path)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!running_) return;
+
+	for (auto it = watched_.begin(); it != watched_.end();) {
+		if (it->second.slot == slot) {
+			inotify_rm_watch(inotify_, it->first);
+			it = watched_.erase(it);
+		} else {
+			++it;
+		}
+	}
+	bases_[slot] = base_path;
+	ready_[slot].reset();
+
+	// Watched here rather than on the watcher thread, so nothing done
+	// after this returns goes unseen
+	add_watch(slot, std::string());
+	DIR* dir = opendir(base_path.c_str());
+	if (dir == nullptr) return;
+	while (struct dirent* entry = readdir(dir)) {
+		struct stat st;
+		std::string path = base_path + "/" + entry->d_name;
+		if (!ignored(entry->d_name, true) && stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+			add_watch(slot, entry->d_name);
+		}
+	}
+	closedir(dir);
+}
+
+std::unique_ptr<Playlist> LibraryWatcher::take(int slot)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return std::move(ready_[slot]);
+}
+
+// With mutex_ held
+void LibraryWatcher::add_watch(int slot, const std::string& name)
+{
+	const bool base = name.empty();
+	const std::string path = base ? bases_[slot] : bases_[slot] + "/" + name;
+	int wd = inotify_add_watch(inotify_, path.c_str(), base ? BASE_MASK : FOLDER_MASK);
+	if (wd == -1) {
+		LOG_WARN("Cannot watch %s: %s", path.c_str(), strerror(errno));
+		return;
+	}
+	watched_[wd] = Watched{slot, name};
+}
+
+void LibraryWatcher::run()
+{
+	for (;;) {
+		// Sleep until an event, or until the first changes have settled
+		auto now = std::chrono::steady_clock::now();
+		int timeout = -1;
+		for (const Pending& pending : pending_) {
+			if (!pending.any) continue;
+			auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(pending.due - now).count();
+			int ms = static_cast<int>(std::max<decltype(wait)>(wait, 0));
+			timeout = (timeout < 0) ? ms : std::min(timeout, ms);
+		}
+
+		struct pollfd pt[2];
+		pt[0].fd = wake_[0];
+		pt[0].events = POLLIN;
+		pt[1].fd = inotify_;
+		pt[1].events = POLLIN;
+		if (poll(pt, 2, timeout) == -1 && errno != EINTR) {
+			LOG_ERROR("Library watcher: %s", strerror(errno));
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (!running_) return;
+		}
+		if (pt[1].revents & POLLIN) {
+			read_events();
+		}
+
+		now = std::chrono::steady_clock::now();
+		for (int slot = 0; slot < SLOTS; slot++) {
+			if (pending_[slot].any && pending_[slot].due <= now) {
+				rebuild(slot);
+			}
+		}
+	}
+}
+
+void LibraryWatcher::read_events()
+{
+	alignas(struct inotify_event) char buffer[4096];
+	const auto due = std::chrono::steady_clock::now() + std::chrono::milliseconds(SETTLE_MS);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (;;) {
+		ssize_t n = read(inotify_, buffer, sizeof(buffer));
+		if (n <= 0) return;
+
+		for (char* p = buffer; p < buffer + n;) {
+			const auto* event = reinterpret_cast<const struct inotify_event*>(p);
+			p += sizeof(struct inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW) {
+				// Events were lost: every folder is read again
+				for (int slot = 0; slot < SLOTS; slot++) {
+					Pending& pending = pending_[slot];
+					pending.any = pending.base = !bases_[slot].empty();
+					for (const auto& w : watched_) {
+						if (w.second.slot == slot && !w.second.name.empty()) {
+							pending.folders.push_back(w.second.name);
+						}
+					}
+					pending.due = due;
+				}
+				continue;
+			}
+
+			auto w = watched_.find(event->wd);
+			if (w == watched_.end()) continue;
+			if (event->mask & IN_IGNORED) {
+				watched_.erase(w);
+				continue;
+			}
+
+			const int slot = w->second.slot;
+			const bool folder = (event->mask & IN_ISDIR) != 0;
+			const char* name = (event->len > 0) ? event->name : "";
+			if (ignored(name, folder)) continue;
+
+			Pending& pending = pending_[slot];
+			std::string changed = w->second.name;
+			if (changed.empty()) {
+				// Only subfolders count in the base
+				if (!folder) continue;
+				pending.base = true;
+				changed = name;
+				if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+					add_watch(slot, changed);
+				}
+			}
+			if (std::find(pending.folders.begin(), pending.folders.end(), changed) == pending.folders.end()) {
+				pending.folders.push_back(changed);
+			}
+			pending.any = true;
+			pending.due = due;
+		}
+	}
+}
+
+void LibraryWatcher::rebuild(int slot)
+{
+	Pending pending = std::move(pending_[slot]);
+	pending_[slot] = Pending();
+
+	std::string base;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		base = bases_[slot];
+	}
+	if (base.empty()) return;
+
+	// Folders that changed are listed again, the rest come from the index
+	PlaylistScan scan(base);
+	if (pending.base) {
+		scan.stale(std::string());
+	}
+	for (const std::string& folder : pending.folders) {
+		scan.stale(folder);
+	}
+	auto next = std::make_unique<Playlist>();
+	next->load(scan);
+
+	// Dropped if the slot has moved on to another folder meanwhile
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (bases_[slot] == base) {
+		ready_[slot] = std::move(next);
+	}
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+//
+// Library Watcher - follows the decks' folders on the stick with inotify
+//
+// Each deck's base folder and its subfolders are watched. Files and
+// folders added, removed or renamed mark the folders they are in as
+// changed; once nothing has changed for SETTLE_MS the playlist is built
+// again on the watcher thread, from the index for the folders that have
+// not changed, and the index is written back. The input thread takes the
+// new playlist and swaps it in (Deck::swap_playlist()), so navigation
+// never sees one half updated.
+//
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "playlist.h"
+
+class LibraryWatcher {
+public:
+	static constexpr int SLOTS = 2;          // One per deck
+	static constexpr int SETTLE_MS = 300;    // Quiet time before a rebuild, a copy comes in many events
+
+	LibraryWatcher() = default;
+	~LibraryWatcher();
+
+	LibraryWatcher(const LibraryWatcher&) = delete;
+	LibraryWatcher& operator=(const LibraryWatcher&) = delete;
+
+	// Return: false if inotify is not available, the library then stays as loaded
+	bool start();
+	void stop();
+
+	// Watch base_path for slot, in place of what it watched before
+	void watch(int slot, const std::string& base_path);
+
+	/*
+	 * The playlist of slot built since the last call, if any (input thread)
+	 */
+	std::unique_ptr<Playlist> take(int slot);
+
+private:
+	// What a watch descriptor is on: a subfolder of slot, or its base ("")
+	struct Watched {
+		int slot;
+		std::string name;
+	};
+
+	// Changes of a slot waiting to settle (watcher thread)
+	struct Pending {
+		bool any = false;
+		bool base = false;
+		std::vector<std::string> folders;
+		std::chrono::steady_clock::time_point due;
+	};
+
+	void run();
+	void add_watch(int slot, const std::string& name);
+	void read_events();
+	void rebuild(int slot);
+
+	int inotify_ = -1;
+	int wake_[2] = {-1, -1};
+	std::thread thread_;
+
+	std::mutex mutex_;
+	bool running_ = false;
+	std::string bases_[SLOTS];
+	std::unordered_map<int, Watched> watched_;
+	std::unique_ptr<Playlist> ready_[SLOTS];
+
+	Pending pending_[SLOTS];
+};
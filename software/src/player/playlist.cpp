@@ -22,86 +22,322 @@
 // SC1000 playlist routines
 // Manages a tree of folders and audio files using std::vector
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <sys/stat.h>
 
 #include "playlist.h"
+#include "playlist_index.h"
 #include "../util/log.h"
 
-bool Playlist::load(const char* base_folder_path)
-{
-	struct dirent** dir_list;
-	struct dirent** file_list;
+namespace {
 
-	LOG_DEBUG("indexing %s", base_folder_path);
+int64_t mtime_ns(const struct stat& st)
+{
+	return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
 
-	int num_dirs = scandir(base_folder_path, &dir_list, nullptr, alphasort);
-	if (num_dirs <= 0) {
+// scandir() path in alphasort order into names, skipping hidden entries and,
+// for files, .cue files. The names live in owned until the caller frees it.
+bool scan(const std::string& path, bool files, std::vector<const char*>* names,
+          std::vector<struct dirent*>* owned)
+{
+	struct dirent** list;
+	int n = scandir(path.c_str(), &list, nullptr, alphasort);
+	if (n < 0) {
 		return false;
 	}
 
-	folders_.clear();
-	all_files_.clear();
-	total_files_ = 0;
-
-	for (int d = 0; d < num_dirs; d++) {
-		// Skip hidden files/folders
-		if (dir_list[d]->d_name[0] == '.') {
-			free(dir_list[d]);
+	for (int i = 0; i < n; i++) {
+		owned->push_back(list[i]);
+		const char* name = list[i]->d_name;
+		if (name[0] == '.' || (files && strstr(name, ".cue") != nullptr)) {
 			continue;
 		}
+		names->push_back(name);
+	}
+	free(list);
+	return true;
+}
 
-		std::string subfolder_path = std::string(base_folder_path) + "/" + dir_list[d]->d_name;
+// Write folder/name at p, returning the end of what was written
+char* join(char* p, const char* folder, size_t folder_len, const char* name)
+{
+	size_t name_len = strlen(name);
+	memcpy(p, folder, folder_len);
+	p[folder_len] = '/';
+	memcpy(p + folder_len + 1, name, name_len + 1);
+	return p + folder_len + 1 + name_len + 1;
+}
 
-		int num_files = scandir(subfolder_path.c_str(), &file_list, nullptr, alphasort);
-		if (num_files <= 0) {
-			free(dir_list[d]);
-			continue;
-		}
+} // namespace
 
-		ScFolder folder;
-		folder.full_path = subfolder_path;
+PlaylistScan::PlaylistScan(const std::string& base_path)
+	: base_path_(base_path),
+	  index_path_(PlaylistIndex::path_for(base_path))
+{
+}
 
-		for (int f = 0; f < num_files; f++) {
-			// Skip hidden files and .cue files
-			if (file_list[f]->d_name[0] == '.' ||
-			    strstr(file_list[f]->d_name, ".cue") != nullptr) {
-				free(file_list[f]);
-				continue;
-			}
+PlaylistScan::~PlaylistScan()
+{
+	for (struct dirent* entry : entries_) {
+		free(entry);
+	}
+}
 
-			ScFile file;
-			file.full_path = subfolder_path + "/" + file_list[f]->d_name;
-			file.global_index = static_cast<unsigned int>(total_files_);
-			total_files_++;
+void PlaylistScan::stale(const std::string& name)
+{
+	if (name.empty()) {
+		base_stale_ = true;
+	} else if (std::find(stale_.begin(), stale_.end(), name) == stale_.end()) {
+		stale_.push_back(name);
+	}
+}
 
-			folder.files.push_back(std::move(file));
-			free(file_list[f]);
+bool PlaylistScan::list()
+{
+	struct stat st;
+	if (stat(base_path_.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+		return false;
+	}
+	base_mtime_ = mtime_ns(st);
+
+	index_.read(index_path_);
+	if (base_stale_ || !index_.folders(base_mtime_, &listings_)) {
+		listings_.clear();
+		std::vector<const char*> names;
+		if (!scan(base_path_, false, &names, &entries_)) {
+			return false;
+		}
+		for (const char* name : names) {
+			FolderListing listing;
+			listing.name = name;
+			listings_.push_back(std::move(listing));
 		}
-		free(file_list);
+		base_scanned_ = true;
+	}
 
-		// Only add folder if it has files
-		if (!folder.files.empty()) {
-			folders_.push_back(std::move(folder));
+	folders_.resize(listings_.size());
+	paths_.resize(listings_.size());
+	rescanned_.reset(new bool[listings_.size()]());
+	return true;
+}
+
+void PlaylistScan::list_folder(size_t i)
+{
+	FolderListing& listing = listings_[i];
+	const std::string folder_path = base_path_ + "/" + listing.name;
+
+	// Files in the base folder are not folders, and a folder may be gone by now
+	struct stat st;
+	if (stat(folder_path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+		listing.mtime = -1;
+		return;
+	}
+	listing.mtime = mtime_ns(st);
+
+	std::vector<struct dirent*> owned;
+	const bool stale = std::find(stale_.begin(), stale_.end(), listing.name) != stale_.end();
+	if (stale || !index_.files(i, listing.name, listing.mtime, &listing.files)) {
+		listing.files.clear();
+		scan(folder_path, true, &listing.files, &owned);
+		rescanned_[i] = true;
+	}
+
+	// The folder's paths in one block, the listing's names pointing at their ends
+	const size_t folder_len = folder_path.size();
+	size_t size = folder_len + 1;
+	for (const char* file : listing.files) {
+		size += folder_len + 1 + strlen(file) + 1;
+	}
+	paths_[i].reset(new char[size]);
+
+	ScFolder& folder = folders_[i];
+	char* p = paths_[i].get();
+	memcpy(p, folder_path.c_str(), folder_len + 1);
+	folder.full_path = p;
+	p += folder_len + 1;
+
+	folder.files.resize(listing.files.size());
+	for (size_t f = 0; f < listing.files.size(); f++) {
+		folder.files[f].full_path = p;
+		p = join(p, folder.full_path, folder_len, listing.files[f]);
+		listing.files[f] = folder.files[f].full_path + folder_len + 1;
+	}
+
+	for (struct dirent* entry : owned) {
+		free(entry);
+	}
+}
+
+std::string PlaylistScan::index_contents() const
+{
+	bool changed = base_scanned_;
+	for (size_t i = 0; i < listings_.size(); i++) {
+		changed = changed || rescanned_[i];
+	}
+	if (!changed || listings_.empty()) {
+		return std::string();
+	}
+	return PlaylistIndex::contents(base_mtime_, listings_);
+}
+
+bool Playlist::load(const char* base_folder_path)
+{
+	PlaylistScan scan(base_folder_path);
+	return load(scan);
+}
+
+bool Playlist::load(PlaylistScan& scan)
+{
+	LOG_DEBUG("indexing %s", scan.base_path_.c_str());
+	reset(scan.base_path_.c_str());
+
+	if (!scan.list()) {
+		return false;
+	}
+	for (size_t i = 0; i < scan.folder_count(); i++) {
+		scan.list_folder(i);
+		take(scan, i);
+	}
+
+	std::string contents = scan.index_contents();
+	if (!contents.empty()) {
+		PlaylistIndex::write(scan.index_path(), contents);
+	}
+
+	LOG_INFO("Added folder %s: %zu files found, %zu folders rescanned", base_path_.c_str(), total_files_,
+	         rescanned_);
+
+	return total_files_ > 0;
+}
+
+void Playlist::reset(const char* base_folder_path)
+{
+	base_path_ = base_folder_path;
+	folders_.clear();
+	all_files_.clear();
+	paths_.clear();
+	total_files_ = 0;
+	rescanned_ = 0;
+	search_.clear();
+	results_.files.clear();
+}
+
+void Playlist::take(PlaylistScan& scan, size_t i)
+{
+	ScFolder& folder = scan.folders_[i];
+	if (scan.rescanned_[i]) {
+		rescanned_++;
+	}
+	if (folder.files.empty()) {
+		return;
+	}
+	paths_.push_back(std::move(scan.paths_[i]));
+	search_.clear();
+
+	// A folder add_file() got to first only gets the files it lacks
+	auto existing = std::find_if(folders_.begin(), folders_.end(),
+	                             [&](const ScFolder& f) { return strcmp(f.full_path, folder.full_path) == 0; });
+	if (existing != folders_.end()) {
+		for (const ScFile& file : folder.files) {
+			bool known = std::any_of(existing->files.begin(), existing->files.end(),
+			                         [&](const ScFile& f) { return strcmp(f.full_path, file.full_path) == 0; });
+			if (!known) {
+				existing->files.push_back(file);
+				total_files_++;
+			}
 		}
+		rebuild_index();
+		return;
+	}
 
-		free(dir_list[d]);
+	// Appended, so the flat view only grows: moving the folder keeps its files where they are
+	total_files_ += folder.files.size();
+	folders_.push_back(std::move(folder));
+	for (auto& file : folders_.back().files) {
+		file.global_index = static_cast<unsigned int>(all_files_.size());
+		all_files_.push_back(&file);
 	}
-	free(dir_list);
+}
 
-	// Build flat file index for O(1) random access
+// Build flat file index for O(1) random access
+void Playlist::rebuild_index()
+{
+	all_files_.clear();
 	all_files_.reserve(total_files_);
 	for (auto& folder : folders_) {
 		for (auto& file : folder.files) {
+			file.global_index = static_cast<unsigned int>(all_files_.size());
 			all_files_.push_back(&file);
 		}
 	}
+}
 
-	LOG_INFO("Added folder %s: %zu files found", base_folder_path, total_files_);
+void Playlist::add_file(const std::string& folder_path, const std::string& file_path)
+{
+	auto folder = std::find_if(folders_.begin(), folders_.end(),
+	                           [&](const ScFolder& f) { return f.full_path == folder_path; });
+	if (folder == folders_.end()) {
+		ScFolder added;
+		added.full_path = keep(folder_path);
+		folders_.push_back(std::move(added));
+		folder = folders_.end() - 1;
+	}
 
-	return total_files_ > 0;
+	ScFile file;
+	file.full_path = keep(file_path);
+	folder->files.push_back(file);
+	total_files_++;
+	search_.clear();
+
+	// Vectors may have moved, pointers and global indices are rebuilt
+	rebuild_index();
+
+	LOG_DEBUG("added %s", file_path.c_str());
+}
+
+// Copy a path into a block of its own in the pool
+const char* Playlist::keep(const std::string& path)
+{
+	paths_.emplace_back(new char[path.size() + 1]);
+	memcpy(paths_.back().get(), path.c_str(), path.size() + 1);
+	return paths_.back().get();
+}
+
+size_t Playlist::search(const std::string& query)
+{
+	if (!search_.built()) {
+		search_.build(folders_, all_files_.size());
+	}
+
+	std::vector<unsigned int> found;
+	search_.find(query, &found);
+
+	results_.full_path = "search";
+	results_.files.clear();
+	for (unsigned int index : found) {
+		results_.files.push_back(*all_files_[index]);
+	}
+	return results_.files.size();
+}
+
+// Each folder's files are numbered in one run (see take() and rebuild_index())
+bool Playlist::locate(unsigned int global_index, size_t* folder_idx, size_t* file_idx) const
+{
+	for (size_t f = 0; f < folders_.size(); f++) {
+		const std::vector<ScFile>& files = folders_[f].files;
+		if (!files.empty() && global_index >= files.front().global_index &&
+		    global_index - files.front().global_index < files.size()) {
+			*folder_idx = f;
+			*file_idx = global_index - files.front().global_index;
+			return true;
+		}
+	}
+	return false;
 }
 
 ScFile* Playlist::get_file_at_index(unsigned int index)
@@ -112,39 +348,41 @@ ScFile* Playlist::get_file_at_index(unsigned int index)
 	return all_files_[index];
 }
 
-ScFolder* Playlist::get_folder(size_t folder_idx)
+const ScFolder* Playlist::folder_at(size_t folder_idx) const
 {
+	if (folder_idx == RESULTS) {
+		return &results_;
+	}
 	if (folder_idx >= folders_.size()) {
 		return nullptr;
 	}
 	return &folders_[folder_idx];
 }
 
+ScFolder* Playlist::get_folder(size_t folder_idx)
+{
+	return const_cast<ScFolder*>(folder_at(folder_idx));
+}
+
 ScFile* Playlist::get_file(size_t folder_idx, size_t file_idx)
 {
-	if (folder_idx >= folders_.size()) {
+	ScFolder* folder = get_folder(folder_idx);
+	if (folder == nullptr || file_idx >= folder->files.size()) {
 		return nullptr;
 	}
-	if (file_idx >= folders_[folder_idx].files.size()) {
-		return nullptr;
-	}
-	return &folders_[folder_idx].files[file_idx];
+	return &folder->files[file_idx];
 }
 
 size_t Playlist::file_count_in_folder(size_t folder_idx) const
 {
-	if (folder_idx >= folders_.size()) {
-		return 0;
-	}
-	return folders_[folder_idx].files.size();
+	const ScFolder* folder = folder_at(folder_idx);
+	return folder ? folder->files.size() : 0;
 }
 
 bool Playlist::has_next_file(size_t folder_idx, size_t file_idx) const
 {
-	if (folder_idx >= folders_.size()) {
-		return false;
-	}
-	return file_idx + 1 < folders_[folder_idx].files.size();
+	const ScFolder* folder = folder_at(folder_idx);
+	return folder != nullptr && file_idx + 1 < folder->files.size();
 }
 
 bool Playlist::has_prev_file(size_t folder_idx, size_t file_idx) const
@@ -152,21 +390,22 @@ bool Playlist::has_prev_file(size_t folder_idx, size_t file_idx) const
 	return file_idx > 0;
 }
 
+// The search results lead nowhere by folder, search_clear goes back
 bool Playlist::has_next_folder(size_t folder_idx) const
 {
-	return folder_idx + 1 < folders_.size();
+	return folder_idx != RESULTS && folder_idx + 1 < folders_.size();
 }
 
 bool Playlist::has_prev_folder(size_t folder_idx) const
 {
-	return folder_idx > 0;
+	return folder_idx != RESULTS && folder_idx > 0;
 }
 
 void Playlist::dump() const
 {
 	for (const auto& folder : folders_) {
 		for (const auto& file : folder.files) {
-			LOG_DEBUG("%s - %s", folder.full_path.c_str(), file.full_path.c_str());
+			LOG_DEBUG("%s - %s", folder.full_path, file.full_path);
 		}
 	}
 }
@@ -22,21 +22,87 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 
+#include "library_search.h"
+#include "playlist_index.h"
+
+struct dirent;
+
 // File entry (beat or sample)
 struct ScFile {
-	std::string full_path;
+	const char* full_path = nullptr;  // In the playlist's path pool
 	unsigned int global_index = 0;  // Index across all files
 };
 
 // Folder containing files
 struct ScFolder {
-	std::string full_path;
+	const char* full_path = nullptr;  // In the playlist's path pool
 	std::vector<ScFile> files;
 };
 
+/*
+ * PlaylistScan - Playlist::load() in steps that can run on other threads
+ *
+ * list() reads the index and lists the base folder. list_folder() then
+ * lists each subfolder, in any order and on any thread, each folder on one
+ * thread at a time. Playlist::take() adds the listed folders to a playlist,
+ * in order, on the thread that owns it.
+ */
+class PlaylistScan {
+public:
+	explicit PlaylistScan(const std::string& base_path);
+	~PlaylistScan();
+
+	PlaylistScan(const PlaylistScan&) = delete;
+	PlaylistScan& operator=(const PlaylistScan&) = delete;
+
+	/*
+	 * List the subfolders, from the index if the base folder is unchanged
+	 * Return: false if the base folder cannot be read
+	 */
+	bool list();
+
+	/*
+	 * List subfolder name (or, empty, the base folder) from disk whatever
+	 * the index says, as it is known to have changed. Call before list().
+	 */
+	void stale(const std::string& name);
+
+	// Subfolders found by list()
+	size_t folder_count() const { return listings_.size(); }
+
+	// List the files of subfolder i, from the index if it is unchanged
+	void list_folder(size_t i);
+
+	/*
+	 * What the index should hold once every folder is taken, empty if it
+	 * holds that already. Call before the playlist changes again, as file
+	 * names point into its paths.
+	 */
+	std::string index_contents() const;
+	const std::string& index_path() const { return index_path_; }
+
+private:
+	friend class Playlist;
+
+	std::string base_path_;
+	std::string index_path_;
+	PlaylistIndex index_;
+	int64_t base_mtime_ = 0;
+	bool base_scanned_ = false;                    // Subfolders from scandir, not the index
+	bool base_stale_ = false;
+	std::vector<std::string> stale_;               // Subfolders not to take from the index
+	std::vector<struct dirent*> entries_;          // Of the base folder, for the names
+	std::vector<FolderListing> listings_;
+	std::vector<ScFolder> folders_;                // Listed, until taken
+	std::vector<std::unique_ptr<char[]>> paths_;   // Their paths, until taken
+	std::unique_ptr<bool[]> rescanned_;            // By folder, not from the index
+};
+
 /*
  * Playlist - manages a collection of folders and audio files
  *
@@ -45,6 +111,9 @@ struct ScFolder {
  */
 class Playlist {
 public:
+	// Folder index of the files found by the last search()
+	static constexpr size_t RESULTS = SIZE_MAX;
+
 	Playlist() = default;
 	~Playlist() = default;
 
@@ -56,12 +125,56 @@ public:
 
 	/*
 	 * Load all audio files from a base folder
-	 * Scans subdirectories for audio files, excluding .cue files
+	 * Scans subdirectories for audio files, excluding .cue files. Folders
+	 * unchanged since the last load are taken from the playlist index
+	 * (see playlist_index.h), which is rewritten if any were not.
 	 *
 	 * Return: true if files were found, false otherwise
 	 */
 	bool load(const char* base_folder_path);
 
+	// The same, from a scan not yet listed (see PlaylistScan::stale())
+	bool load(PlaylistScan& scan);
+
+	/*
+	 * Start over, empty, on a base folder whose folders come from a scan
+	 */
+	void reset(const char* base_folder_path);
+
+	/*
+	 * Add folder i of scan, listed by now, after the folders taken before
+	 * it. Folders without files are left out.
+	 */
+	void take(PlaylistScan& scan, size_t i);
+
+	/*
+	 * Add a file written while running (e.g. a saved loop) to its folder,
+	 * appending the folder if it is new. Indices of existing entries do not
+	 * change; the next load() sorts everything again.
+	 */
+	void add_file(const std::string& folder_path, const std::string& file_path);
+
+	/*
+	 * Find the files with a word starting with each word of query, in
+	 * their name or their folder's (see library_search.h). They make up
+	 * folder RESULTS, in library order, until the next search.
+	 *
+	 * Return: number of files found
+	 */
+	size_t search(const std::string& query);
+
+	/*
+	 * Folder and file index of the file numbered global_index
+	 * Return: false if there is no such file
+	 */
+	bool locate(unsigned int global_index, size_t* folder_idx, size_t* file_idx) const;
+
+	// Folder passed to load()
+	const std::string& base_path() const { return base_path_; }
+
+	// Folders load() or take() had to scan, not having them in the index
+	size_t rescanned() const { return rescanned_; }
+
 	/*
 	 * Get file by global index (for random access / shuffle)
 	 * Return: pointer to file, or nullptr if index out of range
@@ -69,7 +182,7 @@ public:
 	ScFile* get_file_at_index(unsigned int index);
 
 	/*
-	 * Get folder by index
+	 * Get folder by index, RESULTS included
 	 * Return: pointer to folder, or nullptr if index out of range
 	 */
 	ScFolder* get_folder(size_t folder_idx);
@@ -80,7 +193,7 @@ public:
 	 */
 	ScFile* get_file(size_t folder_idx, size_t file_idx);
 
-	// Counts
+	// Counts (RESULTS is not one of the folders)
 	size_t folder_count() const { return folders_.size(); }
 	size_t total_files() const { return total_files_; }
 	size_t file_count_in_folder(size_t folder_idx) const;
@@ -95,7 +208,19 @@ public:
 	void dump() const;
 
 private:
+	void rebuild_index();
+	const char* keep(const std::string& path);
+	const ScFolder* folder_at(size_t folder_idx) const;
+
+	std::string base_path_;
 	std::vector<ScFolder> folders_;
 	std::vector<ScFile*> all_files_;  // Flat view for O(1) random access
 	size_t total_files_ = 0;
+	size_t rescanned_ = 0;
+
+	LibrarySearch search_;   // Built on the first search() after a change
+	ScFolder results_;
+
+	// Path pool: one block per folder taken, plus one per add_file()
+	std::vector<std::unique_ptr<char[]>> paths_;
 };
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+//
+// Playlist Index - folder listings kept in a binary file next to the base folder
+//
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "playlist_index.h"
+#include "../engine/wav_file.h"
+#include "../util/log.h"
+
+namespace {
+
+constexpr char MAGIC[4] = {'S', 'C', 'P', 'I'};
+constexpr uint32_t VERSION = 1;
+constexpr int64_t RACY_NS = 2000000000;  // FAT keeps mtimes to 2 s
+
+struct Header {
+	char magic[4];
+	uint32_t version;
+	uint32_t folder_count;
+	uint32_t reserved;
+	int64_t base_mtime;
+	int64_t written;
+};
+
+// Bounds-checked walk over the index buffer
+struct Reader {
+	const char* p;
+	const char* end;
+
+	template <typename T>
+	bool get(T* value)
+	{
+		if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+		memcpy(value, p, sizeof(T));
+		p += sizeof(T);
+		return true;
+	}
+
+	// A length-prefixed, NUL-terminated name, returned in place
+	const char* name()
+	{
+		uint16_t len;
+		if (!get(&len) || static_cast<size_t>(end - p) < len + 1u || p[len] != '\0') return nullptr;
+		const char* s = p;
+		p += len + 1;
+		return s;
+	}
+};
+
+template <typename T>
+void put(std::string& out, T value)
+{
+	out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void put_name(std::string& out, const char* name)
+{
+	size_t len = strlen(name);
+	put(out, static_cast<uint16_t>(len));
+	out.append(name, len + 1);
+}
+
+} // namespace
+
+bool PlaylistIndex::read(const std::string& path)
+{
+	data_.reset();
+	folders_.clear();
+
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) return false;
+
+	struct stat st;
+	bool ok = fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Header));
+	size_t size = ok ? static_cast<size_t>(st.st_size) : 0;
+	if (ok) {
+		data_.reset(new char[size]);
+		ok = ::read(fd, data_.get(), size) == static_cast<ssize_t>(size);
+	}
+	close(fd);
+
+	Header header{};
+	Reader in{data_.get(), data_.get() + size};
+	ok = ok && in.get(&header) && memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+	     header.version == VERSION;
+	// Each folder takes at least its mtime, file count and an empty name,
+	// so a count the file cannot hold is corrupt, not an allocation to try
+	ok = ok && header.folder_count <= (size - sizeof(Header)) /
+	                                  (sizeof(int64_t) + sizeof(uint32_t) + 3);
+	if (ok) {
+		folders_.resize(header.folder_count);
+		for (auto& folder : folders_) {
+			uint32_t count = 0;
+			ok = in.get(&folder.mtime) && in.get(&count) && (folder.name = in.name()) != nullptr;
+			for (uint32_t f = 0; ok && f < count; f++) {
+				const char* name = in.name();
+				ok = name != nullptr;
+				folder.files.push_back(name);
+			}
+			if (!ok) break;
+		}
+	}
+
+	if (!ok) {
+		LOG_INFO("Playlist index %s unreadable, rescanning", path.c_str());
+		data_.reset();
+		folders_.clear();
+		return false;
+	}
+
+	base_mtime_ = header.base_mtime;
+	written_ = header.written;
+	return true;
+}
+
+bool PlaylistIndex::fresh(int64_t cached, int64_t now) const
+{
+	return data_ && cached == now && std::llabs(written_ - cached) >= RACY_NS;
+}
+
+bool PlaylistIndex::folders(int64_t base_mtime, std::vector<FolderListing>* out) const
+{
+	if (!fresh(base_mtime_, base_mtime)) return false;
+
+	out->clear();
+	for (const auto& folder : folders_) {
+		FolderListing listing;
+		listing.name = folder.name;
+		out->push_back(std::move(listing));
+	}
+	return true;
+}
+
+bool PlaylistIndex::files(size_t hint, const char* name, int64_t mtime,
+                          std::vector<const char*>* out) const
+{
+	for (size_t i = 0; i < folders_.size(); i++) {
+		const FolderListing& folder = folders_[(hint + i) % folders_.size()];
+		if (strcmp(folder.name, name) != 0) continue;
+
+		if (!fresh(folder.mtime, mtime)) return false;
+		*out = folder.files;
+		return true;
+	}
+	return false;
+}
+
+std::string PlaylistIndex::contents(int64_t base_mtime, const std::vector<FolderListing>& folders)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	Header header{};
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.base_mtime = base_mtime;
+	header.written = static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+	for (const auto& folder : folders) {
+		if (folder.mtime >= 0) header.folder_count++;
+	}
+
+	std::string out;
+	put(out, header);
+	for (const auto& folder : folders) {
+		if (folder.mtime < 0) continue;
+
+		put(out, folder.mtime);
+		put(out, static_cast<uint32_t>(folder.files.size()));
+		put_name(out, folder.name);
+		for (const char* file : folder.files) {
+			put_name(out, file);
+		}
+	}
+	return out;
+}
+
+bool PlaylistIndex::write(const std::string& path, const std::string& contents)
+{
+	std::string tmp;
+	int fd = sc::audio::replace_open(path, &tmp);
+	if (fd == -1) return false;
+	if (!sc::audio::write_all(fd, contents.data(), contents.size())) {
+		LOG_ERROR("Cannot write %s", path.c_str());
+		sc::audio::replace_abort(fd, tmp);
+		return false;
+	}
+	return sc::audio::replace_commit(fd, tmp, path);
+}
+
+std::string PlaylistIndex::path_for(const std::string& base_folder)
+{
+	std::string base = base_folder;
+	while (base.size() > 1 && base.back() == '/') {
+		base.pop_back();
+	}
+
+	size_t slash = base.find_last_of('/');
+	if (slash == std::string::npos) {
+		return "." + base + ".index";
+	}
+	return base.substr(0, slash + 1) + "." + base.substr(slash + 1) + ".index";
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024-2026 Niklas Klügel <lodsb@lodsb.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+//
+// Playlist Index - folder listings kept in a binary file next to the base
+// folder, so a boot only rescans folders that changed
+//
+// A folder's mtime moves whenever a name in it is added, removed or
+// renamed, so a listing stays good while the folder's mtime matches the
+// one it was read with. Listings taken within the filesystem's timestamp
+// granularity (2 s on FAT) of writing the index could have missed a
+// change in the same tick and are never trusted.
+//
+// The file is read with one read() into one buffer. Names in it are
+// length-prefixed and NUL-terminated, so listings point straight into
+// the buffer rather than holding strings of their own.
+//
+// Layout, native byte order (the index never leaves the stick it lists):
+//   header   magic "SCPI", version, folder count, base mtime, time written
+//   folder   mtime, file count, name, then that many file names
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A subfolder of the base folder and the names in it, in scandir order.
+// Names point into a PlaylistIndex or into scandir's entries.
+struct FolderListing {
+	const char* name = nullptr;
+	int64_t mtime = 0;                // Of the folder, ns since the epoch
+	std::vector<const char*> files;
+};
+
+class PlaylistIndex {
+public:
+	/*
+	 * Read the index at path in one go
+	 * Return: false, leaving the index empty, if it is missing, from
+	 * another version or damaged
+	 */
+	bool read(const std::string& path);
+
+	/*
+	 * Names of the base folder's subfolders, if its mtime still matches
+	 */
+	bool folders(int64_t base_mtime, std::vector<FolderListing>* out) const;
+
+	/*
+	 * Files of the subfolder called name, if its mtime still matches.
+	 * hint is where the folder is likely to be in the index (its place
+	 * in folders()). Safe to call from several threads at once.
+	 */
+	bool files(size_t hint, const char* name, int64_t mtime, std::vector<const char*>* out) const;
+
+	/*
+	 * An index of the listings of a base folder, leaving out folders with a
+	 * negative mtime (gone by the time they were listed)
+	 */
+	static std::string contents(int64_t base_mtime, const std::vector<FolderListing>& folders);
+
+	/*
+	 * Write contents to path, through a temp file renamed over the old index
+	 */
+	static bool write(const std::string& path, const std::string& contents);
+
+	// Where the index of base_folder lives: a hidden file beside it, as
+	// writing it inside would move the folder's own mtime
+	static std::string path_for(const std::string& base_folder);
+
+private:
+	// A cached mtime still matching is only proof when it is not racy
+	bool fresh(int64_t cached, int64_t now) const;
+
+	std::unique_ptr<char[]> data_;
+	int64_t base_mtime_ = 0;
+	int64_t written_ = 0;
+	std::vector<FolderListing> folders_;
+};
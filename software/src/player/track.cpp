@@ -24,6 +24,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <csignal>
+#include <cstring>
 #include <string>
 #include <unordered_map>
 #include <sys/types.h>
@@ -91,34 +92,58 @@ void track_use_mlock()
 }
 
 /*
- * Allocate more memory
+ * Allocate a block of audio, locked into RAM if requested
  *
- * Return: -1 if memory could not be allocated, otherwise 0
+ * Return: pointer, or NULL if memory could not be allocated
  */
 
-static int more_space(Track* tr)
+TrackBlock* track_block_alloc()
 {
 	TrackBlock* block;
 
 	rt_not_allowed();
 
-	if (tr->blocks >= TRACK_MAX_BLOCKS)
-	{
-		LOG_WARN("Maximum track length reached");
-		return -1;
-	}
-
 	block = static_cast<TrackBlock*>(malloc(sizeof(TrackBlock)));
 	if (block == nullptr)
 	{
 		perror("malloc");
-		return -1;
+		return nullptr;
 	}
 
 	if (use_mlock && mlock(block, sizeof(TrackBlock)) == -1)
 	{
 		perror("mlock");
 		free(block);
+		return nullptr;
+	}
+
+	return block;
+}
+
+void track_block_free(TrackBlock* block)
+{
+	free(block);
+}
+
+/*
+ * Allocate more memory
+ *
+ * Return: -1 if memory could not be allocated, otherwise 0
+ */
+
+static int more_space(Track* tr)
+{
+	TrackBlock* block;
+
+	if (tr->blocks >= TRACK_MAX_BLOCKS)
+	{
+		LOG_WARN("Maximum track length reached");
+		return -1;
+	}
+
+	block = track_block_alloc();
+	if (block == nullptr)
+	{
 		return -1;
 	}
 
@@ -225,7 +250,7 @@ static int track_init(Track* t, const char* importer, const char* path)
 	t->length = 0;
 
 	t->importer = importer;
-	t->path = path;
+	t->path = strdup(path);  // Outlives the playlist or string it came from
 	t->finished = false;
 
 	// Add to track registry for deduplication lookups
@@ -258,6 +283,7 @@ static void track_clear(Track* tr)
 	// Remove from track registry
 	if (tr->path != nullptr) {
 		g_track_registry.erase(tr->path);
+		free(const_cast<char*>(tr->path));
 	}
 }
 
@@ -39,9 +39,9 @@ struct Track {
     unsigned int refcount;
     int rate;
 
-    // Pointers to external data (owned by caller)
+    // Pointer to external data (owned by caller)
     const char* importer;
-    const char* path;
+    const char* path;       // Own copy, freed with the track
 
     size_t bytes;           // Bytes loaded
     unsigned int length;    // Track length in samples
@@ -80,6 +80,11 @@ struct Track {
 // Enable memory locking for track allocations
 void track_use_mlock();
 
+// Allocate/free one block outside a track, e.g. for a pool of loop storage.
+// Locked into RAM when track_use_mlock() was called. Not RT-safe.
+TrackBlock* track_block_alloc();
+void track_block_free(TrackBlock* block);
+
 // Track acquisition functions (reference counted)
 Track* track_acquire_by_import(const char* importer, const char* path);
 Track* track_acquire_empty();
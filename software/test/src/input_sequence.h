@@ -11,6 +11,7 @@
 #include <vector>
 #include <variant>
 #include <cstdint>
+#include <cstddef>
 
 namespace sc {
 namespace test {
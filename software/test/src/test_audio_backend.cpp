@@ -24,8 +24,11 @@ TestAudioBackend::TestAudioBackend(Sc1000* engine, unsigned int sample_rate)
         SND_PCM_FORMAT_FLOAT_LE
     );
 
+    // Timed input events are scheduled against rendered time, not wall time
+    audio_engine_->set_clock([this] { return render_time(); });
+
     // Initialize loop buffers
-    audio_engine_->init_loop_buffers(sample_rate_, 60);  // 60 sec max loop
+    audio_engine_->init_loop_buffers(sample_rate_, 60, 0);  // 60 sec max loop, pool for two
 
     // Pre-allocate period buffer
     period_buffer_.resize(period_size_ * 2);  // stereo
@@ -58,6 +61,41 @@ void TestAudioBackend::reset_loop(int deck)
     audio_engine_->reset_loop(deck);
 }
 
+bool TestAudioBackend::grab_loop(int deck, double seconds)
+{
+    return audio_engine_->grab_loop(deck, seconds);
+}
+
+bool TestAudioBackend::adopt_loop(int deck, Track* track)
+{
+    return audio_engine_->adopt_loop(deck, track);
+}
+
+void TestAudioBackend::collect_loops()
+{
+    audio_engine_->collect_loops();
+}
+
+unsigned int TestAudioBackend::loop_version(int deck) const
+{
+    return audio_engine_->loop_version(deck);
+}
+
+bool TestAudioBackend::snapshot_loop(int deck, sc::audio::LoopSnapshot* snapshot)
+{
+    return audio_engine_->snapshot_loop(deck, snapshot);
+}
+
+bool TestAudioBackend::calibrate_latency()
+{
+    return audio_engine_->start_latency_calibration();
+}
+
+sc::audio::LatencyCalibration TestAudioBackend::latency_calibration() const
+{
+    return audio_engine_->latency_calibration();
+}
+
 Track* TestAudioBackend::get_loop_track(int deck)
 {
     return audio_engine_->get_loop_track(deck);
@@ -104,7 +142,18 @@ void TestAudioBackend::render(unsigned long frames)
     AudioCapture capture = {};
     std::vector<float> capture_buffer;
 
-    if (capture_enabled_ && capture_offset_ < capture_input_.size()) {
+    if (capture_enabled_ && loopback_delay_ >= frames) {
+        // Output rendered loopback_delay_ frames ago (silence if not kept)
+        capture_buffer.assign(frames * 2, 0.0f);
+        size_t kept = output_buffer_.size() / 2;
+        for (unsigned long i = 0; i < frames; i++) {
+            size_t back = loopback_delay_ - i;  // Frames before the end of the output
+            if (back <= kept) {
+                capture_buffer[2 * i] = output_buffer_[2 * (kept - back)];
+                capture_buffer[2 * i + 1] = output_buffer_[2 * (kept - back) + 1];
+            }
+        }
+    } else if (capture_enabled_ && capture_offset_ < capture_input_.size()) {
         size_t available = capture_input_.size() - capture_offset_;
         size_t needed = frames * 2;  // stereo
         size_t to_copy = std::min(available, needed);
@@ -116,14 +165,18 @@ void TestAudioBackend::render(unsigned long frames)
             capture_buffer.begin()
         );
 
+        capture_offset_ += to_copy;
+    }
+
+    if (!capture_buffer.empty()) {
         capture.buffer = capture_buffer.data();
         capture.format = SND_PCM_FORMAT_FLOAT_LE;
         capture.channels = 2;
         capture.bytes_per_sample = sizeof(float);
         capture.left_channel = 0;
         capture.right_channel = 1;
-
-        capture_offset_ += to_copy;
+        capture.scratch_left_channel = scratch_left_;
+        capture.scratch_right_channel = scratch_right_;
     }
 
     // Process audio
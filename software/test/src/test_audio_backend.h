@@ -47,6 +47,13 @@ public:
     bool has_loop(int deck) const override;
     bool has_capture() const override { return capture_enabled_; }
     void reset_loop(int deck) override;
+    bool grab_loop(int deck, double seconds) override;
+    bool adopt_loop(int deck, Track* track) override;
+    void collect_loops() override;
+    unsigned int loop_version(int deck) const override;
+    bool snapshot_loop(int deck, sc::audio::LoopSnapshot* snapshot) override;
+    bool calibrate_latency() override;
+    sc::audio::LatencyCalibration latency_calibration() const override;
     Track* get_loop_track(int deck) override;
     Track* peek_loop_track(int deck) override;
 
@@ -75,6 +82,19 @@ public:
     void set_capture_input(const std::vector<float>& input);
     void enable_capture(bool enabled) { capture_enabled_ = enabled; }
 
+    // Feed the output back as capture input, delayed by frames (at least a
+    // period, 0 = off). Replaces set_capture_input()
+    void set_capture_loopback(unsigned long frames) { loopback_delay_ = frames; }
+
+    // Channels of the capture input the scratch deck records (default 0, 1)
+    void set_scratch_capture_pair(int left, int right) { scratch_left_ = left; scratch_right_ = right; }
+
+    // Keep the last seconds of capture input for grab_loop (off by default)
+    void init_capture_ring(int seconds) { audio_engine_->init_capture_ring(static_cast<int>(sample_rate_), seconds); }
+    void init_loop_buffers(int max_seconds, int pool_seconds) {
+        audio_engine_->init_loop_buffers(static_cast<int>(sample_rate_), max_seconds, pool_seconds);
+    }
+
     // Get total rendered sample count
     size_t total_samples_rendered() const { return total_samples_; }
 
@@ -97,6 +117,9 @@ private:
     std::vector<float> capture_input_;
     size_t capture_offset_ = 0;
     bool capture_enabled_ = false;
+    unsigned long loopback_delay_ = 0;
+    int scratch_left_ = 0;
+    int scratch_right_ = 1;
 
     // Temporary buffer for period rendering
     std::vector<float> period_buffer_;
@@ -8,8 +8,28 @@
 
 #include "test_harness.h"
 #include "core/sc_settings.h"
+#include "control/actions.h"
+#include "control/mapping_registry.h"
+#include "engine/tempo_grid.h"
+#include "engine/wav_file.h"
+#include "input/midi_command.h"
+#include "input/midi_feedback.h"
+#include "input/midi_parser.h"
+#include "platform/gpio.h"
+#include "player/cue_writer.h"
+#include "player/cues.h"
+#include "player/folder_indexer.h"
+#include "player/library_watcher.h"
+#include "player/playlist_index.h"
+#include <chrono>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 namespace sc {
 namespace test {
@@ -33,8 +53,13 @@ void TestHarness::setup_engine()
     settings_->buffer_period_factor = 4;
     settings_->platter_enabled = 1;
     settings_->platter_speed = 3072;
+    settings_->platter_estimator = true;
+    settings_->midi_jog_speed = 1024;
+    settings_->midi_feedback = false;
+    settings_->midi_feedback_rate = 1000;
     settings_->slippiness = 100;
     settings_->brake_speed = 50;
+    settings_->max_scratch_pitch = 10.0;
     settings_->initial_volume = 1.0;
     settings_->max_volume = 1.0;
     settings_->pitch_range = 8;
@@ -49,6 +74,9 @@ void TestHarness::setup_engine()
     engine_.beat_deck.deck_no = 0;
     engine_.scratch_deck.deck_no = 1;
 
+    // Compile mappings added by tests against these decks
+    engine_.mappings.bind(&engine_.beat_deck, &engine_.scratch_deck);
+
     // Set beat deck to just_play mode
     engine_.beat_deck.player.input.just_play = true;
 
@@ -90,9 +118,25 @@ void TestHarness::apply_input_at(double time)
     // Encoder -> target position
     // platter_speed = 3072 means 3072 ticks per second of audio
     // Encoder is 4096 ticks per rotation
-    double position = static_cast<double>(input_->encoder_angle()) /
-                      engine_.settings->platter_speed;
-    scratch_input.target_position = position;
+    if (engine_.settings->platter_estimator) {
+        // Sample the encoder at the input thread rate, as sc_input does,
+        // and extrapolate to the end of the chunk about to be rendered
+        for (; next_input_time_ <= time; next_input_time_ += INPUT_PERIOD) {
+            input_->set_time(next_input_time_);
+            double measured = static_cast<double>(input_->encoder_angle()) /
+                              engine_.settings->platter_speed;
+            platter_estimator_.update(measured, next_input_time_);
+        }
+        input_->set_time(time);
+
+        double block_time = static_cast<double>(FRAMES_PER_CHUNK) / sample_rate_;
+        scratch_input.target_position = platter_estimator_.predict(time + block_time);
+        scratch_input.target_velocity = platter_estimator_.velocity();
+    } else {
+        double position = static_cast<double>(input_->encoder_angle()) /
+                          engine_.settings->platter_speed;
+        scratch_input.target_position = position;
+    }
 
     // Touch state
     scratch_input.touched = input_->cap_touched();
@@ -103,11 +147,16 @@ void TestHarness::apply_input_at(double time)
 }
 
 void TestHarness::run(double duration_seconds)
+{
+    run(duration_seconds, nullptr);
+}
+
+void TestHarness::run(double duration_seconds, const std::function<void(double)>& on_chunk)
 {
     sequence_.finalize();
 
     unsigned long total_frames = static_cast<unsigned long>(duration_seconds * sample_rate_);
-    unsigned long frames_per_chunk = 256;
+    unsigned long frames_per_chunk = FRAMES_PER_CHUNK;
     double dt = static_cast<double>(frames_per_chunk) / sample_rate_;
 
     unsigned long rendered = 0;
@@ -122,6 +171,8 @@ void TestHarness::run(double duration_seconds)
 
         current_time_ += dt;
         rendered += chunk;
+
+        if (on_chunk) on_chunk(current_time_);
     }
 }
 
@@ -131,6 +182,8 @@ void TestHarness::reset()
     sequence_.clear();
     input_->set_time(0.0);
     current_time_ = 0.0;
+    platter_estimator_ = sc::input::PlatterEstimator();
+    next_input_time_ = 0.0;
 }
 
 bool TestHarness::run_assertions(const std::vector<AssertFunc>& assertions) const
@@ -380,6 +433,1940 @@ TestResult test_frequency_scaling()
     return result;
 }
 
+// Scratch back and forth and measure how far the playback position trails
+// the hand, once with the platter estimator and once with the plain
+// P-controller on raw encoder positions
+static double platter_tracking_error_ms(bool use_estimator)
+{
+    TestHarness harness;
+    harness.engine().settings->platter_estimator = use_estimator;
+
+    auto* sine = generate_sine(440.0, 48000, 96000);
+    harness.load_track(1, sine);
+
+    // Start mid-track so backward movement doesn't wrap
+    const double start = 1.0;
+    const double speed = harness.engine().settings->platter_speed;
+    harness.engine().scratch_deck.player.input.seek_to = start;
+    harness.engine().scratch_deck.player.input.position_offset = 0.0;
+
+    // Forward at 1x for 0.25s, then back at 1x for 0.25s (input-rate steps)
+    int32_t a0 = static_cast<int32_t>(start * speed);
+    int32_t a1 = a0 + static_cast<int32_t>(0.25 * speed);
+    harness.sequence().add(0.0, TouchEvent{true});
+    harness.sequence().add(0.0, AdcEvent{1, 1023});
+    harness.sequence().add_encoder_ramp(0.0, 0.25, a0, a1, 125);
+    harness.sequence().add_encoder_ramp(0.25, 0.25, a1, a0, 125);
+
+    auto hand_position = [&](double t) {
+        double forward = t < 0.25 ? t : 0.5 - t;
+        return start + forward;
+    };
+
+    // Skip the first 50ms (controller spin-up) and the turnaround
+    double sum_sq = 0.0;
+    int count = 0;
+    harness.run(0.5, [&](double t) {
+        if (t < 0.05 || std::abs(t - 0.25) < 0.05) return;
+        double err = hand_position(t) - harness.audio().get_position(1);
+        sum_sq += err * err;
+        count++;
+    });
+
+    track_release(sine);
+    return count > 0 ? std::sqrt(sum_sq / count) * 1000.0 : 0.0;
+}
+
+TestResult test_platter_tracking()
+{
+    TestResult result;
+    result.name = "Platter tracking (estimator vs P-controller)";
+
+    double legacy_ms = platter_tracking_error_ms(false);
+    double estimator_ms = platter_tracking_error_ms(true);
+
+    result.details = "RMS tracking error: P-controller " + std::to_string(legacy_ms) +
+                     " ms, estimator " + std::to_string(estimator_ms) + " ms";
+    result.passed = estimator_ms < legacy_ms;
+    return result;
+}
+
+// Byte-level parsing: running status, realtime bytes inside a message,
+// 14-bit CC pairing, NRPN assembly and relative encoder decoding
+// Bitsliced debounce: edge on the first scan, bounce locked out, release on time
+TestResult test_gpio_debounce()
+{
+    TestResult result;
+    result.name = "GPIO debounce (edge, lockout, release)";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    constexpr unsigned int LOCKOUT = 5;
+    constexpr uint32_t PIN = 1u << 3;
+    constexpr uint32_t OTHER = 1u << 17;
+    sc::platform::GpioPortDebounce db;
+
+    // A press is reported on the scan that sees it, unmasked pins never are
+    if (sc::platform::gpio_debounce_update(&db, PIN | (1u << 30), PIN | OTHER, LOCKOUT) != PIN ||
+        db.state != PIN) {
+        return fail("edge not accepted on the first scan");
+    }
+
+    // Bounce on the pin is ignored until the lockout runs out,
+    // while another pin in the same port still gets its edge at once
+    for (unsigned int tick = 1; tick < LOCKOUT; tick++) {
+        uint32_t sample = (tick & 1) ? OTHER : PIN | OTHER;
+        uint32_t changed = sc::platform::gpio_debounce_update(&db, sample, PIN | OTHER, LOCKOUT);
+        if (changed & PIN) {
+            return fail("bounce accepted " + std::to_string(tick) + " scans after the edge");
+        }
+        if (tick == 1 && changed != OTHER) {
+            return fail("other pin held back by the lockout");
+        }
+    }
+    if (!(db.state & PIN)) {
+        return fail("debounced state followed the bounce");
+    }
+
+    // Exactly lockout_ticks scans after the edge the pin is free again
+    if (sc::platform::gpio_debounce_update(&db, OTHER, PIN | OTHER, LOCKOUT) != PIN ||
+        (db.state & PIN)) {
+        return fail("release not accepted after " + std::to_string(LOCKOUT) + " scans");
+    }
+
+    // Without a lockout every change goes straight through
+    sc::platform::GpioPortDebounce raw;
+    for (int i = 0; i < 4; i++) {
+        uint32_t sample = (i & 1) ? 0 : PIN;
+        if (sc::platform::gpio_debounce_update(&raw, sample, PIN, 0) != PIN || raw.lockout) {
+            return fail("zero lockout held a change back");
+        }
+    }
+
+    result.passed = true;
+    result.details = "Edge at once, " + std::to_string(LOCKOUT - 1) +
+                     " bounce scans ignored, released on scan " + std::to_string(LOCKOUT);
+    return result;
+}
+
+TestResult test_midi_parser()
+{
+    TestResult result;
+    result.name = "MIDI parser (running status, 14-bit CC, NRPN)";
+
+    sc::input::MidiParser parser;
+    std::vector<sc::MidiEvent> events;
+    auto feed = [&](std::initializer_list<uint8_t> bytes) {
+        events.clear();
+        for (uint8_t b : bytes) {
+            sc::MidiEvent ev;
+            if (parser.feed(b, &ev)) events.push_back(ev);
+        }
+    };
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    // Running status and a clock byte in the middle of a note-on
+    feed({0xB0, 0x07, 0x40, 0x07, 0x41, 0x90, 0xF8, 0x3C, 0x64});
+    if (events.size() != 3 || events[1].value != (0x41 << 7) || events[1].high_res ||
+        events[2].bytes[0] != 0x90 || events[2].bytes[1] != 0x3C) {
+        return fail("running status / realtime byte");
+    }
+
+    // Without a high_res mapping CC 1 and CC 33 are two 7-bit knobs
+    feed({0xB1, 0x01, 0x10, 0x21, 0x05, 0x01, 0x11});
+    if (events.size() != 3 || events[1].high_res || events[1].bytes[1] != 0x21 ||
+        events[2].bytes[1] != 0x01 || events[2].value != (0x11 << 7)) {
+        return fail("7-bit CC 1/33 paired without high_res");
+    }
+
+    // Mapped as high_res, the first MSB goes out alone, from then on CC 1 waits for CC 33
+    parser.set_high_res(1, 1u << 1);
+    feed({0xB1, 0x01, 0x10, 0x21, 0x05, 0x01, 0x11, 0x21, 0x00});
+    if (events.size() != 3 || events[0].high_res ||
+        !events[1].high_res || events[1].bytes[1] != 0x01 || events[1].value != ((0x10 << 7) | 0x05) ||
+        !events[2].high_res || events[2].value != (0x11 << 7)) {
+        return fail("14-bit CC pairing");
+    }
+
+    // NRPN 0x0082 = 0x40/0x7F on channel 3, SysEx in between is skipped
+    feed({0xB2, 0x63, 0x01, 0x62, 0x02, 0xF0, 0x01, 0x02, 0xF7, 0xB2, 0x06, 0x40, 0x26, 0x7F});
+    MidiCommand nrpn = events.empty() ? MidiCommand{} : MidiCommand::from_bytes(events.back().bytes);
+    if (events.size() != 2 || !nrpn.is_nrpn() || nrpn.channel() != 2 || nrpn.nrpn_number() != 0x82 ||
+        !events.back().high_res || events.back().value != ((0x40 << 7) | 0x7F)) {
+        return fail("NRPN assembly");
+    }
+
+    // NRPNs with the same parameter LSB are mapped apart by their MSB
+    sc::control::MappingRegistry registry;
+    for (uint8_t msb : {0x00, 0x01}) {
+        Mapping m;
+        m.midi_command_bytes = {static_cast<uint8_t>(MidiCommand::NRPN | 2), 0x02, msb};
+        m.parameter = msb;
+        registry.add(m);
+    }
+    Mapping* low = registry.find_midi(MidiCommand{MidiCommand::NRPN | 2, 0x02, 0x00}, BUTTON_PRESSED);
+    Mapping* high = registry.find_midi(nrpn, BUTTON_PRESSED);
+    if (!low || low->parameter != 0x00 || !high || high->parameter != 0x01 ||
+        registry.find_midi(MidiCommand{MidiCommand::NRPN | 2, 0x02, 0x02}, BUTTON_PRESSED)) {
+        return fail("NRPN 0x0002/0x0082 mapping lookup");
+    }
+
+    if (MidiCommand::relative_delta(0x7F, MidiCommand::REL_TWOS_COMPLEMENT) != -1 ||
+        MidiCommand::relative_delta(0x03, MidiCommand::REL_TWOS_COMPLEMENT) != 3 ||
+        MidiCommand::relative_delta(0x41, MidiCommand::REL_BINARY_OFFSET) != 1 ||
+        MidiCommand::relative_delta(0x43, MidiCommand::REL_SIGN_MAGNITUDE) != -3) {
+        return fail("relative encoder decoding");
+    }
+
+    result.passed = true;
+    result.details = "All byte sequences decoded";
+    return result;
+}
+
+// Feedback diffing, coalescing, running status and the byte budget
+TestResult test_midi_feedback()
+{
+    TestResult result;
+    result.name = "MIDI feedback (diff, running status, budget)";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    sc::input::MidiFeedback feedback;
+    feedback.set_rate(1000.0);  // Bursts of 50 bytes
+    uint8_t out[256];
+
+    // Three LEDs and a ring: one status byte per status
+    feedback.set(0x90, 1, 127);
+    feedback.set(0x90, 2, 127);
+    feedback.set(0x90, 3, 127);
+    feedback.set(0xB0, 10, 64);
+    size_t n = feedback.flush(0.0, out, sizeof(out));
+    const std::vector<uint8_t> expected = {0x90, 1, 127, 2, 127, 3, 127, 0xB0, 10, 64};
+    if (std::vector<uint8_t>(out, out + n) != expected) {
+        return fail("running status encoding, " + std::to_string(n) + " bytes");
+    }
+
+    // Toggled back before the next flush: nothing goes out
+    feedback.set(0x90, 1, 0);
+    feedback.set(0x90, 1, 127);
+    feedback.set(0x90, 2, 127);
+    if (feedback.pending() != 0 || feedback.flush(0.001, out, sizeof(out)) != 0) {
+        return fail("unchanged state was resent");
+    }
+
+    // 40 LEDs = 81 bytes, more than one burst
+    for (uint8_t note = 0; note < 40; note++) {
+        feedback.set(0x91, note, 127);
+    }
+    size_t first = feedback.flush(1.0, out, sizeof(out));
+    if (first > 50 || out[0] != 0x91 || feedback.pending() == 0) {
+        return fail("burst not limited, " + std::to_string(first) + " bytes");
+    }
+    if (feedback.flush(1.001, out, sizeof(out)) != 0) {
+        return fail("sent beyond the budget");
+    }
+    size_t rest = feedback.flush(1.1, out, sizeof(out));
+    if (feedback.pending() != 0 || first + rest != 81 + 1) {
+        return fail("paced remainder, " + std::to_string(first + rest) + " bytes");
+    }
+
+    // After a failed write everything known goes out again
+    feedback.invalidate();
+    if (feedback.pending() != 44) {
+        return fail("invalidate left " + std::to_string(feedback.pending()) + " slots");
+    }
+
+    result.passed = true;
+    result.details = "Changes coalesced and paced";
+    return result;
+}
+
+// Compiled action dispatch: a macro mapping fires its steps in order on the
+// bound deck, a semitone pitch mapping resolves to its own handler
+TestResult test_action_macro()
+{
+    TestResult result;
+    result.name = "Compiled action macro";
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    ScSettings* settings = engine.settings.get();
+    settings->volume_amount = 0.1;
+
+    // Note 0x24: stop the beat deck and raise its volume three steps
+    Mapping macro{};
+    macro.type = IOType::MIDI;
+    macro.midi_command_bytes = {0x90, 0x24, 0x00};
+    macro.deck_no = 0;
+    macro.action_type = STOP;
+    macro.macro = {VOLUP, VOLUP, VOLUP};
+    engine.mappings.add(macro);
+
+    // CC 1: pitch fader over +-2 semitones on the scratch deck
+    Mapping pitch{};
+    pitch.type = IOType::MIDI;
+    pitch.midi_command_bytes = {0xB0, 0x01, 0x00};
+    pitch.deck_no = 1;
+    pitch.action_type = PITCH;
+    pitch.parameter = 2;
+    engine.mappings.add(pitch);
+
+    auto send = [&](uint8_t status, uint8_t data1, uint8_t data2) {
+        sc::MidiEvent ev;
+        ev.bytes[0] = status;
+        ev.bytes[1] = data1;
+        ev.bytes[2] = data2;
+        ev.value = static_cast<uint16_t>(data2 << 7);
+        Mapping* map = engine.mappings.find_midi(MidiCommand::from_bytes(ev.bytes), BUTTON_PRESSED);
+        const sc::control::ActionProgram* program = engine.mappings.program(map);
+        if (program == nullptr) return size_t{0};
+        sc::control::dispatch_event(map, &ev, &engine, settings, engine.input_state);
+        return program->count;
+    };
+
+    engine.beat_deck.player.input.stopped = false;
+    engine.beat_deck.player.input.volume_knob = 0.5;
+    size_t steps = send(0x90, 0x24, 0x7F);
+    if (steps != 4 || !engine.beat_deck.player.input.stopped ||
+        std::abs(engine.beat_deck.player.input.volume_knob - 0.8) > 1e-9) {
+        result.passed = false;
+        result.details = "macro ran " + std::to_string(steps) + " steps, volume " +
+                         std::to_string(engine.beat_deck.player.input.volume_knob);
+        return result;
+    }
+
+    // Full scale is one step short of +2 semitones
+    send(0xB0, 0x01, 0x7F);
+    double expected = std::pow(2.0, (127.0 * 128.0 - 8192.0) / 8192.0 * 2.0 / 12.0);
+    double actual = engine.scratch_deck.player.input.pitch_fader;
+    if (std::abs(actual - expected) > 1e-9 || engine.beat_deck.player.input.pitch_fader != 1.0) {
+        result.passed = false;
+        result.details = "pitch " + std::to_string(actual) + ", expected " + std::to_string(expected);
+        return result;
+    }
+
+    result.passed = true;
+    result.details = "4 steps fired, pitch " + std::to_string(actual);
+    return result;
+}
+
+// Reload settings and mappings from a file into a new snapshot; the old one
+// is freed only after the audio thread reports a finished block
+TestResult test_settings_reload()
+{
+    TestResult result;
+    result.name = "Settings hot reload";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    char path[] = "/tmp/sc1000-settings-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        return fail("cannot create settings file");
+    }
+    close(fd);
+
+    std::ofstream(path) << R"({
+        "sc1000": { "slippiness": 321, "period_size": 1024 },
+        "midi_mapping": [
+            { "type": "midi_note_on", "channel": 0, "parameter1": 36, "parameter2": 0,
+              "shifted": false, "deck": "beats", "action": ["stop", "cue"] },
+            { "type": "midi_note_on", "channel": 0, "parameter1": 37, "parameter2": 0,
+              "shifted": false, "deck": "beats", "action": ["loop_roll", "start_stop"] }
+        ]
+    })";
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    engine.settings->settings_path = path;
+    const ScSettings* before = engine.settings.get();
+    unsigned int period_size = before->period_size;
+
+    bool reloaded = engine.reload_settings();
+    const ScSettings* after = engine.settings.get();
+    const uint8_t note_on[3] = {0x90, 36, 0x7F};
+    MidiCommand note = MidiCommand::from_bytes(note_on);
+    const Mapping* map = engine.mappings.find_midi(note, BUTTON_PRESSED);
+    const sc::control::ActionProgram* program = engine.mappings.program(map);
+    const uint8_t roll_off[3] = {0x80, 37, 0};
+    const Mapping* release = engine.mappings.find_midi(MidiCommand::from_bytes(roll_off), BUTTON_PRESSED);
+    const sc::control::ActionProgram* release_program = engine.mappings.program(release);
+
+    std::ofstream(path) << "{ \"sc1000\": { ";
+    bool broken_kept = !engine.reload_settings() && engine.settings.get() == after;
+    unlink(path);
+
+    if (!reloaded || after == before || after->slippiness != 321) {
+        return fail("new snapshot not published");
+    }
+    if (after->period_size != period_size || after->settings_path != path) {
+        return fail("boot-time settings replaced");
+    }
+    if (program == nullptr || program->count != 2 || engine.mappings.size() != 3) {
+        return fail("mappings not rebuilt");
+    }
+    // The roll's note-off lets go of the roll without toggling playback again
+    if (release_program == nullptr || release_program->count != 1) {
+        return fail("note-off repeats the macro");
+    }
+    if (!broken_kept) {
+        return fail("invalid file replaced the settings");
+    }
+
+    // Retired until a block has ended since the swap
+    engine.settings.reclaim();
+    size_t held = engine.settings.retired();
+    engine.settings.quiescent();
+    engine.settings.reclaim();
+    if (held != 1 || engine.settings.retired() != 0) {
+        return fail("reclaimed " + std::to_string(held) + " -> " +
+                    std::to_string(engine.settings.retired()));
+    }
+
+    result.passed = true;
+    result.details = "Snapshot swapped, old one freed after a block";
+    return result;
+}
+
+// Capture input runs into the always-on ring without recording; grabbing
+// makes the last half second the scratch deck's loop, pointing into the ring
+TestResult test_capture_grab()
+{
+    TestResult result;
+    result.name = "Grab recent input as loop";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    harness.audio().init_capture_ring(2);
+    harness.audio().enable_capture(true);
+
+    // Each frame carries its own index, so the span can be checked exactly
+    const int frames = 48000;
+    std::vector<float> input(2 * frames);
+    for (int i = 0; i < frames; i++) {
+        input[2 * i] = static_cast<float>(i % 20000) / 32767.0f;
+        input[2 * i + 1] = -input[2 * i];
+    }
+    harness.audio().set_capture_input(input);
+    harness.run(1.0);
+
+    if (engine.audio->is_recording(1) || engine.audio->has_loop(1)) {
+        return fail("ring wrote into the loop buffer");
+    }
+
+    auto& in = engine.scratch_deck.player.input;
+    in.grab_seconds = 0.5;
+    engine.handle_deck_recording();
+
+    Track* loop = engine.audio->peek_loop_track(1);
+    if (!engine.audio->has_loop(1) || in.source != sc::PlaybackSource::Loop || loop->length != 24000) {
+        return fail("no 24000 frame loop after grab");
+    }
+
+    for (int s : {0, 4321, 23999}) {
+        int expected = (frames - 24000 + s) % 20000;
+        const signed short* pcm = loop->get_sample(s);
+        if (std::abs(pcm[0] - expected) > 1 || std::abs(pcm[1] + expected) > 1) {
+            return fail("frame " + std::to_string(s) + " is " + std::to_string(pcm[0]) +
+                        ", expected " + std::to_string(expected));
+        }
+    }
+
+    // Nothing captured since the grab
+    in.grab_seconds = 0.0;
+    engine.handle_deck_recording();
+    if (in.beep_request != sc::BeepType::RecordingError || engine.audio->peek_loop_track(1) != loop) {
+        return fail("empty grab replaced the loop");
+    }
+
+    // Each grab drops the last one, whose buffer is free again once collected
+    for (int i = 0; i < 4; i++) {
+        harness.audio().set_capture_input(input);
+        harness.run(0.1);
+        in.grab_seconds = 0.05;
+        engine.handle_deck_recording();
+        engine.audio->collect_loops();
+        if (in.beep_request != sc::BeepType::RecordingStop || engine.audio->peek_loop_track(1) == loop) {
+            return fail("grab " + std::to_string(i + 2) + " found no free buffer");
+        }
+        loop = engine.audio->peek_loop_track(1);
+    }
+
+    result.passed = true;
+    result.details = "0.5 s grabbed without recording, buffers reused";
+    return result;
+}
+
+// Record both decks at once, the scratch deck from the swapped channel pair,
+// then overdub a quarter second onto the beat deck loop at feedback 0.5
+TestResult test_loop_overdub()
+{
+    TestResult result;
+    result.name = "Dual-deck recording and overdub";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    ScSettings* settings = engine.settings.get();
+    harness.audio().enable_capture(true);
+    harness.audio().set_scratch_capture_pair(1, 0);
+
+    std::vector<float> input(2 * 96000);
+    for (size_t i = 0; i < input.size(); i += 2) {
+        input[i] = 0.2f;
+        input[i + 1] = 0.4f;
+    }
+    harness.audio().set_capture_input(input);
+
+    if (!engine.audio->start_recording(0, 0.0) || !engine.audio->start_recording(1, 0.0)) {
+        return fail("second deck could not start recording");
+    }
+    harness.run(0.5);
+    engine.audio->stop_recording(0);
+    engine.audio->stop_recording(1);
+
+    Track* beat = engine.audio->peek_loop_track(0);
+    Track* scratch = engine.audio->peek_loop_track(1);
+    auto level = [](Track* t, int s, int channel) {
+        return static_cast<double>(t->get_sample(s)[channel]) / 32767.0;
+    };
+    auto near = [](double a, double b) { return std::abs(a - b) < 1e-3; };
+
+    if (!engine.audio->has_loop(0) || !engine.audio->has_loop(1) || beat->length != scratch->length) {
+        return fail("decks did not both record");
+    }
+    if (!near(level(beat, 100, 0), 0.2) || !near(level(beat, 100, 1), 0.4) ||
+        !near(level(scratch, 100, 0), 0.4) || !near(level(scratch, 100, 1), 0.2)) {
+        return fail("decks did not record their own channel pairs");
+    }
+
+    // Sound-on-sound: old layer at half level plus the new input
+    settings->loop_overdub = true;
+    settings->loop_feedback = 0.5;
+    engine.audio->start_recording(0, 0.0);
+    harness.run(0.25);
+    engine.audio->stop_recording(0);
+
+    double layered = level(beat, 1000, 0);
+    double untouched = level(beat, beat->length - 100, 0);
+    if (!near(layered, 0.3) || !near(level(beat, 1000, 1), 0.6) || !near(untouched, 0.2)) {
+        return fail("overdub gave " + std::to_string(layered) + ", untouched " + std::to_string(untouched));
+    }
+
+    result.passed = true;
+    result.details = "Both decks recorded, overdub layer " + std::to_string(layered);
+    return result;
+}
+
+// Save the beat deck loop through the save_loop action and punch in over it
+// while the writer runs; the file keeps the loop as it was at the save
+TestResult test_loop_save()
+{
+    TestResult result;
+    result.name = "Save loop to WAV";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    char base[] = "/tmp/sc1000-beats-XXXXXX";
+    if (mkdtemp(base) == nullptr) {
+        return fail("cannot create beats folder");
+    }
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    engine.beat_deck.load_folder(base);
+    engine.loop_writer.start();
+    harness.audio().enable_capture(true);
+
+    auto constant_input = [&](float level) {
+        harness.audio().set_capture_input(std::vector<float>(2 * 48000, level));
+    };
+
+    constant_input(0.25f);
+    engine.audio->start_recording(0, 0.0);
+    harness.run(0.5);
+    engine.audio->stop_recording(0);
+    unsigned int frames = engine.audio->peek_loop_track(0)->length;
+    unsigned int refs = engine.audio->peek_loop_track(0)->refcount;
+
+    Mapping save{};
+    save.type = IOType::MIDI;
+    save.midi_command_bytes = {0x90, 0x30, 0x00};
+    save.action_type = SAVELOOP;
+    engine.mappings.add(save);
+    const uint8_t note_on[3] = {0x90, 0x30, 0x7F};
+    sc::MidiEvent ev;
+    std::copy(note_on, note_on + 3, ev.bytes);
+    Mapping* map = engine.mappings.find_midi(MidiCommand::from_bytes(note_on), BUTTON_PRESSED);
+    sc::control::dispatch_event(map, &ev, &engine, engine.settings.get(), engine.input_state);
+    engine.handle_deck_recording();
+
+    // Overwrite the whole loop right away
+    constant_input(-0.5f);
+    engine.audio->start_recording(0, 0.0);
+    harness.run(0.6);
+    engine.audio->stop_recording(0);
+
+    for (int i = 0; i < 500 && engine.loop_writer.pending() > 0; i++) {
+        harness.run(0.01);
+        usleep(1000);
+    }
+    engine.loop_writer.stop();
+    engine.collect_saved_loops();
+
+    std::string folder = std::string(base) + "/loops";
+    ScFile* file = engine.beat_deck.playlist->get_file(0, 0);
+    std::string path = file ? file->full_path : "";
+    std::vector<char> wav;
+    if (file) {
+        std::ifstream in(path, std::ios::binary);
+        wav.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    unlink(path.c_str());
+    rmdir(folder.c_str());
+    rmdir(base);
+
+    if (!file || path.compare(0, folder.size(), folder) != 0 || !engine.beat_deck.nav_state.files_present) {
+        return fail("saved loop not in the playlist");
+    }
+    if (wav.size() != 44 + 4 * static_cast<size_t>(frames) || std::string(wav.data(), 4) != "RIFF") {
+        return fail("file has " + std::to_string(wav.size()) + " bytes for " + std::to_string(frames) + " frames");
+    }
+
+    const auto* pcm = reinterpret_cast<const int16_t*>(wav.data() + 44);
+    const int16_t level = static_cast<int16_t>(0.25f * 32767.0f);
+    for (size_t i = 0; i < 2 * static_cast<size_t>(frames); i++) {
+        if (pcm[i] != level) {
+            return fail("sample " + std::to_string(i) + " is " + std::to_string(pcm[i]));
+        }
+    }
+    if (engine.audio->peek_loop_track(0)->get_sample(0)[0] != static_cast<int16_t>(-0.5f * 32767.0f)) {
+        return fail("punch-in did not reach the loop");
+    }
+    if (engine.audio->peek_loop_track(0)->refcount != refs) {
+        return fail("save kept a reference to the loop");
+    }
+
+    result.passed = true;
+    result.details = std::to_string(frames) + " frames saved, punch-in kept out";
+    return result;
+}
+
+// With a pool of one block, a deck only gets to record once the other
+// deck's loop is erased
+TestResult test_loop_pool()
+{
+    TestResult result;
+    result.name = "Shared loop pool";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    harness.audio().init_loop_buffers(40, 40);
+    harness.audio().enable_capture(true);
+    harness.audio().set_capture_input(std::vector<float>(2 * 4 * 48000, 0.25f));
+
+    auto record = [&](int deck) {
+        engine.audio->start_recording(deck, 0.0);
+        harness.run(0.5);
+        engine.audio->stop_recording(deck);
+        return engine.audio->has_loop(deck);
+    };
+
+    if (!record(0)) {
+        return fail("beat deck could not record");
+    }
+    if (record(1)) {
+        return fail("scratch deck recorded with the pool used up");
+    }
+
+    // Erased on the audio thread, at the start of the next block
+    engine.beat_deck.player.input.loop_erase = true;
+    harness.run(0.01);
+    if (engine.beat_deck.player.input.loop_erase || engine.audio->has_loop(0)) {
+        return fail("erase request not applied");
+    }
+    if (!record(1)) {
+        return fail("erased loop did not free its storage");
+    }
+    if (engine.audio->peek_loop_track(1)->get_sample(100)[0] != static_cast<int16_t>(0.25f * 32767.0f)) {
+        return fail("scratch deck recorded wrong audio");
+    }
+
+    result.passed = true;
+    result.details = "Block passed from beat to scratch deck";
+    return result;
+}
+
+// Record the output mix with the input pair alongside, rendering faster
+// than real time so the ring has to hold what the writer has not got to
+TestResult test_master_record()
+{
+    TestResult result;
+    result.name = "Master recording to WAV";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    char folder[] = "/tmp/sc1000-recordings-XXXXXX";
+    if (mkdtemp(folder) == nullptr) {
+        return fail("cannot create recordings folder");
+    }
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    engine.master_recorder.init(48000, 1);
+    harness.audio().enable_capture(true);
+    harness.audio().set_capture_input(std::vector<float>(2 * 48000, 0.25f));
+
+    auto* sine = generate_sine(440.0, 48000, 96000);
+    harness.load_track(0, sine);
+    engine.beat_deck.player.input.volume_knob = 1.0;
+    harness.sequence().add(0.0, AdcEvent{0, 1023});
+    harness.run(0.1);
+
+    engine.master_recorder.start(folder, 48000, true);
+    for (int i = 0; i < 500 && !engine.master_recorder.stats().recording; i++) {
+        usleep(1000);
+    }
+    double start = harness.audio().render_time();
+    harness.run(0.5);
+    auto frames = static_cast<size_t>((harness.audio().render_time() - start) * 48000.0 + 0.5);
+    sc::audio::MasterRecorder::Stats stats = engine.master_recorder.stats();
+    engine.master_recorder.stop();
+    engine.master_recorder.shutdown();
+
+    std::string path;
+    std::vector<char> wav;
+    if (DIR* dir = opendir(folder)) {
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') path = std::string(folder) + "/" + entry->d_name;
+        }
+        closedir(dir);
+    }
+    if (!path.empty()) {
+        std::ifstream in(path, std::ios::binary);
+        wav.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        unlink(path.c_str());
+    }
+    rmdir(folder);
+
+    if (!stats.recording || stats.dropped_blocks != 0) {
+        return fail("recorder did not take every period");
+    }
+    if (wav.size() != 44 + 8 * frames || std::string(wav.data(), 4) != "RIFF" || wav[22] != 4) {
+        return fail("file has " + std::to_string(wav.size()) + " bytes for " + std::to_string(frames) + " frames");
+    }
+
+    const auto* pcm = reinterpret_cast<const int16_t*>(wav.data() + 44);
+    const int16_t level = static_cast<int16_t>(0.25f * 32767.0f);
+    int16_t peak = 0;
+    for (size_t i = 0; i < frames; i++) {
+        if (pcm[4 * i + 2] != level || pcm[4 * i + 3] != level) {
+            return fail("input sample " + std::to_string(i) + " is " + std::to_string(pcm[4 * i + 2]));
+        }
+        peak = std::max<int16_t>(peak, static_cast<int16_t>(std::abs(pcm[4 * i])));
+    }
+    if (peak < 1000) {
+        return fail("output pair is silent");
+    }
+
+    result.passed = true;
+    result.details = std::to_string(frames) + " frames, ring peak " +
+                     std::to_string(static_cast<int>(stats.fill_peak * 100.0)) + "%";
+    return result;
+}
+
+// Measure a 700 frame loopback, then check a fresh recording starts and
+// stops that much later in the input and a punch-in lands that much earlier
+TestResult test_latency_calibration()
+{
+    TestResult result;
+    result.name = "Latency calibration and alignment";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    constexpr unsigned long LOOPBACK = 700;
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    harness.audio().enable_capture(true);
+    harness.audio().set_capture_loopback(LOOPBACK);
+
+    engine.beat_deck.player.input.calibrate_latency = true;
+    engine.handle_deck_recording();
+    harness.run(3.5);
+    engine.check_latency_calibration();
+
+    sc::audio::LatencyCalibration cal = engine.audio->latency_calibration();
+    if (cal.state != sc::audio::LatencyCalibration::State::Done || cal.frames != static_cast<int>(LOOPBACK)) {
+        return fail("measured " + std::to_string(cal.frames) + " frames");
+    }
+    if (engine.latency_runs != 1) {
+        return fail("result not reported");
+    }
+
+    // Input numbered by frame, so the recording shows where it started
+    harness.audio().set_capture_loopback(0);
+    std::vector<float> input(2 * 48000);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = static_cast<float>(i / 2) / 65536.0f;
+    }
+    harness.audio().set_capture_input(input);
+
+    engine.audio->start_recording(0, 0.0);
+    harness.run(0.25);
+    engine.audio->stop_recording(0);
+    harness.run(0.05);
+
+    Track* loop = engine.audio->peek_loop_track(0);
+    if (!engine.audio->has_loop(0) || loop->length != 12000) {
+        return fail("loop is " + std::to_string(loop->length) + " frames, not 12000");
+    }
+    if (loop->get_sample(0)[0] != float_to_s16(input[2 * LOOPBACK])) {
+        return fail("loop does not start latency frames into the input");
+    }
+
+    // Punch in at 0.2 s with a constant level
+    harness.audio().set_capture_input(std::vector<float>(2 * 48000, -0.5f));
+    engine.audio->start_recording(0, 0.2);
+    harness.run(0.01);
+    engine.audio->stop_recording(0);
+    harness.run(0.05);
+
+    const unsigned int at = 9600 - LOOPBACK;
+    const int16_t level = float_to_s16(-0.5f);
+    if (loop->get_sample(at)[0] != level || loop->get_sample(at - 1)[0] == level ||
+        loop->get_sample(at + 480 + LOOPBACK - 1)[0] != level || loop->get_sample(at + 480 + LOOPBACK)[0] == level) {
+        return fail("punch-in not moved back by the latency");
+    }
+
+    result.passed = true;
+    result.details = std::to_string(cal.frames) + " frames measured and applied";
+    return result;
+}
+
+// Quantized at 120 BPM: the first loop starts the grid and closes on a whole
+// beat with its overhang crossfaded in, a recording on the other deck waits
+// for the next beat, and a loop roll repeats a sixteenth until let go
+TestResult test_loop_quantize()
+{
+    TestResult result;
+    result.name = "Beat-quantized recording and loop roll";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    // Without loop_bpm the first loop sets the tempo: 0.1 s is a quarter
+    // beat at 150 BPM, 3 s four beats at 80 BPM
+    sc::audio::TempoGrid tempo;
+    tempo.set_from_loop(4800, 48000);
+    const double short_loop = tempo.beat_frames();
+    tempo.set_from_loop(144000, 48000);
+    if (short_loop != 19200.0 || tempo.beat_frames() != 36000.0) {
+        return fail("loop tempo beats of " + std::to_string(short_loop) + " and " +
+                    std::to_string(tempo.beat_frames()) + " frames");
+    }
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    ScSettings* settings = engine.settings.get();
+    settings->loop_quantize = true;
+    settings->loop_bpm = 120.0;
+    settings->loop_crossfade_ms = 4.0;
+    harness.audio().enable_capture(true);
+
+    // Input numbered by frame, so a loop shows where it started
+    std::vector<float> input(2 * 240000);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = static_cast<float>(i / 2) / 262144.0f;
+    }
+    harness.audio().set_capture_input(input);
+    auto now = [&]() { return static_cast<size_t>(harness.audio().render_time() * 48000.0 + 0.5); };
+    auto heard = [&](size_t frame) { return float_to_s16(input[2 * frame]); };
+
+    constexpr unsigned int BEAT = 24000;
+    constexpr unsigned int FADE = 192;
+
+    harness.run(0.01);
+    const size_t grid = now();
+    engine.audio->start_recording(0, 0.0);
+    harness.run(0.7);
+    engine.audio->stop_recording(0);
+    harness.run(0.5);
+
+    Track* beat = engine.audio->peek_loop_track(0);
+    if (!engine.audio->has_loop(0) || beat->length != 2 * BEAT) {
+        return fail("first loop is " + std::to_string(beat->length) + " frames, not two beats");
+    }
+    if (beat->get_sample(FADE)[0] != heard(grid + FADE) || beat->get_sample(1000)[0] != heard(grid + 1000)) {
+        return fail("first loop does not start where it was pressed");
+    }
+    const float g = 0.5f / FADE;
+    if (std::abs(beat->get_sample(0)[0] - (heard(grid) * g + heard(grid + 2 * BEAT) * (1.0f - g))) > 1.0f) {
+        return fail("loop end not crossfaded into its start");
+    }
+
+    // Pressed off the grid, recorded from the next beat for one beat
+    const size_t pressed = now();
+    const size_t next = grid + (pressed - grid + BEAT - 1) / BEAT * BEAT;
+    engine.audio->start_recording(1, 0.0);
+    harness.run(0.3);
+    engine.audio->stop_recording(1);
+    harness.run(0.6);
+
+    Track* scratch = engine.audio->peek_loop_track(1);
+    if (!engine.audio->has_loop(1) || scratch->length != BEAT) {
+        return fail("second loop is " + std::to_string(scratch->length) + " frames, not one beat");
+    }
+    if (scratch->get_sample(1000)[0] != heard(next + 1000)) {
+        return fail("second loop did not start on the beat");
+    }
+
+    // Roll a sixteenth of a 10 s track playing at 1x, then let go
+    auto* sine = generate_sine(440.0, 48000, 480000);
+    harness.load_track(0, sine);
+    harness.run(0.3);
+
+    sc::DeckInput& in = engine.beat_deck.player.input;
+    const double from = engine.audio->get_position(0);
+    const double started = harness.audio().render_time();
+    in.roll_beats = 0.25;
+
+    double low = 1e9, high = -1e9;
+    harness.run(0.1);
+    harness.run(0.5, [&](double) {
+        low = std::min(low, engine.audio->get_position(0));
+        high = std::max(high, engine.audio->get_position(0));
+    });
+    in.roll_beats = 0.0;
+    harness.run(0.1);
+
+    const double slice = 0.125;
+    if (high - low > slice + 0.01 || high - low < slice - 0.02 || low < from) {
+        return fail("roll played " + std::to_string(low) + " to " + std::to_string(high));
+    }
+    const double expected = from + (harness.audio().render_time() - started);
+    const double slip = engine.audio->get_position(0) - expected;
+    if (std::abs(slip) > 0.001) {
+        return fail("released " + std::to_string(slip) + " s off where the track would be");
+    }
+
+    track_release(sine);
+    result.passed = true;
+    result.details = "Loops of 2 and 1 beats on the grid, roll slipped " + std::to_string(slip) + " s";
+    return result;
+}
+
+// Pads play cue slices of the beat deck's track as one-shot voices over the
+// muted decks; past the voice count, and past the time budget, the oldest
+// voices are stolen, and collect() gives every track reference back
+TestResult test_sampler()
+{
+    TestResult result;
+    result.name = "One-shot sampler voices";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    ScSettings* settings = engine.settings.get();
+    settings->sampler_voices = 2;
+    settings->sampler_volume = 1.0;
+    settings->sampler_budget_percent = 100.0;
+
+    auto* sine = generate_sine(440.0, 48000, 96000);
+    harness.load_track(0, sine);
+    engine.beat_deck.player.input.volume_knob = 0.0;
+    const unsigned int refs = sine->refcount;
+
+    // Pad on note 0x24 plays from its cue at 0.5 s to the next one at 0.75 s
+    engine.beat_deck.cues.set(0x24, 0.5);
+    engine.beat_deck.cues.set(0x25, 0.75);
+    Mapping pad{};
+    pad.type = IOType::MIDI;
+    pad.midi_command_bytes = {0x90, 0x24, 0x00};
+    pad.action_type = ONESHOT;
+    engine.mappings.add(pad);
+
+    auto hit = [&](uint8_t velocity) {
+        const uint8_t note_on[3] = {0x90, 0x24, velocity};
+        sc::MidiEvent ev;
+        std::copy(note_on, note_on + 3, ev.bytes);
+        Mapping* map = engine.mappings.find_midi(MidiCommand::from_bytes(note_on), BUTTON_PRESSED);
+        sc::control::dispatch_event(map, &ev, &engine, settings, engine.input_state);
+    };
+
+    harness.run(0.1);
+    const size_t from = harness.output_left().size();
+    hit(127);
+    harness.run(0.5);
+
+    std::vector<float> left = harness.output_left();
+    std::vector<float> slice(left.begin() + from, left.begin() + from + 11904);
+    std::vector<float> after(left.begin() + from + 12100, left.end());
+    if (calculate_rms(slice) < 0.2 || calculate_rms(after) > 1e-6) {
+        return fail("slice RMS " + std::to_string(calculate_rms(slice)) +
+                    ", after " + std::to_string(calculate_rms(after)));
+    }
+    if (std::abs(find_peak_frequency(slice, 48000, 100, 1000) - 440.0) > 20.0) {
+        return fail("slice not played at 1x");
+    }
+
+    // Three hits on two voices: the first is stolen
+    hit(100);
+    hit(100);
+    hit(100);
+    harness.run(0.01);
+    if (engine.sampler.voices() != 2) {
+        return fail(std::to_string(engine.sampler.voices()) + " voices, not 2");
+    }
+
+    // No time to spare: one voice fewer each block, down to one
+    settings->sampler_budget_percent = 0.0;
+    harness.run(0.03);
+    if (engine.sampler.voices() != 1 || engine.sampler.limit() != 1) {
+        return fail("budget left " + std::to_string(engine.sampler.voices()) + " voices");
+    }
+
+    harness.run(0.3);
+    engine.sampler.collect();
+    if (engine.sampler.voices() != 0 || sine->refcount != refs) {
+        return fail("track references not given back");
+    }
+
+    // A pitched pad an octave above middle C; the explicit mapping keeps
+    // its parameter2 in the parameter field, the pitch comes from the note
+    {
+        TestHarness keys;
+        Sc1000& engine2 = keys.engine();
+        ScSettings* settings2 = engine2.settings.get();
+        settings2->sampler_volume = 1.0;
+        settings2->sampler_budget_percent = 100.0;
+
+        auto* tone = generate_sine(440.0, 48000, 96000);
+        keys.load_track(0, tone);
+        engine2.beat_deck.player.input.volume_knob = 0.0;
+
+        Mapping key{};
+        key.type = IOType::MIDI;
+        key.midi_command_bytes = {0x90, 0x48, 0x00};
+        key.action_type = ONESHOTNOTE;
+        key.parameter = 5;
+        engine2.mappings.add(key);
+
+        const uint8_t note_on[3] = {0x90, 0x48, 127};
+        sc::MidiEvent ev;
+        std::copy(note_on, note_on + 3, ev.bytes);
+        Mapping* map = engine2.mappings.find_midi(MidiCommand::from_bytes(note_on), BUTTON_PRESSED);
+        keys.run(0.1);
+        const size_t start = keys.output_left().size();
+        sc::control::dispatch_event(map, &ev, &engine2, settings2, engine2.input_state);
+        keys.run(0.3);
+
+        std::vector<float> out = keys.output_left();
+        std::vector<float> voice(out.begin() + start, out.end());
+        double peak = find_peak_frequency(voice, 48000, 100, 2000);
+        if (std::abs(peak - 880.0) > 20.0) {
+            return fail("one-shot note played at " + std::to_string(peak) + " Hz, not 880");
+        }
+    }
+
+    result.passed = true;
+    result.details = "Cue slice played, voices stolen by count and budget";
+    return result;
+}
+
+// A beat repeat of a 32nd note at 130 BPM, a period of 2769.23 frames:
+// every retrigger lands on its grid line to the frame and plays the same
+// audio again, and letting go slips back to where the track would be
+TestResult test_stutter()
+{
+    TestResult result;
+    result.name = "Beat repeat retriggers on the frame";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    ScSettings* settings = engine.settings.get();
+    settings->loop_bpm = 130.0;
+
+    // Rising one step a frame on the left, so a jump back shows as a drop,
+    // over a constant right to read the level from
+    std::vector<float> ramp(2 * 32000);
+    for (size_t i = 0; i < ramp.size() / 2; i++) {
+        ramp[2 * i] = static_cast<float>(i) / 32767.0f;
+        ramp[2 * i + 1] = 0.5f;
+    }
+    auto* track = generate_from_buffer(ramp, 48000);
+    harness.load_track(0, track);
+    harness.run(0.2);
+
+    sc::DeckInput& in = engine.beat_deck.player.input;
+    const double from = engine.audio->get_position(0);
+    const double started = harness.audio().render_time();
+    const size_t pressed = harness.output_left().size();
+    in.stutter_beats = 0.125;
+    harness.run(0.3);
+    const size_t released = harness.output_left().size();
+    in.stutter_beats = 0.0;
+    harness.run(0.1);
+
+    // Held from the next grid line on, retriggering each period after it
+    const double period = 60.0 * 48000 / 130.0 / 8.0;
+    const double engaged = std::ceil(pressed / period) * period;
+    const auto retriggers = static_cast<size_t>((released - engaged) / period);
+
+    // First frame of each drop: the declick starts a frame after the jump
+    std::vector<float> left = harness.output_left();
+    std::vector<float> right = harness.output_right();
+    auto played = [&](size_t frame) { return left[frame] / right[frame] * 16383.0f; };
+    std::vector<size_t> jumps;
+    for (size_t i = pressed + 1; i < left.size(); i++) {
+        if (left[i] < left[i - 1] && left[i - 1] >= left[i - 2]) jumps.push_back(i - 1);
+    }
+    if (jumps.size() != retriggers) {
+        return fail(std::to_string(jumps.size()) + " jumps, not " + std::to_string(retriggers));
+    }
+
+    for (size_t jump : jumps) {
+        double off = std::fmod(static_cast<double>(jump), period);
+        if (std::min(off, period - off) > 1.0) {
+            return fail("retrigger at frame " + std::to_string(jump) + " is " + std::to_string(off) +
+                        " frames off the grid");
+        }
+        if (std::abs(played(jump + 40) - played(jumps[0] + 40)) > 0.1f) {
+            return fail("retrigger at frame " + std::to_string(jump) + " did not jump back to the start");
+        }
+    }
+
+    const double expected = from + (harness.audio().render_time() - started);
+    const double slip = engine.audio->get_position(0) - expected;
+    if (std::abs(slip) > 0.001) {
+        return fail("released " + std::to_string(slip) + " s off where the track would be");
+    }
+
+    track_release(track);
+    result.passed = true;
+    result.details = std::to_string(jumps.size()) + " retriggers on the grid, slipped " +
+                     std::to_string(slip) + " s";
+    return result;
+}
+
+// Index a beats folder, load it again from the index alone, then add a
+// file to one folder and damage the index: only what changed is rescanned
+TestResult test_playlist_index()
+{
+    TestResult result;
+    result.name = "Playlist index rescans changed folders";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    char base[] = "/tmp/sc1000-index-XXXXXX";
+    if (mkdtemp(base) == nullptr) {
+        return fail("cannot create beats folder");
+    }
+    const std::string root = base;
+    const std::string index = PlaylistIndex::path_for(root);
+    const char* files[] = {"a/1.wav", "a/2.mp3", "a/2.mp3.cue", "a/.hidden", "b/3.wav"};
+
+    // Dated back, well clear of the time the index is written
+    auto age = [](const std::string& path, int seconds) {
+        struct timespec times[2];
+        clock_gettime(CLOCK_REALTIME, &times[0]);
+        times[0].tv_sec -= seconds;
+        times[1] = times[0];
+        utimensat(AT_FDCWD, path.c_str(), times, 0);
+    };
+    for (const char* folder : {"/a", "/b", "/empty"}) {
+        mkdir((root + folder).c_str(), 0755);
+    }
+    for (const char* file : files) {
+        std::ofstream(root + "/" + file).put('x');
+    }
+    for (const char* folder : {"/a", "/b", "/empty", ""}) {
+        age(root + folder, 3600);
+    }
+
+    auto cleanup = [&]() {
+        for (const char* file : files) {
+            unlink((root + "/" + file).c_str());
+        }
+        unlink((root + "/empty/4.wav").c_str());
+        for (const char* folder : {"/a", "/b", "/empty", ""}) {
+            rmdir((root + folder).c_str());
+        }
+        unlink(index.c_str());
+    };
+
+    Playlist first;
+    first.load(base);
+    if (first.total_files() != 3 || first.rescanned() != 3 || access(index.c_str(), R_OK) != 0) {
+        cleanup();
+        return fail("first load found " + std::to_string(first.total_files()) + " files");
+    }
+
+    Playlist second;
+    second.load(base);
+    if (second.rescanned() != 0 || second.total_files() != 3 || second.folder_count() != 2 ||
+        second.get_file(0, 1)->full_path != root + "/a/2.mp3" ||
+        second.get_file_at_index(2)->full_path != root + "/b/3.wav") {
+        cleanup();
+        return fail("index load rescanned " + std::to_string(second.rescanned()) + " folders");
+    }
+
+    std::ofstream(root + "/empty/4.wav").put('x');
+    age(root + "/empty", 1800);
+    Playlist third;
+    third.load(base);
+    if (third.rescanned() != 1 || third.total_files() != 4 || third.folder_count() != 3) {
+        cleanup();
+        return fail("changed folder: " + std::to_string(third.rescanned()) + " rescanned");
+    }
+
+    truncate(index.c_str(), 40);
+    Playlist fourth;
+    fourth.load(base);
+    const size_t rescanned = fourth.rescanned();
+    const size_t total = fourth.total_files();
+
+    // A folder count past what the file could hold, after magic and version
+    {
+        std::fstream patch(index, std::ios::in | std::ios::out | std::ios::binary);
+        const uint32_t count = 0xFFFFFFFF;
+        patch.seekp(8);
+        patch.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+    Playlist fifth;
+    fifth.load(base);
+    const size_t recounted = fifth.rescanned();
+
+    // A rebuild and a background listing writing the index at once: each
+    // has a temporary of its own and the later rename wins
+    std::string tmp_a, tmp_b;
+    int a = sc::audio::replace_open(index, &tmp_a);
+    int b = sc::audio::replace_open(index, &tmp_b);
+    bool both = a != -1 && b != -1 && tmp_a != tmp_b &&
+                sc::audio::write_all(a, "a", 1) && sc::audio::write_all(b, "b", 1) &&
+                sc::audio::replace_commit(b, tmp_b, index) &&
+                sc::audio::replace_commit(a, tmp_a, index);
+    std::string last;
+    std::getline(std::ifstream(index), last);
+    cleanup();
+    if (rescanned != 3 || total != 4) {
+        return fail("damaged index: " + std::to_string(rescanned) + " rescanned");
+    }
+    if (recounted != 3 || fifth.total_files() != 4) {
+        return fail("impossible folder count: " + std::to_string(recounted) + " rescanned");
+    }
+    if (!both || last != "a" || access(tmp_a.c_str(), F_OK) == 0 || access(tmp_b.c_str(), F_OK) == 0) {
+        return fail("overlapping index writes clobbered each other");
+    }
+
+    result.passed = true;
+    result.details = "Unchanged load read the index only, one folder rescanned after a change";
+    return result;
+}
+
+// List a tree on worker threads and take its folders in order as they come,
+// then check it against a plain load that reads the index written back
+TestResult test_folder_indexer()
+{
+    TestResult result;
+    result.name = "Background folder listing";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    char base[] = "/tmp/sc1000-indexer-XXXXXX";
+    if (mkdtemp(base) == nullptr) {
+        return fail("cannot create beats folder");
+    }
+    const std::string root = base;
+    const std::string index = PlaylistIndex::path_for(root);
+    const char* folders[] = {"/a", "/b", "/c", "/d", "/e", "/f"};
+
+    auto age = [](const std::string& path) {
+        struct timespec times[2];
+        clock_gettime(CLOCK_REALTIME, &times[0]);
+        times[0].tv_sec -= 3600;
+        times[1] = times[0];
+        utimensat(AT_FDCWD, path.c_str(), times, 0);
+    };
+    for (const char* folder : folders) {
+        mkdir((root + folder).c_str(), 0755);
+        for (const char* file : {"/1.wav", "/2.wav"}) {
+            std::ofstream(root + folder + file).put('x');
+        }
+        age(root + folder);
+    }
+    age(root);
+
+    auto cleanup = [&]() {
+        for (const char* folder : folders) {
+            for (const char* file : {"/1.wav", "/2.wav"}) {
+                unlink((root + folder + file).c_str());
+            }
+            rmdir((root + folder).c_str());
+        }
+        rmdir(root.c_str());
+        unlink(index.c_str());
+    };
+
+    auto paths = [](Playlist& playlist) {
+        std::vector<std::string> out;
+        for (size_t i = 0; i < playlist.total_files(); i++) {
+            out.push_back(playlist.get_file_at_index(i)->full_path);
+        }
+        return out;
+    };
+
+    // A listing started and dropped at once must not show up in the slot
+    FolderIndexer indexer;
+    indexer.start(2);
+    indexer.load(0, "/nonexistent-sc1000-folder");
+    indexer.load(0, root);
+
+    Playlist pooled;
+    pooled.reset(base);
+    size_t polls = 0;
+    while (indexer.take(0, pooled) && polls < 5000) {
+        usleep(200);
+        polls++;
+    }
+    indexer.stop();
+
+    if (pooled.total_files() != 12 || pooled.folder_count() != 6) {
+        cleanup();
+        return fail("pool took " + std::to_string(pooled.total_files()) + " files");
+    }
+    if (access(index.c_str(), R_OK) != 0) {
+        cleanup();
+        return fail("index not written by stop()");
+    }
+
+    Playlist plain;
+    plain.load(base);
+    const bool same = paths(plain) == paths(pooled) && plain.rescanned() == 0;
+
+    // Without workers the listing is done in load(), taken in one go
+    unlink(index.c_str());
+    FolderIndexer inline_indexer;
+    inline_indexer.start(0);
+    inline_indexer.load(1, root);
+    Playlist in_place;
+    in_place.reset(base);
+    const bool more = inline_indexer.take(1, in_place);
+    const bool in_place_same = !more && paths(in_place) == paths(plain) && access(index.c_str(), R_OK) == 0;
+
+    cleanup();
+    if (!same) {
+        return fail("pooled listing differs from a plain load");
+    }
+    if (!in_place_same) {
+        return fail("inline listing differs from a plain load");
+    }
+
+    result.passed = true;
+    result.details = std::to_string(polls) + " polls, " + std::to_string(pooled.folder_count()) +
+                     " folders taken in order, index written back";
+    return result;
+}
+
+// Add and remove folders under a watched tree and swap the rebuilt playlists
+// into a deck, which has to stay on the folder and file it was on
+TestResult test_library_watcher()
+{
+    TestResult result;
+    result.name = "Library follows changes on the stick";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    char base[] = "/tmp/sc1000-watch-XXXXXX";
+    if (mkdtemp(base) == nullptr) {
+        return fail("cannot create beats folder");
+    }
+    const std::string root = base;
+    const std::string index = PlaylistIndex::path_for(root);
+    const char* files[] = {"/a/1.wav", "/b/1.wav", "/c/0.wav", "/c/1.wav"};
+
+    auto age = [](const std::string& path) {
+        struct timespec times[2];
+        clock_gettime(CLOCK_REALTIME, &times[0]);
+        times[0].tv_sec -= 3600;
+        times[1] = times[0];
+        utimensat(AT_FDCWD, path.c_str(), times, 0);
+    };
+    for (const char* folder : {"/a", "/c"}) {
+        mkdir((root + folder).c_str(), 0755);
+    }
+    std::ofstream(root + "/a/1.wav").put('x');
+    std::ofstream(root + "/c/1.wav").put('x');
+    for (const char* folder : {"/a", "/c", ""}) {
+        age(root + folder);
+    }
+
+    auto cleanup = [&]() {
+        for (const char* file : files) {
+            unlink((root + file).c_str());
+        }
+        for (const char* folder : {"/a", "/b", "/c", ""}) {
+            rmdir((root + folder).c_str());
+        }
+        unlink(index.c_str());
+    };
+
+    TestHarness harness;
+    Deck& deck = harness.engine().beat_deck;
+    deck.playlist = std::make_unique<Playlist>();
+    deck.playlist->load(base);
+    deck.nav_state.files_present = true;
+    deck.nav_state.folder_idx = 1;
+    deck.nav_state.file_idx = 0;
+
+    LibraryWatcher watcher;
+    if (!watcher.start()) {
+        cleanup();
+        return fail("inotify not available");
+    }
+    watcher.watch(0, root);
+
+    auto wait = [&]() {
+        for (int i = 0; i < 300; i++) {
+            if (std::unique_ptr<Playlist> next = watcher.take(0)) return next;
+            usleep(10000);
+        }
+        return std::unique_ptr<Playlist>();
+    };
+
+    // A folder added ahead of the deck's, and a file ahead of its file
+    mkdir((root + "/b").c_str(), 0755);
+    std::ofstream(root + "/b/1.wav").put('x');
+    std::ofstream(root + "/c/0.wav").put('x');
+    std::unique_ptr<Playlist> added = wait();
+    if (!added || added->total_files() != 4 || added->rescanned() != 2) {
+        cleanup();
+        return fail(added ? "rebuilt with " + std::to_string(added->total_files()) + " files, " +
+                            std::to_string(added->rescanned()) + " rescanned"
+                          : "no playlist after adding files");
+    }
+    deck.swap_playlist(std::move(added));
+    if (deck.nav_state.folder_idx != 2 || deck.nav_state.file_idx != 1) {
+        cleanup();
+        return fail("deck moved to folder " + std::to_string(deck.nav_state.folder_idx) + " file " +
+                    std::to_string(deck.nav_state.file_idx));
+    }
+
+    // The deck's folder goes: it ends up on the one now last
+    unlink((root + "/c/0.wav").c_str());
+    unlink((root + "/c/1.wav").c_str());
+    rmdir((root + "/c").c_str());
+    std::unique_ptr<Playlist> removed = wait();
+    watcher.stop();
+    if (!removed || removed->total_files() != 2) {
+        cleanup();
+        return fail("no playlist after removing a folder");
+    }
+    deck.swap_playlist(std::move(removed));
+    const bool moved = deck.nav_state.folder_idx == 1 && deck.nav_state.file_idx == 0 &&
+                       deck.nav_state.files_present;
+    cleanup();
+    if (!moved) {
+        return fail("deck left on folder " + std::to_string(deck.nav_state.folder_idx));
+    }
+
+    result.passed = true;
+    result.details = "Added and removed folders swapped in, deck kept on its file";
+    return result;
+}
+
+// Search a library of 20000 made-up names as they are typed, and walk the
+// results as a folder
+TestResult test_library_search()
+{
+    TestResult result;
+    result.name = "Library search as you type";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    static const char* words[] = {"Kick", "snare", "hat", "clap", "bass", "pad", "vox", "loop", "perc", "fx",
+                                  "808", "break", "amen", "hard", "soft", "dub", "tom", "ride", "crash", "stab"};
+    Playlist playlist;
+    uint32_t seed = 1;
+    auto next = [&]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    for (int f = 0; f < 200; f++) {
+        const std::string folder = "/lib/pack " + std::to_string(f) + " " + words[f % 20];
+        for (int i = 0; i < 100; i++) {
+            std::string name = std::string(words[next() % 20]) + "_" + words[next() % 20] + "-" +
+                               std::to_string(next() % 100) + ".wav";
+            playlist.add_file(folder, folder + "/" + name);
+        }
+    }
+    playlist.add_file("/lib/drums", "/lib/drums/909 Kick 02.wav");
+    playlist.add_file("/lib/kicks", "/lib/kicks/909-hard.wav");
+
+    // Both words, each in the name or the folder's
+    if (playlist.search("kick 909") != 2 ||
+        strcmp(playlist.get_file(Playlist::RESULTS, 0)->full_path, "/lib/drums/909 Kick 02.wav") != 0 ||
+        playlist.has_next_folder(Playlist::RESULTS) || playlist.has_prev_folder(Playlist::RESULTS)) {
+        return fail("\"kick 909\" found " + std::to_string(playlist.file_count_in_folder(Playlist::RESULTS)));
+    }
+
+    size_t folder_idx = 0;
+    size_t file_idx = 0;
+    ScFile* found = playlist.get_file(Playlist::RESULTS, 1);
+    if (!playlist.locate(found->global_index, &folder_idx, &file_idx) ||
+        playlist.get_file(folder_idx, file_idx)->full_path != found->full_path) {
+        return fail("result not located in its folder");
+    }
+
+    // Typing narrows, every query timed
+    const char* typed[] = {"s", "sn", "sna", "snar", "snare", "snare ", "snare h", "snare ha", "snare har",
+                           "snare hard", "snare hard 1", "snare hard 12", "b", "br", "bre", "brea", "break",
+                           "pack 1", "pack 17", "pack 17 ride", "zzz"};
+    size_t last = 0;
+    const char* before = nullptr;
+    double worst = 0.0;
+    double total = 0.0;
+    size_t queries = 0;
+    for (int round = 0; round < 20; round++) {
+        for (const char* query : typed) {
+            auto start = std::chrono::steady_clock::now();
+            size_t count = playlist.search(query);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (round > 0) {
+                worst = std::max(worst, ms);
+                total += ms;
+                queries++;
+            }
+            if (before && strncmp(query, before, strlen(before)) == 0 && count > last) {
+                return fail(std::string("\"") + query + "\" found more than \"" + before + "\"");
+            }
+            before = query;
+            last = count;
+        }
+    }
+    if (playlist.search("snare hard") == 0 || playlist.search("zzz") != 0) {
+        return fail("common words not found");
+    }
+
+    const double mean = total / static_cast<double>(queries);
+    if (mean > 1.0) {
+        return fail("mean query " + std::to_string(mean) + " ms");
+    }
+
+    result.passed = true;
+    result.details = "20002 files, mean query " + std::to_string(mean) + " ms, worst " + std::to_string(worst) + " ms";
+    return result;
+}
+
+// Save the cues of two tracks over and over and check each lands in one
+// write, seen by a load before it is on disk
+TestResult test_cue_writer()
+{
+    TestResult result;
+    result.name = "Cue writes coalesced in the background";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    char base[] = "/tmp/sc1000-cues-XXXXXX";
+    if (mkdtemp(base) == nullptr) {
+        return fail("cannot create folder");
+    }
+    const std::string root = base;
+    const std::string tracks[] = {root + "/a.wav", root + "/b.mp3"};
+
+    auto cleanup = [&]() {
+        for (const std::string& track : tracks) {
+            unlink(Cues::path_for(track.c_str()).c_str());
+        }
+        rmdir(root.c_str());
+    };
+
+    CueWriter writer;
+    writer.start();
+    Cues cues;
+    for (int i = 1; i <= 10; i++) {
+        for (const std::string& track : tracks) {
+            cues.reset();
+            cues.set(0, 0.5 * i);
+            cues.set(2, static_cast<double>(i));
+            writer.request(Cues::path_for(track.c_str()), cues.contents());
+        }
+    }
+
+    // Still queued: a load has to see the last save, not the disk
+    std::string pending;
+    Cues loaded;
+    const bool queued = writer.pending(Cues::path_for(tracks[1].c_str()), &pending);
+    loaded.load(pending);
+    const bool on_disk = access(Cues::path_for(tracks[1].c_str()).c_str(), F_OK) == 0;
+    writer.stop();
+
+    if (!queued || on_disk || loaded.get(2) != 10.0 || loaded.is_set(1)) {
+        cleanup();
+        return fail("pending cues not the last saved");
+    }
+    if (writer.requested() != 20 || writer.written() != 2) {
+        cleanup();
+        return fail(std::to_string(writer.written()) + " files written for " +
+                    std::to_string(writer.requested()) + " saves");
+    }
+
+    // Nothing left behind but the files, which read back as saved
+    Cues read;
+    read.load_from_file(tracks[0].c_str());
+    size_t entries = 0;
+    if (DIR* dir = opendir(root.c_str())) {
+        while (const dirent* entry = readdir(dir)) {
+            entries += entry->d_name[0] != '.';
+        }
+        closedir(dir);
+    }
+    const bool tmp = entries != 2;
+    const bool after = writer.request(Cues::path_for(tracks[0].c_str()), cues.contents());
+    if (read.get(0) != 5.0 || read.get(2) != 10.0 || tmp || after) {
+        cleanup();
+        return fail("file read back wrong or writer still taking saves");
+    }
+
+    // Loading a track: the writer reads the file, the deck takes it later
+    writer.start();
+    const std::string cuepath = Cues::path_for(tracks[0].c_str());
+    const std::string missing = root + "/none.cue";
+    std::string got, none;
+    bool asked = writer.read(0, cuepath) && writer.read(1, missing);
+    bool wrong = writer.take(1, cuepath, &none);
+    bool first = false, second = false;
+    for (int i = 0; i < 1000 && !(first && second); i++) {
+        first = first || writer.take(0, cuepath, &got);
+        second = second || writer.take(1, missing, &none);
+        usleep(1000);
+    }
+    const bool done = first && second;
+
+    // A cue set while the file was being read goes over it, the rest stay
+    Cues set;
+    set.set(1, 7.0);
+    const bool merging = writer.merge(cuepath, set.contents());
+    writer.stop();
+    Cues merged;
+    merged.load_from_file(tracks[0].c_str());
+    cleanup();
+
+    Cues taken;
+    taken.load(got);
+    if (!asked || wrong || !done || taken.get(0) != 5.0 || taken.get(2) != 10.0 || !none.empty()) {
+        return fail("cue file not read in the background");
+    }
+    if (!merging || merged.get(0) != 5.0 || merged.get(1) != 7.0 || merged.get(2) != 10.0) {
+        return fail("cue set while loading not merged into the file");
+    }
+
+    result.passed = true;
+    result.details = "20 saves of 2 files, 2 writes, files read and merged in the background";
+    return result;
+}
+
+// Scratch the beat deck at 2x with a touch-sensitive MIDI jog wheel, going
+// through the parser, the mapping table and action dispatch
+TestResult test_midi_jog_scratch()
+{
+    TestResult result;
+    result.name = "MIDI jog wheel scratch at 2x speed";
+
+    TestHarness harness;
+    Sc1000& engine = harness.engine();
+    ScSettings* settings = engine.settings.get();
+
+    auto* sine = generate_sine(440.0, 48000, 96000);
+    harness.load_track(0, sine);
+    engine.beat_deck.player.input.volume_knob = 1.0;
+    harness.sequence().add(0.0, AdcEvent{0, 1023});
+
+    // Touch on note 0x36, jog on CC 0x21 (two's complement), channel 1
+    Mapping touch{};
+    touch.type = IOType::MIDI;
+    touch.midi_command_bytes = {0x90, 0x36, 0x00};
+    touch.action_type = JOGTOUCH;
+    engine.mappings.add(touch);
+
+    Mapping jog{};
+    jog.type = IOType::MIDI;
+    jog.midi_command_bytes = {0xB0, 0x21, 0x00};
+    jog.action_type = JOG;
+    jog.parameter = MidiCommand::REL_TWOS_COMPLEMENT;
+    engine.mappings.add(jog);
+
+    sc::input::MidiParser parser;
+    auto send = [&](std::initializer_list<uint8_t> bytes, double time) {
+        for (uint8_t b : bytes) {
+            sc::MidiEvent ev;
+            if (!parser.feed(b, &ev)) continue;
+            ev.timestamp = time;
+            Mapping* map = engine.mappings.find_midi(MidiCommand::from_bytes(ev.bytes), BUTTON_PRESSED);
+            if (map) sc::control::dispatch_event(map, &ev, &engine, settings, engine.input_state);
+        }
+    };
+
+    // 2x speed, ticks sent in messages of up to 4 under running status
+    const double ticks_per_second = 2.0 * settings->midi_jog_speed;
+    int sent = 0;
+    send({0x90, 0x36, 0x7F, 0xB0}, 0.0);
+    harness.run(0.5, [&](double t) {
+        int due = static_cast<int>(t * ticks_per_second);
+        while (sent < due) {
+            int n = std::min(4, due - sent);
+            send({0x21, static_cast<uint8_t>(n)}, t);
+            sent += n;
+        }
+        engine.beat_deck.jog_update(t, settings);
+    });
+
+    track_release(sine);
+
+    if (!engine.beat_deck.player.input.touched) {
+        result.passed = false;
+        result.details = "Jog touch did not hold the deck";
+        return result;
+    }
+
+    double peak = find_peak_frequency(harness.output_left(), 48000, 400, 1200);
+    if (std::abs(peak - 880.0) > 50.0) {
+        result.passed = false;
+        result.details = "Peak frequency " + std::to_string(peak) + " Hz, expected ~880 Hz";
+        return result;
+    }
+
+    result.passed = true;
+    result.details = "Peak: " + std::to_string(peak) + " Hz (expected ~880 Hz)";
+    return result;
+}
+
+// Jump from silence into a DC section with a seek stamped part-way through
+// a block, and return how far the step lands from event time + latency
+static double timed_seek_error_frames(double fraction_of_block)
+{
+    TestHarness harness;
+    ScSettings* settings = harness.engine().settings.get();
+
+    std::vector<float> buffer(2 * 96000, 0.0f);
+    std::fill(buffer.begin() + 2 * 48000, buffer.end(), 0.5f);
+    auto* track = generate_from_buffer(buffer, 48000);
+    harness.load_track(1, track);
+    harness.engine().scratch_deck.player.input.seek_to = 0.1;
+    harness.sequence().add(0.0, TouchEvent{false});
+    harness.sequence().add(0.0, AdcEvent{1, 1023});
+
+    const double block = static_cast<double>(settings->period_size) / settings->sample_rate;
+    const double latency = static_cast<double>(settings->period_size) / settings->sample_rate +
+                           static_cast<double>(settings->update_rate) / 1000000.0;
+    double event_time = -1.0;
+
+    // The event happened during the block just rendered and reaches the
+    // input fields before the next one, as from the input thread
+    harness.run(0.2, [&](double t) {
+        if (event_time < 0.0 && t >= 0.1) {
+            event_time = t - fraction_of_block * block;
+            auto& in = harness.engine().scratch_deck.player.input;
+            in.seek_time = event_time;
+            in.position_offset = 0.0;
+            in.seek_to = 1.5;
+        }
+    });
+
+    auto left = harness.output_left();
+    track_release(track);
+
+    size_t onset = 0;
+    for (size_t i = static_cast<size_t>(0.1 * 48000); i < left.size(); i++) {
+        if (std::abs(left[i]) > 0.5 * std::abs(left.back())) {
+            onset = i;
+            break;
+        }
+    }
+    return static_cast<double>(onset) - (event_time + latency) * 48000.0;
+}
+
+TestResult test_timed_midi_seek()
+{
+    TestResult result;
+    result.name = "Timed MIDI seek lands at fixed latency";
+
+    // Events early and late in a block must land the same distance after
+    // they happened, not at the next block boundary
+    double early = timed_seek_error_frames(0.8);
+    double late = timed_seek_error_frames(0.2);
+
+    result.details = "Offset from event time + latency: " + std::to_string(early) +
+                     " / " + std::to_string(late) + " frames";
+    result.passed = std::abs(early) <= 2.0 && std::abs(late) <= 2.0;
+    return result;
+}
+
+// Save a session with a recorded loop through the writer, then restore it
+// into a fresh engine: the loop is mapped back in and the deck plays it
+TestResult test_session_restore()
+{
+    TestResult result;
+    result.name = "Session save and restore";
+
+    auto fail = [&](const std::string& what) {
+        result.passed = false;
+        result.details = what;
+        return result;
+    };
+
+    char folder[] = "/tmp/sc1000-session-XXXXXX";
+    if (mkdtemp(folder) == nullptr) {
+        return fail("cannot create session folder");
+    }
+
+    const int16_t level = static_cast<int16_t>(0.25f * 32767.0f);
+    unsigned int frames = 0;
+    {
+        TestHarness harness;
+        Sc1000& engine = harness.engine();
+        engine.session.init(folder);
+        engine.loop_writer.start();
+        harness.audio().enable_capture(true);
+        harness.audio().set_capture_input(std::vector<float>(2 * 48000, 0.25f));
+
+        engine.audio->start_recording(1, 0.0);
+        harness.run(0.5);
+        engine.audio->stop_recording(1);
+        frames = engine.audio->peek_loop_track(1)->length;
+        engine.scratch_deck.player.input.source = sc::PlaybackSource::Loop;
+        engine.scratch_deck.cues.set(2, 0.125);
+
+        engine.save_session(false);
+        for (int i = 0; i < 500 && engine.loop_writer.pending() > 0; i++) {
+            engine.handle_deck_recording();
+            harness.run(0.01);
+            usleep(1000);
+        }
+        engine.loop_writer.stop();
+    }
+
+    bool loaded = false, adopted = false, at_loop = false;
+    std::optional<double> cue;
+    unsigned int restored = 0;
+    int16_t sample = 0;
+    {
+        TestHarness harness;
+        Sc1000& engine = harness.engine();
+        engine.session.init(folder);
+        loaded = engine.session.load();
+        if (loaded) {
+            engine.restore_session();
+            adopted = engine.audio->has_loop(1);
+            at_loop = engine.scratch_deck.player.input.source == sc::PlaybackSource::Loop;
+            cue = engine.scratch_deck.cues.get(2);
+        }
+        if (adopted) {
+            Track* loop = engine.audio->peek_loop_track(1);
+            restored = loop->length;
+            sample = loop->get_sample(static_cast<int>(restored / 2))[1];
+        }
+    }
+
+    unlink((std::string(folder) + "/session.json").c_str());
+    unlink((std::string(folder) + "/loop-scratch.pcm").c_str());
+    rmdir(folder);
+
+    if (!loaded) {
+        return fail("session file missing or unreadable");
+    }
+    if (!adopted || !at_loop) {
+        return fail("scratch deck loop not restored");
+    }
+    if (restored != frames || sample != level) {
+        return fail("restored " + std::to_string(restored) + " of " + std::to_string(frames) +
+                    " frames, sample " + std::to_string(sample));
+    }
+    if (!cue.has_value() || cue.value() != 0.125) {
+        return fail("cue point not restored");
+    }
+
+    result.passed = true;
+    result.details = std::to_string(frames) + " frames mapped back as the loop";
+    return result;
+}
+
 std::vector<TestResult> run_all_tests()
 {
     std::vector<TestResult> results;
@@ -389,6 +2376,28 @@ std::vector<TestResult> run_all_tests()
     results.push_back(test_scratch_backward_1x());
     results.push_back(test_pitch_midi_note());
     results.push_back(test_frequency_scaling());
+    results.push_back(test_platter_tracking());
+    results.push_back(test_midi_parser());
+    results.push_back(test_midi_feedback());
+    results.push_back(test_midi_jog_scratch());
+    results.push_back(test_timed_midi_seek());
+    results.push_back(test_action_macro());
+    results.push_back(test_settings_reload());
+    results.push_back(test_capture_grab());
+    results.push_back(test_loop_overdub());
+    results.push_back(test_loop_save());
+    results.push_back(test_loop_pool());
+    results.push_back(test_master_record());
+    results.push_back(test_latency_calibration());
+    results.push_back(test_session_restore());
+    results.push_back(test_loop_quantize());
+    results.push_back(test_sampler());
+    results.push_back(test_stutter());
+    results.push_back(test_playlist_index());
+    results.push_back(test_folder_indexer());
+    results.push_back(test_library_watcher());
+    results.push_back(test_library_search());
+    results.push_back(test_cue_writer());
 
     return results;
 }
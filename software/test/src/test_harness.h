@@ -12,6 +12,7 @@
 #include "input_sequence.h"
 #include "test_samples.h"
 #include "core/sc1000.h"
+#include "input/platter_estimator.h"
 #include <functional>
 #include <string>
 
@@ -45,6 +46,9 @@ public:
     // Run simulation for a duration, applying input events
     void run(double duration_seconds);
 
+    // Same, calling on_chunk(time) after each rendered chunk
+    void run(double duration_seconds, const std::function<void(double)>& on_chunk);
+
     // Get output buffer
     const std::vector<float>& output() const { return audio_->output_buffer(); }
 
@@ -70,6 +74,12 @@ private:
     double current_time_ = 0.0;
     unsigned int sample_rate_ = 48000;
 
+    // Input thread simulation (encoder sampled at the default update_rate)
+    static constexpr double INPUT_PERIOD = 0.002;
+    static constexpr unsigned long FRAMES_PER_CHUNK = 256;
+    sc::input::PlatterEstimator platter_estimator_;
+    double next_input_time_ = 0.0;
+
     void setup_engine();
 };
 
@@ -98,6 +108,75 @@ TestResult test_pitch_midi_note();
 // Test: frequency verification (output should be input freq * pitch)
 TestResult test_frequency_scaling();
 
+// Test: platter tracking error, estimator vs plain P-controller
+TestResult test_platter_tracking();
+
+// Test: GPIO debounce accepts an edge at once and ignores bounce for the lockout
+TestResult test_gpio_debounce();
+
+// Test: MIDI byte parsing (running status, 14-bit CC, NRPN, relative encoders)
+TestResult test_midi_parser();
+
+// Test: LED feedback is diffed, coalesced and paced to the port's byte budget
+TestResult test_midi_feedback();
+
+// Test: scratching the beat deck with a MIDI jog wheel
+TestResult test_midi_jog_scratch();
+
+// Test: a timestamped seek lands at event time + fixed latency within a block
+TestResult test_timed_midi_seek();
+
+// Test: a macro mapping fires its steps in order on the bound deck
+TestResult test_action_macro();
+
+// Test: settings reloaded from a file swap in, the old ones freed after a block
+TestResult test_settings_reload();
+
+// Test: the last seconds of capture input become the deck's loop in place
+TestResult test_capture_grab();
+
+// Test: both decks record at once from different channel pairs, then overdub
+TestResult test_loop_overdub();
+
+// Test: a saved loop is written as recorded, despite a punch-in meanwhile
+TestResult test_loop_save();
+
+// Test: the decks share one pool of loop storage, erasing frees it for the other
+TestResult test_loop_pool();
+
+// Test: latency calibration over a loopback, then recordings aligned by it
+TestResult test_latency_calibration();
+
+// Test: master recording writes the output and input pairs to a 4-channel WAV
+TestResult test_master_record();
+
+// Test: a session saved with a loop is restored into a fresh engine
+TestResult test_session_restore();
+
+// Test: recording snaps to a 120 BPM grid, a loop roll repeats and slips back
+TestResult test_loop_quantize();
+
+// Test: one-shot voices play cue slices, stolen by voice count and CPU budget
+TestResult test_sampler();
+
+// Test: beat repeat retriggers at exact frames on the grid and slips on release
+TestResult test_stutter();
+
+// Test: a reload takes unchanged folders from the playlist index, rescanning the rest
+TestResult test_playlist_index();
+
+// Test: worker threads list a tree that is taken folder by folder, in order
+TestResult test_folder_indexer();
+
+// Test: changes under a watched folder are rebuilt and swapped in, navigation kept
+TestResult test_library_watcher();
+
+// Test: search narrows as a query is typed, in under a millisecond, results walk as a folder
+TestResult test_library_search();
+
+// Test: repeated cue saves are coalesced into one background write per file
+TestResult test_cue_writer();
+
 // Run all built-in tests
 std::vector<TestResult> run_all_tests();
 
@@ -339,6 +339,31 @@ int main(int argc, char* argv[])
         results.push_back(result);
     }
 
+    // These build their own harnesses or none, so there is no single output to export
+    results.push_back(sc::test::test_platter_tracking());
+    results.push_back(sc::test::test_gpio_debounce());
+    results.push_back(sc::test::test_midi_parser());
+    results.push_back(sc::test::test_midi_feedback());
+    results.push_back(sc::test::test_midi_jog_scratch());
+    results.push_back(sc::test::test_timed_midi_seek());
+    results.push_back(sc::test::test_action_macro());
+    results.push_back(sc::test::test_settings_reload());
+    results.push_back(sc::test::test_capture_grab());
+    results.push_back(sc::test::test_loop_overdub());
+    results.push_back(sc::test::test_loop_save());
+    results.push_back(sc::test::test_loop_pool());
+    results.push_back(sc::test::test_master_record());
+    results.push_back(sc::test::test_latency_calibration());
+    results.push_back(sc::test::test_session_restore());
+    results.push_back(sc::test::test_loop_quantize());
+    results.push_back(sc::test::test_sampler());
+    results.push_back(sc::test::test_stutter());
+    results.push_back(sc::test::test_playlist_index());
+    results.push_back(sc::test::test_folder_indexer());
+    results.push_back(sc::test::test_library_watcher());
+    results.push_back(sc::test::test_library_search());
+    results.push_back(sc::test::test_cue_writer());
+
     int passed = 0;
     int failed = 0;
 